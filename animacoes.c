@@ -0,0 +1,294 @@
+/**
+ * @file animacoes.c
+ * @brief Implementação do motor de animações em camadas.
+ * Cada camada guarda o próprio quadro; as saídas só recebem o quadro da camada de cima
+ * quando ele muda ou quando a camada de cima passa a ser outra.
+ */
+
+#include "animacoes.h"
+#include "matriz.h"
+#include "rgb_led.h"
+#include "perfil.h"
+#include "pico/time.h"
+#include "hardware/sync.h" // Para __sev e save_and_disable_interrupts
+#include <string.h>
+
+
+// --- Definições ---
+#define SEM_CAMADA 0xFF
+
+typedef struct {
+    const animacao_t *animacao;                    // NULL: camada livre
+    absolute_time_t inicio;
+    uint8_t keyframe[ANIMACAO_SAIDAS];             // Quadro-chave atual de cada faixa (quantidade: encerrada)
+    absolute_time_t fim_keyframe[ANIMACAO_SAIDAS]; // Limite do quadro-chave atual (em fase com o início)
+    absolute_time_t prazo_gerador;                 // at_the_end_of_time: só após animacoes_invalidar
+    uint8_t alteradas;                             // Saídas redesenhadas desde o último envio
+    animacao_quadro_t quadro;
+} camada_t;
+
+
+// --- Variáveis Estáticas ---
+static camada_t camadas[ANIMACOES_CAMADAS];
+static uint8_t ativas = 0;
+static uint8_t exibida[ANIMACAO_SAIDAS];    // Camada cujo quadro está em cada saída
+
+// Compartilhadas com o callback do alarme, por isso alteradas com interrupções desabilitadas
+static volatile bool quadro_pendente = false;   // Limite cruzado, ou camada iniciada/parada/invalidada
+static volatile bool alarme_agendado = false;
+static volatile uint32_t disparos = 0;
+static alarm_id_t alarme = 0;
+static absolute_time_t proximo_limite;          // Limite de quadro mais próximo entre as camadas
+
+static animacoes_estatisticas_t estatisticas = {0};
+static uint64_t custo_total_us = 0;
+
+
+// --- Funções Auxiliares Estáticas ---
+
+static inline bool chegou(absolute_time_t prazo, absolute_time_t agora) {
+    return to_us_since_boot(prazo) <= to_us_since_boot(agora);
+}
+
+/**
+ * @brief Callback do alarme: só marca o limite cruzado e acorda o loop principal (WFE).
+ */
+static int64_t alarme_callback(alarm_id_t id, void *user_data) {
+    (void)id;
+    (void)user_data;
+    alarme_agendado = false;
+    quadro_pendente = true;
+    disparos++;
+    __sev();
+    return 0;
+}
+
+/**
+ * @brief Reagenda o alarme para o próximo limite de quadro (at_the_end_of_time: nenhum).
+ * Sem alarme livre, animacoes_proximo_prazo() devolve o limite ao loop principal.
+ */
+static void agendar(absolute_time_t limite) {
+    uint32_t estado = save_and_disable_interrupts();
+    if (!(alarme_agendado && to_us_since_boot(limite) == to_us_since_boot(proximo_limite))) {
+        if (alarme_agendado) {
+            cancel_alarm(alarme);
+            alarme_agendado = false;
+        }
+        if (!is_at_the_end_of_time(limite)) {
+            alarme = add_alarm_at(limite, alarme_callback, NULL, false);
+            if (alarme > 0) {
+                alarme_agendado = true;
+            } else if (alarme == 0) {
+                quadro_pendente = true; // O limite já passou
+            }
+        }
+    }
+    proximo_limite = limite;
+    restore_interrupts(estado);
+}
+
+static void desenhar_keyframe(camada_t *camada, uint saida, const keyframe_t *keyframe) {
+    if (saida == ANIMACAO_SAIDA_LED) {
+        camada->quadro.led = keyframe->cor;
+    } else {
+        animacoes_desenhar_padrao(&camada->quadro, keyframe->padrao, keyframe->cor);
+    }
+    camada->alteradas |= (uint8_t)(1u << saida);
+}
+
+/**
+ * @brief Avança as faixas e o gerador de uma camada até 'agora'.
+ * @param limite Saída: próximo limite de quadro da camada.
+ * @return false se a animação terminou (todas as faixas encerradas e nenhum gerador).
+ */
+static bool camada_avancar(camada_t *camada, absolute_time_t agora, absolute_time_t *limite) {
+    const animacao_t *animacao = camada->animacao;
+    bool continua = animacao->gerar != NULL;
+    *limite = at_the_end_of_time;
+
+    for (uint saida = 0; saida < ANIMACAO_SAIDAS; saida++) {
+        const faixa_t *faixa = &animacao->faixas[saida];
+        uint8_t keyframe = camada->keyframe[saida];
+        if (keyframe >= faixa->quantidade) {
+            continue; // Sem faixa nesta saída, ou faixa encerrada
+        }
+        // Quadros-chave perdidos (loop ocupado) são pulados, sem perder a fase
+        bool mudou = false;
+        while (chegou(camada->fim_keyframe[saida], agora)) {
+            if (++keyframe == faixa->quantidade) {
+                if (!animacao->repetir) {
+                    break;
+                }
+                keyframe = 0;
+            }
+            camada->fim_keyframe[saida] = delayed_by_ms(camada->fim_keyframe[saida], faixa->keyframes[keyframe].duracao_ms);
+            mudou = true;
+        }
+        camada->keyframe[saida] = keyframe;
+        if (keyframe == faixa->quantidade) {
+            continue; // Encerrada: a saída mantém o último quadro-chave até a camada sair
+        }
+        if (mudou) {
+            desenhar_keyframe(camada, saida, &faixa->keyframes[keyframe]);
+        }
+        continua = true;
+        *limite = absolute_time_min(*limite, camada->fim_keyframe[saida]);
+    }
+
+    if (animacao->gerar && chegou(camada->prazo_gerador, agora)) {
+        animacao->gerar(&camada->quadro, (uint32_t)(absolute_time_diff_us(camada->inicio, agora) / 1000));
+        camada->alteradas |= animacao->saidas_geradas;
+        if (animacao->periodo_ms == 0) {
+            camada->prazo_gerador = at_the_end_of_time;
+        } else {
+            camada->prazo_gerador = delayed_by_ms(camada->prazo_gerador, animacao->periodo_ms);
+            if (chegou(camada->prazo_gerador, agora)) {
+                camada->prazo_gerador = delayed_by_ms(agora, animacao->periodo_ms); // Atrasada demais: retoma a cadência daqui
+            }
+        }
+    }
+    if (animacao->gerar) {
+        *limite = absolute_time_min(*limite, camada->prazo_gerador);
+    }
+    return continua;
+}
+
+static void camada_liberar(uint8_t indice) {
+    ativas &= (uint8_t)~(1u << indice);
+    camadas[indice].animacao = NULL;
+}
+
+static bool camada_desenha(const camada_t *camada, uint saida) {
+    const animacao_t *animacao = camada->animacao;
+    return animacao->faixas[saida].quantidade > 0 || (animacao->saidas_geradas & (1u << saida));
+}
+
+static void enviar(uint saida, const animacao_quadro_t *quadro) {
+    if (saida == ANIMACAO_SAIDA_LED) {
+        rgb_led_set_rgb(quadro->led);
+    } else {
+        matriz_desenhar_quadro(quadro->pixels);
+    }
+}
+
+/**
+ * @brief Envia a cada saída o quadro da camada de cima, se ele mudou ou se a camada mudou.
+ */
+static void enviar_saidas(void) {
+    for (uint saida = 0; saida < ANIMACAO_SAIDAS; saida++) {
+        uint8_t topo = SEM_CAMADA;
+        for (uint8_t restantes = ativas; restantes; restantes &= restantes - 1) {
+            uint8_t indice = (uint8_t)__builtin_ctz(restantes);
+            if (camada_desenha(&camadas[indice], saida)) {
+                topo = indice; // Bits em ordem crescente: fica a de maior índice
+            }
+        }
+        if (topo != SEM_CAMADA && (topo != exibida[saida] || (camadas[topo].alteradas & (1u << saida)))) {
+            enviar(saida, &camadas[topo].quadro);
+        }
+        exibida[saida] = topo; // Sem camada, a saída fica como está
+    }
+    for (uint8_t restantes = ativas; restantes; restantes &= restantes - 1) {
+        camadas[__builtin_ctz(restantes)].alteradas = 0;
+    }
+}
+
+
+// --- Implementação das Funções Públicas ---
+
+void animacoes_init(void) {
+    memset(camadas, 0, sizeof(camadas));
+    memset(exibida, SEM_CAMADA, sizeof(exibida));
+    ativas = 0;
+    proximo_limite = at_the_end_of_time;
+}
+
+void animacoes_iniciar(uint8_t indice, const animacao_t *animacao) {
+    camada_t *camada = &camadas[indice];
+    memset(camada, 0, sizeof(*camada)); // Geradores que partem do quadro anterior começam do apagado
+    camada->animacao = animacao;
+    camada->inicio = get_absolute_time();
+    camada->prazo_gerador = animacao->gerar ? camada->inicio : at_the_end_of_time;
+    for (uint saida = 0; saida < ANIMACAO_SAIDAS; saida++) {
+        const faixa_t *faixa = &animacao->faixas[saida];
+        if (faixa->quantidade > 0) {
+            camada->fim_keyframe[saida] = delayed_by_ms(camada->inicio, faixa->keyframes[0].duracao_ms);
+            desenhar_keyframe(camada, saida, &faixa->keyframes[0]);
+        }
+    }
+    ativas |= (uint8_t)(1u << indice);
+    quadro_pendente = true;
+}
+
+void animacoes_parar(uint8_t indice) {
+    if (ativas & (1u << indice)) {
+        camada_liberar(indice);
+        quadro_pendente = true; // A camada de baixo volta a aparecer
+    }
+}
+
+void animacoes_parar_todas(void) {
+    for (uint8_t indice = 0; indice < ANIMACOES_CAMADAS; indice++) {
+        animacoes_parar(indice);
+    }
+}
+
+void animacoes_invalidar(uint8_t indice) {
+    if ((ativas & (1u << indice)) && camadas[indice].animacao->gerar) {
+        camadas[indice].prazo_gerador = get_absolute_time();
+        quadro_pendente = true;
+    }
+}
+
+void animacoes_desenhar_padrao(animacao_quadro_t *quadro, uint32_t padrao, uint32_t cor) {
+    for (uint i = 0; i < ANIMACAO_PIXELS; i++) {
+        quadro->pixels[i] = ((padrao >> i) & 1u) ? cor : 0;
+    }
+}
+
+uint8_t animacoes_ativas(void) {
+    return ativas;
+}
+
+void animacoes_processar(void) {
+    if (!quadro_pendente && (alarme_agendado || !time_reached(proximo_limite))) {
+        return; // Nenhum limite de quadro cruzado
+    }
+    PERFIL_ESCOPO(PERFIL_QUADRO_ANIMACAO);
+    uint32_t inicio_us = time_us_32();
+    quadro_pendente = false;
+
+    absolute_time_t agora = get_absolute_time();
+    absolute_time_t limite = at_the_end_of_time;
+    for (uint8_t restantes = ativas; restantes; restantes &= restantes - 1) {
+        uint8_t indice = (uint8_t)__builtin_ctz(restantes);
+        absolute_time_t limite_camada;
+        if (camada_avancar(&camadas[indice], agora, &limite_camada)) {
+            limite = absolute_time_min(limite, limite_camada);
+        } else {
+            camada_liberar(indice); // Terminou no próprio limite: as saídas voltam à camada de baixo já neste quadro
+        }
+    }
+    enviar_saidas();
+    agendar(limite);
+
+    uint32_t custo_us = time_us_32() - inicio_us;
+    estatisticas.quadros++;
+    custo_total_us += custo_us;
+    if (custo_us > estatisticas.custo_maximo_us) {
+        estatisticas.custo_maximo_us = custo_us;
+    }
+}
+
+absolute_time_t animacoes_proximo_prazo(void) {
+    if (quadro_pendente) {
+        return get_absolute_time();
+    }
+    return alarme_agendado ? at_the_end_of_time : proximo_limite;
+}
+
+void animacoes_obter_estatisticas(animacoes_estatisticas_t *saida) {
+    *saida = estatisticas;
+    saida->disparos = disparos;
+    saida->custo_medio_us = estatisticas.quadros ? (uint32_t)(custo_total_us / estatisticas.quadros) : 0;
+}
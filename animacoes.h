@@ -0,0 +1,136 @@
+/**
+ * @file animacoes.h
+ * @brief Motor de animações da matriz de LEDs e do LED RGB.
+ * Cada animação é uma tabela constante (em flash) de quadros-chave por saída e/ou um
+ * gerador chamado numa cadência fixa. As animações rodam em camadas: em cada saída vale
+ * a camada ativa de maior índice que a desenha. Um alarme de hardware marca o próximo
+ * limite de quadro; fora deles, animacoes_processar() retorna sem desenhar nada.
+ */
+
+#ifndef ANIMACOES_H
+#define ANIMACOES_H
+
+#include "pico/stdlib.h"
+
+// --- Parâmetros ---
+#define ANIMACOES_CAMADAS 8         // Animações simultâneas (uma por camada)
+#define ANIMACAO_PIXELS 25          // Matriz 5x5
+
+// Saídas (índices de animacao_t.faixas e bits de animacao_t.saidas_geradas)
+#define ANIMACAO_SAIDA_MATRIZ 0
+#define ANIMACAO_SAIDA_LED 1
+#define ANIMACAO_SAIDAS 2
+
+/// Bit do pixel (x, y) no padrão de um quadro-chave da matriz.
+#define ANIMACAO_PIXEL(x, y) (1u << (5 * (y) + (x)))
+
+/**
+ * @struct keyframe_t
+ * @brief Um quadro-chave de uma faixa.
+ */
+typedef struct {
+    uint32_t padrao;      ///< Matriz: pixels acesos, um bit por pixel (ANIMACAO_PIXEL). LED: ignorado.
+    uint32_t cor;         ///< 0xRRGGBB dos pixels acesos (matriz) ou do LED.
+    uint16_t duracao_ms;  ///< Tempo até o próximo quadro-chave (ou até o fim da faixa).
+} keyframe_t;
+
+/**
+ * @struct faixa_t
+ * @brief Sequência de quadros-chave de uma saída (quantidade 0: a animação não a usa).
+ */
+typedef struct {
+    const keyframe_t *keyframes;
+    uint8_t quantidade;
+} faixa_t;
+
+/**
+ * @struct animacao_quadro_t
+ * @brief Conteúdo de uma camada: preservado entre quadros, para geradores que partem do anterior.
+ */
+typedef struct {
+    uint32_t pixels[ANIMACAO_PIXELS]; ///< 0xRRGGBB, índice 5 * y + x.
+    uint32_t led;                     ///< 0xRRGGBB.
+} animacao_quadro_t;
+
+/**
+ * @struct animacao_t
+ * @brief Definição de uma animação (tipicamente uma constante).
+ * Uma animação só com faixas termina quando a última faixa termina; com gerador, só
+ * quando é parada.
+ */
+typedef struct {
+    faixa_t faixas[ANIMACAO_SAIDAS];  ///< Quadros-chave por saída (ANIMACAO_SAIDA_*).
+    bool repetir;                     ///< As faixas recomeçam ao terminar.
+    /// Desenha um quadro (NULL: nenhum). 'decorrido_ms' conta desde o início da animação.
+    void (*gerar)(animacao_quadro_t *quadro, uint32_t decorrido_ms);
+    uint8_t saidas_geradas;           ///< Saídas que o gerador desenha (bits 1 << ANIMACAO_SAIDA_*).
+    uint16_t periodo_ms;              ///< Cadência do gerador (0: só no início e após animacoes_invalidar).
+} animacao_t;
+
+/**
+ * @struct animacoes_estatisticas_t
+ * @brief Custo dos quadros desde o boot.
+ */
+typedef struct {
+    uint32_t quadros;           ///< Passagens por animacoes_processar() que desenharam algo.
+    uint32_t disparos;          ///< Alarmes de limite de quadro disparados.
+    uint32_t custo_medio_us;    ///< Tempo médio de um quadro (avanço das camadas e envio às saídas).
+    uint32_t custo_maximo_us;
+} animacoes_estatisticas_t;
+
+/**
+ * @brief Inicializa o motor (todas as camadas livres).
+ */
+void animacoes_init(void);
+
+/**
+ * @brief Inicia (ou reinicia) uma animação numa camada; o primeiro quadro sai na
+ * próxima chamada de animacoes_processar().
+ * @param camada 0 a ANIMACOES_CAMADAS - 1 (maior: desenha por cima).
+ * @param animacao Definição, que precisa existir enquanto a animação roda.
+ */
+void animacoes_iniciar(uint8_t camada, const animacao_t *animacao);
+
+/**
+ * @brief Para a animação de uma camada. As saídas que ela ocupava voltam à camada de baixo;
+ * sem nenhuma, ficam como estão.
+ */
+void animacoes_parar(uint8_t camada);
+
+/**
+ * @brief Para todas as camadas.
+ */
+void animacoes_parar_todas(void);
+
+/**
+ * @brief Pede um quadro do gerador da camada na próxima chamada de animacoes_processar()
+ * (para geradores sem cadência cujo conteúdo mudou).
+ */
+void animacoes_invalidar(uint8_t camada);
+
+/**
+ * @brief Para geradores: acende na matriz do quadro os pixels do padrão (bits ANIMACAO_PIXEL)
+ * numa cor (0xRRGGBB) e apaga os demais.
+ */
+void animacoes_desenhar_padrao(animacao_quadro_t *quadro, uint32_t padrao, uint32_t cor);
+
+/**
+ * @brief Camadas ativas, um bit por camada.
+ */
+uint8_t animacoes_ativas(void);
+
+/**
+ * @brief Avança as camadas cujo limite de quadro chegou e envia às saídas o que mudou.
+ * Chamar uma vez por volta do loop principal; sem limite cruzado, retorna de imediato.
+ */
+void animacoes_processar(void);
+
+/**
+ * @brief Quando animacoes_processar() terá trabalho: agora, se há quadro pendente; senão
+ * o alarme acorda o núcleo sozinho (at_the_end_of_time), a menos que não tenha sido agendado.
+ */
+absolute_time_t animacoes_proximo_prazo(void);
+
+void animacoes_obter_estatisticas(animacoes_estatisticas_t *estatisticas);
+
+#endif // ANIMACOES_H
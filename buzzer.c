@@ -1,11 +1,14 @@
 /**
  * @file buzzer.c
  * @brief Implementação do driver do buzzer passivo usando PWM.
- * Permite a geração de tons específicos e melodias pré-definidas.
+ * Os tons e melodias são tocados por um sequenciador não-bloqueante: as notas ficam
+ * em uma fila e a troca de nota é feita no callback de um alarme de hardware.
  */
 
 #include "buzzer.h"
 #include "hardware/clocks.h" // Necessário para clock_get_hz
+#include "hardware/dma.h"    // Reprodução de amostras por DMA
+#include "hardware/sync.h"   // save_and_disable_interrupts
 
 
 // --- Definições Internas de Notas Musicais (Frequências em Hz) ---
@@ -15,6 +18,156 @@
 #define NOTE_E5  659
 #define NOTE_G5  784
 
+// Divisor inteiro do PWM para os tons: com 125MHz, cobre de ~30Hz a dezenas de kHz
+#define BUZZER_DIVISOR_TOM 64
+
+
+// --- Melodias (tabelas constantes, mantidas na flash) ---
+static const buzzer_nota_t MELODIA_SUCESSO[] = {
+    {NOTE_C5, 100}, {NOTE_E5, 100}, {NOTE_G5, 120},
+};
+
+static const buzzer_nota_t MELODIA_ERRO[] = {
+    {NOTE_DS3, 200}, {NOTE_C3, 300},
+};
+
+
+// --- Estado do Sequenciador ---
+
+/**
+ * @brief Entrada da fila: uma sequência de notas (tabela externa ou nota avulsa copiada).
+ */
+typedef struct {
+    const buzzer_nota_t *notas;
+    uint8_t quantidade;
+    buzzer_nota_t nota_avulsa; // Armazena a nota de buzzer_play_tone
+} sequencia_t;
+
+// Fila circular: 'cabeca' é onde entra a próxima sequência, 'cauda' é a que está tocando.
+// Compartilhada com o callback do alarme, por isso é alterada com interrupções desabilitadas.
+static sequencia_t fila[BUZZER_FILA_TAMANHO];
+static volatile uint8_t fila_cabeca = 0, fila_cauda = 0;
+static uint8_t nota_atual = 0;          // Próxima nota da sequência da cauda
+static volatile bool tocando = false;   // Há um alarme agendado para a troca de nota
+static alarm_id_t alarme = 0;
+
+// Reprodução de amostras por DMA (recursos alocados no primeiro uso)
+static int canal_pcm = -1;
+static int temporizador_pcm = -1;
+
+
+// --- Funções Auxiliares Estáticas ---
+
+/**
+ * @brief Desliga o PWM e devolve o pino ao GPIO em nível baixo (silêncio total).
+ */
+static void silenciar(void) {
+    uint slice_num = pwm_gpio_to_slice_num(BUZZER_PIN);
+    pwm_set_enabled(slice_num, false);
+    if (canal_pcm >= 0) {
+        dma_channel_abort(canal_pcm);
+    }
+    gpio_set_function(BUZZER_PIN, GPIO_FUNC_SIO);
+    gpio_put(BUZZER_PIN, 0);
+}
+
+/**
+ * @brief Programa o PWM para a frequência pedida (0 = pausa). Chamado também em interrupção.
+ */
+static void programar_tom(uint16_t frequencia) {
+    if (frequencia == 0) {
+        silenciar();
+        return;
+    }
+    uint slice_num = pwm_gpio_to_slice_num(BUZZER_PIN);
+    // Freq = clock_do_sistema / (divisor * wrap), apenas com aritmética inteira
+    uint32_t wrap = clock_get_hz(clk_sys) / (BUZZER_DIVISOR_TOM * (uint32_t)frequencia);
+    if (wrap > 0xFFFF) wrap = 0xFFFF;
+
+    gpio_set_function(BUZZER_PIN, GPIO_FUNC_PWM);
+    pwm_set_clkdiv_int_frac(slice_num, BUZZER_DIVISOR_TOM, 0);
+    pwm_set_wrap(slice_num, wrap);
+    pwm_set_chan_level(slice_num, pwm_gpio_to_channel(BUZZER_PIN), wrap / 2); // 50% duty cycle
+    pwm_set_enabled(slice_num, true);
+}
+
+/**
+ * @brief Inicia a próxima nota da fila.
+ * @return Duração da nota em microssegundos, ou 0 se a fila terminou (buzzer silenciado).
+ */
+static int64_t avancar_nota(void) {
+    while (fila_cauda != fila_cabeca) {
+        sequencia_t *sequencia = &fila[fila_cauda];
+        while (nota_atual < sequencia->quantidade) {
+            const buzzer_nota_t *nota = &sequencia->notas[nota_atual++];
+            if (nota->duracao_ms == 0) {
+                continue;
+            }
+            programar_tom(nota->frequencia);
+            return (int64_t)nota->duracao_ms * 1000;
+        }
+        fila_cauda = (fila_cauda + 1) % BUZZER_FILA_TAMANHO;
+        nota_atual = 0;
+    }
+    silenciar();
+    tocando = false;
+    return 0;
+}
+
+/**
+ * @brief Callback do alarme: troca de nota. O valor negativo reagenda o alarme
+ * relativo ao instante previsto do disparo anterior, sem acumular atrasos.
+ */
+static int64_t alarme_callback(alarm_id_t id, void *user_data) {
+    (void)id;
+    (void)user_data;
+    return -avancar_nota();
+}
+
+/**
+ * @brief Inicia a reprodução se o sequenciador estiver parado (interrupções já desabilitadas).
+ */
+static void iniciar_se_parado(void) {
+    if (tocando) {
+        return;
+    }
+    nota_atual = 0;
+    int64_t duracao_us = avancar_nota();
+    if (duracao_us > 0) {
+        alarme = add_alarm_in_us(duracao_us, alarme_callback, NULL, true);
+        if (alarme > 0) {
+            tocando = true;
+        } else {
+            // Sem alarmes disponíveis: descarta a fila em vez de deixar o tom preso
+            fila_cauda = fila_cabeca;
+            silenciar();
+        }
+    }
+}
+
+/**
+ * @brief Cancela o alarme e esvazia a fila (interrupções já desabilitadas).
+ */
+static void cancelar_sequenciador(void) {
+    if (tocando) {
+        cancel_alarm(alarme);
+        tocando = false;
+    }
+    fila_cauda = fila_cabeca;
+    nota_atual = 0;
+}
+
+/**
+ * @brief Callback do alarme que encerra a reprodução de amostras.
+ */
+static int64_t fim_amostras_callback(alarm_id_t id, void *user_data) {
+    (void)id;
+    (void)user_data;
+    dma_channel_abort(canal_pcm);
+    nota_atual = 0;
+    return -avancar_nota(); // Segue com as notas enfileiradas durante as amostras, se houver
+}
+
 
 // --- Funções de Controle Básico do Buzzer (Não-Bloqueantes) ---
 
@@ -29,83 +182,127 @@ void buzzer_init() {
 
 /**
  * @brief Inicia a emissão de um bipe contínuo com tom fixo (aprox. 1kHz).
- * Não-bloqueante. Usado para feedback rápido, como o de digitação.
+ * Não-bloqueante. Interrompe o que estiver tocando. Usado para feedback rápido, como o de digitação.
  */
 void buzzer_start_beep() {
-    uint slice_num = pwm_gpio_to_slice_num(BUZZER_PIN);
-    gpio_set_function(BUZZER_PIN, GPIO_FUNC_PWM);
-    
-    // Configura um tom fixo para o bipe rápido (aprox. 1000 Hz)
-    // Freq = clock_do_sistema / (divisor * wrap)
-    // Para 1000 Hz, com clock de 125MHz, podemos usar div=125, wrap=1000.
-    pwm_set_clkdiv(slice_num, 125.0); // Divisor
-    pwm_set_wrap(slice_num, 1000);   // Período (wrap)
-    pwm_set_chan_level(slice_num, pwm_gpio_to_channel(BUZZER_PIN), 500); // 50% duty cycle
-    pwm_set_enabled(slice_num, true);
+    uint32_t interrupcoes = save_and_disable_interrupts();
+    cancelar_sequenciador();
+    programar_tom(1000);
+    restore_interrupts(interrupcoes);
 }
 
 /**
- * @brief Para a emissão do bipe contínuo e desliga o buzzer.
+ * @brief Para qualquer som (bipe contínuo, fila de notas ou amostras) e desliga o buzzer.
  */
 void buzzer_stop_beep() {
-    uint slice_num = pwm_gpio_to_slice_num(BUZZER_PIN);
-    pwm_set_enabled(slice_num, false);
-    // Retorna o pino para função de GPIO normal para garantir silêncio total
-    gpio_set_function(BUZZER_PIN, GPIO_FUNC_SIO);
-    gpio_put(BUZZER_PIN, 0); // Garante que o pino esteja em LOW
+    uint32_t interrupcoes = save_and_disable_interrupts();
+    cancelar_sequenciador();
+    silenciar();
+    restore_interrupts(interrupcoes);
 }
 
 
-// --- Funções de Reprodução de Tons e Melodias (Bloqueantes) ---
+// --- Funções de Reprodução de Tons e Melodias (Não-Bloqueantes) ---
 
 /**
- * @brief Toca um tom com frequência e duração específicas.
- * Bloqueante: pausa a execução durante a duração do tom.
+ * @brief Enfileira um tom com frequência e duração específicas e retorna imediatamente.
  * @param frequency A frequência do tom em Hz (0 para silêncio/pausa).
  * @param duration_ms A duração do tom em milissegundos.
  */
 void buzzer_play_tone(uint16_t frequency, uint16_t duration_ms) {
-    // Se a frequência for 0, trata-se de um silêncio (pausa)
-    if (frequency == 0) {
-        sleep_ms(duration_ms);
-        return;
+    uint32_t interrupcoes = save_and_disable_interrupts();
+    uint8_t proxima = (fila_cabeca + 1) % BUZZER_FILA_TAMANHO;
+    if (proxima != fila_cauda) { // Com a fila cheia o tom é descartado
+        sequencia_t *sequencia = &fila[fila_cabeca];
+        sequencia->nota_avulsa.frequencia = frequency;
+        sequencia->nota_avulsa.duracao_ms = duration_ms;
+        sequencia->notas = &sequencia->nota_avulsa;
+        sequencia->quantidade = 1;
+        fila_cabeca = proxima;
+        iniciar_se_parado();
     }
+    restore_interrupts(interrupcoes);
+}
 
-    uint slice_num = pwm_gpio_to_slice_num(BUZZER_PIN);
-    gpio_set_function(BUZZER_PIN, GPIO_FUNC_PWM);
-    
-    // Configura o PWM para a frequência desejada.
-    // Freq = clock_do_sistema / (divisor * wrap)
-    // Usamos um divisor de 64.0f para um bom balanço entre precisão e alcance do 'wrap'.
-    float div = 64.0f;
-    uint32_t clock = clock_get_hz(clk_sys); // Frequência do clock do sistema (ex: 125MHz)
-    uint32_t wrap = (uint32_t)(clock / (div * frequency)); // Valor de wrap para a frequência desejada
-
-    pwm_set_clkdiv(slice_num, div);
-    pwm_set_wrap(slice_num, wrap);
-    pwm_set_chan_level(slice_num, pwm_gpio_to_channel(BUZZER_PIN), wrap / 2); // 50% duty cycle
-    pwm_set_enabled(slice_num, true);
-
-    sleep_ms(duration_ms); // **Bloqueante:** Pausa a execução pela duração do tom
-    
-    buzzer_stop_beep(); // Para o tom ao final da duração
+/**
+ * @brief Enfileira uma sequência de notas e retorna imediatamente.
+ * A tabela é referenciada, não copiada: deve ser constante (flash) ou permanecer válida.
+ */
+bool buzzer_tocar_sequencia(const buzzer_nota_t *notas, uint8_t quantidade) {
+    bool aceita = false;
+    uint32_t interrupcoes = save_and_disable_interrupts();
+    uint8_t proxima = (fila_cabeca + 1) % BUZZER_FILA_TAMANHO;
+    if (proxima != fila_cauda) {
+        fila[fila_cabeca].notas = notas;
+        fila[fila_cabeca].quantidade = quantidade;
+        fila_cabeca = proxima;
+        iniciar_se_parado();
+        aceita = true;
+    }
+    restore_interrupts(interrupcoes);
+    return aceita;
 }
 
 /**
- * @brief Toca uma melodia curta de sucesso.
- * Bloqueante: a execução é pausada durante a melodia.
+ * @brief Toca uma melodia curta de sucesso (não-bloqueante).
  */
 void buzzer_tocar_melodia_sucesso() {
-    buzzer_play_tone(NOTE_C5, 100);
-    buzzer_play_tone(NOTE_E5, 100);
-    buzzer_play_tone(NOTE_G5, 120);
+    buzzer_tocar_sequencia(MELODIA_SUCESSO, count_of(MELODIA_SUCESSO));
 }
 
 /**
- * @brief Toca uma melodia curta de erro/falha.
- * Bloqueante: a execução é pausada durante a melodia.
+ * @brief Toca uma melodia curta de erro/falha (não-bloqueante).
  */
 void buzzer_tocar_melodia_erro() {
-    buzzer_play_tone(NOTE_DS3, 200);
-    buzzer_play_tone(NOTE_C3, 300);
+    buzzer_tocar_sequencia(MELODIA_ERRO, count_of(MELODIA_ERRO));
+}
+
+/**
+ * @brief Reproduz amostras pelo PWM, com o DMA atualizando o nível a cada período de amostragem.
+ * A portadora do PWM (clock / 256) fica muito acima da faixa audível; o nível médio segue as amostras.
+ */
+bool buzzer_tocar_amostras(const uint16_t *amostras, uint32_t quantidade, uint32_t taxa_hz) {
+    uint32_t clock = clock_get_hz(clk_sys);
+    // O temporizador de DMA divide o clock por uma fração X/Y de 16 bits (aqui X = 1)
+    if (quantidade == 0 || taxa_hz == 0 || clock / taxa_hz > 0xFFFF) {
+        return false;
+    }
+
+    uint32_t interrupcoes = save_and_disable_interrupts();
+    cancelar_sequenciador();
+    silenciar();
+
+    if (canal_pcm < 0) {
+        canal_pcm = dma_claim_unused_channel(true);
+        temporizador_pcm = dma_claim_unused_timer(true);
+    }
+    dma_timer_set_fraction(temporizador_pcm, 1, (uint16_t)(clock / taxa_hz));
+
+    uint slice_num = pwm_gpio_to_slice_num(BUZZER_PIN);
+    gpio_set_function(BUZZER_PIN, GPIO_FUNC_PWM);
+    pwm_set_clkdiv_int_frac(slice_num, 1, 0);
+    pwm_set_wrap(slice_num, BUZZER_AMOSTRA_MAXIMA);
+    pwm_set_chan_level(slice_num, pwm_gpio_to_channel(BUZZER_PIN), 0);
+    pwm_set_enabled(slice_num, true);
+
+    // Escritas de 16 bits são replicadas nas duas metades de CC: os dois canais do slice recebem o nível
+    dma_channel_config config = dma_channel_get_default_config(canal_pcm);
+    channel_config_set_transfer_data_size(&config, DMA_SIZE_16);
+    channel_config_set_read_increment(&config, true);
+    channel_config_set_write_increment(&config, false);
+    channel_config_set_dreq(&config, dma_get_timer_dreq(temporizador_pcm));
+    dma_channel_configure(canal_pcm, &config, &pwm_hw->slice[slice_num].cc, amostras, quantidade, true);
+
+    // Silencia ao fim das amostras
+    alarme = add_alarm_in_us(((uint64_t)quantidade * 1000000) / taxa_hz, fim_amostras_callback, NULL, true);
+    tocando = (alarme > 0);
+    restore_interrupts(interrupcoes);
+    return true;
+}
+
+/**
+ * @brief Indica se há algum som em reprodução ou na fila.
+ */
+bool buzzer_ocupado(void) {
+    return tocando;
 }
\ No newline at end of file
@@ -2,16 +2,29 @@
  * @file buzzer.h
  * @brief Arquivo de cabeçalho para o driver do buzzer passivo.
  * Declara funções para inicialização e controle do buzzer,
- * permitindo a geração de tons e melodias.
+ * permitindo a geração de tons e melodias sem bloquear o chamador.
  */
 
 #ifndef BUZZER_H
 #define BUZZER_H
 
-#include "pico/stdlib.h"    // Para tipos básicos, sleep_ms
+#include "pico/stdlib.h"    // Para tipos básicos e alarmes
 #include "hardware/pwm.h"   // Para controle PWM
 #include "configura_geral.h" // Para acessar BUZZER_PIN (localização do pino do buzzer)
 
+// --- Parâmetros do Sequenciador ---
+#define BUZZER_FILA_TAMANHO 8       // Tons/melodias aguardando reprodução
+#define BUZZER_AMOSTRA_MAXIMA 255   // Nível máximo das amostras de buzzer_tocar_amostras (wrap do PWM)
+
+/**
+ * @struct buzzer_nota_t
+ * @brief Uma nota de uma melodia.
+ */
+typedef struct {
+    uint16_t frequencia;  ///< Frequência em Hz (0 para pausa).
+    uint16_t duracao_ms;  ///< Duração em milissegundos.
+} buzzer_nota_t;
+
 
 // --- Funções de Controle Básico do Buzzer (Não-Bloqueantes) ---
 
@@ -23,38 +36,60 @@ void buzzer_init();
 
 /**
  * @brief Inicia a emissão de um bipe contínuo com tom fixo (aprox. 1kHz).
- * Não-bloqueante. Deve ser parado com buzzer_stop_beep().
+ * Não-bloqueante. Interrompe o que estiver tocando. Deve ser parado com buzzer_stop_beep().
  */
 void buzzer_start_beep();
 
 /**
- * @brief Para a emissão do bipe contínuo e desliga o buzzer.
+ * @brief Para qualquer som em reprodução, descarta a fila e desliga o buzzer.
  * Não-bloqueante.
  */
 void buzzer_stop_beep();
 
 
-// --- Funções de Reprodução de Tons e Melodias (Bloqueantes) ---
+// --- Funções de Reprodução de Tons e Melodias (Não-Bloqueantes) ---
+// As notas são enfileiradas e tocadas em sequência; a troca de nota ocorre no
+// callback de um alarme de hardware, então as chamadas retornam imediatamente.
 
 /**
- * @brief Toca um tom com frequência e duração específicas.
- * Bloqueante: pausa a execução durante a duração do tom.
+ * @brief Enfileira um tom com frequência e duração específicas.
  * @param frequency A frequência do tom em Hz (0 para silêncio/pausa).
  * @param duration_ms A duração do tom em milissegundos.
  */
 void buzzer_play_tone(uint16_t frequency, uint16_t duration_ms);
 
 /**
- * @brief Toca uma melodia curta de sucesso.
- * Bloqueante: a execução é pausada durante a melodia.
+ * @brief Enfileira uma sequência de notas.
+ * @param notas Tabela de notas; é referenciada, não copiada (use tabelas constantes).
+ * @param quantidade Número de notas da tabela.
+ * @return false se a fila estiver cheia.
+ */
+bool buzzer_tocar_sequencia(const buzzer_nota_t *notas, uint8_t quantidade);
+
+/**
+ * @brief Enfileira a melodia curta de sucesso.
  */
 void buzzer_tocar_melodia_sucesso(void);
 
 /**
- * @brief Toca uma melodia curta de erro/falha.
- * Bloqueante: a execução é pausada durante a melodia.
+ * @brief Enfileira a melodia curta de erro/falha.
  */
 void buzzer_tocar_melodia_erro(void);
 
+/**
+ * @brief Reproduz amostras (sons mais ricos que tons puros) via PWM alimentado por DMA.
+ * Interrompe o que estiver tocando; notas enfileiradas depois seguem ao fim das amostras.
+ * @param amostras Níveis de 0 a BUZZER_AMOSTRA_MAXIMA; devem permanecer válidos durante a reprodução.
+ * @param quantidade Número de amostras.
+ * @param taxa_hz Taxa de amostragem (mínimo de clock_do_sistema / 65535, ~1.9kHz a 125MHz).
+ * @return false se os parâmetros forem inválidos.
+ */
+bool buzzer_tocar_amostras(const uint16_t *amostras, uint32_t quantidade, uint32_t taxa_hz);
+
+/**
+ * @brief Indica se há algum som em reprodução ou na fila.
+ */
+bool buzzer_ocupado(void);
+
 
 #endif // BUZZER_H
\ No newline at end of file
@@ -0,0 +1,164 @@
+/**
+ * @file classificador.c
+ * @brief Implementação do classificador de cartões por cromaticidade.
+ *
+ * Uma amostra custa duas divisões inteiras (o RP2040 tem divisor em hardware) e, por
+ * cartão, três diferenças elevadas ao quadrado; nenhuma operação em ponto flutuante.
+ */
+
+#include "classificador.h"
+#include <string.h>
+
+
+// --- Funções Auxiliares Estáticas ---
+
+static uint32_t distancia2(const cromaticidade_t *a, const cromaticidade_t *b) {
+    int32_t dr = (int32_t)a->r - b->r;
+    int32_t dg = (int32_t)a->g - b->g;
+    int32_t db = (int32_t)a->b - b->b;
+    return (uint32_t)(dr * dr + dg * dg + db * db);
+}
+
+/**
+ * @brief Margem relativa (0-100) entre uma distância e um limite: 100 no centro, 0 no limite.
+ */
+static uint8_t margem(uint32_t distancia, uint32_t limite) {
+    if (distancia >= limite) {
+        return 0;
+    }
+    return (uint8_t)(((uint64_t)(limite - distancia) * 100) / limite);
+}
+
+
+// --- Implementação das Funções Públicas ---
+
+bool classificador_cromaticidade(uint16_t red, uint16_t green, uint16_t blue, cromaticidade_t *saida) {
+    uint32_t soma = (uint32_t)red + green + blue;
+    if (soma == 0) {
+        return false;
+    }
+    saida->r = (uint16_t)(((uint32_t)red * CLASSIFICADOR_ESCALA + soma / 2) / soma);
+    saida->g = (uint16_t)(((uint32_t)green * CLASSIFICADOR_ESCALA + soma / 2) / soma);
+    if (saida->r + saida->g > CLASSIFICADOR_ESCALA) {
+        saida->g = CLASSIFICADOR_ESCALA - saida->r; // Arredondamento dos dois para cima
+    }
+    saida->b = CLASSIFICADOR_ESCALA - saida->r - saida->g;
+    return true;
+}
+
+uint8_t classificador_amostra(const classificador_tabela_t *tabela, uint16_t clear, uint16_t red,
+                              uint16_t green, uint16_t blue, uint8_t *confianca) {
+    *confianca = 0;
+    cromaticidade_t amostra;
+    if (clear < tabela->limiar_clear || tabela->quantidade == 0 ||
+        !classificador_cromaticidade(red, green, blue, &amostra)) {
+        return 0;
+    }
+
+    // Mais próximo e segundo mais próximo
+    uint32_t melhor = UINT32_MAX, segundo = UINT32_MAX;
+    uint8_t indice = 0;
+    for (uint8_t i = 0; i < tabela->quantidade; i++) {
+        uint32_t d = distancia2(&amostra, &tabela->centroides[i].centro);
+        if (d < melhor) {
+            segundo = melhor;
+            melhor = d;
+            indice = i;
+        } else if (d < segundo) {
+            segundo = d;
+        }
+    }
+
+    uint32_t raio2 = (uint32_t)tabela->raio * tabela->raio;
+    if (melhor > raio2) {
+        return 0;
+    }
+    // Confiança: a menor das margens para o raio e para o segundo cartão
+    uint8_t pelo_raio = margem(melhor, raio2);
+    uint8_t pelo_segundo = (segundo == UINT32_MAX) ? 100 : margem(melhor, segundo);
+    *confianca = pelo_raio < pelo_segundo ? pelo_raio : pelo_segundo;
+    return tabela->centroides[indice].cartao;
+}
+
+void classificador_reiniciar(classificador_janela_t *janela) {
+    memset(janela, 0, sizeof(*janela));
+}
+
+bool classificador_adicionar(const classificador_tabela_t *tabela, classificador_janela_t *janela,
+                             uint16_t clear, uint16_t red, uint16_t green, uint16_t blue,
+                             classificador_resultado_t *resultado) {
+    uint8_t confianca;
+    uint8_t cartao = classificador_amostra(tabela, clear, red, green, blue, &confianca);
+    janela->amostras++;
+    if (cartao != 0 && confianca >= CLASSIFICADOR_CONFIANCA_MINIMA) {
+        for (uint8_t i = 0; i < tabela->quantidade; i++) {
+            if (tabela->centroides[i].cartao == cartao) {
+                janela->pontos[i] += confianca;
+                break;
+            }
+        }
+    }
+
+    // Líder e total dos demais
+    uint8_t lider = 0;
+    uint32_t outros = 0;
+    for (uint8_t i = 1; i < tabela->quantidade; i++) {
+        if (janela->pontos[i] > janela->pontos[lider]) {
+            lider = i;
+        }
+    }
+    for (uint8_t i = 0; i < tabela->quantidade; i++) {
+        if (i != lider) {
+            outros += janela->pontos[i];
+        }
+    }
+
+    // Decide cedo quando o líder tem os pontos e ao menos o dobro dos demais somados;
+    // com a janela cheia, decide pelo líder apenas se ele chegou à metade dos pontos
+    bool decidido = janela->pontos[lider] >= CLASSIFICADOR_PONTOS_DECISAO && janela->pontos[lider] >= 2 * outros;
+    bool cheia = janela->amostras >= CLASSIFICADOR_JANELA;
+    if (!decidido && !cheia) {
+        return false;
+    }
+    if (!decidido && janela->pontos[lider] < CLASSIFICADOR_PONTOS_DECISAO / 2) {
+        resultado->cartao = 0;
+        resultado->confianca = 0;
+    } else {
+        resultado->cartao = tabela->centroides[lider].cartao;
+        resultado->confianca = (uint8_t)(janela->pontos[lider] / janela->amostras);
+    }
+    resultado->amostras = janela->amostras;
+    classificador_reiniciar(janela);
+    return true;
+}
+
+void classificador_calibracao_iniciar(classificador_calibracao_t *calibracao) {
+    memset(calibracao, 0, sizeof(*calibracao));
+}
+
+bool classificador_calibracao_adicionar(classificador_calibracao_t *calibracao, uint16_t red,
+                                        uint16_t green, uint16_t blue) {
+    cromaticidade_t amostra;
+    if (calibracao->amostras < CLASSIFICADOR_AMOSTRAS_CALIBRACAO &&
+        classificador_cromaticidade(red, green, blue, &amostra)) {
+        calibracao->soma_r += amostra.r;
+        calibracao->soma_g += amostra.g;
+        calibracao->soma_b += amostra.b;
+        calibracao->amostras++;
+    }
+    return calibracao->amostras >= CLASSIFICADOR_AMOSTRAS_CALIBRACAO;
+}
+
+bool classificador_calibracao_resultado(const classificador_calibracao_t *calibracao, cromaticidade_t *centro) {
+    if (calibracao->amostras == 0) {
+        return false;
+    }
+    uint32_t metade = calibracao->amostras / 2;
+    centro->r = (uint16_t)((calibracao->soma_r + metade) / calibracao->amostras);
+    centro->g = (uint16_t)((calibracao->soma_g + metade) / calibracao->amostras);
+    if (centro->r + centro->g > CLASSIFICADOR_ESCALA) {
+        centro->g = CLASSIFICADOR_ESCALA - centro->r;
+    }
+    centro->b = CLASSIFICADOR_ESCALA - centro->r - centro->g;
+    return true;
+}
@@ -0,0 +1,126 @@
+/**
+ * @file classificador.h
+ * @brief Classificação do cartão por cromaticidade, em aritmética inteira.
+ * Cada amostra RGB é normalizada para r+g+b = CLASSIFICADOR_ESCALA (independente do
+ * brilho) e comparada com o centróide calibrado de cada cartão. As amostras de uma
+ * aproximação votam numa janela curta, ponderadas pela confiança: a decisão sai assim
+ * que um cartão acumula pontos suficientes, sem esperar a janela inteira.
+ * Não depende do SDK, para rodar também no benchmark do host (scripts/benchmark-classificador.c).
+ */
+
+#ifndef CLASSIFICADOR_H
+#define CLASSIFICADOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// --- Parâmetros ---
+#define CLASSIFICADOR_ESCALA 1024           // Soma das componentes normalizadas
+#define CLASSIFICADOR_MAXIMO_CARTOES 8
+#define CLASSIFICADOR_JANELA 5              // Amostras de uma aproximação antes de desistir
+#define CLASSIFICADOR_CONFIANCA_MINIMA 30   // Amostras abaixo disso (0-100) não votam
+#define CLASSIFICADOR_PONTOS_DECISAO 160    // Soma das confianças que encerra a votação
+#define CLASSIFICADOR_AMOSTRAS_CALIBRACAO 8
+
+/**
+ * @struct cromaticidade_t
+ * @brief Componentes normalizadas (r + g + b = CLASSIFICADOR_ESCALA).
+ */
+typedef struct {
+    uint16_t r, g, b;
+} cromaticidade_t;
+
+/**
+ * @struct centroide_t
+ * @brief Cromaticidade típica de um cartão.
+ */
+typedef struct {
+    uint8_t cartao;             ///< Identidade devolvida na decisão (enum CorDetectada).
+    cromaticidade_t centro;
+} centroide_t;
+
+/**
+ * @struct classificador_tabela_t
+ * @brief Cartões conhecidos e limites de aceitação.
+ */
+typedef struct {
+    const centroide_t *centroides;
+    uint8_t quantidade;         ///< Até CLASSIFICADOR_MAXIMO_CARTOES.
+    uint16_t raio;              ///< Maior distância ao centróide aceita, na escala da cromaticidade.
+    uint16_t limiar_clear;      ///< Abaixo disso não há cartão diante do sensor.
+} classificador_tabela_t;
+
+/**
+ * @struct classificador_janela_t
+ * @brief Votos da aproximação em andamento.
+ */
+typedef struct {
+    uint16_t pontos[CLASSIFICADOR_MAXIMO_CARTOES];  ///< Confiança acumulada por posição da tabela.
+    uint8_t amostras;
+} classificador_janela_t;
+
+/**
+ * @struct classificador_resultado_t
+ * @brief Decisão de uma aproximação.
+ */
+typedef struct {
+    uint8_t cartao;             ///< 0 (nenhum) se nenhum cartão atingiu os pontos necessários.
+    uint8_t confianca;          ///< Confiança média do cartão decidido por amostra (0-100).
+    uint8_t amostras;           ///< Amostras usadas na decisão.
+} classificador_resultado_t;
+
+/**
+ * @struct classificador_calibracao_t
+ * @brief Acumulador da calibração de um cartão.
+ */
+typedef struct {
+    uint32_t soma_r, soma_g, soma_b;
+    uint8_t amostras;
+} classificador_calibracao_t;
+
+/**
+ * @brief Normaliza uma leitura RGB.
+ * @return false se as três componentes são zero.
+ */
+bool classificador_cromaticidade(uint16_t red, uint16_t green, uint16_t blue, cromaticidade_t *saida);
+
+/**
+ * @brief Classifica uma única amostra.
+ * @param confianca Saída: 0 a 100 (margem para o segundo centróide e para o raio).
+ * @return Cartão mais próximo, ou 0 se a amostra está escura ou fora do raio de todos.
+ */
+uint8_t classificador_amostra(const classificador_tabela_t *tabela, uint16_t clear, uint16_t red,
+                              uint16_t green, uint16_t blue, uint8_t *confianca);
+
+/**
+ * @brief Descarta os votos (início de uma nova aproximação).
+ */
+void classificador_reiniciar(classificador_janela_t *janela);
+
+/**
+ * @brief Acrescenta uma amostra à votação.
+ * @return true quando há decisão em 'resultado' (cartão ou nenhum); a janela é reiniciada.
+ */
+bool classificador_adicionar(const classificador_tabela_t *tabela, classificador_janela_t *janela,
+                             uint16_t clear, uint16_t red, uint16_t green, uint16_t blue,
+                             classificador_resultado_t *resultado);
+
+/**
+ * @brief Zera o acumulador da calibração.
+ */
+void classificador_calibracao_iniciar(classificador_calibracao_t *calibracao);
+
+/**
+ * @brief Acumula uma amostra do cartão sendo calibrado.
+ * @return true quando CLASSIFICADOR_AMOSTRAS_CALIBRACAO amostras foram acumuladas.
+ */
+bool classificador_calibracao_adicionar(classificador_calibracao_t *calibracao, uint16_t red,
+                                        uint16_t green, uint16_t blue);
+
+/**
+ * @brief Centróide das amostras acumuladas (média das componentes normalizadas).
+ * @return false se nenhuma amostra foi acumulada.
+ */
+bool classificador_calibracao_resultado(const classificador_calibracao_t *calibracao, cromaticidade_t *centro);
+
+#endif // CLASSIFICADOR_H
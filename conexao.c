@@ -0,0 +1,244 @@
+/**
+ * @file conexao.c
+ * @brief Implementação do gerenciador assíncrono da conexão Wi-Fi e MQTT (Núcleo 1).
+ */
+
+#include "conexao.h"
+#include "configura_geral.h"
+#include "mqtt_lwip.h"
+#include "pico/cyw43_arch.h"
+#include "pico/rand.h"
+#include <stdio.h>
+#include <string.h>
+
+
+// --- Variáveis Estáticas ---
+
+static conexao_estado_t estado = CONEXAO_AGUARDANDO;
+static bool chip_iniciado = false;
+static uint32_t falhas_seguidas = 0;        // Expoente da espera; zera ao ficar online
+static uint64_t proxima_tentativa_us = 0;
+static uint64_t inicio_queda_us = 0;        // Boot ou momento da queda
+static uint64_t inicio_etapa_us = 0;
+static bool relatorio_pendente = false;
+
+// Último ponto de acesso em que a associação deu certo
+static uint8_t bssid[6];
+static uint32_t canal = 0;
+static bool ponto_em_cache = false;
+static bool tentativa_com_cache = false;
+
+static conexao_estatisticas_t estatisticas;
+
+
+// --- Funções Auxiliares Estáticas ---
+
+static uint32_t ms_desde(uint64_t inicio_us) {
+    return (uint32_t)((time_us_64() - inicio_us) / 1000);
+}
+
+/**
+ * @brief Agenda a próxima tentativa: espera exponencial com metade fixa e metade
+ * aleatória, para que várias fechaduras derrubadas juntas não voltem juntas.
+ */
+static void agendar_nova_tentativa(void) {
+    uint32_t espera_ms = CONEXAO_ESPERA_MAXIMA_MS;
+    if (falhas_seguidas < 16 && ((uint32_t)CONEXAO_ESPERA_INICIAL_MS << falhas_seguidas) < espera_ms) {
+        espera_ms = (uint32_t)CONEXAO_ESPERA_INICIAL_MS << falhas_seguidas;
+    }
+    falhas_seguidas++;
+    espera_ms = espera_ms / 2 + get_rand_32() % (espera_ms / 2 + 1);
+    proxima_tentativa_us = time_us_64() + (uint64_t)espera_ms * 1000;
+    estado = CONEXAO_AGUARDANDO;
+}
+
+/**
+ * @brief Guarda o BSSID e o canal do ponto de acesso recém-associado.
+ */
+static void guardar_ponto_de_acesso(void) {
+    uint8_t resposta[4] = {0};
+    if (cyw43_wifi_get_bssid(&cyw43_state, bssid) != 0 ||
+        cyw43_ioctl(&cyw43_state, CYW43_IOCTL_GET_CHANNEL, sizeof(resposta), resposta, CYW43_ITF_STA) != 0) {
+        ponto_em_cache = false;
+        return;
+    }
+    canal = resposta[0] | (resposta[1] << 8) | (resposta[2] << 16) | ((uint32_t)resposta[3] << 24);
+    ponto_em_cache = canal != 0;
+}
+
+static void falhar_wifi(void) {
+    cyw43_wifi_leave(&cyw43_state, CYW43_ITF_STA);
+    if (tentativa_com_cache) {
+        // O ponto de acesso pode ter mudado de canal ou saído do ar: volta a varrer
+        ponto_em_cache = false;
+    }
+    agendar_nova_tentativa();
+}
+
+static void iniciar_mqtt(void) {
+    inicio_etapa_us = time_us_64();
+    if (!iniciar_mqtt_cliente()) {
+        agendar_nova_tentativa();
+        return;
+    }
+    estado = CONEXAO_CONECTANDO_MQTT;
+}
+
+static void iniciar_associacao(void) {
+    inicio_etapa_us = time_us_64();
+    tentativa_com_cache = ponto_em_cache;
+    int erro = cyw43_wifi_join(&cyw43_state, strlen(WIFI_SSID), (const uint8_t *)WIFI_SSID,
+                               strlen(WIFI_PASS), (const uint8_t *)WIFI_PASS, CYW43_AUTH_WPA2_AES_PSK,
+                               tentativa_com_cache ? bssid : NULL,
+                               tentativa_com_cache ? canal : CYW43_CHANNEL_NONE);
+    if (erro != 0) {
+        falhar_wifi();
+        return;
+    }
+    estado = CONEXAO_ASSOCIANDO;
+}
+
+static void iniciar_tentativa(void) {
+    estatisticas.tentativas++;
+    if (!chip_iniciado) {
+        if (cyw43_arch_init() != 0) {
+            printf("Conexao: falha ao iniciar o chip Wi-Fi\n");
+            agendar_nova_tentativa();
+            return;
+        }
+        cyw43_arch_enable_sta_mode();
+        chip_iniciado = true;
+    }
+    if (cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA) == CYW43_LINK_UP) {
+        tentativa_com_cache = false;
+        iniciar_mqtt(); // Só o broker caiu: o Wi-Fi continua associado
+    } else {
+        iniciar_associacao();
+    }
+}
+
+static void ficar_online(void) {
+    estatisticas.mqtt_ms = ms_desde(inicio_etapa_us);
+    estatisticas.total_ms = ms_desde(inicio_queda_us);
+    estatisticas.conexoes++;
+    falhas_seguidas = 0;
+    relatorio_pendente = true;
+    estado = CONEXAO_ONLINE;
+    printf("Conexao: online em %lu ms (Wi-Fi %lu, DHCP %lu, MQTT %lu), %lu tentativas, BSSID em cache: %s\n",
+           (unsigned long)estatisticas.total_ms, (unsigned long)estatisticas.associacao_ms,
+           (unsigned long)estatisticas.dhcp_ms, (unsigned long)estatisticas.mqtt_ms,
+           (unsigned long)estatisticas.tentativas, tentativa_com_cache ? "sim" : "nao");
+}
+
+/**
+ * @brief Registra o início de uma queda e tenta de novo imediatamente
+ * (a espera só cresce se a primeira tentativa também falhar).
+ */
+static void registrar_queda(void) {
+    inicio_queda_us = time_us_64();
+    estatisticas.tentativas = 0;
+    estatisticas.associacao_ms = 0;
+    estatisticas.dhcp_ms = 0;
+    proxima_tentativa_us = inicio_queda_us;
+    estado = CONEXAO_AGUARDANDO;
+}
+
+/**
+ * @brief Publica os tempos da última conexão (retido, para o dashboard acompanhar o tempo até ficar online).
+ */
+static void publicar_relatorio(void) {
+    char payload[160];
+    int tamanho = snprintf(payload, sizeof(payload),
+                           "{\"total_ms\":%lu,\"wifi_ms\":%lu,\"dhcp_ms\":%lu,\"mqtt_ms\":%lu,"
+                           "\"tentativas\":%lu,\"conexoes\":%lu,\"bssid_cache\":%s}",
+                           (unsigned long)estatisticas.total_ms, (unsigned long)estatisticas.associacao_ms,
+                           (unsigned long)estatisticas.dhcp_ms, (unsigned long)estatisticas.mqtt_ms,
+                           (unsigned long)estatisticas.tentativas, (unsigned long)estatisticas.conexoes,
+                           tentativa_com_cache ? "true" : "false");
+    if (tamanho < 0 || (size_t)tamanho >= sizeof(payload)) {
+        relatorio_pendente = false;
+        return;
+    }
+    if (publicar_topico_mqtt(TOPICO_ID_CONEXAO, payload, (u16_t)tamanho, true, NULL, NULL)) {
+        relatorio_pendente = false;
+    }
+}
+
+
+// --- Implementação das Funções Públicas ---
+
+void conexao_iniciar(void) {
+    inicio_queda_us = 0; // A primeira conexão é medida a partir do reset
+    proxima_tentativa_us = time_us_64();
+    estado = CONEXAO_AGUARDANDO;
+}
+
+void conexao_processar(void) {
+    int link = chip_iniciado ? cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA) : CYW43_LINK_DOWN;
+
+    switch (estado) {
+        case CONEXAO_AGUARDANDO:
+            if (time_us_64() >= proxima_tentativa_us) {
+                iniciar_tentativa();
+            }
+            break;
+
+        case CONEXAO_ASSOCIANDO:
+            if (link == CYW43_LINK_NOIP || link == CYW43_LINK_UP) {
+                estatisticas.associacao_ms = ms_desde(inicio_etapa_us);
+                guardar_ponto_de_acesso();
+                inicio_etapa_us = time_us_64();
+                estado = CONEXAO_AGUARDANDO_IP;
+            } else if (link < 0 || ms_desde(inicio_etapa_us) >= CONEXAO_TIMEOUT_ASSOCIACAO_MS) {
+                falhar_wifi();
+            }
+            break;
+
+        case CONEXAO_AGUARDANDO_IP:
+            if (link == CYW43_LINK_UP) {
+                estatisticas.dhcp_ms = ms_desde(inicio_etapa_us);
+                estatisticas.endereco_ip = ip4_addr_get_u32(netif_ip4_addr(&cyw43_state.netif[CYW43_ITF_STA]));
+                iniciar_mqtt();
+            } else if (link != CYW43_LINK_NOIP || ms_desde(inicio_etapa_us) >= CONEXAO_TIMEOUT_DHCP_MS) {
+                falhar_wifi();
+            }
+            break;
+
+        case CONEXAO_CONECTANDO_MQTT:
+            if (mqtt_obter_estado() == MQTT_ESTADO_CONECTADO) {
+                ficar_online();
+            } else if (link != CYW43_LINK_UP) {
+                mqtt_desconectar();
+                falhar_wifi();
+            } else if (mqtt_obter_estado() == MQTT_ESTADO_DESCONECTADO ||
+                       ms_desde(inicio_etapa_us) >= CONEXAO_TIMEOUT_MQTT_MS) {
+                mqtt_desconectar();
+                agendar_nova_tentativa();
+            }
+            break;
+
+        case CONEXAO_ONLINE:
+            if (link != CYW43_LINK_UP) {
+                estatisticas.quedas_wifi++;
+                mqtt_desconectar();
+                registrar_queda();
+            } else if (mqtt_obter_estado() != MQTT_ESTADO_CONECTADO) {
+                estatisticas.quedas_mqtt++;
+                registrar_queda();
+            } else if (relatorio_pendente && mqtt_pode_publicar()) {
+                publicar_relatorio();
+            }
+            break;
+    }
+}
+
+bool conexao_online(void) {
+    return estado == CONEXAO_ONLINE;
+}
+
+void conexao_obter_estatisticas(conexao_estatisticas_t *saida) {
+    *saida = estatisticas;
+    saida->estado = estado;
+    saida->bssid_em_cache = ponto_em_cache;
+    saida->canal = (uint8_t)canal;
+}
@@ -0,0 +1,78 @@
+/**
+ * @file conexao.h
+ * @brief Gerenciador assíncrono da conexão Wi-Fi e MQTT (Núcleo 1).
+ * Máquina de estados não-bloqueante, avançada a cada volta do loop do Núcleo 1:
+ * associa ao ponto de acesso, aguarda o endereço IP, conecta ao broker e, após
+ * qualquer falha ou queda, tenta de novo com espera exponencial e variação aleatória.
+ * O BSSID e o canal do último ponto de acesso ficam em cache para que a reassociação
+ * dispense a varredura; a interface de rede nunca é desligada, então a concessão DHCP
+ * é reconfirmada (INIT-REBOOT) em vez de negociada do zero. Os tempos de cada conexão
+ * são publicados, retidos, em DEVICE_ID/conexao.
+ */
+
+#ifndef CONEXAO_H
+#define CONEXAO_H
+
+#include "pico/stdlib.h"
+
+// --- Parâmetros ---
+#define CONEXAO_TIMEOUT_ASSOCIACAO_MS 10000 // Associação (inclui varredura quando não há cache)
+#define CONEXAO_TIMEOUT_DHCP_MS 10000       // Do fim da associação até ter endereço IP
+#define CONEXAO_TIMEOUT_MQTT_MS 10000       // Do início da conexão TCP até o CONNACK
+#define CONEXAO_ESPERA_INICIAL_MS 500       // Primeira espera após uma falha
+#define CONEXAO_ESPERA_MAXIMA_MS 30000      // Teto da espera exponencial
+
+/**
+ * @brief Etapa atual do gerenciador.
+ */
+typedef enum {
+    CONEXAO_AGUARDANDO,         ///< Espera antes da próxima tentativa.
+    CONEXAO_ASSOCIANDO,         ///< Associação Wi-Fi em andamento.
+    CONEXAO_AGUARDANDO_IP,      ///< Associado, aguardando o DHCP.
+    CONEXAO_CONECTANDO_MQTT,    ///< Aguardando o CONNACK do broker.
+    CONEXAO_ONLINE
+} conexao_estado_t;
+
+/**
+ * @struct conexao_estatisticas_t
+ * @brief Estado e tempos da última conexão.
+ */
+typedef struct {
+    conexao_estado_t estado;
+    uint32_t tentativas;            ///< Tentativas desde a última vez online (ou desde o boot).
+    uint32_t conexoes;              ///< Vezes que ficou online.
+    uint32_t quedas_wifi;
+    uint32_t quedas_mqtt;
+    uint32_t associacao_ms;         ///< Última associação Wi-Fi.
+    uint32_t dhcp_ms;               ///< Última espera pelo endereço IP.
+    uint32_t mqtt_ms;               ///< Última espera pelo CONNACK.
+    uint32_t total_ms;              ///< Da queda (ou do boot) até ficar online.
+    uint32_t endereco_ip;           ///< Endereço da concessão DHCP atual (ordem de rede).
+    bool bssid_em_cache;            ///< A próxima associação usa o BSSID/canal conhecidos.
+    uint8_t canal;
+} conexao_estatisticas_t;
+
+/**
+ * @brief Agenda a primeira tentativa de conexão para já. O chip Wi-Fi só é iniciado
+ * nessa tentativa, dentro de conexao_processar (e de novo nas seguintes, se falhar).
+ * @note Chamar no Núcleo 1 antes do seu loop.
+ */
+void conexao_iniciar(void);
+
+/**
+ * @brief Avança a máquina de estados e publica o relatório da última conexão.
+ * Nunca bloqueia; chamar a cada volta do loop do Núcleo 1.
+ */
+void conexao_processar(void);
+
+/**
+ * @brief Informa se o Wi-Fi e a sessão MQTT estão de pé.
+ */
+bool conexao_online(void);
+
+/**
+ * @brief Copia o estado e os tempos das conexões.
+ */
+void conexao_obter_estatisticas(conexao_estatisticas_t *estatisticas);
+
+#endif // CONEXAO_H
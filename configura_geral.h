@@ -42,6 +42,11 @@
 
 #define PWM_MAX_DUTY 0xFFFF
 
+// Brilho global da matriz e do LED RGB (0-255, escala perceptual: aplicado antes da gama)
+#ifndef COR_BRILHO_PADRAO
+#define COR_BRILHO_PADRAO 255
+#endif
+
 // --- Rede e MQTT ---
 #ifndef DEVICE_ID
 #define DEVICE_ID "bitdoglab_02"
@@ -55,14 +60,67 @@
 #define MQTT_BROKER_PORT 1884
 #endif
 
+// Coalescencia das publicacoes (Nucleo 1)
+#ifndef MQTT_STATUS_ESPERA_MS
+#define MQTT_STATUS_ESPERA_MS 100   // Espera antes de publicar um status; trocas neste intervalo se fundem
+#endif
+
+#ifndef MQTT_LOTE_JANELA_MS
+#define MQTT_LOTE_JANELA_MS 1000    // Janela de agrupamento dos eventos de historico em uma publicacao
+#endif
+
+// Rajada de teste de vazao: N mensagens em DEVICE_ID/benchmark apos conectar (0 desativa)
+#ifndef MQTT_BENCHMARK_RAJADA
+#define MQTT_BENCHMARK_RAJADA 0
+#endif
+
+// Benchmark da tabela de credenciais no boot: latencia da verificacao com 3 a
+// CREDENCIAIS_MAXIMO cartoes (apaga a tabela; 0 desativa)
+#ifndef CREDENCIAIS_BENCHMARK
+#define CREDENCIAIS_BENCHMARK 0
+#endif
+
+// Benchmark do pipeline de cor no boot: ciclos por quadro do pulso e do fogo, antes
+// (ponto flutuante, rand) e depois (tabelas, xorshift) (0 desativa)
+#ifndef COR_BENCHMARK
+#define COR_BENCHMARK 0
+#endif
+
+// Imprime cada leitura do sensor como linha CSV (clear,red,green,blue), para gravar
+// tracos usados pelo benchmark do classificador (scripts/benchmark-classificador.c)
+#ifndef CLASSIFICADOR_REGISTRAR_AMOSTRAS
+#define CLASSIFICADOR_REGISTRAR_AMOSTRAS 0
+#endif
+
+// Perfil de ciclos dos trechos quentes (perfil.h): histogramas no serial e em
+// DEVICE_ID/diagnostico a cada heartbeat (0 remove toda a instrumentacao)
+#ifndef PERFIL_HABILITADO
+#define PERFIL_HABILITADO 0
+#endif
+
 // --- Tempos ---
 #define TEMPO_MSG_PADRAO_US 4000000 // 4.0 segundos
 
-#ifndef DEBOUNCE_INTERVALO_US
-#define DEBOUNCE_INTERVALO_US 150000 // 150ms
+// Cadência da varredura do teclado no PIO (até ~24ms). Uma mudança só vale depois de
+// repetida em duas varreduras seguidas: este é também o intervalo de debounce.
+#ifndef KEYPAD_PERIODO_VARREDURA_US
+#define KEYPAD_PERIODO_VARREDURA_US 10000 // 10ms
 #endif
 
 // --- Delays de animacao da matriz ---
+#ifndef ERRO_FRAME_DELAY_US
+#define ERRO_FRAME_DELAY_US 200000 // us por fase (ligado/desligado) da animacao de erro
+#endif
+
+#ifndef TIMEOUT_FRAME_DELAY_US
+#define TIMEOUT_FRAME_DELAY_US 200000 // us por fase (ligado/desligado) da animacao de timeout
+#endif
+
+#ifndef FECHANDO_FRAME_DELAY_US
+#define FECHANDO_FRAME_DELAY_US 400000     // us da primeira fase da animacao de fechamento
+#define FECHANDO_INTERVALO_FINAL_US 150000 // us da segunda fase
+#endif
+
 #ifndef SUCESSO_FRAME_DELAY_MS
 #define SUCESSO_FRAME_DELAY_MS 120 // ms entre frames da animacao de sucesso
 #endif
@@ -73,15 +131,28 @@
 
 // --- Topicos MQTT ---
 #define TOPICO_BASE_COMANDO_ESTADO "comando/estado"
+#define TOPICO_BASE_COMANDO_CONFIG "comando/config"
 #define TOPICO_STATUS "status"
 #define TOPICO_HISTORICO "historico"
 #define TOPICO_HEARTBEAT "heartbeat"
+#define TOPICO_CONEXAO "conexao"
+#define TOPICO_DIAGNOSTICO "diagnostico"
+
+// Topicos de publicacao (DEVICE_ID/<base>), montados uma unica vez na conexao
+enum TopicoPublicacao {
+    TOPICO_ID_STATUS,
+    TOPICO_ID_HISTORICO,
+    TOPICO_ID_HEARTBEAT,
+    TOPICO_ID_CONEXAO,
+    TOPICO_ID_DIAGNOSTICO,
+    TOPICO_ID_QUANTIDADE
+};
 
 // --- Comandos FIFO inter-core ---
-#define FIFO_CMD_WIFI_CONECTADO 0xFFFE
 #define FIFO_CMD_PUBLICAR_MQTT 0xADD0
 #define FIFO_CMD_MUDAR_ESTADO 0xE5A0
 #define FIFO_CMD_MQTT_CONECTADO 0xBEEF
+#define FIFO_CMD_CONFIGURAR 0xC0F0      // Chave (enum ChaveConfiguracao) nos 4 bits baixos do comando
 
 // --- Estados e tipos ---
 enum ModoOperacao {
@@ -90,48 +161,58 @@ enum ModoOperacao {
     MODO_ABERTO,
     MODO_ADMIN_AGUARDANDO_CARTAO,
     MODO_ADMIN_AGUARDANDO_NOVA_SENHA,
+    MODO_ADMIN_AJUSTE_TEMPO,
+    MODO_ADMIN_CALIBRACAO,
     MODO_MSG_TIMEOUT,
     MODO_MSG_ACESSO_NEGADO,
     MODO_ADMIN_MSG_SUCESSO,
     MODO_ADMIN_MSG_ERRO_FORMATO,
     MODO_ADMIN_MSG_CANCELADO,
-    MODO_EMERGENCIA_INCENDIO
+    MODO_EMERGENCIA_INCENDIO,
+    MODO_QUANTIDADE
 };
 
 enum CorDetectada {
     COR_NENHUMA,
     COR_VERDE,
     COR_VERMELHA,
-    COR_AZUL
+    COR_AZUL,
+    COR_AMARELA,
+    COR_ROXA,
+    COR_QUANTIDADE
 };
 
-enum WifiStatus {
-    WIFI_STATUS_FAIL,
-    WIFI_STATUS_SUCCESS
-};
+// --- Mensagens MQTT: X(identificador, topico, formato do payload) ---
+// Gera o enum abaixo e a tabela constante do mqtt_lwip.c. Um "%s" no formato
+// recebe o nome da cor do evento e um "%lu" depois dele, o argumento do evento
+// ("%.0s" consome a cor sem imprimi-la).
+#define MQTT_MENSAGENS(X) \
+    X(MSG_STATUS_AGUARDANDO_CARTAO,    TOPICO_ID_STATUS,    "Aguardando cartao") \
+    X(MSG_STATUS_CARTAO_LIDO,          TOPICO_ID_STATUS,    "Cartao %s lido (confianca %lu%%)") \
+    X(MSG_STATUS_AGUARDANDO_SENHA,     TOPICO_ID_STATUS,    "Aguardando senha") \
+    X(MSG_STATUS_SISTEMA_ABERTO,       TOPICO_ID_STATUS,    "Sistema Aberto") \
+    X(MSG_STATUS_SISTEMA_FECHADO,      TOPICO_ID_STATUS,    "Sistema Fechado") \
+    X(MSG_STATUS_MODO_ADMIN,           TOPICO_ID_STATUS,    "Modo Administracao") \
+    X(MSG_LOG_ACESSO_OK,               TOPICO_ID_HISTORICO, "ACESSO LIBERADO: Cartao %s.") \
+    X(MSG_LOG_ACESSO_FALHA,            TOPICO_ID_HISTORICO, "FALHA: Senha incorreta para o Cartao %s.") \
+    X(MSG_LOG_EVENTO_TIMEOUT_SENHA,    TOPICO_ID_HISTORICO, "AVISO: Timeout para digitacao da senha.") \
+    X(MSG_LOG_EVENTO_AUTO_LOCK,        TOPICO_ID_HISTORICO, "EVENTO: Travamento automatico do sistema.") \
+    X(MSG_LOG_OPERACAO_CANCELADA,      TOPICO_ID_HISTORICO, "AVISO: Operacao cancelada pelo usuario.") \
+    X(MSG_LOG_ADMIN_INICIADO,          TOPICO_ID_HISTORICO, "ADMIN: Modo de alteracao de senha iniciado.") \
+    X(MSG_LOG_ADMIN_SENHA_ALTERADA,    TOPICO_ID_HISTORICO, "ADMIN: Senha para Cartao %s foi alterada.") \
+    X(MSG_LOG_CONFIG_ALTERADA,         TOPICO_ID_HISTORICO, "CONFIG: Parametro de operacao alterado.") \
+    X(MSG_LOG_CONFIG_RECUSADA,         TOPICO_ID_HISTORICO, "CONFIG: Alteracao recusada (parametro ou valor invalido).") \
+    X(MSG_LOG_CALIBRACAO_CONCLUIDA,    TOPICO_ID_HISTORICO, "ADMIN: Cartao %s calibrado.") \
+    X(MSG_LOG_EMERGENCIA_INCENDIO_ON,  TOPICO_ID_HISTORICO, "EMERGENCIA: Alarme de incendio ATIVADO.") \
+    X(MSG_LOG_EMERGENCIA_INCENDIO_OFF, TOPICO_ID_HISTORICO, "EMERGENCIA: Alarme de incendio desativado.") \
+    X(MSG_LOG_HEARTBEAT,               TOPICO_ID_HEARTBEAT, "ok") \
+    X(MSG_LOG_HEARTBEAT_BOOT,          TOPICO_ID_HEARTBEAT, "ok%.0s (pronto em %lu ms apos o boot)")
 
 enum MQTT_MSG_TYPE {
-    MSG_STATUS_AGUARDANDO_CARTAO,
-    MSG_STATUS_CARTAO_LIDO,
-    MSG_STATUS_AGUARDANDO_SENHA,
-    MSG_STATUS_SISTEMA_ABERTO,
-    MSG_STATUS_SISTEMA_FECHADO,
-    MSG_STATUS_MODO_ADMIN,
-    MSG_LOG_ACESSO_OK,
-    MSG_LOG_ACESSO_FALHA,
-    MSG_LOG_EVENTO_TIMEOUT_SENHA,
-    MSG_LOG_EVENTO_AUTO_LOCK,
-    MSG_LOG_OPERACAO_CANCELADA,
-    MSG_LOG_ADMIN_INICIADO,
-    MSG_LOG_ADMIN_SENHA_ALTERADA,
-    MSG_LOG_EMERGENCIA_INCENDIO_ON,
-    MSG_LOG_EMERGENCIA_INCENDIO_OFF,
-    MSG_LOG_HEARTBEAT
+#define MQTT_MSG_ENUM(identificador, topico, formato) identificador,
+    MQTT_MENSAGENS(MQTT_MSG_ENUM)
+#undef MQTT_MSG_ENUM
+    MSG_QUANTIDADE
 };
 
-// --- Senhas ativas em memoria ---
-extern char SENHA_VERDE[5];
-extern char SENHA_VERMELHA[5];
-extern char SENHA_AZUL[5];
-
 #endif // CONFIGURA_GERAL_H
\ No newline at end of file
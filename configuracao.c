@@ -0,0 +1,347 @@
+/**
+ * @file configuracao.c
+ * @brief Implementação da configuração persistente.
+ *
+ * Cada setor guarda até 64 blocos de 64 bytes, gravados em ordem. Uma alteração acrescenta
+ * um bloco no próximo espaço livre do setor atual; só quando ele enche a gravação passa ao
+ * outro setor, que já foi apagado em repouso. Assim cada setor é apagado uma vez a cada
+ * 64 gravações, e nunca enquanto guarda o bloco em vigor.
+ */
+
+#include "configuracao.h"
+#include "flash_seguro.h"
+#include "classificador.h"   // CLASSIFICADOR_ESCALA
+#include <stddef.h>
+#include <string.h>
+
+
+// --- Formato na Flash ---
+
+#define CONFIGURACAO_MAGICA 0x43464731u     // "CFG1"
+#define CONFIGURACAO_VERSAO 2              // 2: centróides no lugar das razões de cor
+#define CAMPOS_VERSAO_1 2                   // Da versão 1 só os tempos continuam valendo
+#define ESPACO_VALORES 48
+
+/**
+ * @brief Bloco de 64 bytes: 4 por página, 64 por setor.
+ */
+typedef struct {
+    uint32_t magica;                        // 0xFFFFFFFF = livre
+    uint16_t versao;                        // CONFIGURACAO_VERSAO de quem gravou
+    uint16_t tamanho;                       // sizeof(configuracao_t) de quem gravou
+    uint32_t sequencia;                     // Cresce a cada gravação; vale a maior
+    uint8_t valores[ESPACO_VALORES];        // configuracao_t, completado com 0xFF
+    uint32_t crc;                           // CRC-32 dos campos anteriores
+} bloco_t;
+
+_Static_assert(sizeof(bloco_t) == 64, "bloco_t deve ter 64 bytes");
+_Static_assert(sizeof(configuracao_t) <= ESPACO_VALORES, "configuracao_t nao cabe no bloco");
+
+#define BLOCOS_POR_PAGINA (FLASH_PAGE_SIZE / sizeof(bloco_t))
+#define BLOCOS_POR_SETOR (FLASH_SECTOR_SIZE / sizeof(bloco_t))
+
+// Leitura direta pelo XIP
+static const bloco_t *const setores[CONFIGURACAO_SETORES] = {
+    (const bloco_t *)(XIP_BASE + CONFIGURACAO_OFFSET_FLASH),
+    (const bloco_t *)(XIP_BASE + CONFIGURACAO_OFFSET_FLASH + FLASH_SECTOR_SIZE),
+};
+
+/**
+ * @brief Padrão e faixa de cada parâmetro (tabela em flash).
+ */
+typedef struct {
+    const char *nome;
+    uint16_t padrao;
+    uint16_t minimo;
+    uint16_t maximo;
+} descricao_t;
+
+#define CONFIGURACAO_DESCRICAO(chave, campo, nome, padrao, minimo, maximo) [chave] = { nome, padrao, minimo, maximo },
+static const descricao_t DESCRICOES[CONFIG_QUANTIDADE] = {
+    CONFIGURACAO_CAMPOS(CONFIGURACAO_DESCRICAO)
+};
+#undef CONFIGURACAO_DESCRICAO
+
+
+// --- Variáveis Estáticas ---
+
+static configuracao_t valores;
+static uint32_t sequencia = 0;
+
+static uint32_t setor_atual = 0;
+static uint32_t proximo_bloco = 0;          // Primeiro bloco livre do setor atual
+static bool outro_apagado = false;          // O outro setor está pronto para receber blocos
+static bool gravacao_pendente = false;
+static flash_seguro_adiamento_t adiamento;
+
+static bloco_t pagina[BLOCOS_POR_PAGINA];   // Imagem da página gravada
+
+static configuracao_estatisticas_t estatisticas;
+
+
+// --- Funções Auxiliares Estáticas ---
+
+// Os campos são todos uint16_t: a struct pode ser tratada como vetor indexado pela chave
+static uint16_t *campo(configuracao_t *configuracao, uint chave) {
+    return (uint16_t *)configuracao + chave;
+}
+
+// Um centróide só é válido com r+g <= CLASSIFICADOR_ESCALA (b = escala - r - g)
+static bool centroide_valido(const configuracao_t *configuracao, uint chave, uint16_t valor) {
+    if (chave < CONFIG_VERDE_R || chave > CONFIG_ROXO_G) {
+        return true;
+    }
+    uint par = CONFIG_VERDE_R + ((chave - CONFIG_VERDE_R) ^ 1u); // r <-> g do mesmo cartão
+    return (uint32_t)valor + ((const uint16_t *)configuracao)[par] <= CLASSIFICADOR_ESCALA;
+}
+
+static uint32_t calcular_crc(const void *dados, size_t tamanho) {
+    // CRC-32 (polinômio refletido 0xEDB88320) com tabela de 16 entradas
+    static const uint32_t TABELA[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+    const uint8_t *bytes = (const uint8_t *)dados;
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < tamanho; i++) {
+        crc ^= bytes[i];
+        crc = (crc >> 4) ^ TABELA[crc & 0x0F];
+        crc = (crc >> 4) ^ TABELA[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+static bool bloco_vazio(const bloco_t *bloco) {
+    const uint32_t *palavras = (const uint32_t *)bloco;
+    for (size_t i = 0; i < sizeof(bloco_t) / sizeof(uint32_t); i++) {
+        if (palavras[i] != 0xFFFFFFFFu) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool bloco_valido(const bloco_t *bloco) {
+    return bloco->magica == CONFIGURACAO_MAGICA && bloco->tamanho <= ESPACO_VALORES &&
+           bloco->crc == calcular_crc(bloco, offsetof(bloco_t, crc));
+}
+
+static bool setor_vazio(uint32_t setor) {
+    for (uint32_t i = 0; i < BLOCOS_POR_SETOR; i++) {
+        if (!bloco_vazio(&setores[setor][i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Primeiro bloco livre de um setor. Os blocos são gravados em ordem, então os
+ * ocupados formam um prefixo e a busca binária basta.
+ */
+static uint32_t primeiro_livre(uint32_t setor) {
+    uint32_t inicio = 0, fim = BLOCOS_POR_SETOR;
+    while (inicio < fim) {
+        uint32_t meio = (inicio + fim) / 2;
+        if (bloco_vazio(&setores[setor][meio])) {
+            fim = meio;
+        } else {
+            inicio = meio + 1;
+        }
+    }
+    return inicio;
+}
+
+/**
+ * @brief Bloco íntegro mais recente de um setor (o último, salvo gravação interrompida).
+ */
+static const bloco_t *ultimo_valido(uint32_t setor, uint32_t livre) {
+    for (uint32_t i = livre; i > 0; i--) {
+        if (bloco_valido(&setores[setor][i - 1])) {
+            return &setores[setor][i - 1];
+        }
+    }
+    return NULL;
+}
+
+static void carregar_padroes(void) {
+    for (uint chave = 0; chave < CONFIG_QUANTIDADE; chave++) {
+        *campo(&valores, chave) = DESCRICOES[chave].padrao;
+    }
+}
+
+/**
+ * @brief Copia os valores de um bloco. Campos ausentes (bloco de versão anterior)
+ * ou fora da faixa atual ficam com o padrão.
+ */
+static void carregar_bloco(const bloco_t *bloco) {
+    configuracao_t lidos;
+    size_t tamanho = bloco->tamanho < sizeof(lidos) ? bloco->tamanho : sizeof(lidos);
+    if (bloco->versao < 2 && tamanho > CAMPOS_VERSAO_1 * sizeof(uint16_t)) {
+        tamanho = CAMPOS_VERSAO_1 * sizeof(uint16_t);
+    }
+    memcpy(&lidos, bloco->valores, tamanho);
+    for (uint chave = 0; chave < tamanho / sizeof(uint16_t); chave++) {
+        uint16_t valor = *campo(&lidos, chave);
+        if (valor >= DESCRICOES[chave].minimo && valor <= DESCRICOES[chave].maximo) {
+            *campo(&valores, chave) = valor;
+        }
+    }
+    // Par r/g incoerente volta inteiro ao padrão
+    for (uint chave = CONFIG_VERDE_R; chave < CONFIG_ROXO_G; chave += 2) {
+        if (!centroide_valido(&valores, chave, *campo(&valores, chave))) {
+            *campo(&valores, chave) = DESCRICOES[chave].padrao;
+            *campo(&valores, chave + 1) = DESCRICOES[chave + 1].padrao;
+        }
+    }
+}
+
+// --- Operações na flash ---
+
+static bool apagar_setor(uint32_t setor) {
+    if (!flash_seguro_apagar_setor(CONFIGURACAO_OFFSET_FLASH + setor * FLASH_SECTOR_SIZE, &adiamento)) {
+        return false;
+    }
+    estatisticas.setores_apagados++;
+    return true;
+}
+
+/**
+ * @brief Programa o bloco com os valores atuais no próximo espaço livre.
+ * Os outros blocos da página ficam em 0xFF e não alteram o que já está gravado.
+ */
+static bool gravar_bloco(void) {
+    memset(pagina, 0xFF, sizeof(pagina));
+    bloco_t *bloco = &pagina[proximo_bloco % BLOCOS_POR_PAGINA];
+    bloco->magica = CONFIGURACAO_MAGICA;
+    bloco->versao = CONFIGURACAO_VERSAO;
+    bloco->tamanho = sizeof(configuracao_t);
+    bloco->sequencia = sequencia + 1;
+    memcpy(bloco->valores, &valores, sizeof(configuracao_t));
+    bloco->crc = calcular_crc(bloco, offsetof(bloco_t, crc));
+
+    uint32_t inicio_pagina = proximo_bloco - proximo_bloco % BLOCOS_POR_PAGINA;
+    uint32_t offset = CONFIGURACAO_OFFSET_FLASH + setor_atual * FLASH_SECTOR_SIZE + inicio_pagina * sizeof(bloco_t);
+    if (!flash_seguro_programar_pagina(offset, (const uint8_t *)pagina, &adiamento)) {
+        return false;
+    }
+    // Mesmo que a gravação tenha falhado, o espaço fica marcado e não é reutilizado
+    proximo_bloco++;
+    if (!bloco_valido(&setores[setor_atual][proximo_bloco - 1])) {
+        return false;
+    }
+    sequencia++;
+    estatisticas.gravacoes++;
+    return true;
+}
+
+
+// --- Implementação das Funções Públicas ---
+
+void configuracao_iniciar(void) {
+    uint64_t inicio_us = time_us_64();
+    carregar_padroes();
+
+    const bloco_t *mais_recente = NULL;
+    uint32_t livres[CONFIGURACAO_SETORES];
+    for (uint32_t setor = 0; setor < CONFIGURACAO_SETORES; setor++) {
+        livres[setor] = primeiro_livre(setor);
+        const bloco_t *bloco = ultimo_valido(setor, livres[setor]);
+        if (bloco && (!mais_recente || bloco->sequencia > mais_recente->sequencia)) {
+            mais_recente = bloco;
+            setor_atual = setor;
+        }
+    }
+    if (mais_recente) {
+        carregar_bloco(mais_recente);
+        sequencia = mais_recente->sequencia;
+    }
+    proximo_bloco = livres[setor_atual];
+    outro_apagado = false; // Conferido (ou apagado) na primeira oportunidade em repouso
+    estatisticas.carga_us = (uint32_t)(time_us_64() - inicio_us);
+}
+
+const configuracao_t *configuracao_obter(void) {
+    return &valores;
+}
+
+uint16_t configuracao_valor(uint chave) {
+    return (chave < CONFIG_QUANTIDADE) ? *campo(&valores, chave) : 0;
+}
+
+bool configuracao_alterar(uint chave, uint16_t valor) {
+    if (chave >= CONFIG_QUANTIDADE || valor < DESCRICOES[chave].minimo || valor > DESCRICOES[chave].maximo ||
+        !centroide_valido(&valores, chave, valor)) {
+        return false;
+    }
+    if (*campo(&valores, chave) != valor) {
+        *campo(&valores, chave) = valor;
+        gravacao_pendente = true; // Alterações seguidas saem em um único bloco
+    }
+    return true;
+}
+
+bool configuracao_alterar_centroide(uint cartao, uint16_t r, uint16_t g) {
+    uint chave = CONFIG_CENTROIDE_R(cartao);
+    if (chave < CONFIG_VERDE_R || chave > CONFIG_ROXO_R || (uint32_t)r + g > CLASSIFICADOR_ESCALA ||
+        r > DESCRICOES[chave].maximo || g > DESCRICOES[chave + 1].maximo) {
+        return false;
+    }
+    // Os dois de uma vez: um por vez, o primeiro poderia ser recusado contra o valor antigo do outro
+    if (*campo(&valores, chave) != r || *campo(&valores, chave + 1) != g) {
+        *campo(&valores, chave) = r;
+        *campo(&valores, chave + 1) = g;
+        gravacao_pendente = true;
+    }
+    return true;
+}
+
+int configuracao_chave(const char *nome) {
+    for (uint chave = 0; chave < CONFIG_QUANTIDADE; chave++) {
+        if (strcmp(nome, DESCRICOES[chave].nome) == 0) {
+            return (int)chave;
+        }
+    }
+    return -1;
+}
+
+void configuracao_processar(bool ocioso) {
+    if (!flash_seguro_liberado(&adiamento)) {
+        return;
+    }
+    uint32_t outro = (setor_atual + 1) % CONFIGURACAO_SETORES;
+
+    // Prepara o outro setor: ele só guarda blocos antigos, substituídos pelos do setor atual
+    if (!outro_apagado && ocioso) {
+        outro_apagado = setor_vazio(outro) || apagar_setor(outro);
+    }
+    if (!gravacao_pendente) {
+        return;
+    }
+
+    if (proximo_bloco >= BLOCOS_POR_SETOR) {
+        if (!outro_apagado) {
+            return; // Aguarda o repouso; os valores já estão em vigor na RAM
+        }
+        setor_atual = outro;
+        proximo_bloco = 0;
+        outro_apagado = false;
+    }
+    if (gravar_bloco()) {
+        gravacao_pendente = false;
+    }
+}
+
+absolute_time_t configuracao_proximo_prazo(void) {
+    if (!gravacao_pendente || (proximo_bloco >= BLOCOS_POR_SETOR && !outro_apagado)) {
+        return at_the_end_of_time;
+    }
+    return adiamento.proxima_tentativa;
+}
+
+void configuracao_obter_estatisticas(configuracao_estatisticas_t *destino) {
+    estatisticas.sequencia = sequencia;
+    estatisticas.pendente = gravacao_pendente;
+    estatisticas.adiamentos = adiamento.adiamentos;
+    *destino = estatisticas;
+}
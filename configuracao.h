@@ -0,0 +1,132 @@
+/**
+ * @file configuracao.h
+ * @brief Parâmetros ajustáveis da fechadura, persistidos em flash.
+ * Um bloco versionado (sequência + CRC-32) é acrescentado a cada alteração em um de dois
+ * setores usados em alternância; no boot vale o bloco íntegro de maior sequência, lido
+ * direto pelo XIP. Um setor só é apagado quando o outro já guarda o bloco mais recente,
+ * então uma queda durante a gravação deixa a configuração anterior intacta.
+ * As alterações valem na hora, em RAM; a gravação acontece depois, em configuracao_processar.
+ */
+
+#ifndef CONFIGURACAO_H
+#define CONFIGURACAO_H
+
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "credenciais.h"
+#include "tcs34725.h"   // TCS34725_LIMIAR_PRESENCA
+
+// --- Região reservada (logo abaixo da tabela de credenciais) ---
+#define CONFIGURACAO_SETORES 2
+#define CONFIGURACAO_OFFSET_FLASH (CREDENCIAIS_OFFSET_FLASH - CONFIGURACAO_SETORES * FLASH_SECTOR_SIZE)
+
+/**
+ * @brief Tabela de parâmetros: X(chave, campo, nome remoto, padrão, mínimo, máximo).
+ * Os centróides dos cartões (classificador.h) estão na escala de cromaticidade (r+g+b = 1024),
+ * um par r/g por cartão, na ordem da enum CorDetectada.
+ * Campos novos entram sempre no fim: blocos gravados por versões anteriores continuam
+ * válidos, e os campos que eles não têm assumem o padrão.
+ */
+#define CONFIGURACAO_CAMPOS(X) \
+    X(CONFIG_TIMEOUT_SENHA_S,   timeout_senha_s,  "timeout_senha_s",  15,   5,   120) \
+    X(CONFIG_AUTO_TRAVA_S,      auto_trava_s,     "auto_trava_s",     20,   5,   300) \
+    X(CONFIG_LIMIAR_CLEAR,      limiar_clear,     "limiar_clear",     TCS34725_LIMIAR_PRESENCA, TCS34725_LIMIAR_PRESENCA, 60000) \
+    X(CONFIG_RAIO_CARTAO,       raio_cartao,      "raio_cartao",      120, 20,  1024) \
+    X(CONFIG_VERDE_R,           verde_r,          "verde_r",          225,  0,  1024) \
+    X(CONFIG_VERDE_G,           verde_g,          "verde_g",          573,  0,  1024) \
+    X(CONFIG_VERMELHO_R,        vermelho_r,       "vermelho_r",       614,  0,  1024) \
+    X(CONFIG_VERMELHO_G,        vermelho_g,       "vermelho_g",       205,  0,  1024) \
+    X(CONFIG_AZUL_R,            azul_r,           "azul_r",           184,  0,  1024) \
+    X(CONFIG_AZUL_G,            azul_g,           "azul_g",           307,  0,  1024) \
+    X(CONFIG_AMARELO_R,         amarelo_r,        "amarelo_r",        430,  0,  1024) \
+    X(CONFIG_AMARELO_G,         amarelo_g,        "amarelo_g",        430,  0,  1024) \
+    X(CONFIG_ROXO_R,            roxo_r,           "roxo_r",           389,  0,  1024) \
+    X(CONFIG_ROXO_G,            roxo_g,           "roxo_g",           184,  0,  1024)
+
+// Par r/g do centróide de um cartão (enum CorDetectada a partir de COR_VERDE)
+#define CONFIG_CENTROIDE_R(cartao) (CONFIG_VERDE_R + 2 * ((cartao) - 1))
+#define CONFIG_CENTROIDE_G(cartao) (CONFIG_CENTROIDE_R(cartao) + 1)
+
+#define CONFIGURACAO_ENUM(chave, campo, nome, padrao, minimo, maximo) chave,
+enum ChaveConfiguracao {
+    CONFIGURACAO_CAMPOS(CONFIGURACAO_ENUM)
+    CONFIG_QUANTIDADE
+};
+#undef CONFIGURACAO_ENUM
+
+/**
+ * @struct configuracao_t
+ * @brief Valores em vigor.
+ */
+#define CONFIGURACAO_MEMBRO(chave, campo, nome, padrao, minimo, maximo) uint16_t campo;
+typedef struct {
+    CONFIGURACAO_CAMPOS(CONFIGURACAO_MEMBRO)
+} configuracao_t;
+#undef CONFIGURACAO_MEMBRO
+
+/**
+ * @struct configuracao_estatisticas_t
+ * @brief Estado da persistência.
+ */
+typedef struct {
+    uint32_t sequencia;         ///< Sequência do último bloco gravado (0: padrões de fábrica).
+    uint32_t carga_us;          ///< Duração da leitura no boot.
+    uint32_t gravacoes;         ///< Blocos gravados desde o boot.
+    uint32_t setores_apagados;
+    uint32_t adiamentos;        ///< Operações adiadas (Núcleo 1 indisponível).
+    bool pendente;              ///< Há alteração em RAM ainda não gravada.
+} configuracao_estatisticas_t;
+
+/**
+ * @brief Carrega o bloco mais recente (ou os padrões). Chamar no Núcleo 0 durante o boot.
+ */
+void configuracao_iniciar(void);
+
+/**
+ * @brief Valores em vigor (cópia em RAM; sempre válida).
+ */
+const configuracao_t *configuracao_obter(void);
+
+/**
+ * @brief Valor de um parâmetro pela chave (0 se a chave é inválida).
+ */
+uint16_t configuracao_valor(uint chave);
+
+/**
+ * @brief Altera um parâmetro. Vale imediatamente; a gravação fica para configuracao_processar.
+ * @note Apenas o Núcleo 0 pode chamar (o Núcleo 1 repassa os comandos pela FIFO).
+ * @return false se a chave é inválida, o valor está fora da faixa ou, num centróide,
+ *         somado ao outro componente do par passa de CLASSIFICADOR_ESCALA.
+ */
+bool configuracao_alterar(uint chave, uint16_t valor);
+
+/**
+ * @brief Altera o par r/g do centróide de um cartão (enum CorDetectada) de uma vez.
+ * @return false se o cartão é inválido ou r+g passa de CLASSIFICADOR_ESCALA.
+ */
+bool configuracao_alterar_centroide(uint cartao, uint16_t r, uint16_t g);
+
+/**
+ * @brief Chave de um parâmetro pelo nome usado no comando remoto.
+ * @return A chave, ou -1 se o nome não existe.
+ */
+int configuracao_chave(const char *nome);
+
+/**
+ * @brief Grava o bloco pendente (uma página por chamada) e prepara o outro setor.
+ * @param ocioso Indica que o Núcleo 0 pode parar ~50ms: só então um setor é apagado.
+ */
+void configuracao_processar(bool ocioso);
+
+/**
+ * @brief Prazo da próxima gravação pendente (at_the_end_of_time se nenhuma ou se ela
+ * aguarda o repouso para apagar um setor).
+ */
+absolute_time_t configuracao_proximo_prazo(void);
+
+/**
+ * @brief Copia o estado da persistência.
+ */
+void configuracao_obter_estatisticas(configuracao_estatisticas_t *estatisticas);
+
+#endif // CONFIGURACAO_H
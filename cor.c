@@ -0,0 +1,233 @@
+/**
+ * @file cor.c
+ * @brief Implementação do pipeline de cor: tabelas de gama, brilho global e respiração,
+ * e o gerador xorshift32.
+ */
+
+#include "cor.h"
+#include "pico/rand.h" // Semente do xorshift
+
+
+// --- Tabelas Constantes (flash) ---
+// Geradas com round(max * (i / 255)^2.2): 'max' 255 para a matriz e 65535 para o PWM.
+static const uint8_t GAMA_MATRIZ[256] = {
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,
+      3,   3,   3,   3,   3,   4,   4,   4,   4,   5,   5,   5,   5,   6,   6,   6,
+      6,   7,   7,   7,   8,   8,   8,   9,   9,   9,  10,  10,  11,  11,  11,  12,
+     12,  13,  13,  13,  14,  14,  15,  15,  16,  16,  17,  17,  18,  18,  19,  19,
+     20,  20,  21,  22,  22,  23,  23,  24,  25,  25,  26,  26,  27,  28,  28,  29,
+     30,  30,  31,  32,  33,  33,  34,  35,  35,  36,  37,  38,  39,  39,  40,  41,
+     42,  43,  43,  44,  45,  46,  47,  48,  49,  49,  50,  51,  52,  53,  54,  55,
+     56,  57,  58,  59,  60,  61,  62,  63,  64,  65,  66,  67,  68,  69,  70,  71,
+     73,  74,  75,  76,  77,  78,  79,  81,  82,  83,  84,  85,  87,  88,  89,  90,
+     91,  93,  94,  95,  97,  98,  99, 100, 102, 103, 105, 106, 107, 109, 110, 111,
+    113, 114, 116, 117, 119, 120, 121, 123, 124, 126, 127, 129, 130, 132, 133, 135,
+    137, 138, 140, 141, 143, 145, 146, 148, 149, 151, 153, 154, 156, 158, 159, 161,
+    163, 165, 166, 168, 170, 172, 173, 175, 177, 179, 181, 182, 184, 186, 188, 190,
+    192, 194, 196, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221,
+    223, 225, 227, 229, 231, 234, 236, 238, 240, 242, 244, 246, 248, 251, 253, 255,
+};
+
+static const uint16_t GAMA_LED[256] = {
+        0,     0,     2,     4,     7,    11,    17,    24,    32,    42,    53,    65,
+       79,    94,   111,   129,   148,   169,   192,   216,   242,   270,   299,   330,
+      362,   396,   432,   469,   508,   549,   591,   635,   681,   729,   779,   830,
+      883,   938,   995,  1053,  1113,  1175,  1239,  1305,  1373,  1443,  1514,  1587,
+     1663,  1740,  1819,  1900,  1983,  2068,  2155,  2243,  2334,  2427,  2521,  2618,
+     2717,  2817,  2920,  3024,  3131,  3240,  3350,  3463,  3578,  3694,  3813,  3934,
+     4057,  4182,  4309,  4438,  4570,  4703,  4838,  4976,  5115,  5257,  5401,  5547,
+     5695,  5845,  5998,  6152,  6309,  6468,  6629,  6792,  6957,  7124,  7294,  7466,
+     7640,  7816,  7994,  8175,  8358,  8543,  8730,  8919,  9111,  9305,  9501,  9699,
+     9900, 10102, 10307, 10515, 10724, 10936, 11150, 11366, 11585, 11806, 12029, 12254,
+    12482, 12712, 12944, 13179, 13416, 13655, 13896, 14140, 14386, 14635, 14885, 15138,
+    15394, 15652, 15912, 16174, 16439, 16706, 16975, 17247, 17521, 17798, 18077, 18358,
+    18642, 18928, 19216, 19507, 19800, 20095, 20393, 20694, 20996, 21301, 21609, 21919,
+    22231, 22546, 22863, 23182, 23504, 23829, 24156, 24485, 24817, 25151, 25487, 25826,
+    26168, 26512, 26858, 27207, 27558, 27912, 28268, 28627, 28988, 29351, 29717, 30086,
+    30457, 30830, 31206, 31585, 31966, 32349, 32735, 33124, 33514, 33908, 34304, 34702,
+    35103, 35507, 35913, 36321, 36732, 37146, 37562, 37981, 38402, 38825, 39252, 39680,
+    40112, 40546, 40982, 41421, 41862, 42306, 42753, 43202, 43654, 44108, 44565, 45025,
+    45487, 45951, 46418, 46888, 47360, 47835, 48313, 48793, 49275, 49761, 50249, 50739,
+    51232, 51728, 52226, 52727, 53230, 53736, 54245, 54756, 55270, 55787, 56306, 56828,
+    57352, 57879, 58409, 58941, 59476, 60014, 60554, 61097, 61642, 62190, 62741, 63295,
+    63851, 64410, 64971, 65535,
+};
+
+// round(255 * (sin(2 * pi * i / 256) + 1) / 2): um período, começando no meio e subindo
+static const uint8_t RESPIRACAO[COR_RESPIRACAO_PASSOS] = {
+    128, 131, 134, 137, 140, 143, 146, 149, 152, 155, 158, 162, 165, 167, 170, 173,
+    176, 179, 182, 185, 188, 190, 193, 196, 198, 201, 203, 206, 208, 211, 213, 215,
+    218, 220, 222, 224, 226, 228, 230, 232, 234, 235, 237, 238, 240, 241, 243, 244,
+    245, 246, 248, 249, 250, 250, 251, 252, 253, 253, 254, 254, 254, 255, 255, 255,
+    255, 255, 255, 255, 254, 254, 254, 253, 253, 252, 251, 250, 250, 249, 248, 246,
+    245, 244, 243, 241, 240, 238, 237, 235, 234, 232, 230, 228, 226, 224, 222, 220,
+    218, 215, 213, 211, 208, 206, 203, 201, 198, 196, 193, 190, 188, 185, 182, 179,
+    176, 173, 170, 167, 165, 162, 158, 155, 152, 149, 146, 143, 140, 137, 134, 131,
+    128, 124, 121, 118, 115, 112, 109, 106, 103, 100,  97,  93,  90,  88,  85,  82,
+     79,  76,  73,  70,  67,  65,  62,  59,  57,  54,  52,  49,  47,  44,  42,  40,
+     37,  35,  33,  31,  29,  27,  25,  23,  21,  20,  18,  17,  15,  14,  12,  11,
+     10,   9,   7,   6,   5,   5,   4,   3,   2,   2,   1,   1,   1,   0,   0,   0,
+      0,   0,   0,   0,   1,   1,   1,   2,   2,   3,   4,   5,   5,   6,   7,   9,
+     10,  11,  12,  14,  15,  17,  18,  20,  21,  23,  25,  27,  29,  31,  33,  35,
+     37,  40,  42,  44,  47,  49,  52,  54,  57,  59,  62,  65,  67,  70,  73,  76,
+     79,  82,  85,  88,  90,  93,  97, 100, 103, 106, 109, 112, 115, 118, 121, 124,
+};
+
+
+// --- Variáveis Estáticas ---
+// Gama já composta com o brilho global: uma consulta por canal na saída
+static uint8_t saida_matriz[256];
+static uint16_t saida_led[256];
+static uint8_t brilho_atual = COR_BRILHO_PADRAO;
+static uint32_t estado_aleatorio = 1; // O xorshift nunca pode ficar em zero
+
+
+// --- Implementação das Funções Públicas ---
+
+void cor_init(void) {
+    estado_aleatorio = get_rand_32() | 1;
+    cor_definir_brilho(COR_BRILHO_PADRAO);
+}
+
+void cor_definir_brilho(uint8_t brilho) {
+    brilho_atual = brilho;
+    for (uint i = 0; i < 256; i++) {
+        uint escalado = (i * brilho + 127) / 255; // O brilho age na escala perceptual, antes da gama
+        saida_matriz[i] = GAMA_MATRIZ[escalado];
+        saida_led[i] = GAMA_LED[escalado];
+    }
+}
+
+uint8_t cor_obter_brilho(void) {
+    return brilho_atual;
+}
+
+uint32_t cor_grb(uint32_t cor) {
+    return ((uint32_t)saida_matriz[cor_verde(cor)] << 16) | ((uint32_t)saida_matriz[cor_vermelho(cor)] << 8) |
+           (uint32_t)saida_matriz[cor_azul(cor)];
+}
+
+uint16_t cor_pwm(uint8_t canal) {
+    return saida_led[canal];
+}
+
+uint8_t cor_respiracao(uint32_t decorrido_ms, uint32_t periodo_ms) {
+    return RESPIRACAO[(decorrido_ms % periodo_ms) * COR_RESPIRACAO_PASSOS / periodo_ms];
+}
+
+uint32_t cor_aleatorio(void) {
+    uint32_t x = estado_aleatorio;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    estado_aleatorio = x;
+    return x;
+}
+
+
+// --- Benchmark ---
+#if COR_BENCHMARK
+
+#include "feedback.h"        // O fogo medido é o da animação em uso
+#include "hardware/clocks.h" // Para converter o tempo em ciclos
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCHMARK_QUADROS 1000
+#define BENCHMARK_PASSO_MS 20 // Cadência do pulso em main.c
+
+static animacao_quadro_t quadro;
+static uint32_t grb[ANIMACAO_PIXELS];
+static uint16_t pwm[3];
+static volatile uint32_t cor_pulso = 0x0000FF; // Azul, como no modo de espera
+
+// Pipeline anterior, como referência: brilho com sinf (ponto flutuante emulado no M0+),
+// fogo com rand() e canais desempacotados, LED em 0-255 x 257 e matriz sem gama.
+static void pulso_anterior(uint32_t decorrido_ms) {
+    uint32_t base = cor_pulso;
+    float brilho = (sinf(decorrido_ms * (float)M_PI / 1500.0f) + 1.0f) / 2.0f;
+    uint32_t cor = ((uint32_t)(cor_vermelho(base) * brilho) << 16) | ((uint32_t)(cor_verde(base) * brilho) << 8) |
+                   (uint32_t)(cor_azul(base) * brilho);
+    quadro.led = cor;
+    animacoes_desenhar_padrao(&quadro, FEEDBACK_PADRAO_PONTO, cor);
+}
+
+static void fogo_anterior(uint32_t decorrido_ms) {
+    for (uint y = 0; y < 4; y++) {
+        for (uint x = 0; x < 5; x++) {
+            uint32_t cor_abaixo = quadro.pixels[(y + 1) * 5 + x];
+            uint8_t r = (cor_abaixo >> 16) & 0xFF;
+            uint8_t g = (cor_abaixo >> 8) & 0xFF;
+            r = (r > 10) ? r - 10 : 0;
+            g = (g > 5) ? g - 5 : 0;
+            quadro.pixels[y * 5 + x] = ((uint32_t)r << 16) | ((uint32_t)g << 8);
+        }
+    }
+    for (uint x = 0; x < 5; x++) {
+        if (rand() % 100 < 60) {
+            quadro.pixels[4 * 5 + x] = ((uint32_t)(200 + rand() % 56) << 16) | ((uint32_t)(50 + rand() % 100) << 8);
+        } else {
+            quadro.pixels[4 * 5 + x] = 0;
+        }
+    }
+}
+
+static void saidas_anteriores(void) {
+    for (uint i = 0; i < ANIMACAO_PIXELS; i++) {
+        uint32_t cor = quadro.pixels[i];
+        grb[i] = ((uint32_t)cor_verde(cor) << 16) | ((uint32_t)cor_vermelho(cor) << 8) | cor_azul(cor);
+    }
+    pwm[0] = cor_vermelho(quadro.led) * 257;
+    pwm[1] = cor_verde(quadro.led) * 257;
+    pwm[2] = cor_azul(quadro.led) * 257;
+}
+
+// Pipeline atual: o mesmo cálculo de main.c (pulso) e feedback.c (fogo)
+static void pulso_atual(uint32_t decorrido_ms) {
+    uint32_t cor = cor_escalar(cor_pulso, cor_respiracao(decorrido_ms, COR_PERIODO_RESPIRACAO_MS));
+    quadro.led = cor;
+    animacoes_desenhar_padrao(&quadro, FEEDBACK_PADRAO_PONTO, cor);
+}
+
+static void fogo_atual(uint32_t decorrido_ms) {
+    feedback_animacao_fogo.gerar(&quadro, decorrido_ms);
+}
+
+static void saidas_atuais(void) {
+    for (uint i = 0; i < ANIMACAO_PIXELS; i++) {
+        grb[i] = cor_grb(quadro.pixels[i]);
+    }
+    pwm[0] = cor_pwm(cor_vermelho(quadro.led));
+    pwm[1] = cor_pwm(cor_verde(quadro.led));
+    pwm[2] = cor_pwm(cor_azul(quadro.led));
+}
+
+/**
+ * @brief Ciclos médios de um quadro: o gerador mais a conversão para as duas saídas
+ * (o envio por DMA e o registrador do PWM são iguais nos dois pipelines e ficam de fora).
+ */
+static uint32_t medir(void (*gerar)(uint32_t decorrido_ms), void (*converter)(void)) {
+    memset(&quadro, 0, sizeof(quadro));
+    uint64_t inicio_us = time_us_64();
+    for (uint i = 0; i < BENCHMARK_QUADROS; i++) {
+        gerar(i * BENCHMARK_PASSO_MS);
+        converter();
+    }
+    uint64_t duracao_us = time_us_64() - inicio_us;
+    return (uint32_t)(duracao_us * (clock_get_hz(clk_sys) / 1000000) / BENCHMARK_QUADROS);
+}
+
+void cor_benchmark(void) {
+    uint32_t pulso_antes = medir(pulso_anterior, saidas_anteriores);
+    uint32_t pulso_depois = medir(pulso_atual, saidas_atuais);
+    uint32_t fogo_antes = medir(fogo_anterior, saidas_anteriores);
+    uint32_t fogo_depois = medir(fogo_atual, saidas_atuais);
+    printf("Benchmark cor: pulso %lu -> %lu ciclos/quadro, fogo %lu -> %lu ciclos/quadro (%u quadros a %lu MHz)\n",
+           (unsigned long)pulso_antes, (unsigned long)pulso_depois, (unsigned long)fogo_antes,
+           (unsigned long)fogo_depois, BENCHMARK_QUADROS, (unsigned long)(clock_get_hz(clk_sys) / 1000000));
+}
+
+#endif // COR_BENCHMARK
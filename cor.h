@@ -0,0 +1,103 @@
+/**
+ * @file cor.h
+ * @brief Pipeline de cor em ponto fixo, compartilhado pela matriz de LEDs e pelo LED RGB.
+ * As cores circulam como 0xRRGGBB, em escala perceptual (8 bits por canal); só na saída
+ * passam pelas tabelas de gama e brilho global: 8 bits empacotados em GRB para o WS2812B,
+ * 16 bits por canal para o PWM. Traz também a onda de "respiração" tabelada e um gerador
+ * pseudoaleatório rápido (xorshift32) para os efeitos.
+ */
+
+#ifndef COR_H
+#define COR_H
+
+#include "pico/stdlib.h"
+#include "configura_geral.h" // COR_BRILHO_PADRAO e COR_BENCHMARK
+
+// --- Parâmetros ---
+#define COR_RESPIRACAO_PASSOS 256      // Amostras de um período da onda de respiração
+#define COR_PERIODO_RESPIRACAO_MS 3000 // Ciclo do pulso do LED RGB
+
+
+// --- Cores empacotadas (0xRRGGBB) ---
+
+static inline uint32_t cor_rgb(uint8_t r, uint8_t g, uint8_t b) {
+    return ((uint32_t)r << 16) | ((uint32_t)g << 8) | (uint32_t)b;
+}
+
+static inline uint8_t cor_vermelho(uint32_t cor) { return (uint8_t)(cor >> 16); }
+static inline uint8_t cor_verde(uint32_t cor) { return (uint8_t)(cor >> 8); }
+static inline uint8_t cor_azul(uint32_t cor) { return (uint8_t)cor; }
+
+/**
+ * @brief Multiplica os três canais por nivel/255 (255 devolve a própria cor).
+ * Duas multiplicações de 32 bits: vermelho e azul na mesma, com 8 bits de folga entre eles.
+ */
+static inline uint32_t cor_escalar(uint32_t cor, uint8_t nivel) {
+    uint32_t fator = (uint32_t)nivel + 1;
+    uint32_t rb = (((cor & 0xFF00FF) * fator) >> 8) & 0xFF00FF;
+    uint32_t g = (((cor & 0x00FF00) * fator) >> 8) & 0x00FF00;
+    return rb | g;
+}
+
+/**
+ * @brief Subtrai 'sub' de 'cor' canal a canal, parando em zero.
+ * Cada canal ganha um bit de guarda logo acima dele: se o bit sobrevive à subtração,
+ * o canal não ficou negativo; os que ficaram são zerados por máscara, sem desvios.
+ */
+static inline uint32_t cor_subtrair(uint32_t cor, uint32_t sub) {
+    uint32_t rb = ((cor & 0xFF00FF) | 0x1000100) - (sub & 0xFF00FF);
+    uint32_t g = ((cor & 0x00FF00) | 0x10000) - (sub & 0x00FF00);
+    uint32_t mascara_rb = ((rb >> 8) & 0x10001) * 0xFF;
+    uint32_t mascara_g = ((g >> 16) & 1) * 0xFF00;
+    return (rb & mascara_rb) | (g & mascara_g);
+}
+
+
+// --- Funções Públicas ---
+
+/**
+ * @brief Monta as tabelas de saída com o brilho COR_BRILHO_PADRAO e semeia o gerador
+ * pseudoaleatório. Chamar antes de qualquer saída de cor.
+ */
+void cor_init(void);
+
+/**
+ * @brief Define o brilho global (0 a 255) aplicado à matriz e ao LED RGB, antes da gama.
+ * Reconstrói as tabelas de saída (512 consultas); vale a partir do próximo quadro enviado.
+ */
+void cor_definir_brilho(uint8_t brilho);
+
+uint8_t cor_obter_brilho(void);
+
+/**
+ * @brief Cor no formato da FIFO do WS2812B (0x00GGRRBB), com brilho e gama aplicados.
+ */
+uint32_t cor_grb(uint32_t cor);
+
+/**
+ * @brief Duty do PWM (0 a PWM_MAX_DUTY) de um canal de 8 bits, com brilho e gama aplicados.
+ */
+uint16_t cor_pwm(uint8_t canal);
+
+/**
+ * @brief Nível da onda de respiração (0 a 255, senoide tabelada que começa no meio, subindo).
+ * @param decorrido_ms Tempo desde o início do efeito.
+ * @param periodo_ms Duração de um ciclo completo.
+ */
+uint8_t cor_respiracao(uint32_t decorrido_ms, uint32_t periodo_ms);
+
+/**
+ * @brief Próximo número do xorshift32: 32 bits pseudoaleatórios, sem divisão nem trava
+ * (só para efeitos visuais do Núcleo 0; nada criptográfico).
+ */
+uint32_t cor_aleatorio(void);
+
+#if COR_BENCHMARK
+/**
+ * @brief Mede no serial os ciclos por quadro do pulso e do fogo, no pipeline anterior
+ * (ponto flutuante, rand(), sem gama) e neste.
+ */
+void cor_benchmark(void);
+#endif
+
+#endif // COR_H
@@ -0,0 +1,491 @@
+/**
+ * @file credenciais.c
+ * @brief Implementação da tabela de credenciais em flash.
+ *
+ * Cada banco começa com um registro de cabeçalho (geração do banco). O cabeçalho só é
+ * confirmado depois que todos os registros da compactação foram gravados; no boot vale
+ * o banco confirmado de maior geração. Uma queda no meio da compactação deixa o banco
+ * anterior intacto. O banco reserva é apagado antecipadamente, um setor por vez com o
+ * Núcleo 0 ocioso, de modo que a compactação só programa páginas.
+ */
+
+#include "credenciais.h"
+#include "flash_seguro.h"
+#include "sha256.h"
+#include "pico/rand.h"
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+
+
+// --- Formato na Flash ---
+
+/**
+ * @brief Registro de 64 bytes: 4 por página.
+ */
+typedef struct {
+    uint32_t marca;                         // MARCA_*; 0xFFFFFFFF = livre
+    uint32_t cartao;                        // Cabeçalho: geração do banco
+    uint8_t sal[CREDENCIAIS_SAL_TAMANHO];
+    uint8_t hash[SHA256_TAMANHO];           // SHA-256(sal || cartão || PIN)
+    uint32_t verificacao;                   // Dos campos anteriores: detecta gravação interrompida
+    uint32_t confirmado;                    // Cabeçalho: 0 depois da compactação completa
+} registro_t;
+
+_Static_assert(sizeof(registro_t) == 64, "registro_t deve ter 64 bytes");
+
+#define MARCA_CABECALHO 0x43524442u     // "CRDB"
+#define MARCA_PIN 0x4350494Eu           // "CPIN"
+#define MARCA_REMOVIDO 0x4352454Du      // "CREM"
+#define MARCA_LIVRE 0xFFFFFFFFu
+
+#define REGISTROS_POR_PAGINA (FLASH_PAGE_SIZE / sizeof(registro_t))
+#define REGISTROS_POR_BANCO (CREDENCIAIS_SETORES_BANCO * FLASH_SECTOR_SIZE / sizeof(registro_t))
+#define BANCO_BYTES (CREDENCIAIS_SETORES_BANCO * FLASH_SECTOR_SIZE)
+
+#if CREDENCIAIS_MAXIMO >= (CREDENCIAIS_SETORES_BANCO * FLASH_SECTOR_SIZE / 64)
+#error "CREDENCIAIS_MAXIMO precisa caber em um banco compactado (com folga para novas gravações)"
+#endif
+
+// Leitura direta pelo XIP
+static const registro_t *const bancos[2] = {
+    (const registro_t *)(XIP_BASE + CREDENCIAIS_OFFSET_FLASH),
+    (const registro_t *)(XIP_BASE + CREDENCIAIS_OFFSET_FLASH + BANCO_BYTES),
+};
+
+
+// --- Variáveis Estáticas ---
+
+/**
+ * @brief Entrada do índice em RAM, ordenado por cartão.
+ */
+typedef struct {
+    uint32_t cartao;
+    uint16_t registro;      // Posição no banco atual
+} entrada_indice_t;
+
+static entrada_indice_t indice[CREDENCIAIS_MAXIMO];
+static uint32_t quantidade = 0;
+
+static uint32_t banco_atual = 0;
+static uint32_t geracao = 0;
+static uint32_t proximo_registro = 1;       // Primeiro registro livre do banco atual
+static uint32_t reserva_apagada = 0;        // Setores do outro banco já apagados (um bit por setor)
+static bool disponivel = false;             // Há um banco confirmado para receber gravações
+static flash_seguro_adiamento_t adiamento;
+
+static registro_t pagina[REGISTROS_POR_PAGINA];
+
+// Comparado quando o cartão não existe, para que a resposta leve o mesmo tempo
+static registro_t registro_ficticio;
+
+static credenciais_estatisticas_t estatisticas;
+
+
+// --- Funções Auxiliares Estáticas ---
+
+static uint32_t calcular_verificacao(const registro_t *registro) {
+    // FNV-1a sobre os campos anteriores a verificacao
+    const uint8_t *bytes = (const uint8_t *)registro;
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < offsetof(registro_t, verificacao); i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static bool registro_valido(const registro_t *registro) {
+    return registro->marca != MARCA_LIVRE && registro->verificacao == calcular_verificacao(registro);
+}
+
+static bool cabecalho_confirmado(const registro_t *cabecalho) {
+    return cabecalho->marca == MARCA_CABECALHO && registro_valido(cabecalho) && cabecalho->confirmado == 0;
+}
+
+static void calcular_hash(const uint8_t sal[CREDENCIAIS_SAL_TAMANHO], uint32_t cartao, const char *pin,
+                          uint8_t hash[SHA256_TAMANHO]) {
+    sha256_contexto_t contexto;
+    sha256_iniciar(&contexto);
+    sha256_adicionar(&contexto, sal, CREDENCIAIS_SAL_TAMANHO);
+    sha256_adicionar(&contexto, &cartao, sizeof(cartao));
+    sha256_adicionar(&contexto, pin, strlen(pin));
+    sha256_finalizar(&contexto, hash);
+}
+
+static bool pin_valido(const char *pin) {
+    size_t tamanho = strlen(pin);
+    if (tamanho == 0 || tamanho > CREDENCIAIS_PIN_MAXIMO) {
+        return false;
+    }
+    for (size_t i = 0; i < tamanho; i++) {
+        if (pin[i] < '0' || pin[i] > '9') {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Busca binária no índice.
+ * @return Posição do cartão, ou a posição onde ele seria inserido (com encontrado = false).
+ */
+static uint32_t buscar(uint32_t cartao, bool *encontrado) {
+    uint32_t inicio = 0, fim = quantidade;
+    while (inicio < fim) {
+        uint32_t meio = (inicio + fim) / 2;
+        if (indice[meio].cartao < cartao) {
+            inicio = meio + 1;
+        } else {
+            fim = meio;
+        }
+    }
+    *encontrado = inicio < quantidade && indice[inicio].cartao == cartao;
+    return inicio;
+}
+
+static bool indice_inserir(uint32_t cartao, uint16_t registro) {
+    bool encontrado;
+    uint32_t posicao = buscar(cartao, &encontrado);
+    if (!encontrado) {
+        if (quantidade >= CREDENCIAIS_MAXIMO) {
+            return false;
+        }
+        memmove(&indice[posicao + 1], &indice[posicao], (quantidade - posicao) * sizeof(indice[0]));
+        indice[posicao].cartao = cartao;
+        quantidade++;
+    }
+    indice[posicao].registro = registro;
+    return true;
+}
+
+static void indice_remover(uint32_t cartao) {
+    bool encontrado;
+    uint32_t posicao = buscar(cartao, &encontrado);
+    if (encontrado) {
+        memmove(&indice[posicao], &indice[posicao + 1], (quantidade - posicao - 1) * sizeof(indice[0]));
+        quantidade--;
+    }
+}
+
+// --- Operações na flash ---
+
+static uint32_t offset_registro(uint32_t banco, uint32_t registro) {
+    return CREDENCIAIS_OFFSET_FLASH + banco * BANCO_BYTES + registro * sizeof(registro_t);
+}
+
+#define RESERVA_COMPLETA ((uint32_t)((1ull << CREDENCIAIS_SETORES_BANCO) - 1))
+
+_Static_assert(CREDENCIAIS_SETORES_BANCO <= 32, "reserva_apagada tem um bit por setor");
+
+static bool apagar_setor(uint32_t banco, uint32_t setor) {
+    return flash_seguro_apagar_setor(CREDENCIAIS_OFFSET_FLASH + banco * BANCO_BYTES + setor * FLASH_SECTOR_SIZE, &adiamento);
+}
+
+static bool setor_vazio(uint32_t banco, uint32_t setor) {
+    const uint32_t *palavras = (const uint32_t *)&bancos[banco][setor * FLASH_SECTOR_SIZE / sizeof(registro_t)];
+    for (uint32_t i = 0; i < FLASH_SECTOR_SIZE / sizeof(uint32_t); i++) {
+        if (palavras[i] != 0xFFFFFFFFu) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Apaga os setores do banco que ainda não estão vazios (numa flash nova, nenhum).
+ */
+static bool apagar_banco(uint32_t banco) {
+    for (uint32_t setor = 0; setor < CREDENCIAIS_SETORES_BANCO; setor++) {
+        if (!setor_vazio(banco, setor) && !apagar_setor(banco, setor)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Programa a página da imagem em RAM que contém o registro indicado.
+ */
+static bool programar_pagina(uint32_t banco, uint32_t registro) {
+    return flash_seguro_programar_pagina(offset_registro(banco, registro - registro % REGISTROS_POR_PAGINA),
+                                         (const uint8_t *)pagina, &adiamento);
+}
+
+static registro_t montar_cabecalho(uint32_t geracao_banco) {
+    registro_t cabecalho;
+    memset(&cabecalho, 0, sizeof(cabecalho));
+    cabecalho.marca = MARCA_CABECALHO;
+    cabecalho.cartao = geracao_banco;
+    cabecalho.verificacao = calcular_verificacao(&cabecalho);
+    cabecalho.confirmado = 0xFFFFFFFFu;
+    return cabecalho;
+}
+
+/**
+ * @brief Copia os registros válidos (na ordem do índice) para o outro banco e passa a usá-lo.
+ * @return false se o outro banco ainda não foi todo apagado por credenciais_processar()
+ * ou se a flash não pôde ser gravada agora.
+ */
+static bool compactar(void) {
+    uint32_t destino = 1 - banco_atual;
+    if (reserva_apagada != RESERVA_COMPLETA) {
+        return false; // Apagar 128KB aqui pararia o controle de acesso por mais de um segundo
+    }
+    reserva_apagada = 0; // Daqui em diante o banco reserva deixa de estar limpo, mesmo se a cópia falhar
+
+    memset(pagina, 0xFF, sizeof(pagina));
+    pagina[0] = montar_cabecalho(geracao + 1);
+    for (uint32_t i = 0; i < quantidade; i++) {
+        uint32_t registro = i + 1;
+        pagina[registro % REGISTROS_POR_PAGINA] = bancos[banco_atual][indice[i].registro];
+        if (registro % REGISTROS_POR_PAGINA == REGISTROS_POR_PAGINA - 1) {
+            if (!programar_pagina(destino, registro)) {
+                return false;
+            }
+            memset(pagina, 0xFF, sizeof(pagina));
+        }
+    }
+    if (quantidade % REGISTROS_POR_PAGINA != REGISTROS_POR_PAGINA - 1 && !programar_pagina(destino, quantidade)) {
+        return false;
+    }
+
+    // Confirma o banco novo: só o campo confirmado muda (bits 1 -> 0), sem apagar
+    memset(pagina, 0xFF, sizeof(pagina));
+    pagina[0] = montar_cabecalho(geracao + 1);
+    pagina[0].confirmado = 0;
+    if (!programar_pagina(destino, 0)) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < quantidade; i++) {
+        indice[i].registro = (uint16_t)(i + 1);
+    }
+    banco_atual = destino;
+    geracao++;
+    proximo_registro = quantidade + 1;
+    estatisticas.compactacoes++;
+    return true;
+}
+
+/**
+ * @brief Grava um registro no fim do banco atual, compactando antes se ele estiver cheio.
+ * @return Posição do registro, ou 0 se a gravação falhou.
+ */
+static uint16_t acrescentar(const registro_t *registro) {
+    if (proximo_registro >= REGISTROS_POR_BANCO && !compactar()) {
+        return 0;
+    }
+    memset(pagina, 0xFF, sizeof(pagina));
+    pagina[proximo_registro % REGISTROS_POR_PAGINA] = *registro;
+    if (!programar_pagina(banco_atual, proximo_registro)) {
+        return 0;
+    }
+    return (uint16_t)proximo_registro++;
+}
+
+/**
+ * @brief Cria um banco 0 vazio confirmado. O banco 1 fica para credenciais_processar(),
+ * com o Núcleo 0 ocioso, como a reserva de qualquer outro boot.
+ */
+static bool formatar(void) {
+    disponivel = false;
+    if (!apagar_banco(0)) {
+        return false;
+    }
+    memset(pagina, 0xFF, sizeof(pagina));
+    pagina[0] = montar_cabecalho(1);
+    pagina[0].confirmado = 0;
+    if (!programar_pagina(0, 0)) {
+        return false;
+    }
+    banco_atual = 0;
+    geracao = 1;
+    proximo_registro = 1;
+    quantidade = 0;
+    reserva_apagada = 0;
+    disponivel = true;
+    return true;
+}
+
+
+// --- Implementação das Funções Públicas ---
+
+bool credenciais_iniciar(void) {
+    for (uint i = 0; i < CREDENCIAIS_SAL_TAMANHO; i += 4) {
+        uint32_t aleatorio = get_rand_32();
+        memcpy(&registro_ficticio.sal[i], &aleatorio, 4);
+    }
+
+    bool valido[2] = { cabecalho_confirmado(&bancos[0][0]), cabecalho_confirmado(&bancos[1][0]) };
+    if (!valido[0] && !valido[1]) {
+        if (!formatar()) {
+            // Sem banco gravável: segue sem credenciais (toda verificação é recusada)
+            printf("Credenciais: falha ao criar a tabela\n");
+            quantidade = 0;
+            return false;
+        }
+        return true;
+    }
+    if (valido[0] && valido[1]) {
+        banco_atual = (bancos[1][0].cartao > bancos[0][0].cartao) ? 1 : 0;
+    } else {
+        banco_atual = valido[1] ? 1 : 0;
+    }
+    geracao = bancos[banco_atual][0].cartao;
+
+    // Reaplica os registros em ordem: o último de cada cartão prevalece
+    quantidade = 0;
+    const registro_t *banco = bancos[banco_atual];
+    uint32_t registro = 1;
+    for (; registro < REGISTROS_POR_BANCO && banco[registro].marca != MARCA_LIVRE; registro++) {
+        if (!registro_valido(&banco[registro])) {
+            continue; // Gravação interrompida: a posição fica ocupada até a próxima compactação
+        }
+        if (banco[registro].marca == MARCA_PIN) {
+            indice_inserir(banco[registro].cartao, (uint16_t)registro);
+        } else if (banco[registro].marca == MARCA_REMOVIDO) {
+            indice_remover(banco[registro].cartao);
+        }
+    }
+    proximo_registro = registro;
+    reserva_apagada = 0; // Conferido setor a setor por credenciais_processar()
+    disponivel = true;
+    return false;
+}
+
+void credenciais_processar(bool ocioso) {
+    if (!ocioso || !disponivel || reserva_apagada == RESERVA_COMPLETA || !flash_seguro_liberado(&adiamento)) {
+        return;
+    }
+    // Um setor por chamada: cada apagamento para os dois núcleos por ~50ms
+    uint32_t reserva = 1 - banco_atual;
+    uint32_t setor = (uint32_t)__builtin_ctz(~reserva_apagada);
+    if (setor_vazio(reserva, setor) || apagar_setor(reserva, setor)) {
+        reserva_apagada |= 1u << setor;
+    }
+}
+
+bool credenciais_definir(uint32_t cartao, const char *pin) {
+    if (!disponivel || !pin_valido(pin)) {
+        return false;
+    }
+    bool encontrado;
+    buscar(cartao, &encontrado);
+    if (!encontrado && quantidade >= CREDENCIAIS_MAXIMO) {
+        return false;
+    }
+
+    registro_t registro;
+    memset(&registro, 0xFF, sizeof(registro));
+    registro.marca = MARCA_PIN;
+    registro.cartao = cartao;
+    for (uint i = 0; i < CREDENCIAIS_SAL_TAMANHO; i += 4) {
+        uint32_t aleatorio = get_rand_32();
+        memcpy(&registro.sal[i], &aleatorio, 4);
+    }
+    calcular_hash(registro.sal, cartao, pin, registro.hash);
+    registro.verificacao = calcular_verificacao(&registro);
+
+    uint16_t posicao = acrescentar(&registro);
+    if (posicao == 0) {
+        return false;
+    }
+    return indice_inserir(cartao, posicao);
+}
+
+bool credenciais_remover(uint32_t cartao) {
+    if (!disponivel) {
+        return false;
+    }
+    bool encontrado;
+    buscar(cartao, &encontrado);
+    if (!encontrado) {
+        return true;
+    }
+
+    registro_t registro;
+    memset(&registro, 0, sizeof(registro));
+    registro.marca = MARCA_REMOVIDO;
+    registro.cartao = cartao;
+    registro.verificacao = calcular_verificacao(&registro);
+    registro.confirmado = 0xFFFFFFFFu;
+    if (acrescentar(&registro) == 0) {
+        return false;
+    }
+    indice_remover(cartao);
+    return true;
+}
+
+bool credenciais_verificar(uint32_t cartao, const char *pin) {
+    bool encontrado;
+    uint32_t posicao = buscar(cartao, &encontrado);
+    const registro_t *registro = encontrado ? &bancos[banco_atual][indice[posicao].registro] : &registro_ficticio;
+
+    uint8_t hash[SHA256_TAMANHO];
+    calcular_hash(registro->sal, cartao, pin, hash);
+
+    // Comparação em tempo constante: acumula as diferenças sem sair no primeiro byte
+    uint8_t diferenca = 0;
+    for (uint i = 0; i < SHA256_TAMANHO; i++) {
+        diferenca |= hash[i] ^ registro->hash[i];
+    }
+    return encontrado & (diferenca == 0) & pin_valido(pin);
+}
+
+void credenciais_obter_estatisticas(credenciais_estatisticas_t *saida) {
+    *saida = estatisticas;
+    saida->cartoes = quantidade;
+    saida->registros = proximo_registro - 1;
+    saida->capacidade = REGISTROS_POR_BANCO - 1;
+    saida->geracao = geracao;
+    saida->adiamentos = adiamento.adiamentos;
+}
+
+#if CREDENCIAIS_BENCHMARK
+void credenciais_benchmark(void) {
+    static const uint32_t TAMANHOS[] = { 3, 30, 300, CREDENCIAIS_MAXIMO };
+    const uint32_t BASE = 0x10000; // Cartões sintéticos, fora da faixa das cores
+    const uint VERIFICACOES = 200;
+
+    if (!formatar()) {
+        printf("Benchmark credenciais: falha ao apagar a tabela\n");
+        return;
+    }
+    char pin[CREDENCIAIS_PIN_MAXIMO + 1];
+    for (uint t = 0; t < count_of(TAMANHOS); t++) {
+        uint64_t inicio_cadastro_us = time_us_64();
+        while (quantidade < TAMANHOS[t]) {
+            snprintf(pin, sizeof(pin), "%04lu", (unsigned long)(quantidade % 10000));
+            if (!credenciais_definir(BASE + quantidade, pin)) {
+                printf("Benchmark credenciais: falha ao gravar o cartao %lu\n", (unsigned long)quantidade);
+                return;
+            }
+        }
+        uint32_t cadastro_ms = (uint32_t)((time_us_64() - inicio_cadastro_us) / 1000);
+
+        // Metade com o PIN certo, metade errado, e cartões inexistentes
+        uint32_t soma_us = 0, maximo_us = 0, ausentes_us = 0, aceitos = 0;
+        for (uint i = 0; i < VERIFICACOES; i++) {
+            uint32_t alvo = get_rand_32() % quantidade;
+            snprintf(pin, sizeof(pin), "%04lu", (unsigned long)((alvo + (i & 1)) % 10000));
+            uint64_t inicio_us = time_us_64();
+            aceitos += credenciais_verificar(BASE + alvo, pin);
+            uint32_t duracao_us = (uint32_t)(time_us_64() - inicio_us);
+            soma_us += duracao_us;
+            if (duracao_us > maximo_us) maximo_us = duracao_us;
+
+            inicio_us = time_us_64();
+            credenciais_verificar(BASE + CREDENCIAIS_MAXIMO + i, pin);
+            ausentes_us += (uint32_t)(time_us_64() - inicio_us);
+        }
+        printf("Benchmark credenciais: %4lu cartoes: verificacao media %lu us, max %lu us, ausente %lu us (%lu/%u aceitos, cadastro %lu ms)\n",
+               (unsigned long)quantidade, (unsigned long)(soma_us / VERIFICACOES), (unsigned long)maximo_us,
+               (unsigned long)(ausentes_us / VERIFICACOES), (unsigned long)aceitos, VERIFICACOES,
+               (unsigned long)cadastro_ms);
+    }
+
+    // Invalida os dois bancos: o próximo credenciais_iniciar recria a tabela vazia
+    apagar_banco(0);
+    apagar_banco(1);
+}
+#endif
@@ -0,0 +1,90 @@
+/**
+ * @file credenciais.h
+ * @brief Tabela de credenciais em flash: PIN de cada cartão guardado como hash com sal.
+ * Os registros são acrescentados em um de dois bancos da flash (uma troca de PIN
+ * acrescenta um registro novo, que substitui o anterior). Um índice em RAM, ordenado
+ * pela identidade do cartão e montado no boot, localiza o registro por busca binária;
+ * a comparação do hash leva sempre o mesmo tempo. Quando o banco enche, os registros
+ * válidos são copiados para o outro banco, que só passa a valer depois da cópia completa;
+ * esse banco é apagado antes, aos poucos, enquanto a fechadura está ociosa.
+ */
+
+#ifndef CREDENCIAIS_H
+#define CREDENCIAIS_H
+
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "configura_geral.h" // CREDENCIAIS_BENCHMARK
+#include "diario.h"
+
+// --- Região reservada (logo abaixo do diário de eventos) ---
+#define CREDENCIAIS_SETORES_BANCO 32    // 128KB por banco: cabeçalho + 2047 registros de 64 bytes
+#define CREDENCIAIS_OFFSET_FLASH (DIARIO_OFFSET_FLASH - 2 * CREDENCIAIS_SETORES_BANCO * FLASH_SECTOR_SIZE)
+
+// --- Parâmetros ---
+#define CREDENCIAIS_MAXIMO 2000         // Cartões distintos no índice em RAM
+#define CREDENCIAIS_PIN_MAXIMO 8        // Dígitos
+#define CREDENCIAIS_SAL_TAMANHO 16
+
+/**
+ * @struct credenciais_estatisticas_t
+ * @brief Ocupação da tabela.
+ */
+typedef struct {
+    uint32_t cartoes;           ///< Cartões com PIN cadastrado.
+    uint32_t registros;         ///< Registros ocupados no banco atual (inclui substituídos).
+    uint32_t capacidade;        ///< Registros por banco.
+    uint32_t geracao;           ///< Incrementada a cada compactação.
+    uint32_t compactacoes;      ///< Compactações desde o boot.
+    uint32_t adiamentos;        ///< Operações na flash adiadas (Núcleo 1 indisponível).
+} credenciais_estatisticas_t;
+
+/**
+ * @brief Escolhe o banco válido mais recente e monta o índice em RAM.
+ * Chamar no Núcleo 0, antes de lançar o Núcleo 1.
+ * @return true se a tabela estava vazia ou corrompida e foi criada agora (sem cartões).
+ * Se nem isso foi possível, devolve false e a tabela fica sem cartões, recusando gravações.
+ */
+bool credenciais_iniciar(void);
+
+/**
+ * @brief Apaga o banco reserva antecipadamente, um setor por chamada.
+ * @param ocioso Indica que o Núcleo 0 pode parar ~50ms: só então um setor é apagado.
+ */
+void credenciais_processar(bool ocioso);
+
+/**
+ * @brief Cadastra ou troca o PIN de um cartão (grava na flash antes de retornar).
+ * @param cartao Identidade do cartão (hoje, a enum CorDetectada lida pelo sensor).
+ * @param pin Apenas dígitos, de 1 a CREDENCIAIS_PIN_MAXIMO.
+ * @return false se o PIN é inválido, a tabela está cheia ou a flash não pôde ser gravada agora
+ * (inclusive com o banco cheio e o banco reserva ainda não apagado).
+ */
+bool credenciais_definir(uint32_t cartao, const char *pin);
+
+/**
+ * @brief Remove o cartão da tabela.
+ * @return false se a flash não pôde ser gravada agora (cartão ausente conta como removido).
+ */
+bool credenciais_remover(uint32_t cartao);
+
+/**
+ * @brief Confere o PIN de um cartão. O tempo não depende de o cartão existir
+ * nem de quantos bytes do hash coincidem.
+ */
+bool credenciais_verificar(uint32_t cartao, const char *pin);
+
+/**
+ * @brief Copia a ocupação da tabela.
+ */
+void credenciais_obter_estatisticas(credenciais_estatisticas_t *estatisticas);
+
+#if CREDENCIAIS_BENCHMARK
+/**
+ * @brief Mede a verificação com 3, 30, 300 e CREDENCIAIS_MAXIMO cartões e imprime no serial.
+ * Apaga a tabela antes e depois: usar apenas em firmware de teste.
+ */
+void credenciais_benchmark(void);
+#endif
+
+#endif // CREDENCIAIS_H
@@ -0,0 +1,422 @@
+/**
+ * @file diario.c
+ * @brief Implementação do diário de eventos em flash.
+ *
+ * Cada setor começa com um registro de cabeçalho (contador de uso crescente); o setor
+ * com o maior contador é o atual. Os demais registros são eventos ou marcas da posição
+ * confirmada. Os registros se acumulam em RAM e a página só é programada quando enche
+ * ou quando vence o prazo do evento mais antigo; a marca da posição confirmada vai na
+ * mesma programação. Uma página incompleta pode ser programada de novo: os registros
+ * ainda livres ficam em 0xFF e só passam a ser escritos na gravação seguinte.
+ */
+
+#include "diario.h"
+#include "flash_seguro.h"
+#include "configura_geral.h" // FIFO_CMD_PUBLICAR_MQTT
+#include "pico/multicore.h"
+#include "hardware/sync.h"   // __dmb
+#include <string.h>
+
+
+// --- Formato na Flash ---
+
+/**
+ * @brief Registro de 8 bytes: 32 por página, 512 por setor (o primeiro é o cabeçalho).
+ */
+typedef struct {
+    uint32_t sequencia;     // Evento: sequência; cabeçalho: contador de uso; marca: primeira não confirmada
+    uint8_t tipo;           // enum MQTT_MSG_TYPE ou TIPO_*
+    uint8_t cor;
+    uint16_t verificacao;   // Detecta registros incompletos (queda durante a programação)
+} registro_t;
+
+#define TIPO_MARCA 0xFD
+#define TIPO_CABECALHO 0xFE
+#define TIPO_VAZIO 0xFF
+
+#define REGISTROS_POR_PAGINA (FLASH_PAGE_SIZE / sizeof(registro_t))
+#define REGISTROS_POR_SETOR (FLASH_SECTOR_SIZE / sizeof(registro_t))
+#define REGISTROS_TOTAL (DIARIO_SETORES * REGISTROS_POR_SETOR)
+
+// Leitura direta pelo XIP
+static const registro_t *const regiao = (const registro_t *)(XIP_BASE + DIARIO_OFFSET_FLASH);
+
+
+// --- Variáveis Estáticas ---
+
+// Posição de escrita (Núcleo 0)
+static uint32_t setor_atual;
+static uint32_t contador_setor;
+static uint32_t posicao;                            // Próximo registro livre do setor atual
+static bool proximo_apagado;                        // Setor seguinte já apagado antecipadamente
+static registro_t pagina[REGISTROS_POR_PAGINA];     // Imagem da página corrente
+
+// Registros aguardando gravação; índices correm livres
+static registro_t pendentes[DIARIO_PENDENTES];
+static uint32_t pendentes_cabeca = 0, pendentes_cauda = 0;
+static uint64_t prazo_gravacao_us;
+static uint64_t prazo_marca_us;
+static bool marca_aguardando = false;               // Posição confirmada mudou e ainda não foi gravada
+
+static uint32_t proxima_sequencia;
+static uint32_t confirmada_gravada;                 // Valor da última marca gravada
+static uint32_t primeira_pendente;                  // Posição confirmada encontrada no boot
+static volatile uint32_t sequencia_gravada;         // Escrita pelo Núcleo 0 após cada página
+static volatile uint32_t confirmada_nucleo1;        // Escrita pelo Núcleo 1
+
+// Cursor de leitura (Núcleo 1)
+static uint32_t cursor_indice;
+static uint32_t cursor_sequencia;
+static bool cursor_valido = false;
+
+static diario_estatisticas_t estatisticas;
+static flash_seguro_adiamento_t adiamento;
+
+
+// --- Funções Auxiliares Estáticas ---
+
+static uint16_t calcular_verificacao(uint32_t sequencia, uint8_t tipo, uint8_t cor) {
+    uint32_t x = sequencia ^ ((uint32_t)tipo << 24) ^ ((uint32_t)cor << 16) ^ 0x5A5AC3C3u;
+    x ^= x >> 16;
+    x *= 0x45D9F3Bu;
+    x ^= x >> 16;
+    return (uint16_t)x;
+}
+
+static registro_t montar_registro(uint32_t sequencia, uint8_t tipo, uint8_t cor) {
+    registro_t registro = { sequencia, tipo, cor, calcular_verificacao(sequencia, tipo, cor) };
+    return registro;
+}
+
+static bool registro_vazio(const registro_t *registro) {
+    const uint32_t *palavras = (const uint32_t *)registro;
+    return palavras[0] == 0xFFFFFFFFu && palavras[1] == 0xFFFFFFFFu;
+}
+
+static bool registro_valido(const registro_t *registro) {
+    return registro->tipo != TIPO_VAZIO &&
+           registro->verificacao == calcular_verificacao(registro->sequencia, registro->tipo, registro->cor);
+}
+
+static bool registro_evento(const registro_t *registro) {
+    return registro_valido(registro) && registro->tipo < TIPO_MARCA;
+}
+
+static bool setor_vazio(uint32_t setor) {
+    for (uint32_t i = 0; i < REGISTROS_POR_SETOR; i++) {
+        if (!registro_vazio(&regiao[setor * REGISTROS_POR_SETOR + i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// --- Operações na flash ---
+
+/**
+ * @brief Apaga um setor, contabilizando os eventos ainda não confirmados que se perdem.
+ */
+static bool apagar_setor(uint32_t setor) {
+    uint32_t confirmada = confirmada_nucleo1;
+    uint32_t a_perder = 0;
+    for (uint32_t i = 1; i < REGISTROS_POR_SETOR; i++) {
+        const registro_t *registro = &regiao[setor * REGISTROS_POR_SETOR + i];
+        if (registro_evento(registro) && registro->sequencia >= confirmada) {
+            a_perder++;
+        }
+    }
+
+    if (!flash_seguro_apagar_setor(DIARIO_OFFSET_FLASH + setor * FLASH_SECTOR_SIZE, &adiamento)) {
+        return false;
+    }
+    estatisticas.perdidos += a_perder;
+    estatisticas.setores_apagados++;
+    return true;
+}
+
+/**
+ * @brief Passa para o setor seguinte (apagando-o, se preciso) e prepara o cabeçalho.
+ * O cabeçalho vai para a flash junto com os primeiros eventos do setor.
+ */
+static bool avancar_setor(void) {
+    uint32_t proximo = (setor_atual + 1) % DIARIO_SETORES;
+    if (!proximo_apagado && !apagar_setor(proximo)) {
+        return false;
+    }
+    setor_atual = proximo;
+    contador_setor++;
+    posicao = 1;
+    proximo_apagado = false;
+    memset(pagina, 0xFF, sizeof(pagina));
+    pagina[0] = montar_registro(contador_setor, TIPO_CABECALHO, 0);
+    return true;
+}
+
+static uint32_t livres_na_pagina(void) {
+    return (posicao < REGISTROS_POR_SETOR) ? REGISTROS_POR_PAGINA - posicao % REGISTROS_POR_PAGINA
+                                           : REGISTROS_POR_PAGINA;
+}
+
+/**
+ * @brief Copia os eventos pendentes que cabem na página corrente, mais a marca da
+ * posição confirmada se ela mudou e ainda couber, e programa a página.
+ * @return false se a gravação foi adiada (Núcleo 1 indisponível).
+ */
+static bool gravar_pagina(void) {
+    if (posicao >= REGISTROS_POR_SETOR && !avancar_setor()) {
+        return false;
+    }
+
+    uint32_t inicio_pagina = posicao - posicao % REGISTROS_POR_PAGINA;
+    uint32_t livres = livres_na_pagina();
+    uint32_t quantidade = pendentes_cauda - pendentes_cabeca;
+    if (quantidade > livres) {
+        quantidade = livres;
+    }
+    uint32_t gravada = sequencia_gravada;
+    for (uint32_t i = 0; i < quantidade; i++) {
+        const registro_t *registro = &pendentes[(pendentes_cabeca + i) % DIARIO_PENDENTES];
+        pagina[(posicao + i) % REGISTROS_POR_PAGINA] = *registro;
+        gravada = registro->sequencia + 1;
+    }
+    uint32_t confirmada = confirmada_nucleo1;
+    uint32_t escritos = quantidade;
+    if (confirmada != confirmada_gravada && escritos < livres) {
+        pagina[(posicao + escritos) % REGISTROS_POR_PAGINA] = montar_registro(confirmada, TIPO_MARCA, 0);
+        escritos++;
+    }
+    // Sobras de uma tentativa adiada com mais registros voltam a ficar livres
+    for (uint32_t i = escritos; i < livres; i++) {
+        memset(&pagina[(posicao + i) % REGISTROS_POR_PAGINA], 0xFF, sizeof(registro_t));
+    }
+
+    uint32_t offset = DIARIO_OFFSET_FLASH + setor_atual * FLASH_SECTOR_SIZE + inicio_pagina * sizeof(registro_t);
+    if (!flash_seguro_programar_pagina(offset, (const uint8_t *)pagina, &adiamento)) {
+        // Os registros serão copiados de novo para as mesmas posições na próxima tentativa
+        return false;
+    }
+
+    if (escritos > quantidade) {
+        confirmada_gravada = confirmada;
+        marca_aguardando = false;
+    }
+    posicao += escritos;
+    pendentes_cabeca += quantidade;
+    if (posicao % REGISTROS_POR_PAGINA == 0) {
+        memset(pagina, 0xFF, sizeof(pagina));
+    }
+    estatisticas.paginas_gravadas++;
+    if (quantidade == 0) {
+        return true; // Só a marca: nada novo para o Núcleo 1 publicar
+    }
+
+    __dmb();
+    sequencia_gravada = gravada;
+    // Campainha para o Núcleo 1 publicar os novos eventos
+    if (multicore_fifo_wready()) {
+        multicore_fifo_push_blocking(FIFO_CMD_PUBLICAR_MQTT << 16);
+    }
+    return true;
+}
+
+static bool enfileirar_registro(registro_t registro) {
+    if (pendentes_cauda - pendentes_cabeca >= DIARIO_PENDENTES) {
+        return false;
+    }
+    if (pendentes_cauda == pendentes_cabeca) {
+        prazo_gravacao_us = time_us_64() + DIARIO_ATRASO_GRAVACAO_US;
+    }
+    pendentes[pendentes_cauda % DIARIO_PENDENTES] = registro;
+    pendentes_cauda++;
+    return true;
+}
+
+/**
+ * @brief Posiciona o cursor de leitura no evento de menor sequência >= a pedida.
+ */
+static bool localizar(uint32_t sequencia) {
+    bool encontrado = false;
+    for (uint32_t i = 0; i < REGISTROS_TOTAL; i++) {
+        const registro_t *registro = &regiao[i];
+        if (registro_evento(registro) && registro->sequencia >= sequencia &&
+            (!encontrado || registro->sequencia < cursor_sequencia)) {
+            cursor_indice = i;
+            cursor_sequencia = registro->sequencia;
+            encontrado = true;
+        }
+    }
+    cursor_valido = encontrado;
+    return encontrado;
+}
+
+
+// --- Implementação das Funções Públicas (Núcleo 0) ---
+
+void diario_iniciar(void) {
+    bool encontrado = false;
+    bool ha_marca = false;
+    uint32_t maior_marca = 0;
+    proxima_sequencia = 0;
+
+    for (uint32_t setor = 0; setor < DIARIO_SETORES; setor++) {
+        const registro_t *cabecalho = &regiao[setor * REGISTROS_POR_SETOR];
+        if (registro_valido(cabecalho) && cabecalho->tipo == TIPO_CABECALHO &&
+            (!encontrado || (int32_t)(cabecalho->sequencia - contador_setor) > 0)) {
+            setor_atual = setor;
+            contador_setor = cabecalho->sequencia;
+            encontrado = true;
+        }
+        for (uint32_t i = 1; i < REGISTROS_POR_SETOR; i++) {
+            const registro_t *registro = &cabecalho[i];
+            if (!registro_valido(registro)) {
+                continue;
+            }
+            if (registro->tipo == TIPO_MARCA) {
+                if (!ha_marca || registro->sequencia > maior_marca) {
+                    maior_marca = registro->sequencia;
+                }
+                ha_marca = true;
+            } else if (registro->tipo < TIPO_MARCA && registro->sequencia >= proxima_sequencia) {
+                proxima_sequencia = registro->sequencia + 1;
+            }
+        }
+    }
+
+    if (encontrado) {
+        // Primeiro registro livre do setor atual
+        posicao = 1;
+        while (posicao < REGISTROS_POR_SETOR && !registro_vazio(&regiao[setor_atual * REGISTROS_POR_SETOR + posicao])) {
+            posicao++;
+        }
+    } else {
+        // Diário vazio ou ilegível: a primeira gravação formata o setor 0
+        setor_atual = DIARIO_SETORES - 1;
+        contador_setor = 0;
+        posicao = REGISTROS_POR_SETOR;
+    }
+    proximo_apagado = setor_vazio((setor_atual + 1) % DIARIO_SETORES);
+    if (posicao < REGISTROS_POR_SETOR) {
+        memcpy(pagina, &regiao[setor_atual * REGISTROS_POR_SETOR + posicao - posicao % REGISTROS_POR_PAGINA], FLASH_PAGE_SIZE);
+    }
+
+    sequencia_gravada = proxima_sequencia;
+    primeira_pendente = ha_marca ? maior_marca : 0;
+    confirmada_gravada = primeira_pendente;
+    confirmada_nucleo1 = primeira_pendente;
+}
+
+bool diario_registrar(uint8_t tipo, uint8_t cor) {
+    if (!enfileirar_registro(montar_registro(proxima_sequencia, tipo, cor))) {
+        estatisticas.perdidos++;
+        return false;
+    }
+    proxima_sequencia++;
+    estatisticas.registrados++;
+    return true;
+}
+
+void diario_processar(bool ocioso) {
+    uint64_t agora = time_us_64();
+
+    // Posição confirmada: vai junto com a próxima página de eventos; sozinha, só depois
+    // de DIARIO_ATRASO_MARCA_US, para não gastar uma programação da flash com cada marca
+    if (!marca_aguardando && confirmada_nucleo1 != confirmada_gravada) {
+        marca_aguardando = true;
+        prazo_marca_us = agora + DIARIO_ATRASO_MARCA_US;
+    }
+
+    // Uma página por volta: cada programação para os dois núcleos por ~1ms
+    uint32_t quantidade = pendentes_cauda - pendentes_cabeca;
+    bool eventos_vencidos = quantidade > 0 && (agora >= prazo_gravacao_us || quantidade >= livres_na_pagina());
+    bool marca_vencida = marca_aguardando && agora >= prazo_marca_us;
+    if ((eventos_vencidos || marca_vencida) && flash_seguro_liberado(&adiamento) && !gravar_pagina()) {
+        prazo_gravacao_us = to_us_since_boot(adiamento.proxima_tentativa);
+        if (marca_vencida) {
+            prazo_marca_us = prazo_gravacao_us;
+        }
+    }
+
+    // Apagar leva ~50ms: feito antes de o setor atual encher, enquanto não há interação
+    if (ocioso && !proximo_apagado && posicao >= REGISTROS_POR_SETOR * 3 / 4 && flash_seguro_liberado(&adiamento)) {
+        proximo_apagado = apagar_setor((setor_atual + 1) % DIARIO_SETORES);
+    }
+}
+
+absolute_time_t diario_proximo_prazo(void) {
+    absolute_time_t prazo = at_the_end_of_time;
+    if (pendentes_cauda != pendentes_cabeca) {
+        prazo = from_us_since_boot(prazo_gravacao_us);
+    }
+    if (marca_aguardando) {
+        prazo = absolute_time_min(prazo, from_us_since_boot(prazo_marca_us));
+    }
+    return prazo;
+}
+
+void diario_obter_estatisticas(diario_estatisticas_t *saida) {
+    *saida = estatisticas;
+    saida->em_ram = pendentes_cauda - pendentes_cabeca;
+    saida->adiamentos = adiamento.adiamentos;
+    saida->nao_confirmados = sequencia_gravada - confirmada_nucleo1;
+}
+
+
+// --- Implementação das Funções Públicas (Núcleo 1) ---
+
+uint32_t diario_primeira_pendente(void) {
+    return primeira_pendente;
+}
+
+uint32_t diario_sequencia_gravada(void) {
+    return sequencia_gravada;
+}
+
+uint diario_ler(uint32_t sequencia, diario_entrada_t *entradas, uint maximo) {
+    uint32_t gravada = sequencia_gravada;
+    __dmb();
+    if (sequencia >= gravada || maximo == 0) {
+        return 0;
+    }
+    if (!cursor_valido || sequencia != cursor_sequencia) {
+        if (!localizar(sequencia)) {
+            return 0;
+        }
+    }
+
+    uint quantidade = 0;
+    uint32_t indice = cursor_indice;
+    uint32_t esperada = cursor_sequencia;
+    for (uint32_t passos = 0; passos < REGISTROS_TOTAL && quantidade < maximo; passos++) {
+        const registro_t *registro = &regiao[indice];
+        if (indice % REGISTROS_POR_SETOR == 0) {
+            // Setor seguinte ainda não está em uso
+            if (!registro_valido(registro) || registro->tipo != TIPO_CABECALHO) {
+                break;
+            }
+        } else if (registro_vazio(registro)) {
+            break; // Fim do que já foi gravado
+        } else if (registro_evento(registro)) {
+            if (registro->sequencia < esperada || registro->sequencia >= gravada) {
+                break; // Eventos antigos de uma volta anterior do diário
+            }
+            entradas[quantidade].sequencia = registro->sequencia;
+            entradas[quantidade].tipo = registro->tipo;
+            entradas[quantidade].cor = registro->cor;
+            quantidade++;
+            esperada = registro->sequencia + 1;
+        }
+        indice = (indice + 1) % REGISTROS_TOTAL;
+    }
+
+    if (quantidade == 0) {
+        cursor_valido = false; // O setor sob o cursor foi reutilizado: localiza de novo
+        return 0;
+    }
+    cursor_indice = indice;
+    cursor_sequencia = esperada;
+    return quantidade;
+}
+
+void diario_confirmar(uint32_t sequencia) {
+    confirmada_nucleo1 = sequencia;
+}
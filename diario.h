@@ -0,0 +1,106 @@
+/**
+ * @file diario.h
+ * @brief Diário de eventos de histórico em flash (somente acréscimo, circular).
+ * Todo evento MSG_LOG_* recebe um número de sequência e é gravado em formato binário
+ * compacto numa região reservada no fim da flash. As gravações são agrupadas em RAM
+ * e programadas por página e os setores são usados em rodízio (nivelamento de desgaste). O Núcleo 1
+ * publica a partir do diário e informa até onde o broker confirmou; essa posição
+ * também é gravada, de modo que após uma queda ou reinício a reprodução continua
+ * do primeiro evento ainda não confirmado.
+ */
+
+#ifndef DIARIO_H
+#define DIARIO_H
+
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+
+// --- Região reservada (fim da flash, fora do binário) ---
+#define DIARIO_SETORES 16   // 64KB: 16 x 511 eventos
+#define DIARIO_OFFSET_FLASH (PICO_FLASH_SIZE_BYTES - DIARIO_SETORES * FLASH_SECTOR_SIZE)
+
+// --- Parâmetros ---
+#define DIARIO_PENDENTES 64                 // Eventos aguardando gravação em RAM
+#define DIARIO_ATRASO_GRAVACAO_US 250000    // Maior espera de um evento antes de ir para a flash
+#define DIARIO_ATRASO_MARCA_US 30000000     // Maior espera da posição confirmada sem eventos para acompanhá-la
+
+/**
+ * @struct diario_entrada_t
+ * @brief Evento lido do diário.
+ */
+typedef struct {
+    uint32_t sequencia;
+    uint8_t tipo;       ///< enum MQTT_MSG_TYPE.
+    uint8_t cor;        ///< enum CorDetectada.
+} diario_entrada_t;
+
+/**
+ * @struct diario_estatisticas_t
+ * @brief Contadores do diário.
+ */
+typedef struct {
+    uint32_t registrados;       ///< Eventos aceitos desde o boot.
+    uint32_t em_ram;            ///< Eventos aguardando gravação.
+    uint32_t nao_confirmados;   ///< Eventos na flash ainda não confirmados pelo broker.
+    uint32_t paginas_gravadas;
+    uint32_t setores_apagados;
+    uint32_t adiamentos;        ///< Gravações adiadas (Núcleo 1 indisponível).
+    uint32_t perdidos;          ///< Eventos descartados (RAM cheia ou sobrescritos antes da confirmação).
+} diario_estatisticas_t;
+
+// --- Núcleo 0 ---
+
+/**
+ * @brief Varre a região do diário e recupera a posição de escrita, a próxima sequência
+ * e a última posição confirmada. Chamar antes de lançar o Núcleo 1.
+ */
+void diario_iniciar(void);
+
+/**
+ * @brief Registra um evento (não-bloqueante; a gravação ocorre em diario_processar).
+ * @return false se o buffer em RAM estava cheio e o evento foi perdido.
+ */
+bool diario_registrar(uint8_t tipo, uint8_t cor);
+
+/**
+ * @brief Programa a página corrente quando ela enche ou quando vence o prazo dos eventos
+ * (ou, sem eventos, o da posição confirmada).
+ * @param ocioso Indica que o Núcleo 0 pode parar ~50ms: o próximo setor é apagado
+ * antecipadamente, para que a troca de setor não precise apagar no meio de uma operação.
+ */
+void diario_processar(bool ocioso);
+
+/**
+ * @brief Prazo da próxima gravação pendente (at_the_end_of_time se nenhuma).
+ */
+absolute_time_t diario_proximo_prazo(void);
+
+/**
+ * @brief Copia os contadores do diário.
+ */
+void diario_obter_estatisticas(diario_estatisticas_t *estatisticas);
+
+// --- Núcleo 1 ---
+
+/**
+ * @brief Sequência do primeiro evento não confirmado encontrado no boot.
+ */
+uint32_t diario_primeira_pendente(void);
+
+/**
+ * @brief Sequência seguinte ao último evento já gravado na flash.
+ */
+uint32_t diario_sequencia_gravada(void);
+
+/**
+ * @brief Lê eventos em ordem a partir de uma sequência (ou do primeiro posterior, se ela se perdeu).
+ * @return Quantidade de entradas copiadas (0 se não há eventos gravados a partir dela).
+ */
+uint diario_ler(uint32_t sequencia, diario_entrada_t *entradas, uint maximo);
+
+/**
+ * @brief Informa que todos os eventos com sequência menor que a indicada foram confirmados.
+ */
+void diario_confirmar(uint32_t sequencia);
+
+#endif // DIARIO_H
@@ -8,23 +8,93 @@
 static uint8_t buffer_oled[ssd1306_buffer_length];
 static struct render_area area;
 
+// Cópia-sombra do que o painel está mostrando de fato. Comparando o buffer novo
+// com esta cópia, só as colunas alteradas de cada página vão para o barramento.
+// A sombra também é a origem do DMA, por isso uma página só é regravada nela
+// depois que a transação anterior daquela página terminou.
+static uint8_t buffer_painel[ssd1306_buffer_length];
+static i2c_dma_id_t transacao_pagina[ssd1306_n_pages]; // Último envio de dados de cada página
+static bool pagina_invalida[ssd1306_n_pages];          // Envio falhou: reenviar a página inteira
+static bool envio_pendente = false;                    // Há páginas a enviar ou envios a conferir
+
+// Contagem de atualizações de tela e contadores do driver no início da última delas
+// (páginas adiadas para display_processar() também entram na conta dessa atualização)
+static uint32_t quadros = 0;
+static ssd1306_estatisticas_t inicio_quadro;
+
+// Envia ao painel apenas as faixas de colunas que mudaram em cada página.
+// Páginas idênticas à sombra não geram nenhum tráfego I2C. Páginas que não puderam
+// ser enviadas agora (fila cheia ou envio anterior em curso) ficam para display_processar().
+static void display_enviar_diferencas() {
+    envio_pendente = false;
+    for (uint8_t pagina = 0; pagina < ssd1306_n_pages; pagina++) {
+        const int base = pagina * ssd1306_width;
+        int inicio = 0;
+        int fim = ssd1306_width - 1;
+
+        if (i2c_dma_em_curso(i2c1, transacao_pagina[pagina])) {
+            envio_pendente = true; // O DMA ainda lê esta página da sombra
+            continue;
+        }
+        i2c_dma_resultado_t resultado = i2c_dma_estado(i2c1, transacao_pagina[pagina]);
+        if (resultado == I2C_DMA_ERRO_NAK || resultado == I2C_DMA_ERRO_TIMEOUT) {
+            pagina_invalida[pagina] = true; // O painel pode não ter recebido o conteúdo
+        }
+        transacao_pagina[pagina] = 0;
+
+        if (!pagina_invalida[pagina]) {
+            // Procura a primeira e a última coluna diferentes nesta página
+            while (inicio < ssd1306_width && buffer_oled[base + inicio] == buffer_painel[base + inicio]) {
+                inicio++;
+            }
+            if (inicio == ssd1306_width) {
+                continue; // Página inalterada
+            }
+            while (buffer_oled[base + fim] == buffer_painel[base + fim]) {
+                fim--;
+            }
+        }
+
+        if (!ssd1306_pronto_para_renderizar()) {
+            envio_pendente = true; // Fila do barramento cheia: tenta de novo depois
+            continue;
+        }
+
+        // O DMA lê da sombra: ela recebe a faixa antes do envio
+        memcpy(&buffer_painel[base + inicio], &buffer_oled[base + inicio], fim - inicio + 1);
+
+        struct render_area faixa = {
+            .start_column = inicio,
+            .end_column = fim,
+            .start_page = pagina,
+            .end_page = pagina,
+        };
+        calculate_render_area_buffer_length(&faixa);
+        transacao_pagina[pagina] = render_on_display(&buffer_painel[base + inicio], &faixa);
+        // Sem envio, a sombra não corresponde mais ao painel: a página inteira vai de novo
+        pagina_invalida[pagina] = (transacao_pagina[pagina] == 0);
+        envio_pendente = true; // Confere o resultado do envio (ou tenta de novo) na próxima passagem
+    }
+}
+
 // Função auxiliar estática para limpar o buffer e a tela.
 // "static" significa que ela só é visível dentro deste arquivo.
+// Envia o quadro inteiro, pois o conteúdo do painel após o reset é desconhecido.
 static void display_clear() {
     memset(buffer_oled, 0, ssd1306_buffer_length);
-    render_on_display(buffer_oled, &area);
+    memset(buffer_painel, 0, ssd1306_buffer_length);
+    i2c_dma_id_t id = render_on_display(buffer_painel, &area);
+    for (uint8_t pagina = 0; pagina < ssd1306_n_pages; pagina++) {
+        transacao_pagina[pagina] = id;
+        pagina_invalida[pagina] = (id == 0);
+    }
+    envio_pendente = true;
 }
 
 // Implementação da função de inicialização
 void display_init() {
-    // Inicializa o barramento I2C na porta i2c1
-    i2c_init(i2c1, 400 * 1000);
-
-    // Define os pinos SDA e SCL para a função I2C
-    gpio_set_function(SDA_PIN, GPIO_FUNC_I2C);
-    gpio_set_function(SCL_PIN, GPIO_FUNC_I2C);
-    gpio_pull_up(SDA_PIN);
-    gpio_pull_up(SCL_PIN);
+    // Inicializa o barramento I2C na porta i2c1 (pinos SDA/SCL) sob o motor de DMA
+    i2c_dma_init(i2c1, SDA_PIN, SCL_PIN, 400 * 1000);
 
     // Inicializa o controlador do display
     ssd1306_init();
@@ -42,6 +112,9 @@ void display_init() {
 
 // Implementação da função de exibir mensagens
 void display_show_message(const char *line1, const char *line2, const char *line3) {
+    quadros++;
+    ssd1306_obter_estatisticas(&inicio_quadro);
+
     // Primeiro, limpa o buffer com zeros.
     memset(buffer_oled, 0, ssd1306_buffer_length);
 
@@ -56,6 +129,31 @@ void display_show_message(const char *line1, const char *line2, const char *line
         ssd1306_draw_utf8_multiline(buffer_oled, 0, 56, line3);
     }
 
-    // Finalmente, envia o buffer pronto para a tela de uma vez
-    render_on_display(buffer_oled, &area);
+    // Finalmente, envia para a tela somente o que mudou em relação ao painel
+    display_enviar_diferencas();
+}
+
+// Conclui envios que ficaram pendentes e confere o resultado dos anteriores
+void display_processar() {
+    if (envio_pendente) {
+        display_enviar_diferencas();
+    }
+}
+
+// Total de bytes transmitidos ao display desde o boot
+uint32_t display_bytes_enviados() {
+    ssd1306_estatisticas_t atual;
+    ssd1306_obter_estatisticas(&atual);
+    return atual.bytes;
+}
+
+// Custo de barramento acumulado e da última atualização de tela
+void display_obter_estatisticas(display_estatisticas_t *saida) {
+    ssd1306_estatisticas_t atual;
+    ssd1306_obter_estatisticas(&atual);
+    saida->quadros = quadros;
+    saida->transacoes_total = atual.transacoes;
+    saida->bytes_total = atual.bytes;
+    saida->transacoes_ultimo_quadro = atual.transacoes - inicio_quadro.transacoes;
+    saida->bytes_ultimo_quadro = atual.bytes - inicio_quadro.bytes;
 }
\ No newline at end of file
@@ -1,11 +1,35 @@
 #ifndef DISPLAY_H
 #define DISPLAY_H
 
+#include <stdint.h>
+
+// Custo de barramento das atualizações do display
+typedef struct {
+    uint32_t quadros;                  // Chamadas a display_show_message()
+    uint32_t transacoes_total;         // Transações I2C desde o boot
+    uint32_t bytes_total;              // Bytes no barramento desde o boot
+    uint32_t transacoes_ultimo_quadro; // Transações gastas pela última atualização
+    uint32_t bytes_ultimo_quadro;      // Bytes gastos pela última atualização
+} display_estatisticas_t;
+
 // Inicializa o display OLED e o barramento I2C. Deve ser chamada uma vez.
 void display_init();
 
 // Limpa o display e exibe até três linhas de texto.
 // As linhas podem ser NULL para não desenhar nada naquela posição.
+// Apenas as colunas alteradas de cada página são retransmitidas ao painel,
+// de forma assíncrona (DMA): a função não espera o barramento.
 void display_show_message(const char *line1, const char *line2, const char *line3);
 
+// Envia as páginas que não couberam na fila do barramento e reenvia as que falharam.
+// Não bloqueia; deve ser chamada periodicamente no loop principal.
+void display_processar();
+
+// Retorna o total de bytes enviados ao display pelo I2C desde o boot
+// (endereço, bytes de controle, comandos e dados). Útil para medir a economia.
+uint32_t display_bytes_enviados();
+
+// Copia os contadores de transações e bytes (totais e da última atualização de tela).
+void display_obter_estatisticas(display_estatisticas_t *saida);
+
 #endif // DISPLAY_H
\ No newline at end of file
@@ -0,0 +1,73 @@
+/**
+ * @file energia.c
+ * @brief Implementação do sono do Núcleo 0 entre eventos e das métricas do loop.
+ */
+
+#include "energia.h"
+#include "pico/time.h"
+
+
+// --- Variáveis Estáticas ---
+
+// Acumuladores da janela corrente
+static uint64_t inicio_janela_us;
+static uint64_t dormindo_us;
+static uint32_t iteracoes;
+static uint32_t despertares;
+
+// Resultado da última janela completa
+static energia_metricas_t metricas;
+
+
+// --- Funções Auxiliares Estáticas ---
+
+/**
+ * @brief Fecha a janela de medição quando ENERGIA_JANELA_US se passou.
+ */
+static void fechar_janela(uint64_t agora_us) {
+    if (inicio_janela_us == 0) {
+        inicio_janela_us = agora_us;
+        return;
+    }
+    uint64_t decorrido = agora_us - inicio_janela_us;
+    if (decorrido < ENERGIA_JANELA_US) {
+        return;
+    }
+
+    metricas.iteracoes_por_segundo = (uint32_t)(((uint64_t)iteracoes * 1000000) / decorrido);
+    metricas.despertares = despertares;
+    metricas.ociosidade_permil = (uint16_t)((dormindo_us * 1000) / decorrido);
+
+    inicio_janela_us = agora_us;
+    dormindo_us = 0;
+    iteracoes = 0;
+    despertares = 0;
+}
+
+
+// --- Implementação das Funções Públicas ---
+
+void energia_dormir_ate(absolute_time_t prazo) {
+    // Limita o sono para que as métricas (e qualquer prazo esquecido) avancem
+    prazo = absolute_time_min(prazo, make_timeout_time_us(ENERGIA_SONO_MAXIMO_US));
+    if (time_reached(prazo)) {
+        return;
+    }
+
+    uint64_t antes = time_us_64();
+    // Um único WFE: sai no prazo (alarme) ou em qualquer evento/interrupção.
+    // Os tratadores de interrupção dos periféricos executam __sev(), então um evento
+    // ocorrido entre o cálculo do prazo e este ponto também não é perdido.
+    best_effort_wfe_or_timeout(prazo);
+    dormindo_us += time_us_64() - antes;
+    despertares++;
+}
+
+void energia_registrar_iteracao(void) {
+    iteracoes++;
+    fechar_janela(time_us_64());
+}
+
+void energia_obter_metricas(energia_metricas_t *saida) {
+    *saida = metricas;
+}
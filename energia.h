@@ -0,0 +1,44 @@
+/**
+ * @file energia.h
+ * @brief Sono do Núcleo 0 entre eventos (WFE) e métricas do loop principal.
+ * O loop calcula o prazo mais próximo de que precisa e dorme até ele; qualquer
+ * interrupção (teclado, FIFO inter-core, I2C, alarmes) acorda o núcleo antes.
+ */
+
+#ifndef ENERGIA_H
+#define ENERGIA_H
+
+#include "pico/stdlib.h"
+
+// --- Parâmetros ---
+#define ENERGIA_SONO_MAXIMO_US 1000000  // Maior intervalo sem acordar, mesmo sem prazos pendentes (1s)
+#define ENERGIA_JANELA_US 1000000       // Janela de cálculo das métricas (1s)
+
+/**
+ * @struct energia_metricas_t
+ * @brief Métricas da última janela completa de ENERGIA_JANELA_US.
+ */
+typedef struct {
+    uint32_t iteracoes_por_segundo; ///< Voltas do loop principal.
+    uint32_t despertares;           ///< Vezes em que o núcleo saiu do WFE.
+    uint16_t ociosidade_permil;     ///< Fração do tempo dormindo, em milésimos.
+} energia_metricas_t;
+
+/**
+ * @brief Dorme (WFE) até o prazo ou até o primeiro evento/interrupção.
+ * Retorna imediatamente se o prazo já passou.
+ * @param prazo Instante em que o loop precisa voltar a executar.
+ */
+void energia_dormir_ate(absolute_time_t prazo);
+
+/**
+ * @brief Contabiliza uma volta do loop principal (chamar uma vez por iteração).
+ */
+void energia_registrar_iteracao(void);
+
+/**
+ * @brief Copia as métricas da última janela completa.
+ */
+void energia_obter_metricas(energia_metricas_t *metricas);
+
+#endif // ENERGIA_H
@@ -0,0 +1,78 @@
+/**
+ * @file eventos.c
+ * @brief Implementação do anel de eventos produtor único / consumidor único entre os núcleos.
+ */
+
+#include "eventos.h"
+#include "configura_geral.h" // FIFO_CMD_PUBLICAR_MQTT
+#include "pico/multicore.h"
+#include "hardware/sync.h"   // __dmb
+
+
+// --- Variáveis Estáticas ---
+
+// Índices correm livres (nunca são reduzidos) e a posição é índice % EVENTOS_CAPACIDADE.
+// 'escrita' só é alterado pelo Núcleo 0 e 'leitura' só pelo Núcleo 1.
+static evento_t anel[EVENTOS_CAPACIDADE];
+static volatile uint32_t indice_escrita = 0;
+static volatile uint32_t indice_leitura = 0;
+
+// Contadores mantidos pelo produtor
+static uint32_t ocupacao_maxima = 0;
+static uint32_t enviados = 0;
+static uint32_t descartados = 0;
+
+
+// --- Implementação das Funções Públicas ---
+
+bool eventos_enviar(uint8_t tipo, uint8_t cor, uint32_t argumento) {
+    uint32_t escrita = indice_escrita;
+    uint32_t ocupacao = escrita - indice_leitura;
+    if (ocupacao >= EVENTOS_CAPACIDADE) {
+        descartados++;
+        return false;
+    }
+
+    evento_t *evento = &anel[escrita % EVENTOS_CAPACIDADE];
+    evento->tipo = tipo;
+    evento->cor = cor;
+    evento->instante_ms = to_ms_since_boot(get_absolute_time());
+    evento->argumento = argumento;
+
+    // O conteúdo do evento precisa estar visível antes do índice que o publica
+    __dmb();
+    indice_escrita = escrita + 1;
+
+    enviados++;
+    if (ocupacao + 1 > ocupacao_maxima) {
+        ocupacao_maxima = ocupacao + 1;
+    }
+
+    // Campainha: se a FIFO estiver cheia já há avisos pendentes e o Núcleo 1 esvaziará o anel todo
+    if (multicore_fifo_wready()) {
+        multicore_fifo_push_blocking(FIFO_CMD_PUBLICAR_MQTT << 16);
+    }
+    return true;
+}
+
+bool eventos_retirar(evento_t *evento) {
+    uint32_t leitura = indice_leitura;
+    if (leitura == indice_escrita) {
+        return false;
+    }
+    // Lê o evento só depois de observar o índice que o publicou
+    __dmb();
+    *evento = anel[leitura % EVENTOS_CAPACIDADE];
+
+    // A posição só é devolvida ao produtor depois que a cópia terminou
+    __dmb();
+    indice_leitura = leitura + 1;
+    return true;
+}
+
+void eventos_obter_estatisticas(eventos_estatisticas_t *estatisticas) {
+    estatisticas->ocupacao = indice_escrita - indice_leitura;
+    estatisticas->ocupacao_maxima = ocupacao_maxima;
+    estatisticas->enviados = enviados;
+    estatisticas->descartados = descartados;
+}
@@ -0,0 +1,57 @@
+/**
+ * @file eventos.h
+ * @brief Anel de eventos em SRAM compartilhada, do Núcleo 0 (produtor) para o Núcleo 1 (consumidor).
+ * Substitui o empacotamento de eventos em 16 bits na FIFO de hardware: a FIFO passa a ser
+ * apenas a "campainha" que acorda o Núcleo 1, e o evento completo trafega pelo anel.
+ */
+
+#ifndef EVENTOS_H
+#define EVENTOS_H
+
+#include "pico/stdlib.h"
+
+// Capacidade do anel (potência de 2: os índices correm livres e são mascarados)
+#define EVENTOS_CAPACIDADE 64
+
+/**
+ * @struct evento_t
+ * @brief Evento do Núcleo 0 a ser publicado pelo Núcleo 1.
+ */
+typedef struct {
+    uint8_t tipo;           ///< enum MQTT_MSG_TYPE.
+    uint8_t cor;            ///< enum CorDetectada associada ao evento.
+    uint32_t instante_ms;   ///< Momento do evento (ms desde o boot), registrado pelo produtor.
+    uint32_t argumento;     ///< Dado adicional do evento (significado depende do tipo).
+} evento_t;
+
+/**
+ * @struct eventos_estatisticas_t
+ * @brief Contadores de uso do anel.
+ */
+typedef struct {
+    uint32_t ocupacao;          ///< Eventos aguardando o consumidor.
+    uint32_t ocupacao_maxima;   ///< Maior ocupação observada pelo produtor.
+    uint32_t enviados;          ///< Eventos aceitos no anel.
+    uint32_t descartados;       ///< Eventos perdidos por anel cheio.
+} eventos_estatisticas_t;
+
+/**
+ * @brief Coloca um evento no anel e toca a campainha do Núcleo 1 (não-bloqueante).
+ * @note Apenas o Núcleo 0 pode chamar (produtor único).
+ * @return false se o anel estava cheio e o evento foi descartado.
+ */
+bool eventos_enviar(uint8_t tipo, uint8_t cor, uint32_t argumento);
+
+/**
+ * @brief Retira o evento mais antigo do anel.
+ * @note Apenas o Núcleo 1 pode chamar (consumidor único).
+ * @return false se o anel está vazio.
+ */
+bool eventos_retirar(evento_t *evento);
+
+/**
+ * @brief Copia os contadores de uso do anel.
+ */
+void eventos_obter_estatisticas(eventos_estatisticas_t *estatisticas);
+
+#endif // EVENTOS_H
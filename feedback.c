@@ -1,38 +1,39 @@
 /**
  * @file feedback.c
  * @brief Implementação do módulo de feedback ao usuário.
- * Orquestra outros drivers (buzzer, matriz, led rgb) para criar
- * respostas audiovisuais complexas e significativas.
+ * Orquestra o buzzer e descreve, como dados para o motor de animações,
+ * as respostas visuais na matriz e no LED RGB.
  */
 
 #include "feedback.h"
 #include "buzzer.h"
-#include "matriz.h"
-#include "rgb_led.h"
-#include "configura_geral.h" // Para PWM_MAX_DUTY
-#include "pico/time.h"      // Para get_absolute_time, absolute_time_diff_us
+#include "configura_geral.h" // Para os tempos das animações
+#include "cor.h"            // Para o xorshift e a subtração saturada do fogo
 
 
-// --- Variáveis Estáticas Globais (visíveis apenas neste arquivo) ---
+// --- Definições ---
+#define VERMELHO 0xFF0000
+#define AMARELO 0xFFFF00
+#define APAGADO 0x000000
+// Cores em escala perceptual (a gama é aplicada na saída), com a intensidade que a matriz tinha antes da gama
+#define VERMELHO_MATRIZ 0xC80000
+#define AMARELO_MATRIZ 0xC89200
+#define VERDE_MATRIZ 0x00C800
+#define VERMELHO_FECHANDO 0xE40000
+#define ERRO_QUADRO_MS (ERRO_FRAME_DELAY_US / 1000)
+#define TIMEOUT_QUADRO_MS (TIMEOUT_FRAME_DELAY_US / 1000)
+#define FOGO_RESFRIAMENTO 0x0A0500 // Perda por linha ao subir: vermelho -10, verde -5
 
-// Variáveis de controle para feedback_visual_erro_update
-static int erro_frame_atual = 0;
-static absolute_time_t erro_ultimo_frame_tempo;
-#define ERRO_FRAME_DELAY_US 200000 // 200ms por fase (ligado/desligado)
 
-// Variáveis de controle para feedback_visual_timeout_update
-static int timeout_frame_atual = 0;
-static absolute_time_t timeout_ultimo_frame_tempo;
-#define TIMEOUT_FRAME_DELAY_US 200000 // 200ms por fase (ligado/desligado)
+// --- Variáveis Estáticas Globais (visíveis apenas neste arquivo) ---
 
-// Variáveis de controle para feedback_visual_fechando_update
-static int fechando_frame_atual = 0;
-static absolute_time_t fechando_ultimo_frame_tempo;
-#define FECHANDO_FRAME_DELAY_US 400000      // 400ms para a primeira fase
-#define FECHANDO_INTERVALO_FINAL_US 150000  // 150ms para a segunda fase
+// Três bipes de 880Hz separados por pausas
+static const buzzer_nota_t MELODIA_TIMEOUT[] = {
+    {880, 100}, {0, 50}, {880, 100}, {0, 50}, {880, 100},
+};
 
 
-// --- Implementação do Feedback Sonoro (Bloqueante) ---
+// --- Implementação do Feedback Sonoro (Não-Bloqueante) ---
 
 /**
  * @brief Toca a melodia de sucesso.
@@ -52,128 +53,106 @@ void feedback_tocar_erro() {
  * @brief Toca os bipes de timeout.
  */
 void feedback_tocar_timeout() {
-    buzzer_play_tone(880, 100);
-    buzzer_play_tone(0, 50); // Pausa
-    buzzer_play_tone(880, 100);
-    buzzer_play_tone(0, 50); // Pausa
-    buzzer_play_tone(880, 100);
+    buzzer_tocar_sequencia(MELODIA_TIMEOUT, count_of(MELODIA_TIMEOUT));
 }
 
 
-// --- Implementação do Feedback Visual (Não-Bloqueante) ---
+// --- Animações de Feedback Visual ---
+
+// Erro: três piscadas do X, com o LED acompanhando
+static const keyframe_t ERRO_MATRIZ[] = {
+    {FEEDBACK_PADRAO_X, VERMELHO_MATRIZ, ERRO_QUADRO_MS}, {0, 0, ERRO_QUADRO_MS},
+    {FEEDBACK_PADRAO_X, VERMELHO_MATRIZ, ERRO_QUADRO_MS}, {0, 0, ERRO_QUADRO_MS},
+    {FEEDBACK_PADRAO_X, VERMELHO_MATRIZ, ERRO_QUADRO_MS}, {0, 0, ERRO_QUADRO_MS},
+};
+static const keyframe_t ERRO_LED[] = {
+    {0, VERMELHO, ERRO_QUADRO_MS}, {0, APAGADO, ERRO_QUADRO_MS},
+    {0, VERMELHO, ERRO_QUADRO_MS}, {0, APAGADO, ERRO_QUADRO_MS},
+    {0, VERMELHO, ERRO_QUADRO_MS}, {0, APAGADO, ERRO_QUADRO_MS},
+};
+
+// Timeout: o mesmo ritmo, com a exclamação
+static const keyframe_t TIMEOUT_MATRIZ[] = {
+    {FEEDBACK_PADRAO_EXCLAMACAO, AMARELO_MATRIZ, TIMEOUT_QUADRO_MS}, {0, 0, TIMEOUT_QUADRO_MS},
+    {FEEDBACK_PADRAO_EXCLAMACAO, AMARELO_MATRIZ, TIMEOUT_QUADRO_MS}, {0, 0, TIMEOUT_QUADRO_MS},
+    {FEEDBACK_PADRAO_EXCLAMACAO, AMARELO_MATRIZ, TIMEOUT_QUADRO_MS}, {0, 0, TIMEOUT_QUADRO_MS},
+};
+static const keyframe_t TIMEOUT_LED[] = {
+    {0, AMARELO, TIMEOUT_QUADRO_MS}, {0, APAGADO, TIMEOUT_QUADRO_MS},
+    {0, AMARELO, TIMEOUT_QUADRO_MS}, {0, APAGADO, TIMEOUT_QUADRO_MS},
+    {0, AMARELO, TIMEOUT_QUADRO_MS}, {0, APAGADO, TIMEOUT_QUADRO_MS},
+};
+
+// Fechamento: círculo aceso, depois um intervalo apagado
+static const keyframe_t FECHANDO_MATRIZ[] = {
+    {FEEDBACK_PADRAO_CIRCULO, VERMELHO_FECHANDO, FECHANDO_FRAME_DELAY_US / 1000},
+    {0, 0, FECHANDO_INTERVALO_FINAL_US / 1000},
+};
+static const keyframe_t FECHANDO_LED[] = {
+    {0, VERMELHO, FECHANDO_FRAME_DELAY_US / 1000},
+    {0, APAGADO, FECHANDO_INTERVALO_FINAL_US / 1000},
+};
+
+static const keyframe_t SUCESSO_MATRIZ[] = {
+    {FEEDBACK_PADRAO_PONTO, VERDE_MATRIZ, SUCESSO_FRAME_DELAY_MS},
+    {FEEDBACK_PADRAO_CRUZ, VERDE_MATRIZ, SUCESSO_FRAME_DELAY_MS},
+    {FEEDBACK_PADRAO_CIRCULO, VERDE_MATRIZ, SUCESSO_FRAME_DELAY_MS},
+};
 
 /**
- * @brief Atualiza a animação visual de erro na matriz e no LED.
- * Deve ser chamada repetidamente no loop principal.
- * @return true se a animação foi concluída, false caso contrário.
+ * @brief Um quadro do fogo: o quadro anterior sobe uma linha esfriando, e a base
+ * (linha 4) ganha chamas novas.
  */
-bool feedback_visual_erro_update(void) {
-    if (erro_frame_atual == 0) { // Início da animação
-        erro_ultimo_frame_tempo = get_absolute_time(); // Registra o tempo de início
-        matriz_desenhar_x(); // Desenha o X
-        rgb_led_set_color(PWM_MAX_DUTY, 0, 0); // LED Vermelho
-        erro_frame_atual = 1; // Próximo frame será para desligar
-        return false; // Animação ainda não terminou
-    }
-
-    // Verifica se o tempo mínimo para o próximo frame já passou
-    if (absolute_time_diff_us(erro_ultimo_frame_tempo, get_absolute_time()) < ERRO_FRAME_DELAY_US) {
-        return false; // Ainda não é hora do próximo frame
+static void gerar_fogo(animacao_quadro_t *quadro, uint32_t decorrido_ms) {
+    (void)decorrido_ms;
+    // Propaga o "calor" (cores) para cima, esfriando sem passar de zero (de cima para
+    // baixo: cada pixel lê o de baixo antes de ele mudar)
+    for (uint i = 0; i < 4 * 5; i++) {
+        quadro->pixels[i] = cor_subtrair(quadro->pixels[i + 5], FOGO_RESFRIAMENTO);
     }
 
-    erro_ultimo_frame_tempo = get_absolute_time(); // Atualiza o tempo do último frame
-
-    if (erro_frame_atual < 6) { // A animação tem 3 ciclos (ligado/desligado/ligado)
-        if (erro_frame_atual % 2 != 0) { // Frames 1, 3, 5: Desliga (para o intervalo)
-            matriz_limpar();
-            rgb_led_set_color(0, 0, 0);
-        } else { // Frames 2, 4, 6: Liga (para o brilho)
-            matriz_desenhar_x();
-            rgb_led_set_color(PWM_MAX_DUTY, 0, 0);
+    // Gera novas chamas na base: um sorteio de 32 bits por pixel, um byte para cada decisão
+    for (uint x = 0; x < 5; x++) {
+        uint32_t sorteio = cor_aleatorio();
+        if ((sorteio & 0xFF) < 154) { // 60% de chance de acender um pixel na base
+            uint8_t r = 200 + ((((sorteio >> 8) & 0xFF) * 56) >> 8);  // Vermelho forte (200-255)
+            uint8_t g = 50 + ((((sorteio >> 16) & 0xFF) * 100) >> 8); // Verde para laranja (50-149)
+            quadro->pixels[4 * 5 + x] = cor_rgb(r, g, 0);
+        } else {
+            quadro->pixels[4 * 5 + x] = 0; // Pixel desligado na base
         }
-        erro_frame_atual++; // Avança para o próximo frame
-        return false; // Animação ainda não terminou
-    } else {
-        // Animação completa! Reseta o estado e limpa os visuais.
-        erro_frame_atual = 0; // Prepara para a próxima vez que for chamada
-        matriz_limpar();      // Garante que a matriz termine limpa
-        rgb_led_set_color(0, 0, 0); // Garante que o LED termine desligado
-        return true; // Animação concluída
     }
 }
 
-/**
- * @brief Atualiza a animação visual de timeout na matriz e no LED.
- * Deve ser chamada repetidamente no loop principal.
- * @return true se a animação foi concluída, false caso contrário.
- */
-bool feedback_visual_timeout_update(void) {
-    if (timeout_frame_atual == 0) { // Início da animação
-        timeout_ultimo_frame_tempo = get_absolute_time();
-        matriz_desenhar_exclamacao();
-        rgb_led_set_color(PWM_MAX_DUTY, PWM_MAX_DUTY, 0); // Amarelo
-        timeout_frame_atual = 1; // Próximo frame será para desligar
-        return false; // Animação ainda não terminou
-    }
-
-    // Verifica se o tempo mínimo para o próximo frame já passou
-    if (absolute_time_diff_us(timeout_ultimo_frame_tempo, get_absolute_time()) < TIMEOUT_FRAME_DELAY_US) {
-        return false; // Ainda não é hora do próximo frame
-    }
-
-    timeout_ultimo_frame_tempo = get_absolute_time(); // Atualiza o tempo do último frame
-
-    if (timeout_frame_atual < 6) { // A animação tem 3 ciclos (ligado/desligado/ligado)
-        if (timeout_frame_atual % 2 != 0) { // Frames 1, 3, 5: Desliga (para o intervalo)
-            matriz_limpar();
-            rgb_led_set_color(0, 0, 0);
-        } else { // Frames 2, 4, 6: Liga (para o brilho)
-            matriz_desenhar_exclamacao();
-            rgb_led_set_color(PWM_MAX_DUTY, PWM_MAX_DUTY, 0); // Amarelo
-        }
-        timeout_frame_atual++; // Avança para o próximo frame
-        return false; // Animação ainda não terminou
-    } else {
-        // Animação completa! Reseta o estado e limpa os visuais.
-        timeout_frame_atual = 0; // Prepara para a próxima vez que for chamada
-        matriz_limpar();          // Garante que a matriz termine limpa
-        rgb_led_set_color(0, 0, 0); // Garante que o LED termine desligado
-        return true; // Animação concluída
-    }
-}
-
-/**
- * @brief Atualiza o feedback visual de fechamento da porta.
- * Deve ser chamada repetidamente no loop principal.
- * @return true se a animação foi concluída, false caso contrário.
- */
-bool feedback_visual_fechando_update(void) {
-    if (fechando_frame_atual == 0) { // Início da animação
-        fechando_ultimo_frame_tempo = get_absolute_time();
-        matriz_desenhar_circulo(200, 0, 0); // Círculo Vermelho (brilho 200)
-        rgb_led_set_color(PWM_MAX_DUTY, 0, 0); // Vermelho
-        fechando_frame_atual = 1; // Próximo frame para desligar
-        return false; // Animação ainda não terminou
-    }
-
-    // Verifica se o tempo mínimo para o próximo frame já passou
-    uint64_t current_delay = (fechando_frame_atual == 1) ? FECHANDO_FRAME_DELAY_US : FECHANDO_INTERVALO_FINAL_US;
-    if (absolute_time_diff_us(fechando_ultimo_frame_tempo, get_absolute_time()) < current_delay) {
-        return false; // Ainda não é hora do próximo frame
-    }
-
-    fechando_ultimo_frame_tempo = get_absolute_time(); // Atualiza o tempo do último frame
-
-    if (fechando_frame_atual == 1) { // Fase 2: Desliga LED e matriz
-        matriz_limpar();
-        rgb_led_set_color(0, 0, 0);
-        fechando_frame_atual = 2; // Último frame, para finalizar
-        return false; // Animação ainda não terminou
-    } else {
-        // Animação completa! Reseta o estado.
-        fechando_frame_atual = 0; // Prepara para a próxima vez que for chamada
-        // matriz_limpar() e rgb_led_set_color(0,0,0) já foram feitos no frame 1,
-        // ou serão gerenciados pelo bloco centralizado (main.c) se necessário.
-        return true; // Animação concluída
-    }
-}
\ No newline at end of file
+const animacao_t feedback_animacao_erro = {
+    .faixas = {
+        [ANIMACAO_SAIDA_MATRIZ] = {ERRO_MATRIZ, count_of(ERRO_MATRIZ)},
+        [ANIMACAO_SAIDA_LED] = {ERRO_LED, count_of(ERRO_LED)},
+    },
+};
+
+const animacao_t feedback_animacao_timeout = {
+    .faixas = {
+        [ANIMACAO_SAIDA_MATRIZ] = {TIMEOUT_MATRIZ, count_of(TIMEOUT_MATRIZ)},
+        [ANIMACAO_SAIDA_LED] = {TIMEOUT_LED, count_of(TIMEOUT_LED)},
+    },
+};
+
+const animacao_t feedback_animacao_fechando = {
+    .faixas = {
+        [ANIMACAO_SAIDA_MATRIZ] = {FECHANDO_MATRIZ, count_of(FECHANDO_MATRIZ)},
+        [ANIMACAO_SAIDA_LED] = {FECHANDO_LED, count_of(FECHANDO_LED)},
+    },
+};
+
+const animacao_t feedback_animacao_sucesso = {
+    .faixas = {
+        [ANIMACAO_SAIDA_MATRIZ] = {SUCESSO_MATRIZ, count_of(SUCESSO_MATRIZ)},
+    },
+};
+
+const animacao_t feedback_animacao_fogo = {
+    .gerar = gerar_fogo,
+    .saidas_geradas = 1u << ANIMACAO_SAIDA_MATRIZ,
+    .periodo_ms = FOGO_FRAME_DELAY_US / 1000,
+};
\ No newline at end of file
@@ -9,6 +9,7 @@
 #define FEEDBACK_H
 
 #include "pico/stdlib.h" // Para tipos básicos como bool, uint8_t
+#include "animacoes.h"   // Para animacao_t e ANIMACAO_PIXEL
 
 // --- Funções de Feedback Sonoro ---
 
@@ -28,29 +29,29 @@ void feedback_tocar_erro(void);
 void feedback_tocar_timeout(void);
 
 
-// --- Funções de Feedback Visual (Não-Bloqueantes) ---
-// As funções *_update progridem a animação por um frame e retornam true quando a animação é concluída.
-
-/**
- * @brief Atualiza a animação visual de erro na matriz e no LED.
- * Deve ser chamada repetidamente no loop principal.
- * @return true se a animação foi concluída, false caso contrário.
- */
-bool feedback_visual_erro_update(void);
-
-/**
- * @brief Atualiza a animação visual de timeout na matriz e no LED.
- * Deve ser chamada repetidamente no loop principal.
- * @return true se a animação foi concluída, false caso contrário.
- */
-bool feedback_visual_timeout_update(void);
-
-/**
- * @brief Atualiza o feedback visual de fechamento da porta.
- * Deve ser chamada repetidamente no loop principal.
- * @return true se a animação foi concluída, false caso contrário.
- */
-bool feedback_visual_fechando_update(void);
+// --- Padrões da Matriz ---
+#define FEEDBACK_PADRAO_X \
+    (ANIMACAO_PIXEL(0, 0) | ANIMACAO_PIXEL(4, 0) | ANIMACAO_PIXEL(1, 1) | ANIMACAO_PIXEL(3, 1) | ANIMACAO_PIXEL(2, 2) | \
+     ANIMACAO_PIXEL(1, 3) | ANIMACAO_PIXEL(3, 3) | ANIMACAO_PIXEL(0, 4) | ANIMACAO_PIXEL(4, 4))
+#define FEEDBACK_PADRAO_CIRCULO \
+    (ANIMACAO_PIXEL(1, 0) | ANIMACAO_PIXEL(2, 0) | ANIMACAO_PIXEL(3, 0) | ANIMACAO_PIXEL(0, 1) | ANIMACAO_PIXEL(4, 1) | \
+     ANIMACAO_PIXEL(0, 2) | ANIMACAO_PIXEL(4, 2) | ANIMACAO_PIXEL(0, 3) | ANIMACAO_PIXEL(4, 3) | \
+     ANIMACAO_PIXEL(1, 4) | ANIMACAO_PIXEL(2, 4) | ANIMACAO_PIXEL(3, 4))
+#define FEEDBACK_PADRAO_EXCLAMACAO \
+    (ANIMACAO_PIXEL(2, 0) | ANIMACAO_PIXEL(2, 1) | ANIMACAO_PIXEL(2, 2) | ANIMACAO_PIXEL(2, 4))
+#define FEEDBACK_PADRAO_PONTO ANIMACAO_PIXEL(2, 2)
+#define FEEDBACK_PADRAO_CRUZ \
+    (ANIMACAO_PIXEL(2, 1) | ANIMACAO_PIXEL(1, 2) | ANIMACAO_PIXEL(2, 2) | ANIMACAO_PIXEL(3, 2) | ANIMACAO_PIXEL(2, 3))
+
+
+// --- Animações de Feedback Visual (motor de animacoes.h) ---
+// Tabelas de quadros-chave em flash; terminam sozinhas, exceto o fogo (até ser parado).
+
+extern const animacao_t feedback_animacao_erro;      ///< X vermelho piscando, com o LED.
+extern const animacao_t feedback_animacao_timeout;   ///< Exclamação amarela piscando, com o LED.
+extern const animacao_t feedback_animacao_fechando;  ///< Círculo vermelho e LED vermelho, depois apagados.
+extern const animacao_t feedback_animacao_sucesso;   ///< Ponto, cruz e círculo verdes (só a matriz).
+extern const animacao_t feedback_animacao_fogo;      ///< Chamas subindo na matriz.
 
 
 #endif // FEEDBACK_H
\ No newline at end of file
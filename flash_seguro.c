@@ -0,0 +1,119 @@
+/**
+ * @file flash_seguro.c
+ * @brief Implementação da pausa cooperativa do Núcleo 1 durante operações na flash
+ * e das operações de apagar setor e programar página usadas pelos módulos persistentes.
+ */
+
+#include "flash_seguro.h"
+#include "hardware/flash.h"
+#include "hardware/sync.h" // save_and_disable_interrupts, __dmb
+
+
+// --- Variáveis Estáticas (SRAM) ---
+
+static bool nucleo1_lancado = false;                // Escrita pelo Núcleo 0
+static volatile bool pausa_pedida = false;          // Escrita pelo Núcleo 0
+static volatile bool nucleo1_estacionado = false;   // Escrita pelo Núcleo 1
+static volatile bool nucleo1_atende = false;        // Núcleo 1 já chegou ao seu loop
+
+
+// --- Funções Auxiliares Estáticas ---
+
+/**
+ * @brief Mantém o Núcleo 1 em RAM, sem interrupções, enquanto a pausa estiver pedida.
+ */
+static void __no_inline_not_in_flash_func(estacionar)(void) {
+    uint32_t interrupcoes = save_and_disable_interrupts();
+    nucleo1_estacionado = true;
+    __dmb();
+    while (pausa_pedida) {
+        tight_loop_contents();
+    }
+    __dmb();
+    nucleo1_estacionado = false;
+    restore_interrupts(interrupcoes);
+}
+
+
+// --- Operações na flash (executadas com o Núcleo 1 estacionado) ---
+
+typedef struct {
+    uint32_t offset;
+    const uint8_t *dados;
+} operacao_flash_t;
+
+static void operacao_apagar(void *arg) {
+    flash_range_erase(((operacao_flash_t *)arg)->offset, FLASH_SECTOR_SIZE);
+}
+
+static void operacao_programar(void *arg) {
+    operacao_flash_t *operacao = (operacao_flash_t *)arg;
+    flash_range_program(operacao->offset, operacao->dados, FLASH_PAGE_SIZE);
+}
+
+static bool executar_ou_adiar(flash_seguro_operacao_t operacao, operacao_flash_t *arg,
+                              flash_seguro_adiamento_t *adiamento) {
+    if (!flash_seguro_executar(operacao, arg)) {
+        adiamento->adiamentos++;
+        adiamento->proxima_tentativa = make_timeout_time_us(FLASH_SEGURO_ESPERA_NOVA_TENTATIVA_US);
+        return false;
+    }
+    return true;
+}
+
+
+// --- Implementação das Funções Públicas ---
+
+bool flash_seguro_executar(flash_seguro_operacao_t operacao, void *arg) {
+    if (!nucleo1_lancado) {
+        // Boot: só o Núcleo 0 está executando
+        uint32_t interrupcoes = save_and_disable_interrupts();
+        operacao(arg);
+        restore_interrupts(interrupcoes);
+        return true;
+    }
+    if (!nucleo1_atende) {
+        return false;
+    }
+
+    pausa_pedida = true;
+    __dmb();
+    uint64_t limite_us = time_us_64() + FLASH_SEGURO_TIMEOUT_US;
+    while (!nucleo1_estacionado) {
+        if (time_us_64() > limite_us) {
+            // Se o Núcleo 1 estacionar logo depois, ele verá a pausa cancelada e seguirá
+            pausa_pedida = false;
+            return false;
+        }
+        tight_loop_contents();
+    }
+
+    uint32_t interrupcoes = save_and_disable_interrupts();
+    operacao(arg);
+    restore_interrupts(interrupcoes);
+
+    __dmb();
+    pausa_pedida = false;
+    return true;
+}
+
+bool flash_seguro_apagar_setor(uint32_t offset, flash_seguro_adiamento_t *adiamento) {
+    operacao_flash_t operacao = { .offset = offset };
+    return executar_ou_adiar(operacao_apagar, &operacao, adiamento);
+}
+
+bool flash_seguro_programar_pagina(uint32_t offset, const uint8_t *dados, flash_seguro_adiamento_t *adiamento) {
+    operacao_flash_t operacao = { .offset = offset, .dados = dados };
+    return executar_ou_adiar(operacao_programar, &operacao, adiamento);
+}
+
+void flash_seguro_nucleo1_lancado(void) {
+    nucleo1_lancado = true;
+}
+
+void flash_seguro_atender(void) {
+    nucleo1_atende = true;
+    if (pausa_pedida) {
+        estacionar();
+    }
+}
@@ -0,0 +1,78 @@
+/**
+ * @file flash_seguro.h
+ * @brief Operações de apagar/programar a flash coordenadas entre os dois núcleos.
+ * Durante a operação o XIP fica desligado e nenhum núcleo pode executar da flash.
+ * O Núcleo 0 pede uma pausa por uma variável em SRAM; o Núcleo 1 atende no início
+ * de cada volta do seu loop, aguardando em RAM com as interrupções desabilitadas.
+ * A FIFO inter-core não é usada (ela já leva os comandos do Núcleo 1 ao Núcleo 0,
+ * por interrupção), por isso o multicore_lockout do SDK não se aplica aqui.
+ */
+
+#ifndef FLASH_SEGURO_H
+#define FLASH_SEGURO_H
+
+#include "pico/stdlib.h"
+
+// Espera máxima para o Núcleo 1 estacionar (ele atende a cada volta do loop)
+#define FLASH_SEGURO_TIMEOUT_US 20000
+// Espera antes de repetir uma operação recusada
+#define FLASH_SEGURO_ESPERA_NOVA_TENTATIVA_US 20000
+
+/**
+ * @brief Adiamentos de um módulo que grava na flash (diário, configuração, credenciais).
+ * Começa zerado, com a tentativa liberada.
+ */
+typedef struct {
+    uint32_t adiamentos;                ///< Operações recusadas (Núcleo 1 indisponível).
+    absolute_time_t proxima_tentativa;  ///< Antes disto, uma nova tentativa seria recusada de novo.
+} flash_seguro_adiamento_t;
+
+/**
+ * @brief Operação executada com o Núcleo 1 estacionado e as interrupções do Núcleo 0
+ * desabilitadas. Deve chamar apenas flash_range_erase/flash_range_program e código
+ * que não dependa de interrupções.
+ */
+typedef void (*flash_seguro_operacao_t)(void *arg);
+
+/**
+ * @brief Executa uma operação na flash com o outro núcleo parado em RAM.
+ * Antes de o Núcleo 1 ser lançado, executa diretamente.
+ * @note Apenas o Núcleo 0 pode chamar.
+ * @return false se o Núcleo 1 ainda não atende pedidos ou não estacionou no prazo;
+ * nesse caso nada foi executado e o chamador deve tentar de novo mais tarde.
+ */
+bool flash_seguro_executar(flash_seguro_operacao_t operacao, void *arg);
+
+/**
+ * @brief Apaga o setor que começa em 'offset' (relativo ao início da flash).
+ * Se recusado, conta o adiamento e adia a próxima tentativa.
+ */
+bool flash_seguro_apagar_setor(uint32_t offset, flash_seguro_adiamento_t *adiamento);
+
+/**
+ * @brief Programa FLASH_PAGE_SIZE bytes de 'dados' na página que começa em 'offset'.
+ * Se recusado, conta o adiamento e adia a próxima tentativa.
+ */
+bool flash_seguro_programar_pagina(uint32_t offset, const uint8_t *dados, flash_seguro_adiamento_t *adiamento);
+
+/**
+ * @brief Indica se já passou a espera do último adiamento.
+ */
+static inline bool flash_seguro_liberado(const flash_seguro_adiamento_t *adiamento) {
+    return time_reached(adiamento->proxima_tentativa);
+}
+
+/**
+ * @brief Registra que o Núcleo 1 está sendo lançado: daqui em diante as operações
+ * dependem de ele estacionar. Chamar no Núcleo 0 logo antes de multicore_launch_core1.
+ */
+void flash_seguro_nucleo1_lancado(void);
+
+/**
+ * @brief Atende um pedido de pausa pendente, estacionando o núcleo em RAM até o fim da operação.
+ * @note Apenas o Núcleo 1 pode chamar, no início de cada volta do seu loop.
+ * A primeira chamada habilita os pedidos do Núcleo 0.
+ */
+void flash_seguro_atender(void);
+
+#endif // FLASH_SEGURO_H
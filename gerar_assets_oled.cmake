@@ -0,0 +1,171 @@
+# Gera ssd1306_assets.h a partir de ssd1306_font.h e ssd1306_telas.txt.
+#
+# Uso (executado pelo build, ver CMakeLists.txt):
+#   cmake -DFONTE=<ssd1306_font.h> -DTELAS=<ssd1306_telas.txt> -DSAIDA=<ssd1306_assets.h> -P gerar_assets_oled.cmake
+#
+# Produz:
+#   - ssd1306_glifo_indice[256]: caractere Latin-1 -> indice do glifo em font[],
+#     extraido dos comentarios "//N: X" de cada linha da fonte;
+#   - os textos fixos de ssd1306_telas.txt ja rasterizados em paginas de 128 colunas,
+#     com o mesmo layout de ssd1306_draw_utf8_multiline (8 px por caractere, quebra em 16).
+
+cmake_minimum_required(VERSION 3.18) # string(HEX)
+
+foreach(var FONTE TELAS SAIDA)
+    if(NOT DEFINED ${var})
+        message(FATAL_ERROR "gerar_assets_oled: variavel ${var} nao definida")
+    endif()
+endforeach()
+
+# Decodifica o primeiro caractere UTF-8 (1 ou 2 bytes) de 'texto'.
+# Retorna em <saida_codigo> o codigo Latin-1 e em <saida_bytes> quantos bytes ele ocupa
+# (codigo -1 para sequencias que o display nao suporta).
+function(decodificar_utf8 texto saida_codigo saida_bytes)
+    string(SUBSTRING "${texto}" 0 2 prefixo)
+    string(HEX "${prefixo}" hex)
+    string(SUBSTRING "${hex}" 0 2 b0_hex)
+    math(EXPR b0 "0x${b0_hex}")
+    if(b0 LESS 128)
+        set(${saida_codigo} ${b0} PARENT_SCOPE)
+        set(${saida_bytes} 1 PARENT_SCOPE)
+    elseif(b0 GREATER_EQUAL 192 AND b0 LESS 224)
+        string(SUBSTRING "${hex}" 2 2 b1_hex)
+        math(EXPR codigo "((0x${b0_hex} & 0x1F) << 6) | (0x${b1_hex} & 0x3F)")
+        set(${saida_codigo} ${codigo} PARENT_SCOPE)
+        set(${saida_bytes} 2 PARENT_SCOPE)
+    else()
+        set(${saida_codigo} -1 PARENT_SCOPE)
+        set(${saida_bytes} 1 PARENT_SCOPE)
+    endif()
+endfunction()
+
+# --- 1. Fonte: bytes de cada glifo e mapa caractere -> indice ---
+file(STRINGS "${FONTE}" linhas_fonte ENCODING UTF-8)
+set(glifo_0 "0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00")
+foreach(linha IN LISTS linhas_fonte)
+    string(REPLACE "\r" "" linha "${linha}")
+    if(NOT linha MATCHES "^[ \t]*((0x[0-9a-fA-F][0-9a-fA-F], *)+)//([0-9]+): (.+)$")
+        continue()
+    endif()
+    set(bytes "${CMAKE_MATCH_1}")
+    set(indice "${CMAKE_MATCH_3}")
+    set(rotulo "${CMAKE_MATCH_4}")
+    string(REGEX REPLACE "[ ,]+$" "" bytes "${bytes}")
+    string(REGEX REPLACE ", *" "," bytes "${bytes}")
+    set(glifo_${indice} "${bytes}")
+    if(indice EQUAL 0)
+        continue() # Glifo vazio: padrao para qualquer caractere sem mapeamento
+    endif()
+    decodificar_utf8("${rotulo}" codigo n)
+    if(codigo GREATER_EQUAL 0)
+        set(mapa_${codigo} ${indice})
+    endif()
+endforeach()
+
+set(tabela "")
+foreach(codigo RANGE 0 255)
+    if(DEFINED mapa_${codigo})
+        string(APPEND tabela "${mapa_${codigo}},")
+    else()
+        string(APPEND tabela "0,")
+    endif()
+    math(EXPR fim_linha "${codigo} % 16")
+    if(fim_linha EQUAL 15)
+        string(APPEND tabela "\n    ")
+    else()
+        string(APPEND tabela " ")
+    endif()
+endforeach()
+string(STRIP "${tabela}" tabela)
+
+# --- 2. Textos fixos: rasterizacao em paginas ---
+file(STRINGS "${TELAS}" linhas_telas ENCODING UTF-8)
+set(bitmaps "")
+set(entradas "")
+set(total 0)
+foreach(texto IN LISTS linhas_telas)
+    string(REPLACE "\r" "" texto "${texto}")
+    if(texto STREQUAL "" OR texto MATCHES "^#")
+        continue()
+    endif()
+
+    # Hash FNV-1a de 32 bits dos bytes do texto (o mesmo calculado em ssd1306_i2c.c)
+    string(HEX "${texto}" hex_texto)
+    string(LENGTH "${hex_texto}" n_hex)
+    set(hash 2166136261)
+    math(EXPR ultimo "${n_hex} - 2")
+    foreach(pos RANGE 0 ${ultimo} 2)
+        string(SUBSTRING "${hex_texto}" ${pos} 2 b)
+        math(EXPR hash "((${hash} ^ 0x${b}) * 16777619) & 0xFFFFFFFF")
+    endforeach()
+
+    # Glifos do texto, na ordem em que ocupam as células
+    set(celulas "")
+    set(resto "${texto}")
+    while(NOT resto STREQUAL "")
+        decodificar_utf8("${resto}" codigo n)
+        if(codigo LESS 0)
+            message(FATAL_ERROR "gerar_assets_oled: '${texto}' contem caractere fora do Latin-1")
+        endif()
+        if(DEFINED mapa_${codigo})
+            list(APPEND celulas ${mapa_${codigo}})
+        else()
+            list(APPEND celulas 0)
+        endif()
+        string(SUBSTRING "${resto}" ${n} -1 resto)
+    endwhile()
+
+    list(LENGTH celulas n_celulas)
+    set(bitmap "")
+    set(i 0)
+    foreach(indice IN LISTS celulas)
+        string(APPEND bitmap "${glifo_${indice}},")
+        math(EXPR i "${i} + 1")
+        math(EXPR fim_linha "${i} % 2")
+        if(fim_linha EQUAL 0)
+            string(APPEND bitmap "\n    ")
+        else()
+            string(APPEND bitmap " ")
+        endif()
+    endforeach()
+    string(STRIP "${bitmap}" bitmap)
+
+    string(APPEND bitmaps "// \"${texto}\"\nstatic const uint8_t ssd1306_tela_${total}[] = {\n    ${bitmap}\n};\n\n")
+    string(REPLACE "\\" "\\\\" literal "${texto}")
+    string(REPLACE "\"" "\\\"" literal "${literal}")
+    string(APPEND entradas "    {${hash}u, \"${literal}\", ${n_celulas}, ssd1306_tela_${total}},\n")
+    math(EXPR total "${total} + 1")
+endforeach()
+
+# --- 3. Saida ---
+set(conteudo "// Arquivo gerado por gerar_assets_oled.cmake a partir de ssd1306_font.h e ssd1306_telas.txt.
+// NAO EDITE: altere as fontes e recompile.
+
+#ifndef SSD1306_ASSETS_H
+#define SSD1306_ASSETS_H
+
+#include <stdint.h>
+
+// Caractere Latin-1 -> indice do glifo em font[] (0 = glifo vazio)
+static const uint8_t ssd1306_glifo_indice[256] = {
+    ${tabela}
+};
+
+// Texto fixo ja rasterizado: 8 bytes por caractere, 16 caracteres por pagina
+typedef struct {
+    uint32_t hash;            // FNV-1a dos bytes UTF-8 do texto
+    const char *texto;
+    uint8_t n_caracteres;
+    const uint8_t *bitmap;
+} ssd1306_tela_t;
+
+${bitmaps}static const ssd1306_tela_t ssd1306_telas[] = {
+${entradas}};
+
+#define SSD1306_N_TELAS ${total}
+
+#endif // SSD1306_ASSETS_H
+")
+file(WRITE "${SAIDA}.tmp" "${conteudo}")
+file(COPY_FILE "${SAIDA}.tmp" "${SAIDA}" ONLY_IF_DIFFERENT)
+file(REMOVE "${SAIDA}.tmp")
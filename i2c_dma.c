@@ -0,0 +1,355 @@
+/**
+ * @file i2c_dma.c
+ * @brief Implementação do motor de transações I2C assíncronas por DMA.
+ *
+ * Funcionamento: a transação da cabeça da fila é convertida em palavras do registrador
+ * IC_DATA_CMD (dado + bits CMD/RESTART/STOP) e entregue ao bloco I2C por um canal de DMA;
+ * leituras usam um segundo canal para esvaziar a FIFO de recepção. A interrupção do bloco
+ * I2C (STOP_DET ou TX_ABRT) encerra a transação e dispara a próxima da fila.
+ */
+
+#include "i2c_dma.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/gpio.h"
+#include "hardware/sync.h"
+#include "pico/time.h"
+
+
+// --- Estruturas Internas ---
+
+typedef struct {
+    i2c_dma_transacao_t transacao;
+    uint8_t dados_inline[I2C_DMA_DADOS_INLINE];  // Cópia de escritas curtas (ex.: comandos)
+    volatile i2c_dma_resultado_t estado;
+} slot_transacao_t;
+
+typedef struct {
+    i2c_inst_t *i2c;
+    uint sda, scl, baudrate;
+    int canal_tx, canal_rx;
+    bool inicializado;
+
+    // Fila circular indexada pelo próprio identificador (id % I2C_DMA_FILA_TAMANHO)
+    slot_transacao_t fila[I2C_DMA_FILA_TAMANHO];
+    i2c_dma_id_t proximo_id;    // Próximo identificador a ser entregue
+    i2c_dma_id_t id_cabeca;     // Transação mais antiga ainda não concluída
+    bool ativo;                 // A transação da cabeça está no barramento
+    absolute_time_t prazo;      // Limite de tempo da transação ativa
+
+    // Palavras de IC_DATA_CMD lidas pelo DMA de transmissão
+    uint16_t palavras[I2C_DMA_MAX_BYTES];
+
+    i2c_dma_estatisticas_t estatisticas;
+} barramento_t;
+
+static barramento_t barramentos[2];
+
+
+// --- Funções Auxiliares Estáticas ---
+
+static inline barramento_t *obter_barramento(i2c_inst_t *i2c) {
+    return &barramentos[i2c_hw_index(i2c)];
+}
+
+static inline slot_transacao_t *obter_slot(barramento_t *b, i2c_dma_id_t id) {
+    return &b->fila[id % I2C_DMA_FILA_TAMANHO];
+}
+
+/**
+ * @brief (Re)configura o bloco I2C: pinos, DMA habilitado e interrupções de fim/aborto.
+ */
+static void configurar_hardware(barramento_t *b) {
+    i2c_init(b->i2c, b->baudrate);
+    gpio_set_function(b->sda, GPIO_FUNC_I2C);
+    gpio_set_function(b->scl, GPIO_FUNC_I2C);
+    gpio_pull_up(b->sda);
+    gpio_pull_up(b->scl);
+
+    i2c_hw_t *hw = i2c_get_hw(b->i2c);
+    hw->dma_cr = I2C_IC_DMA_CR_TDMAE_BITS | I2C_IC_DMA_CR_RDMAE_BITS;
+    hw->intr_mask = I2C_IC_INTR_MASK_M_STOP_DET_BITS | I2C_IC_INTR_MASK_M_TX_ABRT_BITS;
+}
+
+/**
+ * @brief Destrava o barramento quando um escravo segura SDA em nível baixo.
+ * Gera até 9 pulsos de clock manualmente, seguidos de uma condição de STOP.
+ */
+static void recuperar_barramento(barramento_t *b) {
+    i2c_get_hw(b->i2c)->enable = 0;
+
+    // Emulação de dreno aberto: saída em 0 puxa a linha, entrada a libera (pull-up)
+    gpio_init(b->sda);
+    gpio_init(b->scl);
+    gpio_pull_up(b->sda);
+    gpio_pull_up(b->scl);
+    gpio_put(b->sda, 0);
+    gpio_put(b->scl, 0);
+
+    for (int i = 0; i < 9 && !gpio_get(b->sda); i++) {
+        gpio_set_dir(b->scl, GPIO_OUT);
+        busy_wait_us_32(5);
+        gpio_set_dir(b->scl, GPIO_IN);
+        busy_wait_us_32(5);
+    }
+
+    // Condição de STOP: SDA sobe com SCL em nível alto
+    gpio_set_dir(b->sda, GPIO_OUT);
+    busy_wait_us_32(5);
+    gpio_set_dir(b->scl, GPIO_IN);
+    busy_wait_us_32(5);
+    gpio_set_dir(b->sda, GPIO_IN);
+    busy_wait_us_32(5);
+
+    configurar_hardware(b);
+    b->estatisticas.recuperacoes++;
+}
+
+static void parar_dma(barramento_t *b) {
+    dma_channel_abort(b->canal_tx);
+    dma_channel_abort(b->canal_rx);
+}
+
+/**
+ * @brief Coloca a transação da cabeça da fila no barramento, se houver uma.
+ * @note Chamada com interrupções desabilitadas ou a partir da própria interrupção.
+ */
+static void iniciar_proxima(barramento_t *b) {
+    if (b->ativo || b->id_cabeca == b->proximo_id) {
+        return;
+    }
+
+    slot_transacao_t *slot = obter_slot(b, b->id_cabeca);
+    const i2c_dma_transacao_t *t = &slot->transacao;
+    i2c_hw_t *hw = i2c_get_hw(b->i2c);
+
+    // O endereço de destino só pode ser trocado com o bloco desabilitado
+    hw->enable = 0;
+    hw->tar = t->endereco;
+    hw->enable = I2C_IC_ENABLE_ENABLE_BITS;
+    (void)hw->clr_tx_abrt;
+    (void)hw->clr_stop_det;
+
+    // Monta as palavras de IC_DATA_CMD: escrita, depois comandos de leitura
+    uint n = 0;
+    if (t->com_prefixo) {
+        b->palavras[n++] = t->prefixo;
+    }
+    for (uint i = 0; i < t->escrita_len; i++) {
+        b->palavras[n++] = t->escrita[i];
+    }
+    const uint inicio_leitura = n;
+    for (uint i = 0; i < t->leitura_len; i++) {
+        b->palavras[n++] = I2C_IC_DATA_CMD_CMD_BITS;
+    }
+    if (t->leitura_len > 0 && inicio_leitura > 0) {
+        b->palavras[inicio_leitura] |= I2C_IC_DATA_CMD_RESTART_BITS; // Repeated start
+    }
+    b->palavras[n - 1] |= I2C_IC_DATA_CMD_STOP_BITS;
+
+    if (t->leitura_len > 0) {
+        dma_channel_config cfg_rx = dma_channel_get_default_config(b->canal_rx);
+        channel_config_set_transfer_data_size(&cfg_rx, DMA_SIZE_8);
+        channel_config_set_read_increment(&cfg_rx, false);
+        channel_config_set_write_increment(&cfg_rx, true);
+        channel_config_set_dreq(&cfg_rx, i2c_get_dreq(b->i2c, false));
+        dma_channel_configure(b->canal_rx, &cfg_rx, t->leitura, &hw->data_cmd, t->leitura_len, true);
+    }
+
+    dma_channel_config cfg_tx = dma_channel_get_default_config(b->canal_tx);
+    channel_config_set_transfer_data_size(&cfg_tx, DMA_SIZE_16);
+    channel_config_set_read_increment(&cfg_tx, true);
+    channel_config_set_write_increment(&cfg_tx, false);
+    channel_config_set_dreq(&cfg_tx, i2c_get_dreq(b->i2c, true));
+
+    slot->estado = I2C_DMA_EM_ANDAMENTO;
+    b->ativo = true;
+    b->prazo = make_timeout_time_us(t->timeout_us ? t->timeout_us : I2C_DMA_TIMEOUT_PADRAO_US);
+    dma_channel_configure(b->canal_tx, &cfg_tx, &hw->data_cmd, b->palavras, n, true);
+}
+
+/**
+ * @brief Encerra a transação ativa, notifica o solicitante e inicia a próxima.
+ */
+static void finalizar(barramento_t *b, i2c_dma_resultado_t resultado) {
+    slot_transacao_t *slot = obter_slot(b, b->id_cabeca);
+    i2c_dma_id_t id = b->id_cabeca;
+
+    slot->estado = resultado;
+    b->ativo = false;
+    b->id_cabeca++;
+
+    switch (resultado) {
+        case I2C_DMA_CONCLUIDA:    b->estatisticas.concluidas++; break;
+        case I2C_DMA_ERRO_NAK:     b->estatisticas.erros_nak++; break;
+        case I2C_DMA_ERRO_TIMEOUT: b->estatisticas.timeouts++; break;
+        default: break;
+    }
+
+    if (slot->transacao.callback) {
+        slot->transacao.callback(id, resultado, slot->transacao.arg);
+    }
+    iniciar_proxima(b);
+    __sev(); // Acorda o loop principal caso esteja em WFE aguardando esta transação
+}
+
+/**
+ * @brief Tratamento comum das interrupções dos blocos I2C.
+ */
+static void tratar_irq(barramento_t *b) {
+    i2c_hw_t *hw = i2c_get_hw(b->i2c);
+    uint32_t status = hw->intr_stat;
+
+    if (status & I2C_IC_INTR_STAT_R_TX_ABRT_BITS) {
+        // NAK ou perda de arbitragem: o hardware já gerou STOP e descartou a FIFO
+        parar_dma(b);
+        (void)hw->clr_tx_abrt;
+        (void)hw->clr_stop_det;
+        if (!gpio_get(b->sda)) {
+            recuperar_barramento(b); // Escravo ficou segurando SDA
+        }
+        if (b->ativo) {
+            finalizar(b, I2C_DMA_ERRO_NAK);
+        }
+    } else if (status & I2C_IC_INTR_STAT_R_STOP_DET_BITS) {
+        (void)hw->clr_stop_det;
+        if (b->ativo) {
+            if (obter_slot(b, b->id_cabeca)->transacao.leitura_len > 0) {
+                // O DMA pode ainda estar retirando o último byte da FIFO de recepção
+                dma_channel_wait_for_finish_blocking(b->canal_rx);
+            }
+            finalizar(b, I2C_DMA_CONCLUIDA);
+        }
+    }
+}
+
+static void i2c0_irq_handler(void) {
+    tratar_irq(&barramentos[0]);
+}
+
+static void i2c1_irq_handler(void) {
+    tratar_irq(&barramentos[1]);
+}
+
+
+// --- Implementação das Funções Públicas ---
+
+void i2c_dma_init(i2c_inst_t *i2c, uint sda, uint scl, uint baudrate) {
+    barramento_t *b = obter_barramento(i2c);
+    b->i2c = i2c;
+    b->sda = sda;
+    b->scl = scl;
+    b->baudrate = baudrate;
+    b->proximo_id = 1; // O id 0 é reservado para indicar falha
+    b->id_cabeca = 1;
+    b->ativo = false;
+
+    configurar_hardware(b);
+
+    if (!b->inicializado) {
+        b->canal_tx = dma_claim_unused_channel(true);
+        b->canal_rx = dma_claim_unused_channel(true);
+        uint irq = (i2c_hw_index(i2c) == 0) ? I2C0_IRQ : I2C1_IRQ;
+        irq_set_exclusive_handler(irq, (i2c_hw_index(i2c) == 0) ? i2c0_irq_handler : i2c1_irq_handler);
+        irq_set_enabled(irq, true);
+        b->inicializado = true;
+    }
+}
+
+i2c_dma_id_t i2c_dma_enviar(i2c_inst_t *i2c, const i2c_dma_transacao_t *transacao) {
+    barramento_t *b = obter_barramento(i2c);
+    uint total = (transacao->com_prefixo ? 1 : 0) + transacao->escrita_len + transacao->leitura_len;
+    if (!b->inicializado || total == 0 || total > I2C_DMA_MAX_BYTES) {
+        return 0;
+    }
+
+    uint32_t interrupcoes = save_and_disable_interrupts();
+    if (b->proximo_id - b->id_cabeca >= I2C_DMA_FILA_TAMANHO) {
+        b->estatisticas.fila_cheia++;
+        restore_interrupts(interrupcoes);
+        return 0;
+    }
+
+    i2c_dma_id_t id = b->proximo_id++;
+    slot_transacao_t *slot = obter_slot(b, id);
+    slot->transacao = *transacao;
+    if (transacao->escrita_len <= I2C_DMA_DADOS_INLINE) {
+        // Escritas curtas são copiadas: o chamador pode reutilizar o buffer imediatamente
+        for (uint i = 0; i < transacao->escrita_len; i++) {
+            slot->dados_inline[i] = transacao->escrita[i];
+        }
+        slot->transacao.escrita = slot->dados_inline;
+    }
+    slot->estado = I2C_DMA_PENDENTE;
+    iniciar_proxima(b);
+    restore_interrupts(interrupcoes);
+    return id;
+}
+
+i2c_dma_resultado_t i2c_dma_estado(i2c_inst_t *i2c, i2c_dma_id_t id) {
+    barramento_t *b = obter_barramento(i2c);
+    if (id == 0 || id >= b->proximo_id) {
+        return I2C_DMA_INVALIDA;
+    }
+    if (b->proximo_id - id > I2C_DMA_FILA_TAMANHO) {
+        return I2C_DMA_CONCLUIDA; // Posição já reaproveitada: transação antiga
+    }
+    return obter_slot(b, id)->estado;
+}
+
+bool i2c_dma_em_curso(i2c_inst_t *i2c, i2c_dma_id_t id) {
+    i2c_dma_resultado_t estado = i2c_dma_estado(i2c, id);
+    return estado == I2C_DMA_PENDENTE || estado == I2C_DMA_EM_ANDAMENTO;
+}
+
+uint i2c_dma_livres(i2c_inst_t *i2c) {
+    barramento_t *b = obter_barramento(i2c);
+    return I2C_DMA_FILA_TAMANHO - (b->proximo_id - b->id_cabeca);
+}
+
+bool i2c_dma_ocupado(i2c_inst_t *i2c) {
+    barramento_t *b = obter_barramento(i2c);
+    return b->id_cabeca != b->proximo_id;
+}
+
+void i2c_dma_processar(void) {
+    for (int i = 0; i < 2; i++) {
+        barramento_t *b = &barramentos[i];
+        if (!b->inicializado || !b->ativo) {
+            continue;
+        }
+        uint32_t interrupcoes = save_and_disable_interrupts();
+        if (b->ativo && time_reached(b->prazo)) {
+            // Transação travada (ex.: SDA preso): aborta, destrava e segue a fila
+            parar_dma(b);
+            recuperar_barramento(b);
+            finalizar(b, I2C_DMA_ERRO_TIMEOUT);
+        }
+        restore_interrupts(interrupcoes);
+    }
+}
+
+absolute_time_t i2c_dma_proximo_prazo(void) {
+    absolute_time_t prazo = at_the_end_of_time;
+    uint32_t interrupcoes = save_and_disable_interrupts(); // 'prazo' é reescrito na interrupção
+    for (int i = 0; i < 2; i++) {
+        barramento_t *b = &barramentos[i];
+        if (b->inicializado && b->ativo) {
+            prazo = absolute_time_min(prazo, b->prazo);
+        }
+    }
+    restore_interrupts(interrupcoes);
+    return prazo;
+}
+
+i2c_dma_resultado_t i2c_dma_aguardar(i2c_inst_t *i2c, i2c_dma_id_t id) {
+    while (i2c_dma_em_curso(i2c, id)) {
+        i2c_dma_processar();
+        tight_loop_contents();
+    }
+    return i2c_dma_estado(i2c, id);
+}
+
+void i2c_dma_obter_estatisticas(i2c_inst_t *i2c, i2c_dma_estatisticas_t *estatisticas) {
+    *estatisticas = obter_barramento(i2c)->estatisticas;
+}
@@ -0,0 +1,137 @@
+/**
+ * @file i2c_dma.h
+ * @brief Motor de transações I2C assíncronas alimentadas por DMA (i2c0 e i2c1).
+ * Cada barramento possui uma fila de transações; a transferência é feita por DMA
+ * e a conclusão é tratada na interrupção do bloco I2C, de modo que o Núcleo 0
+ * nunca fica parado esperando o barramento.
+ */
+
+#ifndef I2C_DMA_H
+#define I2C_DMA_H
+
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+
+// --- Parâmetros do Motor ---
+#ifndef I2C_DMA_FILA_TAMANHO
+#define I2C_DMA_FILA_TAMANHO 32         // Transações enfileiradas por barramento
+#endif
+#define I2C_DMA_DADOS_INLINE 8          // Escritas até este tamanho são copiadas para a própria transação
+#define I2C_DMA_MAX_BYTES 1040          // Maior transação suportada (prefixo + quadro do OLED + folga)
+#define I2C_DMA_TIMEOUT_PADRAO_US 50000 // Prazo padrão de uma transação (50ms)
+
+/**
+ * @brief Resultado/estado de uma transação.
+ */
+typedef enum {
+    I2C_DMA_PENDENTE,       ///< Na fila, aguardando o barramento.
+    I2C_DMA_EM_ANDAMENTO,   ///< Em transferência.
+    I2C_DMA_CONCLUIDA,      ///< Concluída com sucesso.
+    I2C_DMA_ERRO_NAK,       ///< Abortada pelo hardware (NAK, perda de arbitragem...).
+    I2C_DMA_ERRO_TIMEOUT,   ///< Prazo esgotado; o barramento passou por recuperação.
+    I2C_DMA_INVALIDA        ///< Fila cheia ou parâmetros inválidos; nada foi enviado.
+} i2c_dma_resultado_t;
+
+/// Identificador de uma transação enfileirada (0 indica falha ao enfileirar).
+typedef uint32_t i2c_dma_id_t;
+
+/**
+ * @brief Callback de conclusão. Executado em contexto de interrupção: deve ser curto.
+ */
+typedef void (*i2c_dma_callback_t)(i2c_dma_id_t id, i2c_dma_resultado_t resultado, void *arg);
+
+/**
+ * @struct i2c_dma_transacao_t
+ * @brief Descrição de uma transação: escrita opcionalmente precedida de um byte de
+ * prefixo, seguida (ou não) de uma leitura com repeated start.
+ * @note Escritas maiores que I2C_DMA_DADOS_INLINE e o destino da leitura são
+ * referenciados, não copiados: devem permanecer válidos até a conclusão.
+ */
+typedef struct {
+    uint8_t endereco;               ///< Endereço de 7 bits do dispositivo.
+    bool com_prefixo;               ///< Envia 'prefixo' antes de 'escrita' (ex.: byte de controle do SSD1306).
+    uint8_t prefixo;
+    const uint8_t *escrita;         ///< Bytes a escrever (pode ser NULL se escrita_len == 0).
+    uint16_t escrita_len;
+    uint8_t *leitura;               ///< Destino da leitura (pode ser NULL se leitura_len == 0).
+    uint16_t leitura_len;
+    uint32_t timeout_us;            ///< 0 usa I2C_DMA_TIMEOUT_PADRAO_US.
+    i2c_dma_callback_t callback;    ///< Opcional.
+    void *arg;                      ///< Repassado ao callback.
+} i2c_dma_transacao_t;
+
+/**
+ * @struct i2c_dma_estatisticas_t
+ * @brief Contadores de diagnóstico de um barramento.
+ */
+typedef struct {
+    uint32_t concluidas;
+    uint32_t erros_nak;
+    uint32_t timeouts;
+    uint32_t recuperacoes;  ///< Vezes em que o barramento foi destravado manualmente.
+    uint32_t fila_cheia;
+} i2c_dma_estatisticas_t;
+
+/**
+ * @brief Inicializa o barramento, os pinos e os canais de DMA do motor.
+ * Substitui a chamada direta a i2c_init() para barramentos gerenciados pelo motor.
+ * @param i2c Instância (i2c0 ou i2c1).
+ * @param sda Pino SDA.
+ * @param scl Pino SCL.
+ * @param baudrate Frequência do barramento em Hz.
+ */
+void i2c_dma_init(i2c_inst_t *i2c, uint sda, uint scl, uint baudrate);
+
+/**
+ * @brief Enfileira uma transação. Retorna imediatamente.
+ * @return Identificador da transação, ou 0 se a fila estiver cheia/parâmetros inválidos.
+ */
+i2c_dma_id_t i2c_dma_enviar(i2c_inst_t *i2c, const i2c_dma_transacao_t *transacao);
+
+/**
+ * @brief Consulta o estado de uma transação (handle de polling).
+ * @note O resultado de uma transação fica disponível até que I2C_DMA_FILA_TAMANHO
+ * novas transações sejam enfileiradas; depois disso ela é dada como concluída.
+ */
+i2c_dma_resultado_t i2c_dma_estado(i2c_inst_t *i2c, i2c_dma_id_t id);
+
+/**
+ * @brief Indica se a transação ainda não terminou (pendente ou em andamento).
+ */
+bool i2c_dma_em_curso(i2c_inst_t *i2c, i2c_dma_id_t id);
+
+/**
+ * @brief Número de posições livres na fila do barramento.
+ */
+uint i2c_dma_livres(i2c_inst_t *i2c);
+
+/**
+ * @brief Indica se há transações pendentes ou em andamento no barramento.
+ */
+bool i2c_dma_ocupado(i2c_inst_t *i2c);
+
+/**
+ * @brief Verifica prazos das transações em andamento e recupera barramentos travados.
+ * Deve ser chamada periodicamente no loop principal (não bloqueia).
+ */
+void i2c_dma_processar(void);
+
+/**
+ * @brief Prazo mais próximo entre as transações em andamento (at_the_end_of_time se nenhuma).
+ * Permite ao loop principal dormir sem deixar de verificar timeouts; conclusões e
+ * abortos acordam o núcleo pela interrupção do I2C.
+ */
+absolute_time_t i2c_dma_proximo_prazo(void);
+
+/**
+ * @brief Aguarda a conclusão de uma transação (bloqueante).
+ * Destinada apenas a rotinas de inicialização.
+ */
+i2c_dma_resultado_t i2c_dma_aguardar(i2c_inst_t *i2c, i2c_dma_id_t id);
+
+/**
+ * @brief Copia os contadores de diagnóstico do barramento.
+ */
+void i2c_dma_obter_estatisticas(i2c_inst_t *i2c, i2c_dma_estatisticas_t *estatisticas);
+
+#endif // I2C_DMA_H
@@ -1,118 +1,156 @@
 /**
  * @file keypad.c
  * @brief Implementação do driver para o teclado matricial 4x4.
- * Inclui uma rotina de varredura não-bloqueante com debounce por software.
+ * O PIO varre a matriz e envia pela FIFO o estado completo das 16 teclas a cada mudança já
+ * filtrada pelo debounce; a interrupção compara com o estado anterior e gera um evento por
+ * tecla que mudou.
  */
 
 #include "keypad.h"
 #include "configura_geral.h" // Para as definições dos pinos do teclado
-#include "hardware/gpio.h"   // Para controle de GPIO
-#include "pico/time.h"       // Para absolute_time_t, get_absolute_time, absolute_time_diff_us
+#include "hardware/pio.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"   // __sev
+#include "keypad.pio.h"
 
 
-// --- Variáveis Estáticas Globais (visíveis apenas neste arquivo) ---
+// --- Definições ---
+#define KEYPAD_PIO pio1                 // O pio0 fica com a matriz de LEDs
+#define KEYPAD_CAPACIDADE 32            // Eventos guardados no anel
+
+_Static_assert(KEYPAD_ROW2_PIN == KEYPAD_ROW1_PIN + 1, "keypad.pio controla as linhas 1 e 2 com um único 'set'");
+_Static_assert(KEYPAD_COL1_PIN == KEYPAD_COL0_PIN + 1 && KEYPAD_COL2_PIN == KEYPAD_COL0_PIN + 2 &&
+               KEYPAD_COL3_PIN == KEYPAD_COL0_PIN + 3, "keypad.pio lê as colunas com um único 'in'");
 
-// Estado do debounce por borda (edge-trigger):
-// - leitura_bruta_anterior: última leitura instantânea do hardware
-// - tecla_estavel: estado já estabilizado após debounce
-// - instante_ultima_mudanca: momento da última mudança na leitura bruta
-static char leitura_bruta_anterior;
-static char tecla_estavel;
-static absolute_time_t instante_ultima_mudanca;
 
-// Mapeamento dos pinos das linhas (ROWs) e colunas (COLs) do teclado.
+// --- Variáveis Estáticas Globais (visíveis apenas neste arquivo) ---
+
+// Mapeamento dos pinos das linhas (ROWs) do teclado; as colunas são consecutivas a partir de KEYPAD_COL0_PIN.
 // Estes pinos são definidos em configura_geral.h.
-const uint ROW_PINS[4] = {KEYPAD_ROW0_PIN, KEYPAD_ROW1_PIN, KEYPAD_ROW2_PIN, KEYPAD_ROW3_PIN};
-const uint COL_PINS[4] = {KEYPAD_COL0_PIN, KEYPAD_COL1_PIN, KEYPAD_COL2_PIN, KEYPAD_COL3_PIN};
+static const uint ROW_PINS[4] = {KEYPAD_ROW0_PIN, KEYPAD_ROW1_PIN, KEYPAD_ROW2_PIN, KEYPAD_ROW3_PIN};
 
 // Mapeamento de caracteres para a matriz física do teclado 4x4.
 // keymap[row][col]
-const char keymap[4][4] = {
+static const char keymap[4][4] = {
     {'D', 'C', 'B', 'A'}, // Linha 0 (Ex: D = [0,0])
     {'#', '9', '6', '3'}, // Linha 1
     {'0', '8', '5', '2'}, // Linha 2
     {'*', '7', '4', '1'}  // Linha 3
 };
 
+static uint sm;
+
+// Anel produtor único (interrupção) / consumidor único (loop principal), ambos no Núcleo 0.
+// Índices correm livres e a posição é índice % KEYPAD_CAPACIDADE.
+static keypad_evento_t anel[KEYPAD_CAPACIDADE];
+static volatile uint32_t indice_escrita = 0;
+static volatile uint32_t indice_leitura = 0;
+
+static uint16_t pressionadas = 0;       // Bit (3 - linha) * 4 + coluna: tecla pressionada
+static keypad_estatisticas_t estatisticas;
+
+
+// --- Funções Auxiliares Estáticas ---
+
+/**
+ * @brief Guarda um evento no anel (contexto de interrupção).
+ */
+static void guardar_evento(uint32_t instante_us, char tecla, bool pressionada) {
+    uint32_t escrita = indice_escrita;
+    if (escrita - indice_leitura >= KEYPAD_CAPACIDADE) {
+        estatisticas.descartados++;
+        return;
+    }
+    anel[escrita % KEYPAD_CAPACIDADE] = (keypad_evento_t){instante_us, tecla, pressionada};
+    indice_escrita = escrita + 1;
+    estatisticas.eventos++;
+}
+
 /**
- * @brief Faz uma varredura bruta do teclado (sem debounce).
- * @return Tecla detectada ou '\0' se nenhuma tecla estiver pressionada.
+ * @brief Interrupção da FIFO do PIO: converte cada estado novo do teclado em eventos.
  */
-static char keypad_scan_raw(void) {
-    for (int c = 0; c < 4; c++) {
-        gpio_put(COL_PINS[c], 0);
-        for (int r = 0; r < 4; r++) {
-            if (!gpio_get(ROW_PINS[r])) {
-                gpio_put(COL_PINS[c], 1);
-                return keymap[r][c];
+static void keypad_irq_handler(void) {
+    while (!pio_sm_is_rx_fifo_empty(KEYPAD_PIO, sm)) {
+        uint32_t instante_us = time_us_32();
+        uint16_t estado = (uint16_t)~pio_sm_get(KEYPAD_PIO, sm); // Tecla pressionada lê 0
+        uint16_t mudancas = estado ^ pressionadas;
+        pressionadas = estado;
+
+        for (uint bit = 0; mudancas != 0; bit++, mudancas >>= 1) {
+            if (mudancas & 1u) {
+                char tecla = keymap[3 - bit / 4][bit % 4];
+                guardar_evento(instante_us, tecla, (estado >> bit) & 1u);
             }
         }
-        gpio_put(COL_PINS[c], 1);
+        uint8_t simultaneas = (uint8_t)__builtin_popcount(estado);
+        if (simultaneas > estatisticas.simultaneas_max) {
+            estatisticas.simultaneas_max = simultaneas;
+        }
     }
-    return '\0';
+    __sev(); // Acorda o loop principal caso esteja em WFE
 }
 
 
 // --- Implementação das Funções Públicas ---
 
 /**
- * @brief Inicializa os pinos de GPIO para as linhas e colunas do teclado.
- * Configura os pinos das linhas como entrada com pull-up e os das colunas como saída.
- * Inicia o timer de debounce.
+ * @brief Configura os pinos e inicia a varredura no PIO.
+ * A FIFO de recepção do PIO (8 posições, unida) é esvaziada pela interrupção a cada estado novo.
  */
 void keypad_init() {
-    // Inicializa o estado do debounce por borda.
-    absolute_time_t agora = get_absolute_time();
-    leitura_bruta_anterior = '\0';
-    tecla_estavel = '\0';
-    instante_ultima_mudanca = agora;
-
-    // Configura os pinos das linhas (ROWs) como entrada com resistor de pull-up interno.
-    // O pull-up garante que a linha esteja em nível ALTO quando nenhuma tecla é pressionada.
-    for (int i = 0; i < 4; i++) {
-        gpio_init(ROW_PINS[i]);
-        gpio_set_dir(ROW_PINS[i], GPIO_IN);
-        gpio_pull_up(ROW_PINS[i]);
-    }
+    uint offset = pio_add_program(KEYPAD_PIO, &keypad_program);
+    sm = (uint)pio_claim_unused_sm(KEYPAD_PIO, true);
+    keypad_program_init(KEYPAD_PIO, sm, offset, ROW_PINS, KEYPAD_COL0_PIN, KEYPAD_PERIODO_VARREDURA_US);
+
+    uint irq = pio_get_irq_num(KEYPAD_PIO, 0);
+    irq_set_exclusive_handler(irq, keypad_irq_handler);
+    pio_set_irq0_source_enabled(KEYPAD_PIO, pio_get_rx_fifo_not_empty_interrupt_source(sm), true);
+    irq_set_enabled(irq, true);
+}
 
-    // Configura os pinos das colunas (COLs) como saída.
-    // Inicia-os em nível ALTO. Para ativar uma coluna para varredura, ela é puxada para LOW.
-    for (int i = 0; i < 4; i++) {
-        gpio_init(COL_PINS[i]);
-        gpio_set_dir(COL_PINS[i], GPIO_OUT);
-        gpio_put(COL_PINS[i], 1); // Garante que todas as colunas estão desativadas (HIGH)
+bool keypad_ler_evento(keypad_evento_t *evento) {
+    uint32_t leitura = indice_leitura;
+    if (leitura == indice_escrita) {
+        return false;
     }
+    *evento = anel[leitura % KEYPAD_CAPACIDADE];
+    indice_leitura = leitura + 1;
+    return true;
 }
 
 /**
- * @brief Lê o estado do teclado de forma não-bloqueante com debounce.
- * Realiza uma varredura das colunas e lê o estado das linhas para identificar a tecla pressionada.
- * @return Retorna o caractere da tecla pressionada, ou '\0' (nulo) 
- * se nenhuma tecla for pressionada ou se o tempo de debounce não passou desde o último toque.
+ * @brief Próxima tecla pressionada, na ordem em que foram pressionadas.
+ * Consome um evento de tecla pressionada por chamada; os demais ficam no anel para as
+ * próximas iterações do loop (keypad_proximo_prazo as antecipa).
+ * @return Retorna o caractere da tecla pressionada, ou '\0' (nulo) se não há nenhuma nova.
  */
 char keypad_get_key() {
-    absolute_time_t agora = get_absolute_time();
-    char leitura_bruta = keypad_scan_raw();
-
-    // 1. Se a leitura bruta mudou, reinicia a janela de debounce.
-    if (leitura_bruta != leitura_bruta_anterior) {
-        leitura_bruta_anterior = leitura_bruta;
-        instante_ultima_mudanca = agora;
-        return '\0';
+    keypad_evento_t evento;
+    while (keypad_ler_evento(&evento)) {
+        if (evento.pressionada) {
+            return evento.tecla;
+        }
     }
+    return '\0';
+}
 
-    // 2. Aguarda a leitura ficar estável pelo tempo de debounce.
-    if (absolute_time_diff_us(instante_ultima_mudanca, agora) < DEBOUNCE_INTERVALO_US) {
-        return '\0';
-    }
+void keypad_descartar(void) {
+    uint32_t escrita = indice_escrita;
+    estatisticas.descartados_modo += escrita - indice_leitura;
+    indice_leitura = escrita;
+}
 
-    // 3. Gera evento apenas na borda de subida (tecla pressionada), não em repetição por tecla segurada.
-    if (tecla_estavel != leitura_bruta) {
-        tecla_estavel = leitura_bruta;
-        if (tecla_estavel != '\0') {
-            return tecla_estavel;
-        }
+/**
+ * @brief Informa quando o teclado precisa ser lido novamente.
+ * @return Agora, se há eventos a tratar; at_the_end_of_time quando só uma nova interrupção trará novidades.
+ */
+absolute_time_t keypad_proximo_prazo() {
+    if (indice_leitura != indice_escrita) {
+        return get_absolute_time();
     }
+    return at_the_end_of_time;
+}
 
-    return '\0';
+void keypad_obter_estatisticas(keypad_estatisticas_t *saida) {
+    *saida = estatisticas;
 }
\ No newline at end of file
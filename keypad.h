@@ -1,8 +1,10 @@
 /**
  * @file keypad.h
  * @brief Arquivo de cabeçalho para o driver do teclado matricial 4x4.
- * Declara as funções públicas para inicializar e ler as teclas pressionadas
- * de forma não-bloqueante.
+ * A varredura e o debounce rodam numa máquina de estados do PIO (keypad.pio), sem custo
+ * de CPU; cada mudança do teclado vira eventos de tecla pressionada/solta com o instante,
+ * guardados num anel pela interrupção da FIFO do PIO. Nenhuma tecla se perde enquanto o
+ * Núcleo 0 está ocupado, e várias teclas podem estar pressionadas ao mesmo tempo.
  */
 
 #ifndef KEYPAD_H
@@ -11,18 +13,62 @@
 #include "pico/stdlib.h" // Para tipos básicos como char
 
 /**
- * @brief Inicializa os pinos de GPIO para as linhas e colunas do teclado.
- * As linhas são configuradas como entrada com pull-up e as colunas como saída.
- * Deve ser chamada uma vez na inicialização do sistema.
+ * @struct keypad_evento_t
+ * @brief Mudança de uma tecla.
+ */
+typedef struct {
+    uint32_t instante_us;   ///< time_us_32() quando a mudança saiu da FIFO do PIO.
+    char tecla;
+    bool pressionada;       ///< false: a tecla foi solta.
+} keypad_evento_t;
+
+/**
+ * @struct keypad_estatisticas_t
+ * @brief Contadores de diagnóstico do teclado.
+ */
+typedef struct {
+    uint32_t eventos;           ///< Eventos guardados no anel.
+    uint32_t descartados;       ///< Eventos perdidos com o anel cheio.
+    uint32_t descartados_modo;  ///< Eventos descartados por keypad_descartar.
+    uint8_t simultaneas_max;    ///< Maior número de teclas pressionadas ao mesmo tempo.
+} keypad_estatisticas_t;
+
+/**
+ * @brief Configura os pinos e inicia a varredura no PIO.
+ * As linhas passam a ser controladas pelo PIO (dreno aberto) e as colunas ficam como
+ * entrada com pull-up. Deve ser chamada uma vez na inicialização do sistema.
  */
 void keypad_init(void);
 
 /**
- * @brief Lê o estado do teclado de forma não-bloqueante com debounce.
- * Varre as colunas e lê as linhas para identificar a tecla pressionada.
- * @return Retorna o caractere da tecla pressionada ('\0' se nenhuma tecla
- * for pressionada ou se o tempo de debounce não passou).
+ * @brief Retira o próximo evento do anel.
+ * @return false se não há eventos.
+ */
+bool keypad_ler_evento(keypad_evento_t *evento);
+
+/**
+ * @brief Próxima tecla pressionada, na ordem em que foram pressionadas.
+ * Eventos de tecla solta são consumidos e ignorados.
+ * @return Retorna o caractere da tecla pressionada ('\0' se não há nenhuma nova).
  */
 char keypad_get_key(void);
 
+/**
+ * @brief Descarta os eventos guardados (modos que não usam o teclado), para que teclas
+ * apertadas neles não sejam entregues ao próximo modo.
+ */
+void keypad_descartar(void);
+
+/**
+ * @brief Prazo até o qual o loop principal pode dormir sem perder teclas.
+ * A interrupção da FIFO do PIO acorda o núcleo a cada mudança do teclado.
+ * @return Agora, se há eventos no anel; at_the_end_of_time caso contrário.
+ */
+absolute_time_t keypad_proximo_prazo(void);
+
+/**
+ * @brief Copia os contadores de diagnóstico.
+ */
+void keypad_obter_estatisticas(keypad_estatisticas_t *estatisticas);
+
 #endif // KEYPAD_H
\ No newline at end of file
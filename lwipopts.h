@@ -12,6 +12,7 @@
  * - Tamanho de buffers, alinhamento de memória, número de segmentos e filas
  * - Ativação de protocolos como ARP, ICMP, DHCP, TCP, UDP, DNS
  * - Habilitação de callbacks de status e link da interface de rede
+ * - Slots de requisição e buffer de saída do cliente MQTT
  * - Níveis de debug e coleta de estatísticas
  *
  * Este arquivo é essencial para projetos que utilizam comunicação TCP/IP no Pico W, permitindo 
@@ -75,6 +76,10 @@
 #define DHCP_DOES_ARP_CHECK         0
 #define LWIP_DHCP_DOES_ACD_CHECK    0
 
+// Cliente MQTT: publicacoes QoS1 simultaneas (janela do mqtt_lwip.c) e buffer de saida para elas
+#define MQTT_REQ_MAX_IN_FLIGHT      8
+#define MQTT_OUTPUT_RINGBUF_SIZE    1024
+
 #ifndef NDEBUG
 #define LWIP_DEBUG                  1
 #define LWIP_STATS                  1
@@ -8,7 +8,7 @@
 #include "configura_geral.h" // Arquivo de configuração geral do projeto (ex: pinos)
 #include <stdio.h>
 #include <string.h>
-#include <math.h>
+#include <stdlib.h>
 
 // Bibliotecas do SDK do Pico
 #include "pico/multicore.h"      // Para gerenciamento dos dois núcleos do RP2040
@@ -16,6 +16,7 @@
 #include "hardware/gpio.h"       // Controle de pinos de I/O de propósito geral
 #include "hardware/pwm.h"        // Para controle de PWM (ex: LED RGB, servo)
 #include "hardware/i2c.h"        // Para comunicação I2C (ex: display, sensor de cor)
+#include "hardware/irq.h"        // Para a interrupção da FIFO inter-core
 #include "pico/time.h"           // Funções de tempo e timers
 
 // Drivers dos módulos de hardware específicos do projeto
@@ -28,17 +29,70 @@
 #include "buzzer.h"    // Driver para o buzzer
 #include "servo.h"     // Driver para o servo motor
 #include "feedback.h"  // Funções de feedback ao usuário (visual e sonoro)
+#include "animacoes.h" // Motor de animações em camadas (matriz e LED RGB)
+#include "cor.h"       // Pipeline de cor em ponto fixo (gama, brilho e respiração)
+#include "i2c_dma.h"   // Motor de transações I2C assíncronas (DMA)
+#include "energia.h"   // Sono do Núcleo 0 entre eventos e métricas do loop
+#include "eventos.h"   // Anel de eventos compartilhado entre os núcleos
+#include "publicacoes.h" // Coalescência das publicações MQTT no Núcleo 1
+#include "diario.h"    // Diário de eventos de histórico em flash
+#include "flash_seguro.h" // Pausa do Núcleo 1 durante gravações na flash
+#include "conexao.h"   // Gerenciador da conexão Wi-Fi/MQTT no Núcleo 1
+#include "credenciais.h" // Tabela de PINs (hash com sal) em flash
+#include "configuracao.h" // Tempos e limiares ajustáveis, persistidos em flash
+#include "classificador.h" // Classificação do cartão por cromaticidade (inteira)
+#include "perfil.h"    // Histogramas de ciclos dos trechos quentes (PERFIL_HABILITADO)
 
 // --- Definições de Tempo e Limiares ---
 #define SERVO_MOVE_DURATION_US 500000       // Duração do movimento do servo (0.5s)
-#define TIMEOUT_SENHA_S 15                  // Tempo limite para digitar a senha (15s)
-#define TEMPO_AUTO_TRAVA_S 20               // Tempo para a fechadura travar automaticamente (20s)
 #define DISPLAY_UPDATE_INTERVAL_US 1000000  // Intervalo de atualização do display (1s)
 #define HEARTBEAT_INTERVAL_US 30000000      // Intervalo para enviar sinal de "estou vivo" via MQTT (30s)
-#define MQTT_PUB_MIN_DELAY_US 50000         // Atraso mínimo entre publicações MQTT para evitar flooding
+#define PERIODO_PULSO_MS 20                // Cadência do LED pulsante (50 quadros/s)
+#define PERIODO_CIRCULO_TEMPO_MS 1000       // O círculo só muda a cada segundo da contagem
+#define FIFO_RECEBIDOS_TAMANHO 8            // Pacotes do Núcleo 1 guardados pela interrupção da FIFO
+#define JANELA_CARTAO_VALIDADE_US (3 * TCS34725_PERIODO_MAXIMO_US) // Sem leitura por mais que isso, a aproximação acabou
 
 // --- Estruturas de Dados Globais ---
 
+/**
+ * @brief Eventos que movem a máquina de estados (ver a tabela TRANSICOES).
+ */
+enum EventoFechadura {
+    EVENTO_CARTAO_LIDO,         // O classificador decidiu um cartão
+    EVENTO_SENHA_CORRETA,
+    EVENTO_SENHA_INCORRETA,
+    EVENTO_TEMPO_ESGOTADO,      // Fim do tempo para digitar a senha
+    EVENTO_AUTO_TRAVA,          // Fim da contagem do modo aberto
+    EVENTO_MENSAGEM_CONCLUIDA,  // Fim da exibição de uma mensagem temporária
+    EVENTO_CANCELAR,            // Tecla '*'
+    EVENTO_SALVO,               // Senha, tempo ou calibração gravados
+    EVENTO_FALHA,               // Gravação recusada (flash indisponível ou valor fora da faixa)
+    EVENTO_TECLA_AJUSTE,        // Teclas A/B no modo admin
+    EVENTO_TECLA_CALIBRAR,      // Tecla C no modo admin
+    EVENTO_COMANDO_ADMIN,       // Comando remoto do Núcleo 1: entra no modo admin
+    EVENTO_COMANDO_INCENDIO     // Comando remoto do Núcleo 1: liga/desliga a emergência
+};
+
+/**
+ * @brief Animações da fechadura (ver a tabela ANIMACOES). O valor é a camada no motor de
+ * animações: numa saída usada por duas animações ativas, aparece a de valor maior.
+ */
+enum Animacao {
+    ANIMACAO_PULSO,
+    ANIMACAO_DIGITACAO,
+    ANIMACAO_CIRCULO_TEMPO,
+    ANIMACAO_FOGO,
+    ANIMACAO_SUCESSO,
+    ANIMACAO_FECHANDO,
+    ANIMACAO_TIMEOUT,
+    ANIMACAO_ERRO,
+    ANIMACAO_QUANTIDADE
+};
+
+// Animações que terminam sozinhas; enquanto alguma roda, a fechadura não está em repouso
+#define ANIMACOES_TRANSITORIAS ((1u << ANIMACAO_ERRO) | (1u << ANIMACAO_TIMEOUT) | \
+                                (1u << ANIMACAO_FECHANDO) | (1u << ANIMACAO_SUCESSO))
+
 /**
  * @brief Estrutura para um timer não-bloqueante.
  * @details Permite verificar se um período de tempo passou sem parar a execução do código.
@@ -50,11 +104,9 @@ typedef struct {
 } TimerNaoBloqueante;
 
 /**
- * @brief Estrutura para controlar o efeito de pulso do LED RGB.
+ * @brief Cor do efeito de pulso do LED RGB (animação ANIMACAO_PULSO, que conta o tempo desde o início).
  */
 typedef struct {
-    bool ativo;             // Indica se o efeito está ativo
-    absolute_time_t inicio; // Momento de início do pulso para cálculo do brilho
     uint8_t r, g, b;        // Cor base do pulso (0-255)
 } EfeitoPulso;
 
@@ -63,13 +115,14 @@ typedef struct {
  * @details Centraliza todas as variáveis que definem o comportamento atual do sistema.
  */
 typedef struct {
-    volatile enum ModoOperacao modo_atual; // O modo de operação atual (ex: MODO_ESPERA). 'volatile' pois é alterado pela FIFO.
+    enum ModoOperacao modo_atual;         // O modo de operação atual (ex: MODO_ESPERA). Só muda em maquina_disparar().
     enum CorDetectada cor_ativa;          // A cor do cartão que iniciou a operação atual.
     bool status_aberto;                   // TRUE se a fechadura está aberta, FALSE se fechada.
-    bool modo_foi_inicializado;           // Flag para executar código de inicialização de um modo apenas uma vez.
 
     char senha_digitada[5];               // Buffer para armazenar a senha (4 dígitos + terminador nulo).
     int digitos_count;                    // Contador de quantos dígitos da senha já foram inseridos.
+    uint8_t ajuste_chave;                 // Parâmetro (enum ChaveConfiguracao) em ajuste no modo admin.
+    enum CorDetectada calibracao_cartao;  // Cartão em calibração (COR_NENHUMA enquanto é escolhido).
 
     // Instâncias dos timers não-bloqueantes para diferentes funções
     TimerNaoBloqueante timer_servo;
@@ -79,24 +132,72 @@ typedef struct {
     TimerNaoBloqueante timer_geral;         // Timer para mensagens temporárias.
     TimerNaoBloqueante timer_alarme_beep;   // Timer para o beep do alarme de incêndio.
 
-    // Flags para controlar o estado das animações visuais
-    bool animacao_erro_ativa;
-    bool animacao_timeout_ativa;
-    bool animacao_fechando_ativa;
-    bool animacao_sucesso_ativa;
-    bool animacao_digitacao_ativa;
-    bool animacao_circulo_tempo_ativa;
-    bool animacao_fogo_ativa;
-
     EfeitoPulso efeito_pulso;               // Estado do efeito de pulso do LED RGB.
     TimerNaoBloqueante timer_heartbeat;     // Timer para o envio periódico do heartbeat.
 } EstadoFechadura;
 
+// Fontes de prazo que só alguns modos consomem (campo 'consome' de modo_t)
+#define CONSOME_DISPLAY        (1u << 0) // timer_display_update
+#define CONSOME_TIMEOUT_SENHA  (1u << 1) // timer_timeout_senha
+#define CONSOME_AUTO_TRAVA     (1u << 2) // timer_auto_trava
+#define CONSOME_SENSOR         (1u << 3) // Amostras do TCS34725
+#define CONSOME_TECLADO        (1u << 4) // Teclas (os outros modos as descartam)
+#define CONSOME_MENSAGEM       (1u << 5) // timer_geral
+#define CONSOME_ALARME         (1u << 6) // timer_alarme_beep
+
+/**
+ * @brief Um modo de operação na tabela MODOS.
+ */
+typedef struct {
+    void (*entrar)(void);   // Ao entrar no modo (NULL: nada)
+    void (*executar)(void); // A cada volta do loop enquanto o modo estiver ativo
+    void (*sair)(void);     // Ao sair do modo, antes da ação da transição (NULL: nada)
+    uint8_t consome;        // Bits CONSOME_*
+    uint8_t ponto_perfil;   // Ponto de medida do handler (PERFIL_QUANTIDADE: não medido)
+} modo_t;
+
+// Na origem de uma transição: qualquer modo. No destino: o evento não muda de modo.
+#define MODO_QUALQUER MODO_QUANTIDADE
+
+/**
+ * @brief Uma linha da tabela TRANSICOES: modo x evento -> ação, próximo modo.
+ */
+typedef struct {
+    enum ModoOperacao origem;
+    enum EventoFechadura evento;
+    void (*acao)(void);         // Entre a saída da origem e a entrada no destino (NULL: nada)
+    enum ModoOperacao destino;
+} transicao_t;
+
 // --- Variáveis de Estado Global ---
-char SENHA_VERDE[5] = "1337";        // Senha padrão para o cartão verde
-char SENHA_VERMELHA[5] = "8008";     // Senha padrão para o cartão vermelho
-char SENHA_AZUL[5] = "4242";         // Senha padrão para o cartão azul
+// Senhas de fábrica, gravadas na tabela de credenciais quando ela é criada
+static const char *const SENHAS_PADRAO[] = {
+    [COR_VERDE] = "1337",
+    [COR_VERMELHA] = "8008",
+    [COR_AZUL] = "4242",
+    [COR_AMARELA] = "2580",
+    [COR_ROXA] = "1470",
+};
+static const char *const NOMES_CARTAO[COR_QUANTIDADE] = {
+    [COR_NENHUMA] = "?",
+    [COR_VERDE] = "Verde",
+    [COR_VERMELHA] = "Vermelho",
+    [COR_AZUL] = "Azul",
+    [COR_AMARELA] = "Amarelo",
+    [COR_ROXA] = "Roxo",
+};
 static EstadoFechadura fechadura;    // Instância global da estrutura de estado da fechadura
+static uint32_t boot_pronto_ms = 0;  // Do reset até a fechadura aceitar cartões (vai no primeiro heartbeat)
+static bool boot_reportado = false;
+
+// Votação do classificador durante a aproximação de um cartão
+static classificador_janela_t janela_cartao;
+static absolute_time_t janela_cartao_validade;
+static classificador_calibracao_t calibracao;
+
+// Pacotes recebidos do Núcleo 1, retirados da FIFO de hardware pela interrupção SIO_IRQ_PROC0
+static volatile uint32_t fifo_recebidos[FIFO_RECEBIDOS_TAMANHO];
+static volatile uint8_t fifo_recebidos_cabeca = 0, fifo_recebidos_cauda = 0;
 
 // --- Protótipos de Funções (declarações antecipadas) ---
 void timer_iniciar(TimerNaoBloqueante *timer, uint64_t duracao_us);
@@ -104,20 +205,32 @@ bool timer_expirou(TimerNaoBloqueante *timer);
 void led_iniciar_pulso(uint8_t r, uint8_t g, uint8_t b);
 void led_parar_pulso();
 void solicitar_publicacao_mqtt(enum MQTT_MSG_TYPE tipo_msg, enum CorDetectada cor);
+void fifo_irq_handler(void);
+bool fifo_receber(uint32_t *pacote);
 void verificar_fifo(void);
+void maquina_iniciar(void);
+void maquina_disparar(enum EventoFechadura evento);
+void animacao_iniciar(enum Animacao animacao);
+void animacao_parar(enum Animacao animacao);
+void animacao_invalidar(enum Animacao animacao);
+absolute_time_t calcular_proximo_prazo(void);
+bool modo_le_teclado(enum ModoOperacao modo);
 void inicia_hardware();
-void set_rgb_solid(uint16_t r, uint16_t g, uint16_t b);
+void set_rgb_solid(uint32_t cor);
 void start_rgb_pulse_and_matrix_center(uint8_t r, uint8_t g, uint8_t b);
 void reset_visual_state();
 void acionar_fechamento();
 void acionar_abertura();
-void desativar_modo_emergencia(void);
-enum CorDetectada detectar_cor_cartao(tcs34725_color_data_t colors);
+enum CorDetectada detectar_cor_cartao(tcs34725_color_data_t colors, uint8_t *confianca);
 void handle_modo_espera();
 void handle_modo_aguarda_senha();
 void handle_modo_aberto();
 void handle_admin_aguardando_cartao();
 void handle_admin_aguardando_nova_senha();
+void handle_admin_ajuste_tempo();
+void handle_admin_calibracao();
+void handle_modo_mensagem();
+void handle_modo_emergencia();
 void funcao_wifi_nucleo1();
 void inicia_core1();
 
@@ -142,13 +255,22 @@ void timer_iniciar(TimerNaoBloqueante *timer, uint64_t duracao_us) {
  */
 bool timer_expirou(TimerNaoBloqueante *timer) {
     if (!timer->ativo) return false;
-    if (absolute_time_diff_us(timer->inicio, get_absolute_time()) >= timer->duracao_us) {
+    if (absolute_time_diff_us(timer->inicio, get_absolute_time()) >= (int64_t)timer->duracao_us) {
         timer->ativo = false; // Desativa o timer após expirar
         return true;
     }
     return false;
 }
 
+/**
+ * @brief Instante em que um timer não-bloqueante expira.
+ * @param timer Ponteiro para a estrutura do timer.
+ * @return O prazo do timer, ou at_the_end_of_time se ele não estiver ativo.
+ */
+static absolute_time_t timer_prazo(const TimerNaoBloqueante *timer) {
+    return timer->ativo ? delayed_by_us(timer->inicio, timer->duracao_us) : at_the_end_of_time;
+}
+
 /**
  * @brief Ativa o efeito de pulso para o LED RGB.
  * @param r Componente vermelho da cor (0-255).
@@ -156,100 +278,125 @@ bool timer_expirou(TimerNaoBloqueante *timer) {
  * @param b Componente azul da cor (0-255).
  */
 void led_iniciar_pulso(uint8_t r, uint8_t g, uint8_t b) {
-    fechadura.efeito_pulso.ativo = true;
-    fechadura.efeito_pulso.inicio = get_absolute_time();
     fechadura.efeito_pulso.r = r;
     fechadura.efeito_pulso.g = g;
     fechadura.efeito_pulso.b = b;
+    animacao_iniciar(ANIMACAO_PULSO);
 }
 
 /**
  * @brief Para o efeito de pulso e desliga o LED RGB.
  */
 void led_parar_pulso() {
-    fechadura.efeito_pulso.ativo = false;
+    animacao_parar(ANIMACAO_PULSO);
     rgb_led_set_color(0, 0, 0); // Apaga o LED
 }
 
 /**
- * @brief Envia uma solicitação de publicação MQTT para o Núcleo 1 através da FIFO.
- * @details Empacota o tipo de mensagem e a cor associada em um único valor de 32 bits.
+ * @brief Envia uma solicitação de publicação MQTT para o Núcleo 1.
+ * @details Eventos de histórico vão para o diário em flash (diario.h), de onde o Núcleo 1
+ * os publica em ordem, mesmo após uma queda da rede ou um reinício. Os demais vão pelo
+ * anel compartilhado (eventos.h). Nenhum dos caminhos bloqueia o Núcleo 0.
  * @param tipo_msg O tipo de mensagem a ser enviada (definido no enum MQTT_MSG_TYPE).
  * @param cor A cor associada ao evento (definido no enum CorDetectada).
  */
 void solicitar_publicacao_mqtt(enum MQTT_MSG_TYPE tipo_msg, enum CorDetectada cor) {
-    // Empacota o tipo de mensagem e a cor em um valor de 16 bits
-    uint16_t valor = (uint16_t)((tipo_msg & 0xFF) | ((cor & 0xFF) << 8));
-    // Empacota o comando e o valor em um pacote de 32 bits
-    uint32_t pacote = (FIFO_CMD_PUBLICAR_MQTT << 16) | valor;
-    // Envia o pacote para o Núcleo 1 de forma bloqueante
-    multicore_fifo_push_blocking(pacote);
+    if (mqtt_topico_do_evento((uint8_t)tipo_msg) == TOPICO_ID_HISTORICO) {
+        diario_registrar((uint8_t)tipo_msg, (uint8_t)cor);
+    } else {
+        eventos_enviar((uint8_t)tipo_msg, (uint8_t)cor, 0);
+    }
+}
+
+/**
+ * @brief Interrupção da FIFO inter-core no Núcleo 0.
+ * @details Esvazia a FIFO de hardware para a fila local e acorda o loop principal (WFE).
+ */
+void fifo_irq_handler(void) {
+    while (multicore_fifo_rvalid()) {
+        uint32_t pacote = multicore_fifo_pop_blocking();
+        uint8_t proxima = (fifo_recebidos_cabeca + 1) % FIFO_RECEBIDOS_TAMANHO;
+        if (proxima != fifo_recebidos_cauda) { // Descarta se a fila local estiver cheia
+            fifo_recebidos[fifo_recebidos_cabeca] = pacote;
+            fifo_recebidos_cabeca = proxima;
+        }
+    }
+    multicore_fifo_clear_irq();
+    __sev();
+}
+
+/**
+ * @brief Retira o próximo pacote recebido do Núcleo 1, se houver.
+ * @param pacote Destino do pacote.
+ * @return true se um pacote foi retirado.
+ */
+bool fifo_receber(uint32_t *pacote) {
+    if (fifo_recebidos_cauda == fifo_recebidos_cabeca) {
+        return false;
+    }
+    *pacote = fifo_recebidos[fifo_recebidos_cauda];
+    fifo_recebidos_cauda = (fifo_recebidos_cauda + 1) % FIFO_RECEBIDOS_TAMANHO;
+    return true;
 }
 
 /**
  * @brief Verifica se há dados na FIFO vindos do Núcleo 1.
- * @details Usado para receber comandos do Núcleo 1, como mudar o estado da fechadura (ex: modo admin, emergência).
+ * @details Usado para receber comandos do Núcleo 1. Os pedidos de mudança de estado (modo admin,
+ * emergência) viram eventos da máquina de estados; a tabela TRANSICOES decide o que fazer com eles.
  */
 void verificar_fifo(void) {
-    if (multicore_fifo_rvalid()) { // Há dados para ler?
-        uint32_t pacote = multicore_fifo_pop_blocking();
+    uint32_t pacote;
+    if (fifo_receber(&pacote)) { // Há dados para ler?
         uint16_t comando = pacote >> 16;
         uint16_t valor = pacote & 0xFFFF;
 
         if (comando == FIFO_CMD_MUDAR_ESTADO) {
             if (valor == MODO_EMERGENCIA_INCENDIO) {
-                // Lógica para alternar (ligar/desligar) o modo de emergência
-                if (fechadura.modo_atual == MODO_EMERGENCIA_INCENDIO) {
-                    desativar_modo_emergencia();
-                } else {
-                    fechadura.modo_atual = (enum ModoOperacao)valor;
-                    fechadura.modo_foi_inicializado = false;
-                }
-            } else { // Outras mudanças de estado
-                fechadura.modo_atual = (enum ModoOperacao)valor;
-                fechadura.modo_foi_inicializado = false;
-                // Limpa a senha ao mudar de estado para evitar resíduos
-                fechadura.digitos_count = 0;
-                memset(fechadura.senha_digitada, 0, sizeof(fechadura.senha_digitada));
+                maquina_disparar(EVENTO_COMANDO_INCENDIO); // Alterna (liga/desliga) o modo de emergência
+            } else if (valor == MODO_ADMIN_AGUARDANDO_CARTAO) {
+                maquina_disparar(EVENTO_COMANDO_ADMIN);
             }
+        } else if (comando == FIFO_CMD_MQTT_CONECTADO) {
+            printf("Rede: broker conectado %lu ms apos o boot\n", (unsigned long)to_ms_since_boot(get_absolute_time()));
+        } else if ((comando & 0xFFF0) == FIFO_CMD_CONFIGURAR) {
+            // Ajuste remoto: vale já; a gravação na flash fica para configuracao_processar
+            bool aceito = configuracao_alterar(comando & 0x000F, valor);
+            solicitar_publicacao_mqtt(aceito ? MSG_LOG_CONFIG_ALTERADA : MSG_LOG_CONFIG_RECUSADA, COR_NENHUMA);
         }
     }
 }
 
 /**
  * @brief Inicia o processo de fechamento da tranca.
- * @details Mostra mensagem, ativa animação, move o servo, e atualiza o estado e MQTT.
+ * @details Mostra mensagem, ativa animação, move o servo e atualiza o estado e MQTT.
+ * Ação das transições que levam de volta ao MODO_ESPERA fechando a tranca.
  */
 void acionar_fechamento() {
     display_show_message(NULL, "Fechado", NULL);
-    fechadura.animacao_fechando_ativa = true;
-    fechadura.animacao_circulo_tempo_ativa = false;
-    set_rgb_solid(PWM_MAX_DUTY, 0, 0); // LED vermelho sólido
+    animacao_iniciar(ANIMACAO_FECHANDO);
+    set_rgb_solid(0xFF0000); // LED vermelho sólido
     servo_start_move(0); // Move servo para a posição de fechado
     timer_iniciar(&fechadura.timer_servo, SERVO_MOVE_DURATION_US);
     fechadura.status_aberto = false;
     solicitar_publicacao_mqtt(MSG_STATUS_SISTEMA_FECHADO, COR_NENHUMA);
-    fechadura.modo_atual = MODO_ESPERA; // Retorna ao modo de espera
-    fechadura.modo_foi_inicializado = false;
 }
 
 /**
  * @brief Inicia o processo de abertura da tranca após sucesso na autenticação.
  * @details Toca som de sucesso, ativa animações, move o servo e inicia o timer de auto-travamento.
+ * Ação da transição MODO_AGUARDA_SENHA -> MODO_ABERTO.
  */
 void acionar_abertura() {
     feedback_tocar_sucesso();
-    fechadura.animacao_sucesso_ativa = true;
+    animacao_iniciar(ANIMACAO_SUCESSO);
     matriz_limpar();
-    set_rgb_solid(0, PWM_MAX_DUTY, 0); // LED Verde para sucesso
+    set_rgb_solid(0x00FF00); // LED Verde para sucesso
     display_show_message("ACESSO LIBERADO", "Bem-vindo!", NULL);
     servo_start_move(150); // Move servo para a posição de aberto
     timer_iniciar(&fechadura.timer_servo, SERVO_MOVE_DURATION_US);
     fechadura.status_aberto = true;
-    fechadura.modo_atual = MODO_ABERTO;
-    fechadura.modo_foi_inicializado = false;
     // Inicia contagem regressiva para fechar automaticamente
-    timer_iniciar(&fechadura.timer_auto_trava, (uint64_t)TEMPO_AUTO_TRAVA_S * 1000000);
+    timer_iniciar(&fechadura.timer_auto_trava, (uint64_t)configuracao_obter()->auto_trava_s * 1000000);
     // Publica o status via MQTT
     solicitar_publicacao_mqtt(MSG_STATUS_SISTEMA_ABERTO, COR_NENHUMA);
     solicitar_publicacao_mqtt(MSG_LOG_ACESSO_OK, fechadura.cor_ativa);
@@ -257,97 +404,121 @@ void acionar_abertura() {
 
 /**
  * @brief Lógica para detectar a cor de um cartão usando o sensor TCS34725.
+ * @details Cada leitura vota no classificador (classificador.h) contra os centróides
+ * calibrados; a decisão sai após 2 a CLASSIFICADOR_JANELA leituras da mesma aproximação.
  * @param colors Leituras de R, G, B e Clear do sensor.
- * @return A cor detectada (COR_VERDE, COR_VERMELHA, COR_AZUL) ou COR_NENHUMA.
+ * @param confianca Saída: confiança média da decisão (0-100).
+ * @return A cor decidida, ou COR_NENHUMA enquanto a votação não terminou ou se nenhum cartão venceu.
  */
-enum CorDetectada detectar_cor_cartao(tcs34725_color_data_t colors) {
-    const int CLEAR_THRESHOLD = 70; // Limiar de luminosidade para evitar leituras falsas no escuro
-    if (colors.clear < CLEAR_THRESHOLD) return COR_NENHUMA;
-    // Lógica baseada na proporção entre as componentes de cor
-    if ((colors.green > colors.red * 1.8) && (colors.green > colors.blue * 1.8)) return COR_VERDE;
-    if ((colors.red > colors.green * 2.0) && (colors.red > colors.blue * 2.0)) return COR_VERMELHA;
-    if ((colors.blue > colors.green * 1.5) && (colors.blue > colors.red * 2.0)) return COR_AZUL;
-    return COR_NENHUMA;
+enum CorDetectada detectar_cor_cartao(tcs34725_color_data_t colors, uint8_t *confianca) {
+#if CLASSIFICADOR_REGISTRAR_AMOSTRAS
+    printf("%u,%u,%u,%u\n", colors.clear_normalizado, colors.red, colors.green, colors.blue);
+#endif
+    // Tabela montada a cada leitura a partir da configuração: calibrações valem na hora
+    const configuracao_t *config = configuracao_obter();
+    centroide_t centroides[COR_QUANTIDADE - 1];
+    for (uint cartao = COR_VERDE; cartao < COR_QUANTIDADE; cartao++) {
+        centroide_t *centroide = &centroides[cartao - COR_VERDE];
+        centroide->cartao = (uint8_t)cartao;
+        centroide->centro.r = configuracao_valor(CONFIG_CENTROIDE_R(cartao));
+        centroide->centro.g = configuracao_valor(CONFIG_CENTROIDE_G(cartao));
+        centroide->centro.b = CLASSIFICADOR_ESCALA - centroide->centro.r - centroide->centro.g;
+    }
+    classificador_tabela_t tabela = {
+        .centroides = centroides,
+        .quantidade = COR_QUANTIDADE - 1,
+        .raio = config->raio_cartao,
+        .limiar_clear = config->limiar_clear,
+    };
+
+    // Uma pausa entre leituras indica que o cartão saiu: os votos anteriores não valem mais
+    if (time_reached(janela_cartao_validade)) {
+        classificador_reiniciar(&janela_cartao);
+    }
+    janela_cartao_validade = make_timeout_time_us(JANELA_CARTAO_VALIDADE_US);
+
+    classificador_resultado_t resultado;
+    if (!classificador_adicionar(&tabela, &janela_cartao, colors.clear_normalizado, colors.red, colors.green, colors.blue, &resultado)) {
+        return COR_NENHUMA;
+    }
+    printf("Cartao: %s, confianca %u%%, %u leituras\n", NOMES_CARTAO[resultado.cartao],
+           resultado.confianca, resultado.amostras);
+    *confianca = resultado.confianca;
+    return (enum CorDetectada)resultado.cartao;
 }
 
+// --- Funções Handler da Máquina de Estados ---
+// Cada modo tem um gancho de entrada, um de saída e um handler executado a cada volta do
+// loop (tabela MODOS). Os handlers não trocam de modo: disparam eventos, e a tabela
+// TRANSICOES decide o destino e a ação.
+
 /**
- * @brief Reverte o sistema do modo de emergência para o estado normal.
+ * @brief Entrada no MODO_ESPERA: publica o estado e inicia o pulso azul.
  */
-void desativar_modo_emergencia(void) {
-    reset_visual_state(); // Reseta todos os indicadores visuais
-    fechadura.timer_alarme_beep.ativo = false;
-    buzzer_stop_beep();
-    matriz_parar_animacao_fogo();
-    fechadura.animacao_fogo_ativa = false;
-    solicitar_publicacao_mqtt(MSG_LOG_EMERGENCIA_INCENDIO_OFF, COR_NENHUMA);
-    acionar_fechamento(); // Fecha a tranca por segurança
-    fechadura.modo_atual = MODO_ESPERA;
-    fechadura.modo_foi_inicializado = false;
+static void entrar_modo_espera(void) {
+    solicitar_publicacao_mqtt(MSG_STATUS_AGUARDANDO_CARTAO, COR_NENHUMA);
+    matriz_limpar();
+    start_rgb_pulse_and_matrix_center(0, 0, 255); // Inicia pulso azul
 }
 
-// --- Funções Handler da Máquina de Estados ---
-
 /**
  * @brief Gerencia o estado MODO_ESPERA.
  * @details Aguarda a aproximação de um cartão colorido.
  */
 void handle_modo_espera() {
-    // Bloco de inicialização: executado apenas uma vez quando entra neste modo.
-    if (!fechadura.modo_foi_inicializado) {
-        solicitar_publicacao_mqtt(MSG_STATUS_AGUARDANDO_CARTAO, COR_NENHUMA);
-        matriz_limpar();
-        start_rgb_pulse_and_matrix_center(0, 0, 255); // Inicia pulso azul
-        fechadura.modo_foi_inicializado = true;
-    }
     // Atualiza o display periodicamente
     if (timer_expirou(&fechadura.timer_display_update) || !fechadura.timer_display_update.ativo) {
         display_show_message("BitDogLock 2FA", "Aproxime cartao", NULL);
         timer_iniciar(&fechadura.timer_display_update, DISPLAY_UPDATE_INTERVAL_US);
     }
-    // Lê o sensor de cor
+    // Lê o sensor de cor (não-bloqueante: só classifica quando há leitura nova)
     tcs34725_color_data_t colors;
-    tcs34725_read_colors(i2c0, &colors);
-    enum CorDetectada cor_detectada = detectar_cor_cartao(colors);
+    enum CorDetectada cor_detectada = COR_NENHUMA;
+    uint8_t confianca = 0;
+    if (tcs34725_read_colors(i2c0, &colors)) {
+        cor_detectada = detectar_cor_cartao(colors, &confianca);
+    }
 
     // Se uma cor válida for detectada, muda para o modo de aguardar senha
     if (cor_detectada != COR_NENHUMA) {
         fechadura.cor_ativa = cor_detectada;
-        fechadura.timer_display_update.ativo = false; // Para a atualização periódica
-        solicitar_publicacao_mqtt(MSG_STATUS_CARTAO_LIDO, fechadura.cor_ativa);
-        // Reseta o buffer de senha
-        memset(fechadura.senha_digitada, 0, sizeof(fechadura.senha_digitada));
-        fechadura.digitos_count = 0;
-        // Transição de estado
-        fechadura.modo_atual = MODO_AGUARDA_SENHA;
-        fechadura.modo_foi_inicializado = false;
-        timer_iniciar(&fechadura.timer_timeout_senha, (uint64_t)TIMEOUT_SENHA_S * 1000000);
+        eventos_enviar(MSG_STATUS_CARTAO_LIDO, (uint8_t)fechadura.cor_ativa, confianca);
+        maquina_disparar(EVENTO_CARTAO_LIDO);
     }
 }
 
+/**
+ * @brief Entrada no MODO_AGUARDA_SENHA: LED amarelo e dígitos na matriz.
+ */
+static void entrar_modo_aguarda_senha(void) {
+    solicitar_publicacao_mqtt(MSG_STATUS_AGUARDANDO_SENHA, fechadura.cor_ativa);
+    set_rgb_solid(0xFFFF00); // LED Amarelo para entrada de senha
+    animacao_iniciar(ANIMACAO_DIGITACAO);
+}
+
+/**
+ * @brief Saída dos modos de digitação: os dígitos saem da matriz com eles.
+ */
+static void parar_digitacao(void) {
+    animacao_parar(ANIMACAO_DIGITACAO);
+}
+
 /**
  * @brief Gerencia o estado MODO_AGUARDA_SENHA.
  * @details Aguarda a digitação da senha no teclado. Possui um timeout.
  */
 void handle_modo_aguarda_senha() {
-    // Bloco de inicialização
-    if (!fechadura.modo_foi_inicializado) {
-        solicitar_publicacao_mqtt(MSG_STATUS_AGUARDANDO_SENHA, fechadura.cor_ativa);
-        set_rgb_solid(PWM_MAX_DUTY, PWM_MAX_DUTY, 0); // LED Amarelo para entrada de senha
-        fechadura.modo_foi_inicializado = true;
-        fechadura.animacao_digitacao_ativa = true;
-    }
     // Atualiza o display com o tempo restante
     if (timer_expirou(&fechadura.timer_display_update) || !fechadura.timer_display_update.ativo) {
         int64_t diff_us = absolute_time_diff_us(fechadura.timer_timeout_senha.inicio, get_absolute_time());
-        int tempo_restante = TIMEOUT_SENHA_S - (diff_us / 1000000);
+        int tempo_restante = configuracao_obter()->timeout_senha_s - (diff_us / 1000000);
         if (tempo_restante < 0) tempo_restante = 0;
         char linha1[20], linha3[20];
         // Monta a mensagem do display baseada na cor ativa
-        switch (fechadura.cor_ativa) {
-            case COR_VERDE:    sprintf(linha1, "Senha (Verde):"); break;
-            case COR_VERMELHA: sprintf(linha1, "Senha (Vermelho):"); break;
-            case COR_AZUL:     sprintf(linha1, "Senha (Azul):"); break;
-            default:           sprintf(linha1, "Digite a senha:"); break;
+        if (fechadura.cor_ativa != COR_NENHUMA && fechadura.cor_ativa < COR_QUANTIDADE) {
+            sprintf(linha1, "Senha (%s):", NOMES_CARTAO[fechadura.cor_ativa]);
+        } else {
+            sprintf(linha1, "Digite a senha:");
         }
         sprintf(linha3, "Tempo: %ds", tempo_restante);
         display_show_message(linha1, fechadura.senha_digitada, linha3);
@@ -355,17 +526,7 @@ void handle_modo_aguarda_senha() {
     }
     // Verifica se o tempo para digitar a senha esgotou
     if (timer_expirou(&fechadura.timer_timeout_senha)) {
-        feedback_tocar_timeout();
-        display_show_message("OPERAÇÃO EXPIRADA", "Tempo esgotado", NULL);
-        solicitar_publicacao_mqtt(MSG_LOG_EVENTO_TIMEOUT_SENHA, fechadura.cor_ativa);
-        
-        // SINCRONIZAÇÃO: Define o LED RGB para amarelo, acompanhando a animação de timeout.
-        set_rgb_solid(PWM_MAX_DUTY, 20000, 0); 
-        
-        fechadura.animacao_timeout_ativa = true;
-        fechadura.animacao_digitacao_ativa = false;
-        fechadura.modo_atual = MODO_MSG_TIMEOUT; // Muda para um estado de mensagem temporária
-        fechadura.modo_foi_inicializado = false;
+        maquina_disparar(EVENTO_TEMPO_ESGOTADO);
         return; // Sai da função imediatamente
     }
     // Lê uma tecla do keypad
@@ -373,56 +534,44 @@ void handle_modo_aguarda_senha() {
     if (tecla != '\0') { // Se uma tecla foi pressionada
         buzzer_play_tone(1500, 50); // Beep de feedback
         if (tecla == '*') { // Tecla de cancelamento
-            solicitar_publicacao_mqtt(MSG_LOG_OPERACAO_CANCELADA, fechadura.cor_ativa);
-            fechadura.animacao_digitacao_ativa = false;
-            fechadura.modo_atual = MODO_ESPERA; // Volta ao início
-            fechadura.modo_foi_inicializado = false;
-        } else if (tecla >= '0' && tecla <= '9' && fechadura.digitos_count < (sizeof(fechadura.senha_digitada) - 1)) {
+            maquina_disparar(EVENTO_CANCELAR);
+        } else if (tecla >= '0' && tecla <= '9' && fechadura.digitos_count < (int)sizeof(fechadura.senha_digitada) - 1) {
             // Adiciona o dígito pressionado à senha
             fechadura.senha_digitada[fechadura.digitos_count++] = tecla;
             fechadura.senha_digitada[fechadura.digitos_count] = '\0'; // Mantém o terminador nulo
+            animacao_invalidar(ANIMACAO_DIGITACAO);
 
             // Fluxo único: confirma automaticamente ao completar 4 dígitos
             if (fechadura.digitos_count == 4) {
-                bool senha_valida = false;
-                switch (fechadura.cor_ativa) {
-                    case COR_VERDE:    if (strcmp(fechadura.senha_digitada, SENHA_VERDE) == 0) senha_valida = true; break;
-                    case COR_VERMELHA: if (strcmp(fechadura.senha_digitada, SENHA_VERMELHA) == 0) senha_valida = true; break;
-                    case COR_AZUL:     if (strcmp(fechadura.senha_digitada, SENHA_AZUL) == 0) senha_valida = true; break;
-                    default: senha_valida = false; break;
-                }
-                if (senha_valida) {
-                    acionar_abertura(); // Senha correta, abre a tranca
-                } else {
-                    feedback_tocar_erro();
-                    display_show_message("ACESSO NEGADO", "Senha Incorreta", NULL);
-                    solicitar_publicacao_mqtt(MSG_LOG_ACESSO_FALHA, fechadura.cor_ativa);
-                    set_rgb_solid(PWM_MAX_DUTY, 0, 0);
-                    fechadura.animacao_erro_ativa = true;
-                    fechadura.animacao_digitacao_ativa = false;
-                    fechadura.modo_atual = MODO_MSG_ACESSO_NEGADO;
-                    fechadura.modo_foi_inicializado = false;
-                }
+                // A identidade do cartão é a cor lida pelo sensor
+                bool senha_valida = credenciais_verificar((uint32_t)fechadura.cor_ativa, fechadura.senha_digitada);
+                maquina_disparar(senha_valida ? EVENTO_SENHA_CORRETA : EVENTO_SENHA_INCORRETA);
             }
         }
     }
 }
 
+/**
+ * @brief Entrada no MODO_ABERTO: a cor inicial é definida no acionar_abertura(); aqui
+ * apenas começa o círculo de tempo.
+ */
+static void entrar_modo_aberto(void) {
+    animacao_iniciar(ANIMACAO_CIRCULO_TEMPO);
+}
+
+static void sair_modo_aberto(void) {
+    animacao_parar(ANIMACAO_CIRCULO_TEMPO);
+}
+
 /**
  * @brief Gerencia o estado MODO_ABERTO.
  * @details Mantém a tranca aberta e exibe uma contagem regressiva para o travamento automático.
  */
 void handle_modo_aberto() {
-    // Bloco de inicialização
-    if (!fechadura.modo_foi_inicializado) {
-        // A cor inicial é definida no acionar_abertura(). Aqui apenas ativamos a animação.
-        fechadura.animacao_circulo_tempo_ativa = true;
-        fechadura.modo_foi_inicializado = true;
-    }
     // Atualiza o display com o tempo restante para fechar
     if (timer_expirou(&fechadura.timer_display_update) || !fechadura.timer_display_update.ativo) {
         int64_t diff_us = absolute_time_diff_us(fechadura.timer_auto_trava.inicio, get_absolute_time());
-        int tempo_restante = TEMPO_AUTO_TRAVA_S - (diff_us / 1000000);
+        int tempo_restante = configuracao_obter()->auto_trava_s - (diff_us / 1000000);
         if (tempo_restante < 0) tempo_restante = 0;
         char linha2_buffer[25];
         sprintf(linha2_buffer, "Travando em: %ds", tempo_restante);
@@ -431,40 +580,64 @@ void handle_modo_aberto() {
     }
     // Verifica se o tempo para auto-travamento expirou
     if (timer_expirou(&fechadura.timer_auto_trava)) {
-        solicitar_publicacao_mqtt(MSG_LOG_EVENTO_AUTO_LOCK, COR_NENHUMA);
-        fechadura.animacao_circulo_tempo_ativa = false;
-        acionar_fechamento(); // Inicia o fechamento
+        maquina_disparar(EVENTO_AUTO_TRAVA);
     }
 }
 
+/**
+ * @brief Entrada no MODO_ADMIN_AGUARDANDO_CARTAO: publica o início e inicia o pulso roxo.
+ */
+static void entrar_admin_aguardando_cartao(void) {
+    solicitar_publicacao_mqtt(MSG_LOG_ADMIN_INICIADO, COR_NENHUMA);
+    display_show_message("--- MODO ADMIN ---", "Aproxime o cartao", "A/B/C: ajustes");
+    solicitar_publicacao_mqtt(MSG_STATUS_MODO_ADMIN, COR_NENHUMA);
+    matriz_limpar();
+    start_rgb_pulse_and_matrix_center(255, 0, 255); // Inicia pulso roxo/magenta
+}
+
 /**
  * @brief Gerencia o estado MODO_ADMIN_AGUARDANDO_CARTAO.
  * @details Primeiro passo do modo admin: aguarda o cartão a ser configurado.
  */
 void handle_admin_aguardando_cartao() {
-    // Bloco de inicialização
-    if (!fechadura.modo_foi_inicializado) {
-        solicitar_publicacao_mqtt(MSG_LOG_ADMIN_INICIADO, COR_NENHUMA);
-        display_show_message("--- MODO ADMIN ---", "Aproxime o cartao", "a ser configurado");
-        solicitar_publicacao_mqtt(MSG_STATUS_MODO_ADMIN, COR_NENHUMA);
-        matriz_limpar();
-        start_rgb_pulse_and_matrix_center(255, 0, 255); // Inicia pulso roxo/magenta
-        fechadura.modo_foi_inicializado = true;
-    }
-    // Lê o sensor de cor
+    // Lê o sensor de cor (não-bloqueante: só classifica quando há leitura nova)
     tcs34725_color_data_t colors;
-    tcs34725_read_colors(i2c0, &colors);
-    enum CorDetectada cor_detectada_admin = detectar_cor_cartao(colors);
+    enum CorDetectada cor_detectada_admin = COR_NENHUMA;
+    uint8_t confianca;
+    if (tcs34725_read_colors(i2c0, &colors)) {
+        cor_detectada_admin = detectar_cor_cartao(colors, &confianca);
+    }
 
     // Se um cartão for detectado, avança para o próximo passo do modo admin
     if (cor_detectada_admin != COR_NENHUMA) {
         fechadura.cor_ativa = cor_detectada_admin;
-        matriz_limpar();
-        memset(fechadura.senha_digitada, 0, sizeof(fechadura.senha_digitada));
-        fechadura.digitos_count = 0;
-        fechadura.modo_atual = MODO_ADMIN_AGUARDANDO_NOVA_SENHA;
-        fechadura.modo_foi_inicializado = false;
+        maquina_disparar(EVENTO_CARTAO_LIDO);
+        return;
     }
+
+    // Sem cartão: A ajusta o auto-travamento, B o tempo para digitar a senha e C calibra um cartão
+    char tecla = keypad_get_key();
+    if (tecla == 'C') {
+        buzzer_play_tone(1500, 50);
+        maquina_disparar(EVENTO_TECLA_CALIBRAR);
+        return;
+    }
+    if (tecla == 'A' || tecla == 'B') {
+        buzzer_play_tone(1500, 50);
+        fechadura.ajuste_chave = (tecla == 'A') ? CONFIG_AUTO_TRAVA_S : CONFIG_TIMEOUT_SENHA_S;
+        maquina_disparar(EVENTO_TECLA_AJUSTE);
+    }
+}
+
+/**
+ * @brief Entrada no MODO_ADMIN_AGUARDANDO_NOVA_SENHA: troca o pulso roxo por amarelo sólido.
+ */
+static void entrar_admin_aguardando_nova_senha(void) {
+    char linha1_buffer[25];
+    sprintf(linha1_buffer, "Nova Senha (%s):", NOMES_CARTAO[fechadura.cor_ativa]);
+    display_show_message("--- MODO ADMIN ---", linha1_buffer, "");
+    set_rgb_solid(0xFFFF00);
+    animacao_iniciar(ANIMACAO_DIGITACAO);
 }
 
 /**
@@ -472,24 +645,10 @@ void handle_admin_aguardando_cartao() {
  * @details Aguarda a digitação da nova senha de 4 dígitos para o cartão selecionado.
  */
 void handle_admin_aguardando_nova_senha() {
-    // Bloco de inicialização
-    if (!fechadura.modo_foi_inicializado) {
-        char linha1_buffer[25];
-        sprintf(linha1_buffer, "Nova Senha (%s):",
-                fechadura.cor_ativa == COR_VERDE ? "Verde" :
-                (fechadura.cor_ativa == COR_VERMELHA ? "Vermelho" : "Azul"));
-        display_show_message("--- MODO ADMIN ---", linha1_buffer, "");
-        // Para o pulso roxo e define o LED para amarelo sólido.
-        set_rgb_solid(PWM_MAX_DUTY, PWM_MAX_DUTY, 0);
-        fechadura.modo_foi_inicializado = true;
-        fechadura.animacao_digitacao_ativa = true;
-    }
     // Atualiza o display periodicamente para mostrar a senha sendo digitada
     if (timer_expirou(&fechadura.timer_display_update) || !fechadura.timer_display_update.ativo) {
         char linha1_buffer[25];
-        sprintf(linha1_buffer, "Nova Senha (%s):",
-                fechadura.cor_ativa == COR_VERDE ? "Verde" :
-                (fechadura.cor_ativa == COR_VERMELHA ? "Vermelho" : "Azul"));
+        sprintf(linha1_buffer, "Nova Senha (%s):", NOMES_CARTAO[fechadura.cor_ativa]);
         display_show_message("--- MODO ADMIN ---", linha1_buffer, fechadura.senha_digitada);
         timer_iniciar(&fechadura.timer_display_update, DISPLAY_UPDATE_INTERVAL_US);
     }
@@ -498,34 +657,490 @@ void handle_admin_aguardando_nova_senha() {
     if (tecla != '\0') {
         buzzer_play_tone(1500, 50);
         if (tecla == '*') { // Cancelamento
-            display_show_message("--- MODO ADMIN ---", "Operacao Cancelada", "");
-            solicitar_publicacao_mqtt(MSG_LOG_OPERACAO_CANCELADA, COR_NENHUMA);
-            fechadura.modo_atual = MODO_ADMIN_MSG_CANCELADO; // Estado de mensagem temporária
-            fechadura.modo_foi_inicializado = false;
-            fechadura.animacao_digitacao_ativa = false;
-        } else if (tecla >= '0' && tecla <= '9' && fechadura.digitos_count < (sizeof(fechadura.senha_digitada) - 1)) {
+            maquina_disparar(EVENTO_CANCELAR);
+        } else if (tecla >= '0' && tecla <= '9' && fechadura.digitos_count < (int)sizeof(fechadura.senha_digitada) - 1) {
             // Adiciona o dígito à nova senha
             fechadura.senha_digitada[fechadura.digitos_count++] = tecla;
             fechadura.senha_digitada[fechadura.digitos_count] = '\0';
+            animacao_invalidar(ANIMACAO_DIGITACAO);
 
-            // Fluxo único: salva automaticamente ao completar 4 dígitos
+            // Fluxo único: salva automaticamente ao completar 4 dígitos.
+            // Flash indisponível (ou tabela cheia): a senha anterior continua valendo
             if (fechadura.digitos_count == 4) {
-                switch (fechadura.cor_ativa) {
-                    case COR_VERDE:    strcpy(SENHA_VERDE, fechadura.senha_digitada); break;
-                    case COR_VERMELHA: strcpy(SENHA_VERMELHA, fechadura.senha_digitada); break;
-                    case COR_AZUL:     strcpy(SENHA_AZUL, fechadura.senha_digitada); break;
-                    default: break;
-                }
-                display_show_message("SUCESSO!", "Senha Salva.", NULL);
-                feedback_tocar_sucesso();
-                set_rgb_solid(0, PWM_MAX_DUTY, 0);
-                solicitar_publicacao_mqtt(MSG_LOG_ADMIN_SENHA_ALTERADA, fechadura.cor_ativa);
-                fechadura.modo_atual = MODO_ADMIN_MSG_SUCESSO;
-                fechadura.modo_foi_inicializado = false;
-                fechadura.animacao_digitacao_ativa = false;
+                bool salva = credenciais_definir((uint32_t)fechadura.cor_ativa, fechadura.senha_digitada);
+                maquina_disparar(salva ? EVENTO_SALVO : EVENTO_FALHA);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Entrada no MODO_ADMIN_AJUSTE_TEMPO.
+ */
+static void entrar_admin_ajuste_tempo(void) {
+    set_rgb_solid(0xFFFF00);
+    fechadura.timer_display_update.ativo = false; // Desenha o valor atual já na primeira volta
+}
+
+/**
+ * @brief Gerencia o estado MODO_ADMIN_AJUSTE_TEMPO.
+ * @details Recebe o novo valor, em segundos, do parâmetro escolhido: até 3 dígitos e '#' confirma.
+ * O valor vale imediatamente; a gravação na flash acontece depois, sem parar a máquina de estados.
+ */
+void handle_admin_ajuste_tempo() {
+    const char *titulo = (fechadura.ajuste_chave == CONFIG_AUTO_TRAVA_S) ? "Auto-trava (s):" : "Tempo senha (s):";
+    if (timer_expirou(&fechadura.timer_display_update) || !fechadura.timer_display_update.ativo) {
+        char atual[20];
+        const configuracao_t *config = configuracao_obter();
+        sprintf(atual, "Atual: %u  #=ok",
+                (fechadura.ajuste_chave == CONFIG_AUTO_TRAVA_S) ? config->auto_trava_s : config->timeout_senha_s);
+        display_show_message(titulo, fechadura.senha_digitada, atual);
+        timer_iniciar(&fechadura.timer_display_update, DISPLAY_UPDATE_INTERVAL_US);
+    }
+    // Lê o teclado
+    char tecla = keypad_get_key();
+    if (tecla == '\0') {
+        return;
+    }
+    buzzer_play_tone(1500, 50);
+    if (tecla == '*') { // Cancelamento
+        maquina_disparar(EVENTO_CANCELAR);
+    } else if (tecla >= '0' && tecla <= '9' && fechadura.digitos_count < 3) {
+        fechadura.senha_digitada[fechadura.digitos_count++] = tecla;
+        fechadura.senha_digitada[fechadura.digitos_count] = '\0';
+        fechadura.timer_display_update.ativo = false;
+    } else if (tecla == '#' && fechadura.digitos_count > 0) {
+        bool aceito = configuracao_alterar(fechadura.ajuste_chave, (uint16_t)atoi(fechadura.senha_digitada));
+        maquina_disparar(aceito ? EVENTO_SALVO : EVENTO_FALHA);
+    }
+}
+
+/**
+ * @brief Entrada no MODO_ADMIN_CALIBRACAO: o cartão ainda vai ser escolhido.
+ */
+static void entrar_admin_calibracao(void) {
+    display_show_message("Calibrar cartao:", "1Vd 2Vm 3Az", "4Am 5Rx *=sai");
+    set_rgb_solid(0xFFFF00);
+    fechadura.calibracao_cartao = COR_NENHUMA;
+}
+
+/**
+ * @brief Gerencia o estado MODO_ADMIN_CALIBRACAO.
+ * @details Escolhe o cartão pelo número (1 a COR_QUANTIDADE - 1) e grava como centróide a
+ * média de CLASSIFICADOR_AMOSTRAS_CALIBRACAO leituras dele diante do sensor.
+ */
+void handle_admin_calibracao() {
+    // Lê o teclado
+    char tecla = keypad_get_key();
+    if (tecla == '*') { // Cancelamento
+        buzzer_play_tone(1500, 50);
+        maquina_disparar(EVENTO_CANCELAR);
+        return;
+    }
+    if (fechadura.calibracao_cartao == COR_NENHUMA) {
+        if (tecla >= '1' && tecla < '0' + COR_QUANTIDADE) {
+            buzzer_play_tone(1500, 50);
+            fechadura.calibracao_cartao = (enum CorDetectada)(tecla - '0');
+            classificador_calibracao_iniciar(&calibracao);
+            display_show_message("Calibrar cartao:", NOMES_CARTAO[fechadura.calibracao_cartao], "Segure o cartao");
+        }
+        return;
+    }
+
+    // Acumula as leituras com o cartão diante do sensor
+    tcs34725_color_data_t colors;
+    if (!tcs34725_read_colors(i2c0, &colors) || colors.clear_normalizado < configuracao_obter()->limiar_clear) {
+        return;
+    }
+    if (!classificador_calibracao_adicionar(&calibracao, colors.red, colors.green, colors.blue)) {
+        return;
+    }
+    cromaticidade_t centro;
+    classificador_calibracao_resultado(&calibracao, &centro);
+    configuracao_alterar_centroide(fechadura.calibracao_cartao, centro.r, centro.g);
+    printf("Calibracao: %s em r=%u g=%u b=%u\n", NOMES_CARTAO[fechadura.calibracao_cartao],
+           centro.r, centro.g, centro.b);
+    maquina_disparar(EVENTO_SALVO);
+}
+
+/**
+ * @brief Entrada nos estados de mensagem temporária: a mensagem fica na tela por TEMPO_MSG_PADRAO_US.
+ */
+static void entrar_modo_mensagem(void) {
+    timer_iniciar(&fechadura.timer_geral, TEMPO_MSG_PADRAO_US);
+}
+
+/**
+ * @brief Gerencia os estados de mensagem temporária (MODO_MSG_* e MODO_ADMIN_MSG_*).
+ * @details Estes estados apenas exibem uma mensagem por um tempo e depois voltam para MODO_ESPERA.
+ */
+void handle_modo_mensagem() {
+    if (timer_expirou(&fechadura.timer_geral)) {
+        maquina_disparar(EVENTO_MENSAGEM_CONCLUIDA);
+    }
+}
+
+/**
+ * @brief Entrada no MODO_EMERGENCIA_INCENDIO: alarme, animação de fogo e tranca aberta.
+ */
+static void entrar_modo_emergencia(void) {
+    display_show_message("EMERGENCIA!", "ALARME DE INCENDIO", "PERIGO!");
+    solicitar_publicacao_mqtt(MSG_LOG_EMERGENCIA_INCENDIO_ON, COR_NENHUMA);
+    animacao_iniciar(ANIMACAO_FOGO); // Animação de fogo na matriz, por cima do ponto central do pulso
+    start_rgb_pulse_and_matrix_center(255, 0, 0); // Pulso vermelho
+    timer_iniciar(&fechadura.timer_alarme_beep, 500000); // Inicia timer para o primeiro beep
+    servo_start_move(150); // Abre a tranca
+    timer_iniciar(&fechadura.timer_servo, SERVO_MOVE_DURATION_US);
+}
+
+/**
+ * @brief Saída do modo de emergência: silencia o alarme e limpa os indicadores visuais.
+ */
+static void sair_modo_emergencia(void) {
+    reset_visual_state();
+    fechadura.timer_alarme_beep.ativo = false;
+    buzzer_stop_beep();
+    solicitar_publicacao_mqtt(MSG_LOG_EMERGENCIA_INCENDIO_OFF, COR_NENHUMA);
+}
+
+/**
+ * @brief Gerencia o estado MODO_EMERGENCIA_INCENDIO.
+ * @details Toca um beep de alarme periodicamente até o comando que desliga a emergência.
+ */
+void handle_modo_emergencia() {
+    if (timer_expirou(&fechadura.timer_alarme_beep)) {
+        buzzer_play_tone(3000, 100);
+        timer_iniciar(&fechadura.timer_alarme_beep, 1000000); // Próximo beep em 1s
+    }
+}
+
+// --- Ações das Transições ---
+// Executadas entre a saída do modo de origem e a entrada no de destino.
+
+/**
+ * @brief Reseta o buffer de senha (também usado para os dígitos dos ajustes).
+ */
+static void limpar_senha(void) {
+    memset(fechadura.senha_digitada, 0, sizeof(fechadura.senha_digitada));
+    fechadura.digitos_count = 0;
+}
+
+/**
+ * @brief Cartão lido no MODO_ESPERA: começa a contagem para digitar a senha.
+ */
+static void acao_pedir_senha(void) {
+    fechadura.timer_display_update.ativo = false; // Para a atualização periódica
+    limpar_senha();
+    timer_iniciar(&fechadura.timer_timeout_senha, (uint64_t)configuracao_obter()->timeout_senha_s * 1000000);
+}
+
+static void acao_expirar_senha(void) {
+    feedback_tocar_timeout();
+    display_show_message("OPERAÇÃO EXPIRADA", "Tempo esgotado", NULL);
+    solicitar_publicacao_mqtt(MSG_LOG_EVENTO_TIMEOUT_SENHA, fechadura.cor_ativa);
+    // SINCRONIZAÇÃO: Define o LED RGB para amarelo, acompanhando a animação de timeout.
+    set_rgb_solid(0xFF9600);
+    animacao_iniciar(ANIMACAO_TIMEOUT);
+}
+
+static void acao_negar_acesso(void) {
+    feedback_tocar_erro();
+    display_show_message("ACESSO NEGADO", "Senha Incorreta", NULL);
+    solicitar_publicacao_mqtt(MSG_LOG_ACESSO_FALHA, fechadura.cor_ativa);
+    set_rgb_solid(0xFF0000);
+    animacao_iniciar(ANIMACAO_ERRO);
+}
+
+static void acao_cancelar_senha(void) {
+    solicitar_publicacao_mqtt(MSG_LOG_OPERACAO_CANCELADA, fechadura.cor_ativa);
+}
+
+static void acao_auto_trava(void) {
+    solicitar_publicacao_mqtt(MSG_LOG_EVENTO_AUTO_LOCK, COR_NENHUMA);
+    acionar_fechamento();
+}
+
+static void acao_cancelar_admin(void) {
+    display_show_message("--- MODO ADMIN ---", "Operacao Cancelada", "");
+    solicitar_publicacao_mqtt(MSG_LOG_OPERACAO_CANCELADA, COR_NENHUMA);
+}
+
+/**
+ * @brief Mostra o sucesso de uma operação do modo admin e publica o registro correspondente.
+ */
+static void admin_sucesso(const char *mensagem, enum MQTT_MSG_TYPE registro, enum CorDetectada cor) {
+    display_show_message("SUCESSO!", mensagem, NULL);
+    feedback_tocar_sucesso();
+    set_rgb_solid(0x00FF00);
+    solicitar_publicacao_mqtt(registro, cor);
+}
+
+static void acao_senha_salva(void) {
+    admin_sucesso("Senha Salva.", MSG_LOG_ADMIN_SENHA_ALTERADA, fechadura.cor_ativa);
+}
+
+static void acao_senha_nao_salva(void) {
+    feedback_tocar_erro();
+    display_show_message("--- MODO ADMIN ---", "Falha ao salvar", NULL);
+}
+
+static void acao_ajuste_salvo(void) {
+    admin_sucesso("Tempo Salvo.", MSG_LOG_CONFIG_ALTERADA, COR_NENHUMA);
+}
+
+static void acao_ajuste_recusado(void) {
+    feedback_tocar_erro();
+    display_show_message("--- MODO ADMIN ---", "Fora da faixa", NULL);
+    solicitar_publicacao_mqtt(MSG_LOG_CONFIG_RECUSADA, COR_NENHUMA);
+}
+
+static void acao_calibracao_salva(void) {
+    admin_sucesso("Cartao Calibrado", MSG_LOG_CALIBRACAO_CONCLUIDA, fechadura.calibracao_cartao);
+}
+
+// --- Tabelas da Máquina de Estados ---
+
+static const modo_t MODOS[MODO_QUANTIDADE] = {
+    [MODO_ESPERA] = {entrar_modo_espera, handle_modo_espera, NULL,
+                     CONSOME_DISPLAY | CONSOME_SENSOR, PERFIL_MODO_ESPERA},
+    [MODO_AGUARDA_SENHA] = {entrar_modo_aguarda_senha, handle_modo_aguarda_senha, parar_digitacao,
+                            CONSOME_DISPLAY | CONSOME_TIMEOUT_SENHA | CONSOME_TECLADO, PERFIL_MODO_AGUARDA_SENHA},
+    [MODO_ABERTO] = {entrar_modo_aberto, handle_modo_aberto, sair_modo_aberto,
+                     CONSOME_DISPLAY | CONSOME_AUTO_TRAVA, PERFIL_MODO_ABERTO},
+    [MODO_ADMIN_AGUARDANDO_CARTAO] = {entrar_admin_aguardando_cartao, handle_admin_aguardando_cartao, matriz_limpar,
+                                      CONSOME_SENSOR | CONSOME_TECLADO, PERFIL_MODO_ADMIN_CARTAO},
+    [MODO_ADMIN_AGUARDANDO_NOVA_SENHA] = {entrar_admin_aguardando_nova_senha, handle_admin_aguardando_nova_senha, parar_digitacao,
+                                          CONSOME_DISPLAY | CONSOME_TECLADO, PERFIL_MODO_ADMIN_SENHA},
+    [MODO_ADMIN_AJUSTE_TEMPO] = {entrar_admin_ajuste_tempo, handle_admin_ajuste_tempo, NULL,
+                                 CONSOME_DISPLAY | CONSOME_TECLADO, PERFIL_MODO_ADMIN_AJUSTE},
+    [MODO_ADMIN_CALIBRACAO] = {entrar_admin_calibracao, handle_admin_calibracao, NULL,
+                               CONSOME_SENSOR | CONSOME_TECLADO, PERFIL_MODO_ADMIN_CALIBRACAO},
+    [MODO_MSG_TIMEOUT] = {entrar_modo_mensagem, handle_modo_mensagem, reset_visual_state, CONSOME_MENSAGEM, PERFIL_QUANTIDADE},
+    [MODO_MSG_ACESSO_NEGADO] = {entrar_modo_mensagem, handle_modo_mensagem, reset_visual_state, CONSOME_MENSAGEM, PERFIL_QUANTIDADE},
+    [MODO_ADMIN_MSG_SUCESSO] = {entrar_modo_mensagem, handle_modo_mensagem, reset_visual_state, CONSOME_MENSAGEM, PERFIL_QUANTIDADE},
+    [MODO_ADMIN_MSG_ERRO_FORMATO] = {entrar_modo_mensagem, handle_modo_mensagem, reset_visual_state, CONSOME_MENSAGEM, PERFIL_QUANTIDADE},
+    [MODO_ADMIN_MSG_CANCELADO] = {entrar_modo_mensagem, handle_modo_mensagem, reset_visual_state, CONSOME_MENSAGEM, PERFIL_QUANTIDADE},
+    [MODO_EMERGENCIA_INCENDIO] = {entrar_modo_emergencia, handle_modo_emergencia, sair_modo_emergencia,
+                                  CONSOME_ALARME, PERFIL_QUANTIDADE},
+};
+
+// Procurada em ordem: vale a primeira linha com o modo atual (ou MODO_QUALQUER) e o evento.
+// Um evento sem linha para o modo atual é ignorado.
+static const transicao_t TRANSICOES[] = {
+    // Acesso
+    {MODO_ESPERA,        EVENTO_CARTAO_LIDO,     acao_pedir_senha,    MODO_AGUARDA_SENHA},
+    {MODO_AGUARDA_SENHA, EVENTO_SENHA_CORRETA,   acionar_abertura,    MODO_ABERTO},
+    {MODO_AGUARDA_SENHA, EVENTO_SENHA_INCORRETA, acao_negar_acesso,   MODO_MSG_ACESSO_NEGADO},
+    {MODO_AGUARDA_SENHA, EVENTO_TEMPO_ESGOTADO,  acao_expirar_senha,  MODO_MSG_TIMEOUT},
+    {MODO_AGUARDA_SENHA, EVENTO_CANCELAR,        acao_cancelar_senha, MODO_ESPERA},
+    {MODO_ABERTO,        EVENTO_AUTO_TRAVA,      acao_auto_trava,     MODO_ESPERA},
+
+    // Administração
+    {MODO_ADMIN_AGUARDANDO_CARTAO,     EVENTO_CARTAO_LIDO,    limpar_senha,          MODO_ADMIN_AGUARDANDO_NOVA_SENHA},
+    {MODO_ADMIN_AGUARDANDO_CARTAO,     EVENTO_TECLA_AJUSTE,   limpar_senha,          MODO_ADMIN_AJUSTE_TEMPO},
+    {MODO_ADMIN_AGUARDANDO_CARTAO,     EVENTO_TECLA_CALIBRAR, NULL,                  MODO_ADMIN_CALIBRACAO},
+    {MODO_ADMIN_AGUARDANDO_NOVA_SENHA, EVENTO_SALVO,          acao_senha_salva,      MODO_ADMIN_MSG_SUCESSO},
+    {MODO_ADMIN_AGUARDANDO_NOVA_SENHA, EVENTO_FALHA,          acao_senha_nao_salva,  MODO_ADMIN_MSG_ERRO_FORMATO},
+    {MODO_ADMIN_AGUARDANDO_NOVA_SENHA, EVENTO_CANCELAR,       acao_cancelar_admin,   MODO_ADMIN_MSG_CANCELADO},
+    {MODO_ADMIN_AJUSTE_TEMPO,          EVENTO_SALVO,          acao_ajuste_salvo,     MODO_ADMIN_MSG_SUCESSO},
+    {MODO_ADMIN_AJUSTE_TEMPO,          EVENTO_FALHA,          acao_ajuste_recusado,  MODO_ADMIN_MSG_ERRO_FORMATO},
+    {MODO_ADMIN_AJUSTE_TEMPO,          EVENTO_CANCELAR,       acao_cancelar_admin,   MODO_ADMIN_MSG_CANCELADO},
+    {MODO_ADMIN_CALIBRACAO,            EVENTO_SALVO,          acao_calibracao_salva, MODO_ADMIN_MSG_SUCESSO},
+    {MODO_ADMIN_CALIBRACAO,            EVENTO_CANCELAR,       acao_cancelar_admin,   MODO_ADMIN_MSG_CANCELADO},
+
+    // Mensagens temporárias (só os modos de mensagem disparam o evento)
+    {MODO_QUALQUER, EVENTO_MENSAGEM_CONCLUIDA, NULL, MODO_ESPERA},
+
+    // Comandos do Núcleo 1. A emergência só termina pelo próprio comando, fechando a tranca por segurança
+    {MODO_EMERGENCIA_INCENDIO, EVENTO_COMANDO_INCENDIO, acionar_fechamento, MODO_ESPERA},
+    {MODO_EMERGENCIA_INCENDIO, EVENTO_COMANDO_ADMIN,    NULL,               MODO_QUALQUER},
+    {MODO_QUALQUER,            EVENTO_COMANDO_INCENDIO, NULL,               MODO_EMERGENCIA_INCENDIO},
+    {MODO_QUALQUER,            EVENTO_COMANDO_ADMIN,    limpar_senha,       MODO_ADMIN_AGUARDANDO_CARTAO},
+};
+
+/**
+ * @brief Entra no modo inicial (MODO_ESPERA), executando seu gancho de entrada.
+ */
+void maquina_iniciar(void) {
+    fechadura.modo_atual = MODO_ESPERA;
+    MODOS[MODO_ESPERA].entrar();
+}
+
+/**
+ * @brief Aplica um evento ao modo atual segundo a tabela TRANSICOES.
+ * @details Executa, nesta ordem, a saída do modo atual, a ação da transição e a entrada
+ * no destino. O handler do novo modo roda a partir da próxima volta do loop.
+ * @param evento O evento ocorrido.
+ */
+void maquina_disparar(enum EventoFechadura evento) {
+    enum ModoOperacao origem = fechadura.modo_atual;
+    for (uint i = 0; i < count_of(TRANSICOES); i++) {
+        const transicao_t *transicao = &TRANSICOES[i];
+        if (transicao->evento != evento || (transicao->origem != origem && transicao->origem != MODO_QUALQUER)) {
+            continue;
+        }
+        // Destino MODO_QUALQUER: o evento é consumido sem sair do modo
+        bool muda = transicao->destino != MODO_QUALQUER;
+        if (muda && MODOS[origem].sair) {
+            MODOS[origem].sair();
+        }
+        if (transicao->acao) {
+            transicao->acao();
+        }
+        if (muda) {
+            fechadura.modo_atual = transicao->destino;
+            if (MODOS[transicao->destino].entrar) {
+                MODOS[transicao->destino].entrar();
             }
         }
+        return;
+    }
+}
+
+/**
+ * @brief Indica se o modo consome teclas (digitação de senha, ajustes e calibração).
+ */
+bool modo_le_teclado(enum ModoOperacao modo) {
+    return (MODOS[modo].consome & CONSOME_TECLADO) != 0;
+}
+
+// --- Animações ---
+// Erro, timeout, fechamento, sucesso e fogo são tabelas de feedback.c; as animações abaixo
+// dependem do estado da fechadura. Todas rodam no motor de animacoes.h, uma camada cada.
+
+/**
+ * @brief Dígitos já digitados na matriz (redesenhados a cada tecla, por animacao_invalidar).
+ */
+static void gerar_digitacao(animacao_quadro_t *quadro, uint32_t decorrido_ms) {
+    (void)decorrido_ms;
+    uint32_t padrao = 0;
+    for (int i = 0; i < fechadura.digitos_count && i < 4; i++) {
+        padrao |= ANIMACAO_PIXEL(i + 1, 2);
     }
+    animacoes_desenhar_padrao(quadro, padrao, 0xC89200); // Amarelo
+}
+
+/**
+ * @brief Círculo de tempo do modo aberto, com o LED RGB na mesma cor.
+ */
+static void gerar_circulo_tempo(animacao_quadro_t *quadro, uint32_t decorrido_ms) {
+    (void)decorrido_ms;
+    int64_t diff_us = absolute_time_diff_us(fechadura.timer_auto_trava.inicio, get_absolute_time());
+    int tempo_restante = configuracao_obter()->auto_trava_s - (diff_us / 1000000);
+
+    // A cor muda de verde para amarelo e para vermelho conforme o tempo se esgota.
+    if (tempo_restante > 10) {
+        animacoes_desenhar_padrao(quadro, FEEDBACK_PADRAO_CIRCULO, 0x00C800);
+        quadro->led = 0x00FF00; // Verde
+    } else if (tempo_restante > 5) {
+        animacoes_desenhar_padrao(quadro, FEEDBACK_PADRAO_CIRCULO, 0xFFC800);
+        quadro->led = 0xFF9600; // Amarelo/Laranja
+    } else {
+        animacoes_desenhar_padrao(quadro, FEEDBACK_PADRAO_CIRCULO, 0xFF0000);
+        quadro->led = 0xFF0000; // Vermelho
+    }
+}
+
+/**
+ * @brief Um quadro do LED RGB pulsante, com o ponto central da matriz acompanhando.
+ */
+static void gerar_pulso(animacao_quadro_t *quadro, uint32_t decorrido_ms) {
+    PERFIL_ESCOPO(PERFIL_PULSO_LED);
+    // Brilho da onda de "respiração" (senoide tabelada) aplicado à cor base, só com inteiros
+    uint8_t brilho = cor_respiracao(decorrido_ms, COR_PERIODO_RESPIRACAO_MS);
+    uint32_t cor = cor_escalar(cor_rgb(fechadura.efeito_pulso.r, fechadura.efeito_pulso.g, fechadura.efeito_pulso.b), brilho);
+    quadro->led = cor;
+    animacoes_desenhar_padrao(quadro, FEEDBACK_PADRAO_PONTO, cor);
+}
+
+static const animacao_t PULSO = {
+    .gerar = gerar_pulso,
+    .saidas_geradas = (1u << ANIMACAO_SAIDA_MATRIZ) | (1u << ANIMACAO_SAIDA_LED),
+    .periodo_ms = PERIODO_PULSO_MS,
+};
+
+static const animacao_t DIGITACAO = {
+    .gerar = gerar_digitacao,
+    .saidas_geradas = 1u << ANIMACAO_SAIDA_MATRIZ,
+};
+
+static const animacao_t CIRCULO_TEMPO = {
+    .gerar = gerar_circulo_tempo,
+    .saidas_geradas = (1u << ANIMACAO_SAIDA_MATRIZ) | (1u << ANIMACAO_SAIDA_LED),
+    .periodo_ms = PERIODO_CIRCULO_TEMPO_MS,
+};
+
+static const animacao_t *const ANIMACOES[ANIMACAO_QUANTIDADE] = {
+    [ANIMACAO_PULSO] = &PULSO,
+    [ANIMACAO_DIGITACAO] = &DIGITACAO,
+    [ANIMACAO_CIRCULO_TEMPO] = &CIRCULO_TEMPO,
+    [ANIMACAO_FOGO] = &feedback_animacao_fogo,
+    [ANIMACAO_SUCESSO] = &feedback_animacao_sucesso,
+    [ANIMACAO_FECHANDO] = &feedback_animacao_fechando,
+    [ANIMACAO_TIMEOUT] = &feedback_animacao_timeout,
+    [ANIMACAO_ERRO] = &feedback_animacao_erro,
+};
+_Static_assert(ANIMACAO_QUANTIDADE <= ANIMACOES_CAMADAS, "uma camada do motor por animacao");
+
+/**
+ * @brief Liga uma animação na sua camada; o primeiro quadro sai na próxima volta do loop.
+ */
+void animacao_iniciar(enum Animacao animacao) {
+    animacoes_iniciar((uint8_t)animacao, ANIMACOES[animacao]);
+}
+
+void animacao_parar(enum Animacao animacao) {
+    animacoes_parar((uint8_t)animacao);
+}
+
+/**
+ * @brief Redesenha uma animação sem cadência própria (ex: os dígitos, a cada tecla).
+ */
+void animacao_invalidar(enum Animacao animacao) {
+    animacoes_invalidar((uint8_t)animacao);
+}
+
+/**
+ * @brief Calcula até quando o Núcleo 0 pode dormir sem perder nenhum prazo.
+ * @details Considera os timers da fechadura, as animações ativas e as leituras pendentes
+ * do modo atual. Teclado, FIFO inter-core e conclusões de I2C acordam o núcleo por interrupção.
+ * @return O prazo mais próximo (no passado se o loop deve seguir imediatamente).
+ */
+absolute_time_t calcular_proximo_prazo(void) {
+    absolute_time_t prazo = at_the_end_of_time;
+    prazo = absolute_time_min(prazo, timer_prazo(&fechadura.timer_servo));
+    prazo = absolute_time_min(prazo, timer_prazo(&fechadura.timer_heartbeat));
+    prazo = absolute_time_min(prazo, i2c_dma_proximo_prazo());
+    prazo = absolute_time_min(prazo, matriz_proximo_prazo());
+    prazo = absolute_time_min(prazo, diario_proximo_prazo());
+    prazo = absolute_time_min(prazo, configuracao_proximo_prazo());
+    prazo = absolute_time_min(prazo, animacoes_proximo_prazo());
+
+    // Timers e leituras que só o modo atual consome: os de outro modo podem ter ficado
+    // ativos e expirados na transição, e manteriam o núcleo acordado
+    uint8_t consome = MODOS[fechadura.modo_atual].consome;
+    if (consome & CONSOME_DISPLAY) {
+        prazo = absolute_time_min(prazo, timer_prazo(&fechadura.timer_display_update));
+    }
+    if (consome & CONSOME_TIMEOUT_SENHA) {
+        prazo = absolute_time_min(prazo, timer_prazo(&fechadura.timer_timeout_senha));
+    }
+    if (consome & CONSOME_AUTO_TRAVA) {
+        prazo = absolute_time_min(prazo, timer_prazo(&fechadura.timer_auto_trava));
+    }
+    if (consome & CONSOME_SENSOR) {
+        prazo = absolute_time_min(prazo, tcs34725_proxima_amostra());
+    }
+    if (consome & CONSOME_TECLADO) {
+        prazo = absolute_time_min(prazo, keypad_proximo_prazo());
+    }
+    if (consome & CONSOME_MENSAGEM) {
+        prazo = absolute_time_min(prazo, timer_prazo(&fechadura.timer_geral));
+    }
+    if (consome & CONSOME_ALARME) {
+        prazo = absolute_time_min(prazo, timer_prazo(&fechadura.timer_alarme_beep));
+    }
+    return prazo;
 }
 
 /**
@@ -533,51 +1148,74 @@ void handle_admin_aguardando_nova_senha() {
  */
 void inicia_hardware() {
     stdio_init_all();       // Inicializa stdio para debug (opcional)
+    perfil_iniciar_nucleo(); // SysTick do Núcleo 0 (só com PERFIL_HABILITADO)
+    cor_init();             // Tabelas de gama e brilho (antes de qualquer cor na matriz ou no LED)
     display_init();         // Display OLED
     rgb_led_init();         // LED RGB
     buzzer_init();          // Buzzer
     servo_init();           // Servo motor
     matriz_init();          // Matriz de LED
     matriz_limpar();        // Limpa a matriz
+    animacoes_init();       // Motor de animações (matriz e LED RGB)
+#if COR_BENCHMARK
+    cor_benchmark();        // Ciclos por quadro do pulso e do fogo, antes e depois das tabelas
+#endif
     keypad_init();          // Teclado
 
-    // Configuração da interface I2C0 para o sensor de cor
-    i2c_init(i2c0, 100 * 1000); // 100kHz
-    gpio_set_function(TCS34725_SDA_PIN, GPIO_FUNC_I2C);
-    gpio_set_function(TCS34725_SCL_PIN, GPIO_FUNC_I2C);
-    gpio_pull_up(TCS34725_SDA_PIN);
-    gpio_pull_up(TCS34725_SCL_PIN);
+    // Configuração da interface I2C0 para o sensor de cor, gerenciada pelo motor de DMA
+    i2c_dma_init(i2c0, TCS34725_SDA_PIN, TCS34725_SCL_PIN, 400 * 1000); // 400kHz (Fast Mode, suportado pelo sensor)
 
     // Inicializa o sensor de cor e trava em caso de falha
     if (!tcs34725_init(i2c0)) {
         display_show_message("ERRO FATAL", "TCS34725 falhou!", NULL);
         rgb_led_set_color(PWM_MAX_DUTY, 0, 0);
-        while (true) { tight_loop_contents(); }
+        while (true) {
+            display_processar(); // A mensagem espera o quadro do display_init() sair pelo I2C
+            tight_loop_contents();
+        }
+    }
+
+    // Recupera a posição do diário de eventos (antes de o Núcleo 1 começar a publicar)
+    diario_iniciar();
+
+    // Tempos e limiares gravados (ou os de fábrica): lidos direto da flash, antes de qualquer uso
+    configuracao_iniciar();
+
+    // Monta o índice de credenciais; uma tabela nova recebe as senhas de fábrica
+#if CREDENCIAIS_BENCHMARK
+    credenciais_benchmark(); // Apaga a tabela ao terminar
+#endif
+    if (credenciais_iniciar()) {
+        for (uint cor = COR_VERDE; cor < COR_QUANTIDADE; cor++) {
+            credenciais_definir(cor, SENHAS_PADRAO[cor]);
+        }
     }
 
     // Zera a estrutura de estado e define o estado inicial
     memset(&fechadura, 0, sizeof(EstadoFechadura));
     fechadura.modo_atual = MODO_ESPERA;
-    fechadura.modo_foi_inicializado = false;
 }
 
 /**
  * @brief Lança a função de gerenciamento de Wi-Fi e MQTT para ser executada no Núcleo 1.
  */
 void inicia_core1() {
+    flash_seguro_nucleo1_lancado(); // Daqui em diante, gravar na flash exige estacionar o Núcleo 1
     multicore_launch_core1(funcao_wifi_nucleo1);
+
+    // Mensagens do Núcleo 1 chegam por interrupção, que também acorda o Núcleo 0 do WFE
+    irq_set_exclusive_handler(SIO_IRQ_PROC0, fifo_irq_handler);
+    irq_set_enabled(SIO_IRQ_PROC0, true);
 }
 
 /**
  * @brief Define uma cor sólida (sem pulso) no LED RGB.
  * @details Para qualquer efeito de pulso ativo antes de definir a nova cor.
- * @param r Valor para o canal vermelho (0-65535).
- * @param g Valor para o canal verde (0-65535).
- * @param b Valor para o canal azul (0-65535).
+ * @param cor Cor 0xRRGGBB (passa pela gama e pelo brilho global do pipeline de cor).
  */
-void set_rgb_solid(uint16_t r, uint16_t g, uint16_t b) {
+void set_rgb_solid(uint32_t cor) {
     led_parar_pulso();
-    rgb_led_set_color(r, g, b);
+    rgb_led_set_rgb(cor);
 }
 
 /**
@@ -594,16 +1232,9 @@ void start_rgb_pulse_and_matrix_center(uint8_t r, uint8_t g, uint8_t b) {
  * @brief Reseta todos os indicadores visuais e flags de animação para um estado limpo.
  */
 void reset_visual_state() {
+    animacoes_parar_todas();
     rgb_led_set_color(0, 0, 0);
     matriz_limpar();
-    led_parar_pulso();
-    fechadura.animacao_erro_ativa = false;
-    fechadura.animacao_timeout_ativa = false;
-    fechadura.animacao_fechando_ativa = false;
-    fechadura.animacao_sucesso_ativa = false;
-    fechadura.animacao_digitacao_ativa = false;
-    fechadura.animacao_circulo_tempo_ativa = false;
-    fechadura.animacao_fogo_ativa = false;
 }
 
 /**
@@ -612,177 +1243,119 @@ void reset_visual_state() {
 int main() {
     inicia_hardware();
 
-    // --- Processo de Conexão Wi-Fi e MQTT ---
-    display_show_message("Rede", "Conectando Wi-Fi...", NULL);
-    rgb_led_set_color(40000, 15000, 0); // LED Laranja
-    inicia_core1(); // Inicia o Núcleo 1 para cuidar da conexão
-
-    // Aguarda a resposta do Núcleo 1 sobre o status da conexão Wi-Fi
-    uint32_t fifo_response;
-    while (!multicore_fifo_rvalid()) { tight_loop_contents(); }
-    fifo_response = multicore_fifo_pop_blocking();
-    if ((fifo_response >> 16) != FIFO_CMD_WIFI_CONECTADO || (fifo_response & 0xFFFF) != WIFI_STATUS_SUCCESS) {
-        display_show_message("ERRO FATAL", "Falha na conexao", "Wi-Fi");
-        rgb_led_set_color(PWM_MAX_DUTY, 0, 0); // LED Vermelho
-        while(true) { tight_loop_contents(); } // Trava o sistema
-    }
-
-    // Wi-Fi conectado com sucesso
-    display_show_message("Rede", "Wi-Fi Conectado!", NULL);
-    rgb_led_set_color(0, PWM_MAX_DUTY, 0); // LED Verde
-    sleep_ms(1500);
-
-    // Inicia a conexão com o broker MQTT (também no Núcleo 1)
-    display_show_message("Rede", "Conectando Broker", "MQTT...");
-    rgb_led_set_color(0, 20000, 40000); // LED Ciano
-
-    // Aguarda a resposta do Núcleo 1 sobre a conexão MQTT
-    while(true) {
-        if (multicore_fifo_rvalid()) {
-            fifo_response = multicore_fifo_pop_blocking();
-            if ((fifo_response >> 16) == FIFO_CMD_MQTT_CONECTADO) {
-                break; // Conectado, sai do loop
-            }
-        }
-        tight_loop_contents();
-    }
-    
-    // Sistema totalmente pronto
-    display_show_message("BitDogLock 2FA", "Sistema Pronto", NULL);
-    buzzer_tocar_melodia_sucesso();
-    sleep_ms(2500);
+    // A rede sobe em segundo plano no Núcleo 1: a fechadura opera desde já, e os eventos
+    // ficam no diário e na coalescência até o broker aceitar a conexão
+    inicia_core1();
     reset_visual_state(); // Limpa os indicadores visuais para o início da operação
+    buzzer_tocar_melodia_sucesso();
+    maquina_iniciar();
+
+    boot_pronto_ms = to_ms_since_boot(get_absolute_time());
+    printf("Boot: pronto em %lu ms\n", (unsigned long)boot_pronto_ms);
 
     // --- Loop Principal de Operação do Sistema (Core 0) ---
     while (true) {
+        enum ModoOperacao modo_da_volta = fechadura.modo_atual;
         verificar_fifo(); // Verifica por comandos vindos do Núcleo 1
+        i2c_dma_processar(); // Prazos das transações I2C em andamento
+        display_processar(); // Páginas do OLED que ficaram para depois
+        matriz_processar(); // Quadro da matriz que aguardava o latch do anterior
 
-        // --- Máquina de Estados Principal ---
-        switch (fechadura.modo_atual) {
-            case MODO_ESPERA: handle_modo_espera(); break;
-            case MODO_AGUARDA_SENHA: handle_modo_aguarda_senha(); break;
-            case MODO_ABERTO: handle_modo_aberto(); break;
-            case MODO_ADMIN_AGUARDANDO_CARTAO: handle_admin_aguardando_cartao(); break;
-            case MODO_ADMIN_AGUARDANDO_NOVA_SENHA: handle_admin_aguardando_nova_senha(); break;
-            
-            // --- Estados de Mensagem Temporária ---
-            // Estes estados apenas exibem uma mensagem por um tempo e depois voltam para MODO_ESPERA
-            case MODO_MSG_TIMEOUT:
-            case MODO_MSG_ACESSO_NEGADO:
-            case MODO_ADMIN_MSG_SUCESSO:
-            case MODO_ADMIN_MSG_ERRO_FORMATO:
-            case MODO_ADMIN_MSG_CANCELADO:
-                if (!fechadura.modo_foi_inicializado) {
-                    fechadura.modo_foi_inicializado = true;
-                    timer_iniciar(&fechadura.timer_geral, TEMPO_MSG_PADRAO_US);
-                }
-                if (timer_expirou(&fechadura.timer_geral)) {
-                    reset_visual_state();
-                    fechadura.modo_atual = MODO_ESPERA;
-                    fechadura.modo_foi_inicializado = false;
-                }
-                break;
-            
-            // --- Estado de Emergência ---
-            case MODO_EMERGENCIA_INCENDIO:
-                if (!fechadura.modo_foi_inicializado) {
-                    display_show_message("EMERGENCIA!", "ALARME DE INCENDIO", "PERIGO!");
-                    solicitar_publicacao_mqtt(MSG_LOG_EMERGENCIA_INCENDIO_ON, COR_NENHUMA);
-                    matriz_iniciar_animacao_fogo(); // Animação de fogo na matriz
-                    fechadura.animacao_fogo_ativa = true;
-                    start_rgb_pulse_and_matrix_center(255, 0, 0); // Pulso vermelho
-                    fechadura.modo_foi_inicializado = true;
-                    timer_iniciar(&fechadura.timer_alarme_beep, 500000); // Inicia timer para o primeiro beep
-                    servo_start_move(150); // Abre a tranca
-                    timer_iniciar(&fechadura.timer_servo, SERVO_MOVE_DURATION_US);
-                }
-                // Toca um beep de alarme periodicamente
-                if (timer_expirou(&fechadura.timer_alarme_beep)) {
-                    buzzer_play_tone(3000, 100);
-                    timer_iniciar(&fechadura.timer_alarme_beep, 1000000); // Próximo beep em 1s
-                }
-                break;
-
-            default: // Caso algum estado inválido ocorra, retorna para o modo de espera
-                fechadura.modo_atual = MODO_ESPERA;
-                fechadura.modo_foi_inicializado = false;
-                break;
+        // Teclas apertadas fora dos modos que leem o teclado não passam para o próximo modo
+        if (!modo_le_teclado(fechadura.modo_atual)) {
+            keypad_descartar();
         }
 
-        // --- ATUALIZAÇÃO CONTÍNUA DAS ANIMAÇÕES VISUAIS ---
-        // As funções de update retornam 'true' quando a animação termina.
-        if (fechadura.animacao_erro_ativa) {
-            if (feedback_visual_erro_update()) fechadura.animacao_erro_ativa = false;
-        }
-        if (fechadura.animacao_timeout_ativa) {
-            if (feedback_visual_timeout_update()) fechadura.animacao_timeout_ativa = false;
-        }
-        if (fechadura.animacao_fechando_ativa) {
-            if (feedback_visual_fechando_update()) fechadura.animacao_fechando_ativa = false;
-        }
-        if (fechadura.animacao_sucesso_ativa) {
-            if (matriz_animacao_sucesso_update()) fechadura.animacao_sucesso_ativa = false;
-        }
-        if (fechadura.animacao_digitacao_ativa) {
-            // A animação só deve ocorrer nos modos corretos
-            if (fechadura.modo_atual == MODO_AGUARDA_SENHA || fechadura.modo_atual == MODO_ADMIN_AGUARDANDO_NOVA_SENHA) {
-                matriz_desenhar_digitos(fechadura.digitos_count);
-            } else {
-                fechadura.animacao_digitacao_ativa = false; // Desativa se estiver no modo errado
-            }
-        }
-        if (fechadura.animacao_circulo_tempo_ativa) {
-            int64_t diff_us = absolute_time_diff_us(fechadura.timer_auto_trava.inicio, get_absolute_time());
-            int tempo_restante = TEMPO_AUTO_TRAVA_S - (diff_us / 1000000);
-            if (tempo_restante < 0) tempo_restante = 0;
-            
-            // CORREÇÃO: Sincroniza o LED RGB com a cor do círculo de tempo.
-            // A cor do LED muda de verde para amarelo e para vermelho conforme o tempo se esgota.
-            if (tempo_restante > 10) {
-                set_rgb_solid(0, PWM_MAX_DUTY, 0); // Verde
-            } else if (tempo_restante > 5) {
-                set_rgb_solid(PWM_MAX_DUTY, 20000, 0); // Amarelo/Laranja
-            } else {
-                set_rgb_solid(PWM_MAX_DUTY, 0, 0); // Vermelho
-            }
-
-            matriz_animacao_circulo_tempo_update(tempo_restante);
-        }
-        if (fechadura.animacao_fogo_ativa) {
-            matriz_atualizar_animacao_fogo();
+        // --- Máquina de Estados Principal ---
+        // O handler do modo atual; as trocas de modo saem dele como eventos (maquina_disparar)
+        const modo_t *modo = &MODOS[fechadura.modo_atual];
+        if (modo->ponto_perfil < PERFIL_QUANTIDADE) {
+            PERFIL_MEDIR(modo->ponto_perfil, modo->executar());
+        } else {
+            modo->executar();
         }
 
-        // --- ATUALIZAÇÃO DO LED RGB PULSANTE ---
-        if (fechadura.efeito_pulso.ativo) {
-            // Calcula o brilho usando uma onda senoidal para um efeito suave de "respiração"
-            float tempo_ms = absolute_time_diff_us(fechadura.efeito_pulso.inicio, get_absolute_time()) / 1000.0f;
-            float brilho = (sinf(tempo_ms * (float)M_PI / 1500.0f) + 1.0f) / 2.0f; // Varia entre 0.0 e 1.0
-            
-            // Aplica o brilho à cor base e converte para o range do PWM (0-65535)
-            uint16_t r = (uint16_t)((float)fechadura.efeito_pulso.r * brilho * (PWM_MAX_DUTY / 255.0f));
-            uint16_t g = (uint16_t)((float)fechadura.efeito_pulso.g * brilho * (PWM_MAX_DUTY / 255.0f));
-            uint16_t b = (uint16_t)((float)fechadura.efeito_pulso.b * brilho * (PWM_MAX_DUTY / 255.0f));
-            rgb_led_set_color(r, g, b);
-            
-            // Sincroniza o ponto central na matriz com o pulso do LED
-            if (fechadura.modo_atual == MODO_ESPERA || fechadura.modo_atual == MODO_ADMIN_AGUARDANDO_CARTAO) {
-                 matriz_desenhar_ponto_central((uint8_t)(fechadura.efeito_pulso.r * brilho), (uint8_t)(fechadura.efeito_pulso.g * brilho), (uint8_t)(fechadura.efeito_pulso.b * brilho));
-            }
-        }
+        // --- ATUALIZAÇÃO DAS ANIMAÇÕES VISUAIS ---
+        // Só desenha quando o alarme do motor marcou um limite de quadro
+        animacoes_processar();
 
         // --- Gerenciamento de Timers Globais ---
         // Envia um "heartbeat" (sinal de vida) para o broker MQTT periodicamente
         if (timer_expirou(&fechadura.timer_heartbeat) || !fechadura.timer_heartbeat.ativo) {
-            solicitar_publicacao_mqtt(MSG_LOG_HEARTBEAT, COR_NENHUMA);
+            if (boot_reportado) {
+                solicitar_publicacao_mqtt(MSG_LOG_HEARTBEAT, COR_NENHUMA);
+            } else {
+                eventos_enviar(MSG_LOG_HEARTBEAT_BOOT, COR_NENHUMA, boot_pronto_ms);
+                boot_reportado = true;
+            }
             timer_iniciar(&fechadura.timer_heartbeat, HEARTBEAT_INTERVAL_US);
+
+            // Relatório de carga do Núcleo 0 no console de depuração
+            energia_metricas_t metricas;
+            energia_obter_metricas(&metricas);
+            printf("Loop: %lu it/s, %lu despertares/s, ocioso %u.%u%%\n",
+                   (unsigned long)metricas.iteracoes_por_segundo, (unsigned long)metricas.despertares,
+                   metricas.ociosidade_permil / 10, metricas.ociosidade_permil % 10);
+            matriz_estatisticas_t quadros;
+            matriz_obter_estatisticas(&quadros);
+            printf("Matriz: %lu quadros enviados, %lu repetidos descartados, %lu adiados\n",
+                   (unsigned long)quadros.quadros_enviados, (unsigned long)quadros.quadros_repetidos,
+                   (unsigned long)quadros.quadros_adiados);
+            animacoes_estatisticas_t animacoes;
+            animacoes_obter_estatisticas(&animacoes);
+            printf("Animacao: %lu quadros, %lu alarmes, custo medio %lu us (max %lu us)\n",
+                   (unsigned long)animacoes.quadros, (unsigned long)animacoes.disparos,
+                   (unsigned long)animacoes.custo_medio_us, (unsigned long)animacoes.custo_maximo_us);
+            eventos_estatisticas_t anel;
+            eventos_obter_estatisticas(&anel);
+            printf("Eventos: ocupacao %lu (max %lu), %lu enviados, %lu descartados\n",
+                   (unsigned long)anel.ocupacao, (unsigned long)anel.ocupacao_maxima,
+                   (unsigned long)anel.enviados, (unsigned long)anel.descartados);
+            diario_estatisticas_t diario;
+            diario_obter_estatisticas(&diario);
+            printf("Diario: %lu registrados, %lu em RAM, %lu nao confirmados, %lu paginas, %lu setores apagados, %lu adiamentos, %lu perdidos\n",
+                   (unsigned long)diario.registrados, (unsigned long)diario.em_ram,
+                   (unsigned long)diario.nao_confirmados, (unsigned long)diario.paginas_gravadas,
+                   (unsigned long)diario.setores_apagados, (unsigned long)diario.adiamentos,
+                   (unsigned long)diario.perdidos);
+            configuracao_estatisticas_t config;
+            configuracao_obter_estatisticas(&config);
+            printf("Config: sequencia %lu, carga %lu us, %lu gravacoes, %lu setores apagados, %lu adiamentos%s\n",
+                   (unsigned long)config.sequencia, (unsigned long)config.carga_us,
+                   (unsigned long)config.gravacoes, (unsigned long)config.setores_apagados,
+                   (unsigned long)config.adiamentos, config.pendente ? ", gravacao pendente" : "");
+            keypad_estatisticas_t teclado;
+            keypad_obter_estatisticas(&teclado);
+            printf("Teclado: %lu eventos, %lu perdidos, %lu descartados fora dos modos de digitacao, ate %u teclas simultaneas\n",
+                   (unsigned long)teclado.eventos, (unsigned long)teclado.descartados,
+                   (unsigned long)teclado.descartados_modo, teclado.simultaneas_max);
+            tcs34725_estatisticas_t sensor;
+            tcs34725_obter_estatisticas(&sensor);
+            printf("Sensor: %s, ganho %ux, integracao %lu us, %lu deteccoes (media %lu us, max %lu us), %lu alarmes falsos, %lu saturacoes, %lu ajustes\n",
+                   sensor.repouso ? "repouso" : "leitura", sensor.ganho, (unsigned long)sensor.integracao_us,
+                   (unsigned long)sensor.deteccoes, (unsigned long)sensor.deteccao_media_us,
+                   (unsigned long)sensor.deteccao_maxima_us, (unsigned long)sensor.alarmes_falsos,
+                   (unsigned long)sensor.saturacoes, (unsigned long)sensor.ajustes);
+            perfil_imprimir(); // Histogramas dos dois núcleos (vazio sem PERFIL_HABILITADO)
         }
 
+        // Grava o diário e a configuração e prepara o banco reserva das credenciais; setores só
+        // são apagados em repouso (a operação para os dois núcleos)
+        bool ocioso = fechadura.modo_atual == MODO_ESPERA &&
+                      !(animacoes_ativas() & ANIMACOES_TRANSITORIAS);
+        diario_processar(ocioso);
+        configuracao_processar(ocioso);
+        credenciais_processar(ocioso);
+
         // Para o servo motor após o tempo de movimento ter passado
         if (timer_expirou(&fechadura.timer_servo)) {
             servo_stop_move();
         }
 
-        tight_loop_contents(); // Cede tempo para outros processos de baixa prioridade
+        // Dorme até o próximo prazo ou até uma interrupção (teclado, FIFO, I2C, alarmes)
+        // Um modo que acabou de entrar executa o handler já na próxima volta
+        energia_registrar_iteracao();
+        energia_dormir_ate(fechadura.modo_atual != modo_da_volta ? get_absolute_time() : calcular_proximo_prazo());
     }
     return 0; // Inalcançável
 }
@@ -790,99 +1363,120 @@ int main() {
 /**
  * @brief Função executada exclusivamente no Núcleo 1.
  * @details Gerencia a conexão Wi-Fi, a conexão com o broker MQTT e o envio de mensagens.
- * Usa uma fila para desacoplar o envio de mensagens da lógica principal do Núcleo 0.
+ * A conexão é uma máquina de estados não-bloqueante (conexao.c), que reconecta sozinha;
+ * os eventos do Núcleo 0 passam pelo estágio de coalescência (publicacoes.c) antes do envio.
  */
 void funcao_wifi_nucleo1() {
-    #define QUEUE_SIZE 10 // Tamanho da fila de mensagens a serem publicadas
-    typedef struct {
-        char topico[100];
-        char mensagem[100];
-    } publication_t;
-    // Fila circular estática para armazenar as publicações
-    static publication_t publication_queue[QUEUE_SIZE];
-    static int queue_head = 0, queue_tail = 0;
-    static TimerNaoBloqueante timer_entre_publicacoes; // Timer para limitar a taxa de envio
-
-    // Inicializa o chip Wi-Fi
-    cyw43_arch_init();
-    cyw43_arch_enable_sta_mode();
-
-    // Tenta conectar ao Wi-Fi e informa o Núcleo 0 do resultado via FIFO
-    if (cyw43_arch_wifi_connect_timeout_ms(WIFI_SSID, WIFI_PASS, CYW43_AUTH_WPA2_AES_PSK, 30000)) {
-        multicore_fifo_push_blocking((FIFO_CMD_WIFI_CONECTADO << 16) | WIFI_STATUS_FAIL);
-    } else {
-        multicore_fifo_push_blocking((FIFO_CMD_WIFI_CONECTADO << 16) | WIFI_STATUS_SUCCESS);
-    }
-
-    iniciar_mqtt_cliente(); // Inicializa o cliente MQTT (que tentará conectar)
+    static TimerNaoBloqueante timer_relatorio_mqtt; // Relatório periódico da fila e da latência dos PUBACKs
+#if PERFIL_HABILITADO
+    static uint8_t perfil_ponto = PERFIL_QUANTIDADE; // Próximo ponto a publicar no tópico de diagnóstico
+#endif
+#if MQTT_BENCHMARK_RAJADA > 0
+    static char rajada_topico[MQTT_TOPICO_TAMANHO];
+    static uint32_t rajada_enviadas = 0;
+    static uint64_t rajada_inicio_us = 0;
+    static bool rajada_concluida = false;
+#endif
+
+    perfil_iniciar_nucleo(); // SysTick do Núcleo 1 (só com PERFIL_HABILITADO)
+    conexao_iniciar();      // Wi-Fi e broker sobem dentro do loop, sem bloquear
+    publicacoes_iniciar();  // Retoma o histórico do primeiro evento não confirmado do diário
+    timer_iniciar(&timer_relatorio_mqtt, HEARTBEAT_INTERVAL_US);
 
     while (true) {
-        // Verifica se o Núcleo 0 enviou uma solicitação de publicação
-        if (multicore_fifo_rvalid()) {
-            uint32_t pacote = multicore_fifo_pop_blocking();
-            uint16_t comando = pacote >> 16;
-            if (comando == FIFO_CMD_PUBLICAR_MQTT) {
-                // Desempacota os dados da mensagem
-                uint16_t valor = pacote & 0xFFFF;
-                uint8_t tipo_msg = valor & 0xFF;
-                uint8_t cor_id = (valor >> 8) & 0xFF;
-                char msg_buffer[100], cor_str[15], base_topic[100];
-                bool mensagem_valida = false;
-
-                // Converte o ID da cor em uma string
-                switch ((enum CorDetectada)cor_id) {
-                    case COR_VERDE:    strcpy(cor_str, "Verde"); break;
-                    case COR_VERMELHA: strcpy(cor_str, "Vermelho"); break;
-                    case COR_AZUL:     strcpy(cor_str, "Azul"); break;
-                    default:           strcpy(cor_str, "N/A"); break;
-                }
+        // Estaciona em RAM se o Núcleo 0 precisar gravar na flash
+        flash_seguro_atender();
+
+        // A FIFO só traz campainhas: os eventos estão no anel compartilhado e no diário.
+        // Consome os eventos de estado do Núcleo 0
+        {
+            PERFIL_ESCOPO(PERFIL_EVENTOS_NUCLEO1);
+            multicore_fifo_drain();
+            evento_t evento;
+            while (eventos_retirar(&evento)) {
+                publicacoes_enfileirar(&evento);
+            }
+        }
 
-                // Monta a mensagem e o tópico com base no tipo de mensagem
-                switch ((enum MQTT_MSG_TYPE)tipo_msg) {
-                    // Mensagens de Status
-                    case MSG_STATUS_AGUARDANDO_CARTAO: strcpy(base_topic, TOPICO_STATUS); strcpy(msg_buffer, "Aguardando cartao"); mensagem_valida = true; break;
-                    case MSG_STATUS_CARTAO_LIDO: strcpy(base_topic, TOPICO_STATUS); sprintf(msg_buffer, "Cartao %s lido", cor_str); mensagem_valida = true; break;
-                    case MSG_STATUS_AGUARDANDO_SENHA: strcpy(base_topic, TOPICO_STATUS); strcpy(msg_buffer, "Aguardando senha"); mensagem_valida = true; break;
-                    case MSG_STATUS_SISTEMA_ABERTO: strcpy(base_topic, TOPICO_STATUS); strcpy(msg_buffer, "Sistema Aberto"); mensagem_valida = true; break;
-                    case MSG_STATUS_SISTEMA_FECHADO: strcpy(base_topic, TOPICO_STATUS); strcpy(msg_buffer, "Sistema Fechado"); mensagem_valida = true; break;
-                    case MSG_STATUS_MODO_ADMIN: strcpy(base_topic, TOPICO_STATUS); strcpy(msg_buffer, "Modo Administracao"); mensagem_valida = true; break;
-                    // Mensagens de Log/Histórico
-                    case MSG_LOG_ACESSO_OK: strcpy(base_topic, TOPICO_HISTORICO); sprintf(msg_buffer, "ACESSO LIBERADO: Cartao %s.", cor_str); mensagem_valida = true; break;
-                    case MSG_LOG_ACESSO_FALHA: strcpy(base_topic, TOPICO_HISTORICO); sprintf(msg_buffer, "FALHA: Senha incorreta para o Cartao %s.", cor_str); mensagem_valida = true; break;
-                    case MSG_LOG_EVENTO_TIMEOUT_SENHA: strcpy(base_topic, TOPICO_HISTORICO); strcpy(msg_buffer, "AVISO: Timeout para digitacao da senha."); mensagem_valida = true; break;
-                    case MSG_LOG_EVENTO_AUTO_LOCK: strcpy(base_topic, TOPICO_HISTORICO); strcpy(msg_buffer, "EVENTO: Travamento automatico do sistema."); mensagem_valida = true; break;
-                    case MSG_LOG_OPERACAO_CANCELADA: strcpy(base_topic, TOPICO_HISTORICO); strcpy(msg_buffer, "AVISO: Operacao cancelada pelo usuario."); mensagem_valida = true; break;
-                    case MSG_LOG_ADMIN_INICIADO: strcpy(base_topic, TOPICO_HISTORICO); strcpy(msg_buffer, "ADMIN: Modo de alteracao de senha iniciado."); mensagem_valida = true; break;
-                    case MSG_LOG_ADMIN_SENHA_ALTERADA: strcpy(base_topic, TOPICO_HISTORICO); sprintf(msg_buffer, "ADMIN: Senha para Cartao %s foi alterada.", cor_str); mensagem_valida = true; break;
-                    case MSG_LOG_EMERGENCIA_INCENDIO_ON: strcpy(base_topic, TOPICO_HISTORICO); strcpy(msg_buffer, "EMERGENCIA: Alarme de incendio ATIVADO."); mensagem_valida = true; break;
-                    case MSG_LOG_EMERGENCIA_INCENDIO_OFF: strcpy(base_topic, TOPICO_HISTORICO); strcpy(msg_buffer, "EMERGENCIA: Alarme de incendio desativado."); mensagem_valida = true; break;
-                    case MSG_LOG_HEARTBEAT: strcpy(base_topic, TOPICO_HEARTBEAT); strcpy(msg_buffer, "ok"); mensagem_valida = true; break;
-                    default: break;
-                }
-                
-                // Adiciona a mensagem à fila se houver espaço
-                if (mensagem_valida) {
-                    int next_tail = (queue_tail + 1) % QUEUE_SIZE;
-                    if (next_tail != queue_head) { // Verifica se a fila não está cheia
-                        snprintf(publication_queue[queue_tail].topico, sizeof(publication_queue[queue_tail].topico), "%s/%s", DEVICE_ID, base_topic);
-                        strncpy(publication_queue[queue_tail].mensagem, msg_buffer, sizeof(publication_queue[queue_tail].mensagem) - 1);
-                        publication_queue[queue_tail].mensagem[sizeof(publication_queue[queue_tail].mensagem) - 1] = '\0';
-                        queue_tail = next_tail;
-                    }
+        // Associação, DHCP, broker e reconexões
+        PERFIL_MEDIR(PERFIL_CONEXAO, conexao_processar());
+
+#if MQTT_BENCHMARK_RAJADA > 0
+        // Rajada de teste: MQTT_BENCHMARK_RAJADA mensagens assim que o broker aceitar a conexão,
+        // enviadas pela mesma janela de publicações, com prioridade sobre os eventos
+        if (!rajada_concluida && mqtt_conectado()) {
+            if (rajada_enviadas == 0) {
+                snprintf(rajada_topico, sizeof(rajada_topico), "%s/benchmark", DEVICE_ID);
+                rajada_inicio_us = time_us_64();
+            }
+            while (rajada_enviadas < MQTT_BENCHMARK_RAJADA && mqtt_pode_publicar()) {
+                char sequencia[12];
+                snprintf(sequencia, sizeof(sequencia), "%lu", (unsigned long)rajada_enviadas);
+                if (!publicar_mensagem_mqtt(rajada_topico, sequencia)) {
+                    break;
                 }
+                rajada_enviadas++;
             }
         }
-        
-        // Verifica se é hora de enviar a próxima mensagem da fila
-        if (!mqtt_is_publishing() && queue_head != queue_tail && (timer_expirou(&timer_entre_publicacoes) || !timer_entre_publicacoes.ativo)) {
-            publication_t *pub = &publication_queue[queue_head];
-            publicar_mensagem_mqtt(pub->topico, pub->mensagem);
-            queue_head = (queue_head + 1) % QUEUE_SIZE; // Avança o ponteiro da cabeça da fila
-            timer_iniciar(&timer_entre_publicacoes, MQTT_PUB_MIN_DELAY_US); // Inicia o timer de intervalo
+#endif
+
+        // Publica os estados e lotes de histórico prontos, dentro da janela MQTT
+        PERFIL_MEDIR(PERFIL_PUBLICACOES, publicacoes_processar());
+
+#if PERFIL_HABILITADO
+        // Perfil dos pontos de medida, uma mensagem por ponto, depois dos eventos da fechadura
+        while (perfil_ponto < PERFIL_QUANTIDADE && mqtt_pode_publicar()) {
+            char payload[192];
+            int tamanho = perfil_formatar_json(perfil_ponto, payload, sizeof(payload));
+            if (tamanho > 0 && !publicar_topico_mqtt(TOPICO_ID_DIAGNOSTICO, payload, (u16_t)tamanho, false, NULL, NULL)) {
+                break;
+            }
+            perfil_ponto++;
+        }
+#endif
+
+        mqtt_estatisticas_t mqtt_stats;
+#if MQTT_BENCHMARK_RAJADA > 0
+        mqtt_obter_estatisticas(&mqtt_stats);
+        if (!rajada_concluida && rajada_enviadas == MQTT_BENCHMARK_RAJADA && mqtt_stats.em_voo == 0) {
+            uint64_t duracao_us = time_us_64() - rajada_inicio_us;
+            printf("Benchmark MQTT: %u mensagens em %lu ms (%lu msg/s), janela %u, PUBACK medio %lu us\n",
+                   (unsigned)MQTT_BENCHMARK_RAJADA, (unsigned long)(duracao_us / 1000),
+                   (unsigned long)(((uint64_t)MQTT_BENCHMARK_RAJADA * 1000000) / (duracao_us ? duracao_us : 1)),
+                   mqtt_stats.janela, (unsigned long)mqtt_stats.latencia_media_us);
+            rajada_concluida = true;
+        }
+#endif
+
+        // Relatório periódico: profundidade da fila, coalescência e latência dos PUBACKs
+        if (timer_expirou(&timer_relatorio_mqtt)) {
+            publicacoes_estatisticas_t fila_stats;
+            publicacoes_obter_estatisticas(&fila_stats);
+            printf("Publicacoes: %lu eventos -> %lu mensagens (%lu estados fundidos, %lu lotes)\n",
+                   (unsigned long)fila_stats.eventos, (unsigned long)fila_stats.publicacoes,
+                   (unsigned long)fila_stats.coalescidos, (unsigned long)fila_stats.lotes);
+            mqtt_obter_estatisticas(&mqtt_stats);
+            printf("MQTT: fila %lu, em voo %u/%u, intervalo %lu us, PUBACK medio %lu us (min %lu, max %lu), %lu publicadas, %lu confirmadas, %lu falhas\n",
+                   (unsigned long)fila_stats.pendentes, mqtt_stats.em_voo, mqtt_stats.janela,
+                   (unsigned long)mqtt_stats.intervalo_us, (unsigned long)mqtt_stats.latencia_media_us,
+                   (unsigned long)mqtt_stats.latencia_minima_us, (unsigned long)mqtt_stats.latencia_maxima_us,
+                   (unsigned long)mqtt_stats.publicadas, (unsigned long)mqtt_stats.confirmadas,
+                   (unsigned long)mqtt_stats.falhas);
+            conexao_estatisticas_t conexao_stats;
+            conexao_obter_estatisticas(&conexao_stats);
+            printf("Conexao: estado %d, %lu conexoes, %lu quedas Wi-Fi, %lu quedas MQTT, ultima em %lu ms, canal %u%s\n",
+                   (int)conexao_stats.estado, (unsigned long)conexao_stats.conexoes,
+                   (unsigned long)conexao_stats.quedas_wifi, (unsigned long)conexao_stats.quedas_mqtt,
+                   (unsigned long)conexao_stats.total_ms, conexao_stats.canal,
+                   conexao_stats.bssid_em_cache ? " (BSSID em cache)" : "");
+#if PERFIL_HABILITADO
+            perfil_ponto = 0;
+#endif
+            timer_iniciar(&timer_relatorio_mqtt, HEARTBEAT_INTERVAL_US);
         }
         
         // Funções de manutenção da pilha de rede e Wi-Fi
-        cyw43_arch_poll();
+        PERFIL_MEDIR(PERFIL_CYW43_POLL, cyw43_arch_poll());
         sleep_ms(1);
     }
 }
\ No newline at end of file
@@ -8,22 +8,28 @@
 
 #include "pico/stdlib.h"
 
+/**
+ * @struct matriz_estatisticas_t
+ * @brief Contadores de quadros da matriz.
+ */
+typedef struct {
+    uint32_t quadros_enviados;   ///< Quadros efetivamente transmitidos aos LEDs.
+    uint32_t quadros_repetidos;  ///< Desenhos descartados por serem iguais ao último quadro enviado.
+    uint32_t quadros_adiados;    ///< Quadros que esperaram o fim da transmissão/latch anterior.
+} matriz_estatisticas_t;
+
 // --- Funções de Inicialização e Controle Básico ---
 void matriz_init();
 void matriz_limpar();
 
-// --- Funções de Desenho de Padrões Estáticos (Não-Bloqueantes) ---
-void matriz_desenhar_x();
-void matriz_desenhar_circulo(uint8_t r, uint8_t g, uint8_t b);
-void matriz_desenhar_exclamacao();
-void matriz_desenhar_ponto_central(uint8_t r, uint8_t g, uint8_t b);
-void matriz_desenhar_digitos(int quantidade);
+// --- Saída por DMA ---
+void matriz_processar(void);               // Envia o quadro pendente quando o latch anterior terminou
+absolute_time_t matriz_proximo_prazo(void); // Quando matriz_processar terá um quadro a enviar
+void matriz_obter_estatisticas(matriz_estatisticas_t *estatisticas);
 
-// --- Funções de Animação Não-Bloqueantes (Baseadas em Estados/Frames) ---
-bool matriz_animacao_sucesso_update(void);
-bool matriz_animacao_circulo_tempo_update(int tempo_restante_s);
-void matriz_iniciar_animacao_fogo(void);
-void matriz_atualizar_animacao_fogo(void);
-void matriz_parar_animacao_fogo(void);
+// --- Quadro Completo (Não-Bloqueante) ---
+// Quadros compostos pelo motor de animações (animacoes.h): 0xRRGGBB, índice 5 * y + x;
+// cada pixel sai com o brilho global e a gama do pipeline de cor (cor.h)
+void matriz_desenhar_quadro(const uint32_t pixels[25]);
 
 #endif // MATRIZ_H
\ No newline at end of file
@@ -1,18 +1,98 @@
 /**
  * @file mqtt_lwip.c
+ * @brief Cliente MQTT sobre lwIP com janela adaptativa de publicacoes QoS1.
  */
 
 #include "mqtt_lwip.h"
 #include "configura_geral.h"
+#include "configuracao.h"   // configuracao_chave
 #include "lwip/apps/mqtt.h"
 #include "pico/multicore.h"
+#include "pico/cyw43_arch.h"
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
+
+#if MQTT_JANELA_PUBLICACOES > MQTT_REQ_MAX_IN_FLIGHT
+#error "MQTT_JANELA_PUBLICACOES excede os slots de requisicao da lwIP (MQTT_REQ_MAX_IN_FLIGHT)"
+#endif
+
+_Static_assert(CONFIG_QUANTIDADE < 0xF, "a chave de FIFO_CMD_CONFIGURAR tem 4 bits (0xF = invalida)");
 
 mqtt_client_t *mqtt_client_data;
 
 static char mqtt_incoming_topic[128];
-static bool publicacao_em_andamento = false;
+
+// Payload da publicacao recebida, remontado dos fragmentos ate MQTT_DATA_FLAG_LAST
+static char mqtt_incoming_payload[128];
+static u16_t mqtt_incoming_tamanho = 0;
+static bool mqtt_incoming_descartar = false;   // Nao cabe no buffer: ignorada inteira
+
+// Topicos de comando assinados a cada conexao; uma assinatura recusada e repetida
+#define TENTATIVAS_ASSINATURA 3
+
+typedef struct {
+    char topico[100];
+    uint8_t tentativas;
+} assinatura_t;
+
+static assinatura_t assinaturas[2];
+
+static volatile mqtt_estado_t estado_conexao = MQTT_ESTADO_DESCONECTADO;
+
+// --- Tabelas de mensagens (flash) ---
+
+/**
+ * @brief Entrada da tabela de mensagens gerada a partir de MQTT_MENSAGENS.
+ */
+typedef struct {
+    uint8_t topico;         ///< enum TopicoPublicacao.
+    const char *formato;    ///< Payload; um "%s" recebe o nome da cor.
+} mensagem_mqtt_t;
+
+static const mensagem_mqtt_t MENSAGENS[MSG_QUANTIDADE] = {
+#define MQTT_MSG_TABELA(identificador, topico, formato) [identificador] = { topico, formato },
+    MQTT_MENSAGENS(MQTT_MSG_TABELA)
+#undef MQTT_MSG_TABELA
+};
+
+static const char *const TOPICOS_BASE[TOPICO_ID_QUANTIDADE] = {
+    [TOPICO_ID_STATUS] = TOPICO_STATUS,
+    [TOPICO_ID_HISTORICO] = TOPICO_HISTORICO,
+    [TOPICO_ID_HEARTBEAT] = TOPICO_HEARTBEAT,
+    [TOPICO_ID_CONEXAO] = TOPICO_CONEXAO,
+    [TOPICO_ID_DIAGNOSTICO] = TOPICO_DIAGNOSTICO,
+};
+
+// Indexada por enum CorDetectada
+static const char *const NOMES_COR[] = { "N/A", "Verde", "Vermelho", "Azul", "Amarelo", "Roxo" };
+
+// Topicos completos (DEVICE_ID/<base>), montados uma vez na conexao
+static char topicos[TOPICO_ID_QUANTIDADE][MQTT_TOPICO_TAMANHO];
+
+// PUBACK com latencia ate 2x a menor observada (mais esta folga) indica caminho livre
+#define FOLGA_LATENCIA_US 5000
+
+/**
+ * @brief Publicacao aguardando PUBACK. O registro e o argumento do callback da lwIP.
+ */
+typedef struct {
+    bool ocupado;
+    uint64_t inicio_us;
+    mqtt_confirmacao_cb_t confirmacao;  // Opcional: avisa o dono da mensagem do resultado
+    void *arg;
+} publicacao_em_voo_t;
+
+// --- Estado da janela ---
+// Alterado pelo Core 1 e pelos callbacks da lwIP, que rodam em interrupcao (modo
+// threadsafe_background): no Core 1, so com a trava da lwIP (cyw43_arch_lwip_begin/end).
+static publicacao_em_voo_t em_voo[MQTT_JANELA_PUBLICACOES];
+static uint8_t quantidade_em_voo = 0;
+static uint8_t janela_efetiva = 1;          // Comeca em 1 e cresce com PUBACKs rapidos
+static uint8_t confirmacoes_rapidas = 0;    // PUBACKs rapidos desde o ultimo ajuste da janela
+static uint32_t intervalo_us = MQTT_INTERVALO_MAXIMO_US;
+static uint64_t ultimo_envio_us = 0;
+static mqtt_estatisticas_t estatisticas = { .latencia_media_us = MQTT_LATENCIA_INICIAL_US };
 
 static void mqtt_incoming_publish_cb(void *arg, const char *topic, u32_t tot_len);
 static void mqtt_incoming_data_cb(void *arg, const u8_t *data, u16_t len, u8_t flags);
@@ -21,41 +101,136 @@ static void mqtt_sub_cb(void *arg, err_t result);
 static void mqtt_pub_request_cb(void *arg, err_t err);
 
 
+// --- Ritmo adaptativo ---
+
+/**
+ * @brief Espacamento entre envios: a latencia media dividida pela janela efetiva,
+ * de modo que a janela se renove aproximadamente a cada PUBACK.
+ */
+static void recalcular_intervalo(void) {
+    uint32_t intervalo = estatisticas.latencia_media_us / janela_efetiva;
+    if (intervalo < MQTT_INTERVALO_MINIMO_US) intervalo = MQTT_INTERVALO_MINIMO_US;
+    if (intervalo > MQTT_INTERVALO_MAXIMO_US) intervalo = MQTT_INTERVALO_MAXIMO_US;
+    intervalo_us = intervalo;
+}
+
+/**
+ * @brief Reduz a janela pela metade (latencia alta, erro ou falta de recursos na pilha).
+ */
+static void reduzir_janela(void) {
+    janela_efetiva = (janela_efetiva > 1) ? janela_efetiva / 2 : 1;
+    confirmacoes_rapidas = 0;
+    recalcular_intervalo();
+}
+
+/**
+ * @brief Contabiliza um PUBACK: atualiza a latencia e ajusta a janela (aumento
+ * aditivo a cada janela de confirmacoes rapidas, reducao multiplicativa caso contrario).
+ */
+static void registrar_confirmacao(uint32_t latencia_us) {
+    estatisticas.confirmadas++;
+    if (estatisticas.confirmadas == 1) {
+        estatisticas.latencia_media_us = latencia_us;
+        estatisticas.latencia_minima_us = latencia_us;
+    } else {
+        // Media movel exponencial com peso 1/8 para a nova amostra
+        int32_t desvio = (int32_t)latencia_us - (int32_t)estatisticas.latencia_media_us;
+        estatisticas.latencia_media_us = (uint32_t)((int32_t)estatisticas.latencia_media_us + desvio / 8);
+        if (latencia_us < estatisticas.latencia_minima_us) estatisticas.latencia_minima_us = latencia_us;
+    }
+    if (latencia_us > estatisticas.latencia_maxima_us) estatisticas.latencia_maxima_us = latencia_us;
+
+    if (latencia_us <= 2 * estatisticas.latencia_minima_us + FOLGA_LATENCIA_US) {
+        if (++confirmacoes_rapidas >= janela_efetiva) {
+            if (janela_efetiva < MQTT_JANELA_PUBLICACOES) janela_efetiva++;
+            confirmacoes_rapidas = 0;
+        }
+        recalcular_intervalo();
+    } else {
+        reduzir_janela();
+    }
+}
+
+/**
+ * @brief Monta os topicos de publicacao uma unica vez, evitando formata-los a cada mensagem.
+ */
+static void internar_topicos(void) {
+    for (uint i = 0; i < TOPICO_ID_QUANTIDADE; i++) {
+        snprintf(topicos[i], sizeof(topicos[i]), "%s/%s", DEVICE_ID, TOPICOS_BASE[i]);
+    }
+}
+
+/**
+ * @brief Libera todos os registros em voo. Na desconexao a lwIP descarta as
+ * requisicoes pendentes sem chamar os callbacks.
+ */
+static void liberar_janela(void) {
+    for (uint i = 0; i < MQTT_JANELA_PUBLICACOES; i++) {
+        if (em_voo[i].ocupado) {
+            em_voo[i].ocupado = false;
+            estatisticas.falhas++;
+            if (em_voo[i].confirmacao) {
+                em_voo[i].confirmacao(em_voo[i].arg, false);
+            }
+        }
+    }
+    quantidade_em_voo = 0;
+    janela_efetiva = 1;
+    confirmacoes_rapidas = 0;
+    recalcular_intervalo();
+}
+
+
 static void mqtt_connection_cb(mqtt_client_t *client_inst, void *arg, mqtt_connection_status_t status) {
     (void)arg;
     if (status == MQTT_CONNECT_ACCEPTED) {
+        estado_conexao = MQTT_ESTADO_CONECTADO;
         // Push com verificação não-bloqueante para evitar congestionamento do Core 1
         if (multicore_fifo_wready()) {
             multicore_fifo_push_blocking(FIFO_CMD_MQTT_CONECTADO << 16);
         }
+        internar_topicos();
         mqtt_set_inpub_callback(client_inst, mqtt_incoming_publish_cb, mqtt_incoming_data_cb, NULL);
-        static char topico_comando[100];
-        snprintf(topico_comando, sizeof(topico_comando), "%s/%s", DEVICE_ID, TOPICO_BASE_COMANDO_ESTADO);
-        mqtt_subscribe(client_inst, topico_comando, 1, mqtt_sub_cb, (void *)topico_comando);
+        snprintf(assinaturas[0].topico, sizeof(assinaturas[0].topico), "%s/%s", DEVICE_ID, TOPICO_BASE_COMANDO_ESTADO);
+        snprintf(assinaturas[1].topico, sizeof(assinaturas[1].topico), "%s/%s", DEVICE_ID, TOPICO_BASE_COMANDO_CONFIG);
+        for (uint i = 0; i < count_of(assinaturas); i++) {
+            assinaturas[i].tentativas = 1;
+            mqtt_subscribe(client_inst, assinaturas[i].topico, 1, mqtt_sub_cb, &assinaturas[i]);
+        }
     } else {
+        // Recusa, queda do TCP ou keep-alive sem resposta: o gerenciador de conexao tenta de novo
+        estado_conexao = MQTT_ESTADO_DESCONECTADO;
+        liberar_janela();
     }
 }
 
 static void mqtt_sub_cb(void *arg, err_t result) {
-    (void)arg;
+    assinatura_t *assinatura = (assinatura_t *)arg;
+    if (result == ERR_OK || estado_conexao != MQTT_ESTADO_CONECTADO) {
+        return; // Assinado, ou a sessao caiu: a proxima conexao assina de novo
+    }
+    if (assinatura->tentativas < TENTATIVAS_ASSINATURA) {
+        assinatura->tentativas++;
+        if (mqtt_subscribe(mqtt_client_data, assinatura->topico, 1, mqtt_sub_cb, assinatura) == ERR_OK) {
+            return;
+        }
+    }
+    // Sem a assinatura os comandos remotos deste topico nao chegam ate a proxima conexao
+    printf("MQTT: assinatura de %s recusada (erro %d)\n", assinatura->topico, (int)result);
 }
 
 static void mqtt_incoming_publish_cb(void *arg, const char *topic, u32_t tot_len) {
     (void)arg;
     strncpy(mqtt_incoming_topic, topic, sizeof(mqtt_incoming_topic) - 1);
     mqtt_incoming_topic[sizeof(mqtt_incoming_topic) - 1] = '\0';
+    mqtt_incoming_tamanho = 0;
+    mqtt_incoming_descartar = tot_len >= sizeof(mqtt_incoming_payload);
 }
 
-static void mqtt_incoming_data_cb(void *arg, const u8_t *data, u16_t len, u8_t flags) {
-    (void)arg;
-    (void)flags;
-    char payload[128];
-    if (len >= sizeof(payload)) {
-        return;
-    }
-    memcpy(payload, data, len);
-    payload[len] = '\0';
-
+/**
+ * @brief Executa um comando recebido (payload completo, terminado em '\0').
+ */
+static void tratar_comando(char *payload) {
     char topic_esperado[100];
     snprintf(topic_esperado, sizeof(topic_esperado), "%s/%s", DEVICE_ID, TOPICO_BASE_COMANDO_ESTADO);
 
@@ -74,42 +249,194 @@ static void mqtt_incoming_data_cb(void *arg, const u8_t *data, u16_t len, u8_t f
                 multicore_fifo_push_blocking(pacote);
             }
         }
+        return;
+    }
+
+    // Ajuste de parametro: "<nome>=<valor>" (ex.: "auto_trava_s=30"). A faixa e conferida
+    // no Core 0, que grava na flash; nome ou valor invalido segue com a chave 0xF e e recusado.
+    snprintf(topic_esperado, sizeof(topic_esperado), "%s/%s", DEVICE_ID, TOPICO_BASE_COMANDO_CONFIG);
+    if (strcmp(mqtt_incoming_topic, topic_esperado) == 0) {
+        char *separador = strchr(payload, '=');
+        int chave = -1;
+        unsigned long valor = 0;
+        if (separador) {
+            *separador = '\0';
+            char *fim;
+            chave = configuracao_chave(payload);
+            valor = strtoul(separador + 1, &fim, 10);
+            if (fim == separador + 1 || *fim != '\0' || valor > 0xFFFF) {
+                chave = -1;
+            }
+        }
+        uint32_t pacote = ((uint32_t)(FIFO_CMD_CONFIGURAR | (chave < 0 ? 0xF : chave)) << 16) | (valor & 0xFFFF);
+        if (multicore_fifo_wready()) {
+            multicore_fifo_push_blocking(pacote);
+        }
     }
 }
 
-static void mqtt_pub_request_cb(void *arg, err_t err) {
+static void mqtt_incoming_data_cb(void *arg, const u8_t *data, u16_t len, u8_t flags) {
     (void)arg;
-    publicacao_em_andamento = false;
+    if (!mqtt_incoming_descartar) {
+        if (len >= sizeof(mqtt_incoming_payload) - mqtt_incoming_tamanho) {
+            mqtt_incoming_descartar = true;
+        } else {
+            memcpy(&mqtt_incoming_payload[mqtt_incoming_tamanho], data, len);
+            mqtt_incoming_tamanho += len;
+        }
+    }
+    if (!(flags & MQTT_DATA_FLAG_LAST)) {
+        return; // Aguarda os demais fragmentos
+    }
+    if (!mqtt_incoming_descartar) {
+        mqtt_incoming_payload[mqtt_incoming_tamanho] = '\0';
+        tratar_comando(mqtt_incoming_payload);
+    }
+    mqtt_incoming_tamanho = 0;
 }
 
-void iniciar_mqtt_cliente() {
-    mqtt_client_data = mqtt_client_new();
+static void mqtt_pub_request_cb(void *arg, err_t err) {
+    publicacao_em_voo_t *publicacao = (publicacao_em_voo_t *)arg;
+    if (!publicacao->ocupado) {
+        return; // Ja liberada por uma desconexao
+    }
+    publicacao->ocupado = false;
+    quantidade_em_voo--;
+
+    if (err == ERR_OK) {
+        registrar_confirmacao((uint32_t)(time_us_64() - publicacao->inicio_us));
+    } else {
+        // ERR_TIMEOUT: sem PUBACK dentro de MQTT_REQ_TIMEOUT
+        estatisticas.falhas++;
+        reduzir_janela();
+    }
+    if (publicacao->confirmacao) {
+        publicacao->confirmacao(publicacao->arg, err == ERR_OK);
+    }
+}
+
+bool iniciar_mqtt_cliente() {
     if (!mqtt_client_data) {
-        return;
+        mqtt_client_data = mqtt_client_new();
+        if (!mqtt_client_data) {
+            return false;
+        }
     }
 
     char client_id[32];
     snprintf(client_id, sizeof(client_id), "%s_client", DEVICE_ID);
-    struct mqtt_connect_client_info_t ci = { .client_id = client_id };
+    struct mqtt_connect_client_info_t ci = { .client_id = client_id, .keep_alive = MQTT_KEEPALIVE_S };
     ip_addr_t broker_ip;
     if (!ip4addr_aton(MQTT_BROKER_IP, &broker_ip)) {
-        return;
+        return false;
     }
 
-    mqtt_client_connect(mqtt_client_data, &broker_ip, MQTT_BROKER_PORT, mqtt_connection_cb, 0, &ci);
+    cyw43_arch_lwip_begin();
+    err_t err = mqtt_client_connect(mqtt_client_data, &broker_ip, MQTT_BROKER_PORT, mqtt_connection_cb, 0, &ci);
+    cyw43_arch_lwip_end();
+    if (err != ERR_OK) {
+        return false;
+    }
+    estado_conexao = MQTT_ESTADO_CONECTANDO;
+    return true;
 }
 
-void publicar_mensagem_mqtt(const char *topico, const char *mensagem) {
-    if (!mqtt_client_data || !mqtt_client_is_connected(mqtt_client_data) || publicacao_em_andamento) {
+void mqtt_desconectar(void) {
+    if (!mqtt_client_data) {
         return;
     }
-    err_t err = mqtt_publish(mqtt_client_data, topico, mensagem, strlen(mensagem), 1, 0, mqtt_pub_request_cb, NULL);
-    if (err == ERR_OK) {
-        publicacao_em_andamento = true;
-    } else {
+    // Desconexao pedida pela aplicacao: a lwIP nao chama o callback de conexao
+    cyw43_arch_lwip_begin();
+    mqtt_disconnect(mqtt_client_data);
+    estado_conexao = MQTT_ESTADO_DESCONECTADO;
+    liberar_janela();
+    cyw43_arch_lwip_end();
+}
+
+mqtt_estado_t mqtt_obter_estado(void) {
+    return estado_conexao;
+}
+
+/**
+ * @brief Envia um payload ja montado ocupando um registro da janela.
+ * O registro e ocupado antes de mqtt_publish(): o PUBACK (callback em interrupcao) pode
+ * chegar antes de a chamada retornar.
+ */
+static bool publicar(const char *topico, const void *payload, u16_t tamanho, bool retido,
+                     mqtt_confirmacao_cb_t confirmacao, void *arg) {
+    if (!mqtt_pode_publicar()) {
+        return false;
+    }
+    cyw43_arch_lwip_begin();
+    publicacao_em_voo_t *publicacao = NULL;
+    for (uint i = 0; i < MQTT_JANELA_PUBLICACOES; i++) {
+        if (!em_voo[i].ocupado) {
+            publicacao = &em_voo[i];
+            break;
+        }
+    }
+    if (!publicacao) {
+        cyw43_arch_lwip_end();
+        return false;
+    }
+
+    publicacao->ocupado = true;
+    publicacao->confirmacao = confirmacao;
+    publicacao->arg = arg;
+    publicacao->inicio_us = time_us_64();
+    quantidade_em_voo++;
+    err_t err = mqtt_publish(mqtt_client_data, topico, payload, tamanho, 1, retido ? 1 : 0, mqtt_pub_request_cb, publicacao);
+    if (err != ERR_OK) {
+        // ERR_MEM: sem slots de requisicao ou buffer de saida cheio; a mensagem sera reenviada
+        publicacao->ocupado = false;
+        quantidade_em_voo--;
+        reduzir_janela();
+        cyw43_arch_lwip_end();
+        return false;
     }
+    ultimo_envio_us = publicacao->inicio_us;
+    estatisticas.publicadas++;
+    cyw43_arch_lwip_end();
+    return true;
+}
+
+bool publicar_mensagem_mqtt(const char *topico, const char *mensagem) {
+    return publicar(topico, mensagem, (u16_t)strlen(mensagem), false, NULL, NULL);
+}
+
+bool publicar_topico_mqtt(uint8_t topico, const char *payload, u16_t tamanho, bool retido,
+                          mqtt_confirmacao_cb_t confirmacao, void *arg) {
+    if (topico >= TOPICO_ID_QUANTIDADE) {
+        return false;
+    }
+    return publicar(topicos[topico], payload, tamanho, retido, confirmacao, arg);
+}
+
+int mqtt_topico_do_evento(uint8_t tipo) {
+    return (tipo < MSG_QUANTIDADE) ? MENSAGENS[tipo].topico : -1;
+}
+
+int mqtt_formatar_evento(uint8_t tipo, uint8_t cor, uint32_t argumento, char *destino, size_t tamanho) {
+    if (tipo >= MSG_QUANTIDADE || tamanho == 0) {
+        return -1;
+    }
+    const char *nome_cor = (cor < count_of(NOMES_COR)) ? NOMES_COR[cor] : NOMES_COR[COR_NENHUMA];
+    int escritos = snprintf(destino, tamanho, MENSAGENS[tipo].formato, nome_cor, (unsigned long)argumento);
+    return (escritos >= 0 && (size_t)escritos < tamanho) ? escritos : -1;
+}
+
+bool mqtt_conectado(void) {
+    return mqtt_client_data && mqtt_client_is_connected(mqtt_client_data);
+}
+
+bool mqtt_pode_publicar(void) {
+    return mqtt_conectado() && quantidade_em_voo < janela_efetiva &&
+           time_us_64() - ultimo_envio_us >= intervalo_us;
 }
 
-bool mqtt_is_publishing(void) {
-    return publicacao_em_andamento;
+void mqtt_obter_estatisticas(mqtt_estatisticas_t *saida) {
+    *saida = estatisticas;
+    saida->em_voo = quantidade_em_voo;
+    saida->janela = janela_efetiva;
+    saida->intervalo_us = intervalo_us;
 }
\ No newline at end of file
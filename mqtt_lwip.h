@@ -1,6 +1,9 @@
 /**
  * @file mqtt_lwip.h
  * @brief Interface publica do cliente MQTT baseado em lwIP.
+ * As publicacoes QoS1 usam uma janela de envios aguardando PUBACK ao mesmo tempo;
+ * o tamanho efetivo da janela e o espacamento entre envios se adaptam a latencia
+ * medida dos PUBACKs, em vez de um atraso fixo entre mensagens.
  */
 
 #ifndef MQTT_LWIP_H
@@ -10,23 +13,117 @@
 #include "lwip/err.h"
 #include "lwip/apps/mqtt.h"
 
+// --- Parametros da janela de publicacoes ---
+#ifndef MQTT_JANELA_PUBLICACOES
+#define MQTT_JANELA_PUBLICACOES 4       // Publicacoes QoS1 em voo ao mesmo tempo (<= MQTT_REQ_MAX_IN_FLIGHT)
+#endif
+#define MQTT_INTERVALO_MINIMO_US 1000   // Menor espacamento entre envios
+#define MQTT_INTERVALO_MAXIMO_US 50000  // Maior espacamento entre envios (antigo atraso fixo)
+#define MQTT_LATENCIA_INICIAL_US 20000  // Estimativa de latencia do PUBACK antes da primeira medida
+
+#define MQTT_KEEPALIVE_S 30             // PINGREQ periodico: um broker que sumiu e detectado em ~1,5x este tempo
+
+#define MQTT_TOPICO_TAMANHO 48          // Topico de publicacao completo (DEVICE_ID/<base>)
+#define MQTT_PAYLOAD_TAMANHO 64         // Maior payload gerado a partir da tabela de mensagens
+
+/**
+ * @brief Estado da sessao com o broker.
+ */
+typedef enum {
+    MQTT_ESTADO_DESCONECTADO,
+    MQTT_ESTADO_CONECTANDO,     ///< Aguardando o CONNACK.
+    MQTT_ESTADO_CONECTADO
+} mqtt_estado_t;
+
+/**
+ * @struct mqtt_estatisticas_t
+ * @brief Estado da janela de publicacoes e latencia dos PUBACKs.
+ */
+typedef struct {
+    uint8_t em_voo;                 ///< Publicacoes aguardando PUBACK.
+    uint8_t janela;                 ///< Janela efetiva atual (1..MQTT_JANELA_PUBLICACOES).
+    uint32_t intervalo_us;          ///< Espacamento atual entre envios.
+    uint32_t latencia_media_us;     ///< Media movel exponencial da latencia do PUBACK.
+    uint32_t latencia_minima_us;
+    uint32_t latencia_maxima_us;
+    uint32_t publicadas;            ///< Aceitas pela pilha lwIP.
+    uint32_t confirmadas;           ///< PUBACK recebido.
+    uint32_t falhas;                ///< Recusadas pela pilha, expiradas ou perdidas na desconexao.
+} mqtt_estatisticas_t;
+
 /**
- * @brief Inicializa o cliente MQTT e inicia a conexao com o broker.
+ * @brief Resultado de uma publicacao: chamado no PUBACK (sucesso), no esgotamento do
+ * prazo ou na desconexao (falha). Executado no Core 1, dentro da pilha lwIP.
+ */
+typedef void (*mqtt_confirmacao_cb_t)(void *arg, bool sucesso);
+
+/**
+ * @brief Inicia a conexao com o broker (o cliente e criado na primeira chamada).
+ * O resultado chega de forma assincrona: acompanhe com mqtt_obter_estado().
+ * A cada conexao aceita os topicos de comando sao assinados novamente.
  * @note Deve ser chamada no Core 1.
+ * @return false se a conexao nem pode ser iniciada (sem memoria, endereco invalido).
+ */
+bool iniciar_mqtt_cliente(void);
+
+/**
+ * @brief Encerra a sessao atual; as publicacoes em voo sao dadas como falhas.
  */
-void iniciar_mqtt_cliente(void);
+void mqtt_desconectar(void);
 
 /**
- * @brief Publica mensagem em um topico MQTT.
+ * @brief Estado da sessao com o broker (atualizado pelos callbacks da lwIP).
+ */
+mqtt_estado_t mqtt_obter_estado(void);
+
+/**
+ * @brief Publica mensagem em um topico MQTT (QoS1).
  * @param topico Topico de destino.
  * @param mensagem Payload a ser enviado.
+ * @return true se a publicacao foi aceita pela pilha; false se deve ser tentada novamente.
+ */
+bool publicar_mensagem_mqtt(const char *topico, const char *mensagem);
+
+/**
+ * @brief Publica um payload em um dos topicos de publicacao (QoS1).
+ * @param topico enum TopicoPublicacao; o topico completo e montado uma unica vez na conexao.
+ * @param retido Publica com a flag retain (o broker guarda o ultimo valor do topico).
+ * @param confirmacao Opcional (NULL): informado do resultado quando a publicacao for aceita.
+ * @return true se a publicacao foi aceita pela pilha; false se deve ser tentada novamente.
+ */
+bool publicar_topico_mqtt(uint8_t topico, const char *payload, u16_t tamanho, bool retido,
+                          mqtt_confirmacao_cb_t confirmacao, void *arg);
+
+/**
+ * @brief Topico (enum TopicoPublicacao) de um tipo de mensagem da tabela MQTT_MENSAGENS.
+ * @return O topico, ou -1 se o tipo for invalido.
+ */
+int mqtt_topico_do_evento(uint8_t tipo);
+
+/**
+ * @brief Formata o payload de um evento a partir da tabela MQTT_MENSAGENS (em flash).
+ * @param tipo enum MQTT_MSG_TYPE.
+ * @param cor enum CorDetectada usada no payload, quando o formato a contem.
+ * @param argumento Dado adicional do evento, quando o formato o contem.
+ * @param destino Buffer de saida (terminado em '\0').
+ * @return Bytes escritos (sem o terminador), ou -1 se o tipo for invalido ou nao couber.
+ */
+int mqtt_formatar_evento(uint8_t tipo, uint8_t cor, uint32_t argumento, char *destino, size_t tamanho);
+
+/**
+ * @brief Informa se o cliente esta conectado ao broker.
+ */
+bool mqtt_conectado(void);
+
+/**
+ * @brief Informa se uma nova publicacao pode ser enviada agora.
+ * @return true quando conectado, com espaco na janela e o espacamento adaptativo cumprido.
  */
-void publicar_mensagem_mqtt(const char *topico, const char *mensagem);
+bool mqtt_pode_publicar(void);
 
 /**
- * @brief Informa se existe publicacao MQTT em andamento.
- * @return true quando a pilha ainda esta publicando; caso contrario, false.
+ * @brief Copia o estado da janela e os contadores de latencia.
  */
-bool mqtt_is_publishing(void);
+void mqtt_obter_estatisticas(mqtt_estatisticas_t *estatisticas);
 
 #endif // MQTT_LWIP_H
\ No newline at end of file
@@ -0,0 +1,130 @@
+/**
+ * @file perfil.c
+ * @brief Implementação dos histogramas de ciclos dos pontos de medida.
+ */
+
+#include "perfil.h"
+
+#if PERFIL_HABILITADO
+
+#include "hardware/clocks.h"
+#include "hardware/regs/m0plus.h"
+#include <stdio.h>
+
+
+// --- Definições ---
+#define SYSTICK_MASCARA 0x00FFFFFFu
+// Acima disto o SysTick pode ter dado uma volta; usa-se o timer de 1us
+#define LIMITE_SYSTICK_US 100000u
+
+typedef struct {
+    uint32_t quantidade;
+    uint32_t maximo;
+    uint64_t soma;
+    uint32_t baldes[PERFIL_BALDES];
+} histograma_t;
+
+
+// --- Variáveis Estáticas ---
+static histograma_t histogramas[PERFIL_QUANTIDADE];
+static uint32_t ciclos_por_us = 125;
+
+#define PERFIL_TABELA(identificador, nucleo, nome) [identificador] = { nome, nucleo },
+static const struct {
+    const char *nome;
+    uint8_t nucleo;
+} PONTOS[PERFIL_QUANTIDADE] = {
+    PERFIL_PONTOS(PERFIL_TABELA)
+};
+#undef PERFIL_TABELA
+
+
+// --- Funções Auxiliares Estáticas ---
+
+/**
+ * @brief Limite superior do balde em que cai a fração 'permil' das medidas.
+ */
+static uint32_t percentil(const histograma_t *histograma, uint32_t permil) {
+    uint64_t alvo = ((uint64_t)histograma->quantidade * permil + 999) / 1000;
+    uint64_t acumulado = 0;
+    for (uint k = 0; k < PERFIL_BALDES; k++) {
+        acumulado += histograma->baldes[k];
+        if (acumulado >= alvo) {
+            uint32_t limite = (k == PERFIL_BALDES - 1) ? UINT32_MAX : (2u << k) - 1;
+            return limite < histograma->maximo ? limite : histograma->maximo;
+        }
+    }
+    return histograma->maximo;
+}
+
+
+// --- Implementação das Funções Públicas ---
+
+void perfil_iniciar_nucleo(void) {
+    ciclos_por_us = clock_get_hz(clk_sys) / 1000000;
+    systick_hw->csr = 0;
+    systick_hw->rvr = SYSTICK_MASCARA;
+    systick_hw->cvr = 0;
+    systick_hw->csr = M0PLUS_SYST_CSR_CLKSOURCE_BITS | M0PLUS_SYST_CSR_ENABLE_BITS; // Clock do processador, sem interrupção
+}
+
+void perfil_registrar(const perfil_marca_t *marca) {
+    uint32_t agora = systick_hw->cvr;
+    uint32_t decorrido_us = time_us_32() - marca->us;
+    // O SysTick conta para baixo
+    uint32_t ciclos = (marca->ciclos - agora) & SYSTICK_MASCARA;
+    if (decorrido_us >= LIMITE_SYSTICK_US) {
+        ciclos = decorrido_us * ciclos_por_us;
+    }
+
+    histograma_t *histograma = &histogramas[marca->ponto];
+    histograma->quantidade++;
+    histograma->soma += ciclos;
+    if (ciclos > histograma->maximo) {
+        histograma->maximo = ciclos;
+    }
+    histograma->baldes[31 - __builtin_clz(ciclos | 1)]++;
+}
+
+void perfil_resumir(uint8_t ponto, perfil_resumo_t *resumo) {
+    const histograma_t *histograma = &histogramas[ponto];
+    resumo->nome = PONTOS[ponto].nome;
+    resumo->nucleo = PONTOS[ponto].nucleo;
+    resumo->quantidade = histograma->quantidade;
+    resumo->maximo = histograma->maximo;
+    resumo->media = histograma->quantidade ? (uint32_t)(histograma->soma / histograma->quantidade) : 0;
+    resumo->p50 = percentil(histograma, 500);
+    resumo->p90 = percentil(histograma, 900);
+    resumo->p99 = percentil(histograma, 990);
+}
+
+void perfil_imprimir(void) {
+    for (uint8_t ponto = 0; ponto < PERFIL_QUANTIDADE; ponto++) {
+        perfil_resumo_t resumo;
+        perfil_resumir(ponto, &resumo);
+        if (resumo.quantidade == 0) {
+            continue;
+        }
+        printf("Perfil: nucleo %u %-18s %8lu medidas, media %7lu ciclos, p50 <=%7lu, p90 <=%7lu, p99 <=%8lu, max %8lu (%lu us)\n",
+               resumo.nucleo, resumo.nome, (unsigned long)resumo.quantidade, (unsigned long)resumo.media,
+               (unsigned long)resumo.p50, (unsigned long)resumo.p90, (unsigned long)resumo.p99,
+               (unsigned long)resumo.maximo, (unsigned long)(resumo.maximo / ciclos_por_us));
+    }
+}
+
+int perfil_formatar_json(uint8_t ponto, char *destino, size_t tamanho) {
+    perfil_resumo_t resumo;
+    perfil_resumir(ponto, &resumo);
+    if (resumo.quantidade == 0) {
+        return -1;
+    }
+    int escrito = snprintf(destino, tamanho,
+                           "{\"ponto\":\"%s\",\"nucleo\":%u,\"n\":%lu,\"media\":%lu,\"p50\":%lu,"
+                           "\"p90\":%lu,\"p99\":%lu,\"max\":%lu,\"ciclos_por_us\":%lu}",
+                           resumo.nome, resumo.nucleo, (unsigned long)resumo.quantidade,
+                           (unsigned long)resumo.media, (unsigned long)resumo.p50, (unsigned long)resumo.p90,
+                           (unsigned long)resumo.p99, (unsigned long)resumo.maximo, (unsigned long)ciclos_por_us);
+    return (escrito < 0 || (size_t)escrito >= tamanho) ? -1 : escrito;
+}
+
+#endif // PERFIL_HABILITADO
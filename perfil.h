@@ -0,0 +1,128 @@
+/**
+ * @file perfil.h
+ * @brief Perfil dos trechos quentes dos dois núcleos: pontos de medida nomeados, com o
+ * tempo em ciclos (SysTick de cada núcleo) acumulado em um histograma logarítmico por ponto.
+ *
+ * Com PERFIL_HABILITADO 0 (padrão, configura_geral.h) as macros e funções abaixo não geram
+ * código nenhum. Com 1, cada ponto custa duas leituras de registrador e uma atualização
+ * do histograma; o relatório sai no serial e no tópico DEVICE_ID/diagnostico.
+ */
+
+#ifndef PERFIL_H
+#define PERFIL_H
+
+#include "pico/stdlib.h"
+#include "configura_geral.h"
+
+// --- Pontos de medida ---
+// X(identificador, núcleo, nome). Cada ponto só pode ser medido pelo núcleo indicado:
+// os histogramas não têm trava, e o SysTick é um contador por núcleo.
+#define PERFIL_PONTOS(X) \
+    X(PERFIL_MODO_ESPERA,           0, "modo_espera") \
+    X(PERFIL_MODO_AGUARDA_SENHA,    0, "modo_aguarda_senha") \
+    X(PERFIL_MODO_ABERTO,           0, "modo_aberto") \
+    X(PERFIL_MODO_ADMIN_CARTAO,     0, "admin_cartao") \
+    X(PERFIL_MODO_ADMIN_SENHA,      0, "admin_nova_senha") \
+    X(PERFIL_MODO_ADMIN_AJUSTE,     0, "admin_ajuste") \
+    X(PERFIL_MODO_ADMIN_CALIBRACAO, 0, "admin_calibracao") \
+    X(PERFIL_RENDER_DISPLAY,        0, "render_display") \
+    X(PERFIL_RENDER_MATRIZ,         0, "render_matriz") \
+    X(PERFIL_LEITURA_SENSOR,        0, "leitura_sensor") \
+    X(PERFIL_PULSO_LED,             0, "pulso_led") \
+    X(PERFIL_QUADRO_ANIMACAO,       0, "quadro_animacao") \
+    X(PERFIL_EVENTOS_NUCLEO1,       1, "eventos_nucleo1") \
+    X(PERFIL_CONEXAO,               1, "conexao") \
+    X(PERFIL_PUBLICACOES,           1, "publicacoes") \
+    X(PERFIL_CYW43_POLL,            1, "cyw43_poll")
+
+#define PERFIL_ENUM(identificador, nucleo, nome) identificador,
+enum PontoPerfil {
+    PERFIL_PONTOS(PERFIL_ENUM)
+    PERFIL_QUANTIDADE
+};
+#undef PERFIL_ENUM
+
+// Baldes do histograma: o balde k conta as durações em [2^k, 2^(k+1)) ciclos
+#define PERFIL_BALDES 32
+
+/**
+ * @struct perfil_resumo_t
+ * @brief Resumo de um ponto de medida desde o boot (durações em ciclos).
+ * Os percentis são o limite superior do balde em que caem (resolução de um fator 2).
+ */
+typedef struct {
+    const char *nome;
+    uint8_t nucleo;
+    uint32_t quantidade;
+    uint32_t media;
+    uint32_t p50;
+    uint32_t p90;
+    uint32_t p99;
+    uint32_t maximo;
+} perfil_resumo_t;
+
+#if PERFIL_HABILITADO
+
+#include "hardware/structs/systick.h"
+
+/**
+ * @brief Início de uma medida: o contador do SysTick do núcleo e o timer (para trechos
+ * mais longos que uma volta do SysTick de 24 bits, ~134ms a 125MHz).
+ */
+typedef struct {
+    uint32_t ciclos;
+    uint32_t us;
+    uint8_t ponto;
+} perfil_marca_t;
+
+static inline perfil_marca_t perfil_marcar(uint8_t ponto) {
+    return (perfil_marca_t){ systick_hw->cvr, time_us_32(), ponto };
+}
+
+/**
+ * @brief Fecha uma medida aberta por perfil_marcar() e a soma ao histograma do ponto.
+ */
+void perfil_registrar(const perfil_marca_t *marca);
+
+/**
+ * @brief Liga o SysTick do núcleo que chama, contando os ciclos do processador.
+ * @note Cada núcleo deve chamar uma vez antes dos seus pontos de medida.
+ */
+void perfil_iniciar_nucleo(void);
+
+/**
+ * @brief Resume um ponto de medida (pode ser chamado de qualquer núcleo; o resumo
+ * de um ponto em uso no outro núcleo pode misturar duas medidas consecutivas).
+ */
+void perfil_resumir(uint8_t ponto, perfil_resumo_t *resumo);
+
+/**
+ * @brief Imprime no serial uma linha por ponto já medido.
+ */
+void perfil_imprimir(void);
+
+/**
+ * @brief Formata o resumo de um ponto como JSON para o tópico de diagnóstico.
+ * @return Tamanho do payload, ou -1 se o ponto não foi medido ou não coube no destino.
+ */
+int perfil_formatar_json(uint8_t ponto, char *destino, size_t tamanho);
+
+/// Mede o restante do bloco em que aparece (inclusive saídas por return).
+#define PERFIL_ESCOPO(ponto) \
+    perfil_marca_t perfil_marca_escopo __attribute__((cleanup(perfil_registrar))) = perfil_marcar(ponto)
+
+/// Mede uma única instrução (tipicamente uma chamada).
+#define PERFIL_MEDIR(ponto, instrucao) \
+    do { PERFIL_ESCOPO(ponto); instrucao; } while (0)
+
+#else
+
+static inline void perfil_iniciar_nucleo(void) {}
+static inline void perfil_imprimir(void) {}
+
+#define PERFIL_ESCOPO(ponto) do {} while (0)
+#define PERFIL_MEDIR(ponto, instrucao) do { instrucao; } while (0)
+
+#endif // PERFIL_HABILITADO
+
+#endif // PERFIL_H
@@ -0,0 +1,264 @@
+/**
+ * @file publicacoes.c
+ * @brief Implementacao do estagio de coalescencia das publicacoes MQTT (Nucleo 1).
+ */
+
+#include "publicacoes.h"
+#include "configura_geral.h"
+#include "mqtt_lwip.h"
+#include "diario.h"
+
+
+// --- Politica por topico ---
+
+typedef enum {
+    CLASSE_ULTIMO_VALOR,    // So o valor mais recente importa
+    CLASSE_LOTE             // Todos os eventos, em ordem, lidos do diario e agrupados por janela
+} classe_topico_t;
+
+typedef struct {
+    uint8_t classe;
+    bool retido;            // Publicado com retain: quem assinar depois recebe o ultimo valor
+} politica_topico_t;
+
+static const politica_topico_t POLITICAS[TOPICO_ID_QUANTIDADE] = {
+    [TOPICO_ID_STATUS]    = { CLASSE_ULTIMO_VALOR, true },
+    [TOPICO_ID_HISTORICO] = { CLASSE_LOTE, false },
+    [TOPICO_ID_HEARTBEAT] = { CLASSE_ULTIMO_VALOR, false },
+    // TOPICO_ID_CONEXAO e publicado diretamente pelo gerenciador de conexao (conexao.c)
+    // e TOPICO_ID_DIAGNOSTICO pelo relatorio do perfil (main.c)
+};
+
+
+// --- Variaveis Estaticas ---
+
+// Ultimo valor pendente de cada topico da classe CLASSE_ULTIMO_VALOR
+typedef struct {
+    bool pendente;
+    uint8_t tipo;
+    uint8_t cor;
+    uint32_t argumento;
+    uint64_t prazo_us;      // Fim da espera MQTT_STATUS_ESPERA_MS, contada do primeiro valor pendente
+} ultimo_valor_t;
+
+static ultimo_valor_t ultimos[TOPICO_ID_QUANTIDADE];
+
+// Lotes de historico publicados, na ordem de envio, aguardando o resultado
+typedef enum {
+    LOTE_EM_VOO,
+    LOTE_CONFIRMADO,
+    LOTE_FALHOU
+} estado_lote_t;
+
+typedef struct {
+    uint32_t inicio;        // Primeira sequencia do lote
+    uint32_t fim;           // Sequencia seguinte a ultima do lote
+    uint16_t quantidade;
+    uint8_t estado;
+} lote_t;
+
+static lote_t lotes[MQTT_JANELA_PUBLICACOES];
+static uint8_t lotes_cabeca = 0, lotes_quantidade = 0;
+static bool reenvio_pendente = false;
+
+static uint32_t proxima_sequencia = 0;      // Proximo evento do diario a publicar
+static uint32_t sequencia_confirmada = 0;   // Todos os eventos anteriores foram confirmados
+static uint64_t pendencia_desde_us = 0;     // Inicio da janela do lote (0 = nada pendente)
+
+static publicacoes_estatisticas_t estatisticas;
+
+
+// --- Funcoes Auxiliares Estaticas ---
+
+/**
+ * @brief Publica o valor pendente de um topico.
+ * @return false se o cliente MQTT recusou (tentar de novo na proxima volta).
+ */
+static bool enviar_ultimo_valor(uint8_t topico) {
+    ultimo_valor_t *ultimo = &ultimos[topico];
+    char payload[MQTT_PAYLOAD_TAMANHO];
+    int tamanho = mqtt_formatar_evento(ultimo->tipo, ultimo->cor, ultimo->argumento, payload, sizeof(payload));
+    if (tamanho >= 0 && !publicar_topico_mqtt(topico, payload, (u16_t)tamanho, POLITICAS[topico].retido, NULL, NULL)) {
+        return false;
+    }
+    ultimo->pendente = false;
+    estatisticas.publicacoes++;
+    return true;
+}
+
+/**
+ * @brief Resultado de um lote, informado pelo cliente MQTT.
+ */
+static void lote_resultado(void *arg, bool sucesso) {
+    lote_t *lote = (lote_t *)arg;
+    lote->estado = sucesso ? LOTE_CONFIRMADO : LOTE_FALHOU;
+    if (!sucesso) {
+        reenvio_pendente = true;
+    }
+}
+
+/**
+ * @brief Avanca a posicao confirmada pelos lotes confirmados em sequencia e a repassa
+ * ao diario. Se algum lote falhou, volta a publicar do primeiro nao confirmado assim
+ * que todos os lotes em voo tiverem resultado (entrega ao menos uma vez).
+ */
+static void avancar_confirmacoes(void) {
+    while (lotes_quantidade > 0 && lotes[lotes_cabeca].estado == LOTE_CONFIRMADO) {
+        sequencia_confirmada = lotes[lotes_cabeca].fim;
+        estatisticas.eventos += lotes[lotes_cabeca].quantidade;
+        lotes_cabeca = (lotes_cabeca + 1) % MQTT_JANELA_PUBLICACOES;
+        lotes_quantidade--;
+    }
+    diario_confirmar(sequencia_confirmada);
+
+    if (reenvio_pendente) {
+        for (uint8_t i = 0; i < lotes_quantidade; i++) {
+            if (lotes[(lotes_cabeca + i) % MQTT_JANELA_PUBLICACOES].estado == LOTE_EM_VOO) {
+                return;
+            }
+        }
+        lotes_quantidade = 0;
+        proxima_sequencia = sequencia_confirmada;
+        reenvio_pendente = false;
+    }
+}
+
+/**
+ * @brief Publica em uma unica mensagem (uma linha por evento) os proximos eventos do
+ * diario que pertencem ao mesmo topico e cabem em PUBLICACOES_LOTE_TAMANHO.
+ * @return false se nada foi enviado (cliente MQTT recusou ou diario indisponivel).
+ */
+static bool enviar_lote(void) {
+    diario_entrada_t entradas[PUBLICACOES_LOTE_EVENTOS * 2];
+    uint lidas = diario_ler(proxima_sequencia, entradas, count_of(entradas));
+    if (lidas == 0) {
+        return false;
+    }
+
+    char payload[PUBLICACOES_LOTE_TAMANHO];
+    size_t tamanho = 0;
+    uint quantidade = 0;
+    int topico = mqtt_topico_do_evento(entradas[0].tipo);
+    while (quantidade < lidas) {
+        const diario_entrada_t *entrada = &entradas[quantidade];
+        if (mqtt_topico_do_evento(entrada->tipo) != topico) {
+            break;
+        }
+        size_t separador = (quantidade > 0) ? 1 : 0;
+        if (tamanho + separador >= sizeof(payload)) {
+            break;
+        }
+        int escritos = mqtt_formatar_evento(entrada->tipo, entrada->cor, 0, payload + tamanho + separador,
+                                            sizeof(payload) - tamanho - separador);
+        if (escritos < 0) {
+            break; // Nao cabe: fica para o proximo lote
+        }
+        if (separador) {
+            payload[tamanho] = '\n';
+        }
+        tamanho += separador + (size_t)escritos;
+        quantidade++;
+    }
+
+    if (quantidade == 0) {
+        // Evento que nao pode ser formatado: descartado
+        proxima_sequencia = entradas[0].sequencia + 1;
+        if (lotes_quantidade == 0) {
+            sequencia_confirmada = proxima_sequencia;
+        }
+        return true;
+    }
+
+    lote_t *lote = &lotes[(lotes_cabeca + lotes_quantidade) % MQTT_JANELA_PUBLICACOES];
+    lote->inicio = entradas[0].sequencia;
+    lote->fim = entradas[quantidade - 1].sequencia + 1;
+    lote->quantidade = (uint16_t)quantidade;
+    lote->estado = LOTE_EM_VOO;
+    if (!publicar_topico_mqtt((uint8_t)topico, payload, (u16_t)tamanho, POLITICAS[topico].retido,
+                              lote_resultado, lote)) {
+        return false;
+    }
+    lotes_quantidade++;
+    proxima_sequencia = lote->fim;
+    estatisticas.lotes++;
+    estatisticas.publicacoes++;
+    return true;
+}
+
+
+// --- Implementacao das Funcoes Publicas ---
+
+void publicacoes_iniciar(void) {
+    proxima_sequencia = diario_primeira_pendente();
+    sequencia_confirmada = proxima_sequencia;
+}
+
+void publicacoes_enfileirar(const evento_t *evento) {
+    int topico = mqtt_topico_do_evento(evento->tipo);
+    if (topico < 0 || POLITICAS[topico].classe != CLASSE_ULTIMO_VALOR) {
+        return; // Tipo desconhecido, ou historico (publicado a partir do diario)
+    }
+
+    ultimo_valor_t *ultimo = &ultimos[topico];
+    if (ultimo->pendente) {
+        estatisticas.coalescidos++;
+        if (ultimo->tipo == MSG_LOG_HEARTBEAT_BOOT) {
+            // O primeiro heartbeat leva o tempo de boot: os seguintes nao o substituem
+            estatisticas.eventos++;
+            return;
+        }
+    } else {
+        ultimo->pendente = true;
+        ultimo->prazo_us = time_us_64() + (uint64_t)MQTT_STATUS_ESPERA_MS * 1000;
+    }
+    ultimo->tipo = evento->tipo;
+    ultimo->cor = evento->cor;
+    ultimo->argumento = evento->argumento;
+    estatisticas.eventos++;
+}
+
+void publicacoes_processar(void) {
+    uint64_t agora = time_us_64();
+    avancar_confirmacoes();
+
+    // Estados primeiro: refletem a situacao atual da fechadura
+    for (uint8_t topico = 0; topico < TOPICO_ID_QUANTIDADE; topico++) {
+        if (ultimos[topico].pendente && agora >= ultimos[topico].prazo_us) {
+            if (!mqtt_pode_publicar() || !enviar_ultimo_valor(topico)) {
+                return;
+            }
+        }
+    }
+
+    // Historico: lotes ao fim da janela ou quando ja ha eventos suficientes no diario.
+    // Depois de um lote, os eventos restantes ja esperaram a janela inteira (reproducao).
+    uint32_t gravada = diario_sequencia_gravada();
+    if (proxima_sequencia >= gravada) {
+        pendencia_desde_us = 0;
+        return;
+    }
+    if (pendencia_desde_us == 0) {
+        pendencia_desde_us = agora;
+    }
+    bool janela_vencida = agora - pendencia_desde_us >= (uint64_t)MQTT_LOTE_JANELA_MS * 1000;
+    while (proxima_sequencia < gravada && !reenvio_pendente && lotes_quantidade < MQTT_JANELA_PUBLICACOES &&
+           (janela_vencida || gravada - proxima_sequencia >= PUBLICACOES_LOTE_EVENTOS)) {
+        if (!mqtt_pode_publicar() || !enviar_lote()) {
+            return;
+        }
+        janela_vencida = true;
+    }
+    if (proxima_sequencia >= gravada) {
+        pendencia_desde_us = 0;
+    }
+}
+
+void publicacoes_obter_estatisticas(publicacoes_estatisticas_t *saida) {
+    *saida = estatisticas;
+    saida->pendentes = diario_sequencia_gravada() - sequencia_confirmada;
+    for (uint8_t topico = 0; topico < TOPICO_ID_QUANTIDADE; topico++) {
+        if (ultimos[topico].pendente) {
+            saida->pendentes++;
+        }
+    }
+}
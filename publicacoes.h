@@ -0,0 +1,55 @@
+/**
+ * @file publicacoes.h
+ * @brief Estagio de coalescencia das publicacoes MQTT no Nucleo 1.
+ * Mensagens de estado (status, heartbeat) valem pelo ultimo valor: enquanto aguardam
+ * o envio, uma nova mensagem do mesmo topico substitui a anterior. Eventos de
+ * historico sao lidos em ordem do diario em flash (diario.h) e agrupados em uma
+ * publicacao por janela; a posicao confirmada pelo broker volta para o diario.
+ */
+
+#ifndef PUBLICACOES_H
+#define PUBLICACOES_H
+
+#include "pico/stdlib.h"
+#include "eventos.h"
+
+// --- Parametros ---
+#define PUBLICACOES_LOTE_TAMANHO 384    // Maior payload de um lote (cabe no buffer de saida da lwIP)
+#define PUBLICACOES_LOTE_EVENTOS 8      // Lote enviado antes do fim da janela ao atingir este numero
+
+/**
+ * @struct publicacoes_estatisticas_t
+ * @brief Contadores do estagio de coalescencia.
+ */
+typedef struct {
+    uint32_t pendentes;     ///< Eventos de historico nao confirmados e estados aguardando envio.
+    uint32_t eventos;       ///< Estados recebidos e eventos de historico confirmados.
+    uint32_t coalescidos;   ///< Estados substituidos antes do envio.
+    uint32_t lotes;         ///< Publicacoes de historico (cada uma com um ou mais eventos).
+    uint32_t publicacoes;   ///< Total de mensagens entregues ao cliente MQTT.
+} publicacoes_estatisticas_t;
+
+/**
+ * @brief Retoma a publicacao do historico a partir do primeiro evento nao confirmado do diario.
+ * @note Chamar no Nucleo 1 antes do seu loop.
+ */
+void publicacoes_iniciar(void);
+
+/**
+ * @brief Recebe um evento de estado do Nucleo 0 (ultimo valor por topico).
+ * Eventos de historico nao passam por aqui: sao lidos do diario.
+ */
+void publicacoes_enfileirar(const evento_t *evento);
+
+/**
+ * @brief Publica os estados e lotes cujo prazo venceu, dentro do que a janela MQTT permitir.
+ * Deve ser chamada a cada volta do loop do Nucleo 1.
+ */
+void publicacoes_processar(void);
+
+/**
+ * @brief Copia os contadores do estagio de coalescencia.
+ */
+void publicacoes_obter_estatisticas(publicacoes_estatisticas_t *estatisticas);
+
+#endif // PUBLICACOES_H
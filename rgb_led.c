@@ -5,6 +5,7 @@
  */
 
 #include "rgb_led.h" // Para o próprio cabeçalho do driver
+#include "cor.h"     // Para as tabelas de gama e brilho
 
 
 // --- Implementação das Funções Públicas ---
@@ -49,4 +50,13 @@ void rgb_led_set_color(uint16_t r, uint16_t g, uint16_t b) {
     pwm_set_gpio_level(LED_R, r);
     pwm_set_gpio_level(LED_G, g);
     pwm_set_gpio_level(LED_B, b);
+}
+
+/**
+ * @brief Define a cor do LED RGB a partir de 0xRRGGBB: cada canal passa pela tabela de
+ * saída do pipeline de cor (brilho global e gama, direto em 16 bits de duty).
+ * @param cor Cor em escala perceptual (0xRRGGBB).
+ */
+void rgb_led_set_rgb(uint32_t cor) {
+    rgb_led_set_color(cor_pwm(cor_vermelho(cor)), cor_pwm(cor_verde(cor)), cor_pwm(cor_azul(cor)));
 }
\ No newline at end of file
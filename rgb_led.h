@@ -26,4 +26,10 @@ void rgb_led_init(void);
  */
 void rgb_led_set_color(uint16_t r, uint16_t g, uint16_t b);
 
+/**
+ * @brief Define a cor do LED RGB a partir de uma cor 0xRRGGBB (escala perceptual),
+ * aplicando o brilho global e a gama do pipeline de cor (cor.h).
+ */
+void rgb_led_set_rgb(uint32_t cor);
+
 #endif // RGB_LED_H
\ No newline at end of file
@@ -0,0 +1,234 @@
+/**
+ * @file benchmark-classificador.c
+ * @brief Benchmark, no host, do classificador de cartões sobre tracos gravados do sensor.
+ *
+ * A primeira aproximação de cada cartão no arquivo calibra o seu centróide; as demais são
+ * classificadas como no firmware (votação até a decisão) e comparadas com o rótulo.
+ * Para referência, as mesmas aproximações passam também pela classificação anterior
+ * (razões em ponto flutuante, aceitando a primeira leitura que casa com um cartão). Mede acertos, cartões trocados
+ * (o erro caro: custa uma senha recusada) e ciclos/tempo por decisão.
+ *
+ * Uso (na raiz do projeto):
+ *   cc -O2 -I. scripts/benchmark-classificador.c classificador.c -o benchmark-classificador
+ *   ./benchmark-classificador scripts/tracos-classificador.csv
+ */
+
+#include "classificador.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CICLOS() __rdtsc()
+#endif
+
+#define MAXIMO_APROXIMACOES 1024
+#define MAXIMO_LEITURAS 16
+#define REPETICOES_TEMPO 2000
+#define LIMIAR_CLEAR 70     // TCS34725_LIMIAR_PRESENCA
+#define RAIO 120            // Padrão de raio_cartao (configuracao.h)
+
+static const char *const NOMES[] = { "nenhum", "verde", "vermelho", "azul", "amarelo", "roxo" };
+#define QUANTIDADE_NOMES (sizeof(NOMES) / sizeof(NOMES[0]))
+
+typedef struct {
+    uint16_t clear, red, green, blue;
+} leitura_t;
+
+typedef struct {
+    uint8_t cartao;
+    uint8_t quantidade;
+    leitura_t leituras[MAXIMO_LEITURAS];
+} aproximacao_t;
+
+static aproximacao_t aproximacoes[MAXIMO_APROXIMACOES];
+static size_t total_aproximacoes = 0;
+
+
+static int cartao_pelo_nome(const char *nome) {
+    for (size_t i = 0; i < QUANTIDADE_NOMES; i++) {
+        if (strcmp(nome, NOMES[i]) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+static bool ler_tracos(const char *caminho) {
+    FILE *arquivo = fopen(caminho, "r");
+    if (!arquivo) {
+        perror(caminho);
+        return false;
+    }
+    char linha[128];
+    aproximacao_t *atual = NULL;
+    while (fgets(linha, sizeof(linha), arquivo)) {
+        if (linha[0] == '#') {
+            continue;
+        }
+        char nome[16];
+        unsigned clear, red, green, blue;
+        if (sscanf(linha, "%15[^,],%u,%u,%u,%u", nome, &clear, &red, &green, &blue) != 5) {
+            atual = NULL; // Linha vazia: fim da aproximação
+            continue;
+        }
+        int cartao = cartao_pelo_nome(nome);
+        if (cartao < 0) {
+            fprintf(stderr, "cartao desconhecido: %s\n", nome);
+            continue;
+        }
+        if (!atual || atual->cartao != cartao || atual->quantidade == MAXIMO_LEITURAS) {
+            if (total_aproximacoes == MAXIMO_APROXIMACOES) {
+                break;
+            }
+            atual = &aproximacoes[total_aproximacoes++];
+            atual->cartao = (uint8_t)cartao;
+            atual->quantidade = 0;
+        }
+        atual->leituras[atual->quantidade++] = (leitura_t){ clear, red, green, blue };
+    }
+    fclose(arquivo);
+    return true;
+}
+
+/**
+ * @brief Classificação anterior: razões fixas sobre uma única leitura, em double.
+ */
+static uint8_t classificar_legado(const leitura_t *l) {
+    if (l->clear < LIMIAR_CLEAR) return 0;
+    if ((l->green > l->red * 1.8) && (l->green > l->blue * 1.8)) return 1;
+    if ((l->red > l->green * 2.0) && (l->red > l->blue * 2.0)) return 2;
+    if ((l->blue > l->green * 1.5) && (l->blue > l->red * 2.0)) return 3;
+    return 0;
+}
+
+/**
+ * @brief Classifica uma aproximação como o firmware: leituras até a decisão.
+ * Sem decisão até a última leitura conta como nenhum cartão.
+ */
+static classificador_resultado_t classificar(const classificador_tabela_t *tabela, const aproximacao_t *aproximacao) {
+    classificador_janela_t janela;
+    classificador_resultado_t resultado = { 0, 0, aproximacao->quantidade };
+    classificador_reiniciar(&janela);
+    for (uint8_t i = 0; i < aproximacao->quantidade; i++) {
+        const leitura_t *l = &aproximacao->leituras[i];
+        if (classificador_adicionar(tabela, &janela, l->clear, l->red, l->green, l->blue, &resultado)) {
+            break;
+        }
+    }
+    return resultado;
+}
+
+static uint64_t agora_ns(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000u + (uint64_t)t.tv_nsec;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2 || !ler_tracos(argv[1])) {
+        fprintf(stderr, "uso: %s <tracos.csv>\n", argv[0]);
+        return 1;
+    }
+
+    // Calibração: primeira aproximação de cada cartão
+    centroide_t centroides[CLASSIFICADOR_MAXIMO_CARTOES];
+    bool calibrado[QUANTIDADE_NOMES] = { false };
+    bool avaliar[MAXIMO_APROXIMACOES];
+    uint8_t quantidade = 0;
+    for (size_t i = 0; i < total_aproximacoes; i++) {
+        const aproximacao_t *a = &aproximacoes[i];
+        avaliar[i] = a->cartao == 0 || calibrado[a->cartao];
+        if (avaliar[i] || quantidade == CLASSIFICADOR_MAXIMO_CARTOES) {
+            continue;
+        }
+        classificador_calibracao_t calibracao;
+        classificador_calibracao_iniciar(&calibracao);
+        for (uint8_t j = 0; j < a->quantidade; j++) {
+            // Como no firmware, a calibração só usa leituras com o cartão presente
+            if (a->leituras[j].clear >= LIMIAR_CLEAR) {
+                classificador_calibracao_adicionar(&calibracao, a->leituras[j].red, a->leituras[j].green, a->leituras[j].blue);
+            }
+        }
+        centroide_t *c = &centroides[quantidade];
+        if (classificador_calibracao_resultado(&calibracao, &c->centro)) {
+            c->cartao = a->cartao;
+            calibrado[a->cartao] = true;
+            quantidade++;
+            printf("Calibrado %-8s r=%4u g=%4u b=%4u (%u leituras)\n", NOMES[a->cartao],
+                   c->centro.r, c->centro.g, c->centro.b, calibracao.amostras);
+        }
+    }
+    classificador_tabela_t tabela = { centroides, quantidade, RAIO, LIMIAR_CLEAR };
+
+    // Acurácia
+    unsigned avaliadas = 0, acertos = 0, trocados = 0, recusados = 0, leituras = 0;
+    unsigned legado_acertos = 0, legado_trocados = 0, legado_comparaveis = 0;
+    unsigned confianca_soma = 0;
+    for (size_t i = 0; i < total_aproximacoes; i++) {
+        if (!avaliar[i]) {
+            continue;
+        }
+        const aproximacao_t *a = &aproximacoes[i];
+        classificador_resultado_t r = classificar(&tabela, a);
+        avaliadas++;
+        leituras += r.amostras;
+        if (r.cartao == a->cartao) {
+            acertos++;
+            confianca_soma += r.confianca;
+        } else if (r.cartao != 0) {
+            trocados++;
+        } else {
+            recusados++;
+        }
+
+        // O legado só conhece verde, vermelho e azul e aceita a primeira leitura que casa com algum
+        if (a->cartao <= 3) {
+            uint8_t legado = 0;
+            for (uint8_t j = 0; j < a->quantidade && legado == 0; j++) {
+                legado = classificar_legado(&a->leituras[j]);
+            }
+            legado_comparaveis++;
+            legado_acertos += (legado == a->cartao);
+            legado_trocados += (legado != a->cartao && legado != 0);
+        }
+    }
+    if (avaliadas == 0) {
+        fprintf(stderr, "nenhuma aproximacao para avaliar\n");
+        return 1;
+    }
+
+    // Custo: todas as aproximações avaliadas, REPETICOES_TEMPO vezes
+    volatile uint8_t sumidouro = 0;
+    uint64_t inicio_ns = agora_ns();
+#ifdef CICLOS
+    uint64_t inicio_ciclos = CICLOS();
+#endif
+    for (int repeticao = 0; repeticao < REPETICOES_TEMPO; repeticao++) {
+        for (size_t i = 0; i < total_aproximacoes; i++) {
+            if (avaliar[i]) {
+                sumidouro ^= classificar(&tabela, &aproximacoes[i]).cartao;
+            }
+        }
+    }
+#ifdef CICLOS
+    double ciclos = (double)(CICLOS() - inicio_ciclos) / ((double)REPETICOES_TEMPO * avaliadas);
+#endif
+    double ns = (double)(agora_ns() - inicio_ns) / ((double)REPETICOES_TEMPO * avaliadas);
+
+    printf("\nAproximacoes avaliadas: %u (%u cartoes calibrados)\n", avaliadas, quantidade);
+    printf("Classificador: %.1f%% acertos, %u cartoes trocados, %u recusados, confianca media %.0f%%\n",
+           100.0 * acertos / avaliadas, trocados, recusados, acertos ? (double)confianca_soma / acertos : 0.0);
+    printf("Leituras por decisao: %.2f (janela de %d)\n", (double)leituras / avaliadas, CLASSIFICADOR_JANELA);
+#ifdef CICLOS
+    printf("Custo por decisao no host: %.0f ciclos, %.0f ns\n", ciclos, ns);
+#else
+    printf("Custo por decisao no host: %.0f ns\n", ns);
+#endif
+    if (legado_comparaveis) {
+        printf("Legado (razoes em double, primeira leitura aceita, so verde/vermelho/azul): %.1f%% acertos, %u trocados em %u\n",
+               100.0 * legado_acertos / legado_comparaveis, legado_trocados, legado_comparaveis);
+    }
+    return 0;
+}
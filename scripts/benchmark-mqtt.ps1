@@ -0,0 +1,77 @@
+param(
+    [int]$BrokerPort = 1884,
+    [string]$DeviceId = "bitdoglab_02",
+    [int]$Quantidade = 200,
+    [int]$TimeoutSegundos = 120
+)
+
+# Mede, no host, a vazao da rajada de teste do firmware (MQTT_BENCHMARK_RAJADA).
+# Uso: iniciar o broker com mosquitto.local.conf, executar este script e, em seguida,
+# reiniciar a placa compilada com MQTT_BENCHMARK_RAJADA igual a -Quantidade.
+# Para comparar com o envio de uma mensagem por vez, recompilar com MQTT_JANELA_PUBLICACOES 1.
+
+$ErrorActionPreference = "Stop"
+
+function Resolve-ToolPath {
+    param(
+        [string[]]$Candidates,
+        [string]$CommandName
+    )
+
+    foreach ($candidate in $Candidates) {
+        if ($candidate -and (Test-Path $candidate)) {
+            return $candidate
+        }
+    }
+
+    if ($CommandName) {
+        $cmd = Get-Command $CommandName -ErrorAction SilentlyContinue
+        if ($cmd) {
+            return $cmd.Source
+        }
+    }
+
+    return $null
+}
+
+$subExe = Resolve-ToolPath -Candidates @("C:\Program Files\Mosquitto\mosquitto_sub.exe") -CommandName "mosquitto_sub"
+if (-not $subExe) {
+    Write-Error "mosquitto_sub nao encontrado"
+    exit 1
+}
+
+$topic = "$DeviceId/benchmark"
+"Aguardando $Quantidade mensagens em $topic (127.0.0.1:$BrokerPort). Reinicie a placa agora."
+
+$cronometro = New-Object System.Diagnostics.Stopwatch
+$recebidas = 0
+& $subExe -h 127.0.0.1 -p $BrokerPort -t $topic -q 1 -C $Quantidade -W $TimeoutSegundos | ForEach-Object {
+    # O tempo conta a partir da primeira mensagem, descontando a conexao da placa
+    if (-not $cronometro.IsRunning) {
+        $cronometro.Start()
+    }
+    $recebidas++
+}
+$cronometro.Stop()
+
+if ($recebidas -lt 2) {
+    "Mensagens insuficientes para medir: $recebidas recebida(s)"
+    exit 1
+}
+
+$segundos = $cronometro.Elapsed.TotalSeconds
+$taxa = if ($segundos -gt 0) { ($recebidas - 1) / $segundos } else { 0 }
+
+""
+"Benchmark MQTT"
+[pscustomobject]@{
+    Recebidas = $recebidas
+    Duracao_ms = [math]::Round($cronometro.Elapsed.TotalMilliseconds)
+    Mensagens_por_segundo = [math]::Round($taxa, 1)
+} | Format-Table -AutoSize
+
+if ($recebidas -lt $Quantidade) {
+    exit 1
+}
+
+exit 0
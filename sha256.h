@@ -0,0 +1,29 @@
+/**
+ * @file sha256.h
+ * @brief SHA-256 em software (FIPS 180-4). O RP2040 não tem acelerador de hash.
+ */
+
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define SHA256_TAMANHO 32   // Bytes do resumo
+
+/**
+ * @struct sha256_contexto_t
+ * @brief Estado de um cálculo incremental.
+ */
+typedef struct {
+    uint32_t estado[8];
+    uint64_t total_bytes;
+    uint8_t bloco[64];
+    size_t usados;          ///< Bytes já acumulados em bloco.
+} sha256_contexto_t;
+
+void sha256_iniciar(sha256_contexto_t *contexto);
+void sha256_adicionar(sha256_contexto_t *contexto, const void *dados, size_t tamanho);
+void sha256_finalizar(sha256_contexto_t *contexto, uint8_t resumo[SHA256_TAMANHO]);
+
+#endif // SHA256_H
@@ -0,0 +1,17 @@
+/**
+ * @file clocks.h
+ * @brief Relógio do sistema fixo em 125MHz.
+ */
+
+#ifndef SIM_HARDWARE_CLOCKS_H
+#define SIM_HARDWARE_CLOCKS_H
+
+#include "pico.h"
+
+enum clock_index {
+    clk_sys = 5,
+};
+
+uint32_t clock_get_hz(enum clock_index relogio);
+
+#endif // SIM_HARDWARE_CLOCKS_H
@@ -0,0 +1,53 @@
+/**
+ * @file dma.h
+ * @brief Canais de DMA do simulador. Os dados não são copiados (os destinos usados pelo
+ * firmware são registradores de periféricos); o canal fica ocupado pelo tempo que o
+ * DREQ levaria para consumir a transferência.
+ */
+
+#ifndef SIM_HARDWARE_DMA_H
+#define SIM_HARDWARE_DMA_H
+
+#include "pico.h"
+
+#define NUM_DMA_CHANNELS 12
+#define NUM_DMA_TIMERS 4
+
+// DREQs do RP2040 usados pelo firmware
+#define DREQ_PIO0_TX0 0
+#define DREQ_PIO1_TX0 8
+#define DREQ_DMA_TIMER0 59
+#define DREQ_FORCE 63
+
+enum dma_channel_transfer_size {
+    DMA_SIZE_8 = 0,
+    DMA_SIZE_16 = 1,
+    DMA_SIZE_32 = 2,
+};
+
+typedef struct {
+    uint32_t ctrl;
+    uint dreq;
+} dma_channel_config;
+
+int dma_claim_unused_channel(bool required);
+dma_channel_config dma_channel_get_default_config(uint canal);
+void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size tamanho);
+void channel_config_set_read_increment(dma_channel_config *c, bool incrementa);
+void channel_config_set_write_increment(dma_channel_config *c, bool incrementa);
+void channel_config_set_dreq(dma_channel_config *c, uint dreq);
+void dma_channel_configure(uint canal, const dma_channel_config *c, volatile void *destino,
+                           const volatile void *origem, uint quantidade, bool iniciar);
+void dma_channel_transfer_from_buffer_now(uint canal, const volatile void *origem, uint32_t quantidade);
+bool dma_channel_is_busy(uint canal);
+void dma_channel_abort(uint canal);
+void dma_channel_wait_for_finish_blocking(uint canal);
+
+int dma_claim_unused_timer(bool required);
+void dma_timer_set_fraction(uint temporizador, uint16_t numerador, uint16_t denominador);
+
+static inline uint dma_get_timer_dreq(uint temporizador) {
+    return DREQ_DMA_TIMER0 + temporizador;
+}
+
+#endif // SIM_HARDWARE_DMA_H
@@ -0,0 +1,18 @@
+/**
+ * @file flash.h
+ * @brief Flash simulada, mapeada em XIP_BASE. Apagar e gravar ocupam o núcleo pelo
+ * tempo típico do chip (setor ~45ms, página ~0,4ms).
+ */
+
+#ifndef SIM_HARDWARE_FLASH_H
+#define SIM_HARDWARE_FLASH_H
+
+#include "pico.h"
+
+#define FLASH_PAGE_SIZE (1u << 8)
+#define FLASH_SECTOR_SIZE (1u << 12)
+
+void flash_range_erase(uint32_t offset, size_t tamanho);
+void flash_range_program(uint32_t offset, const uint8_t *dados, size_t tamanho);
+
+#endif // SIM_HARDWARE_FLASH_H
@@ -0,0 +1,32 @@
+/**
+ * @file gpio.h
+ * @brief GPIOs do simulador: guardam função, direção e nível, sem efeito externo.
+ */
+
+#ifndef SIM_HARDWARE_GPIO_H
+#define SIM_HARDWARE_GPIO_H
+
+#include "pico.h"
+
+#define GPIO_OUT 1
+#define GPIO_IN 0
+
+enum gpio_function {
+    GPIO_FUNC_SPI = 1,
+    GPIO_FUNC_UART = 2,
+    GPIO_FUNC_I2C = 3,
+    GPIO_FUNC_PWM = 4,
+    GPIO_FUNC_SIO = 5,
+    GPIO_FUNC_PIO0 = 6,
+    GPIO_FUNC_PIO1 = 7,
+    GPIO_FUNC_NULL = 0x1f,
+};
+
+void gpio_init(uint gpio);
+void gpio_set_dir(uint gpio, bool saida);
+void gpio_put(uint gpio, bool valor);
+bool gpio_get(uint gpio);
+void gpio_pull_up(uint gpio);
+void gpio_set_function(uint gpio, enum gpio_function funcao);
+
+#endif // SIM_HARDWARE_GPIO_H
@@ -0,0 +1,25 @@
+/**
+ * @file i2c.h
+ * @brief Instâncias I2C do simulador. As transações passam pelo modelo do motor
+ * i2c_dma (sim_i2c.c), que substitui o acesso aos registradores.
+ */
+
+#ifndef SIM_HARDWARE_I2C_H
+#define SIM_HARDWARE_I2C_H
+
+#include "pico.h"
+
+typedef struct i2c_inst {
+    uint indice;
+} i2c_inst_t;
+
+extern i2c_inst_t i2c0_inst, i2c1_inst;
+
+#define i2c0 (&i2c0_inst)
+#define i2c1 (&i2c1_inst)
+
+static inline uint i2c_hw_index(i2c_inst_t *i2c) {
+    return i2c->indice;
+}
+
+#endif // SIM_HARDWARE_I2C_H
@@ -0,0 +1,28 @@
+/**
+ * @file irq.h
+ * @brief Tratadores de interrupção, executados pelo escalonador no contexto do Núcleo 0.
+ */
+
+#ifndef SIM_HARDWARE_IRQ_H
+#define SIM_HARDWARE_IRQ_H
+
+#include "pico.h"
+
+// Mesma numeração do RP2040
+#define TIMER_IRQ_0 0
+#define PIO0_IRQ_0 7
+#define PIO1_IRQ_0 9
+#define DMA_IRQ_0 11
+#define DMA_IRQ_1 12
+#define SIO_IRQ_PROC0 15
+#define SIO_IRQ_PROC1 16
+#define I2C0_IRQ 23
+#define I2C1_IRQ 24
+#define NUM_IRQS 32
+
+typedef void (*irq_handler_t)(void);
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler);
+void irq_set_enabled(uint num, bool enabled);
+
+#endif // SIM_HARDWARE_IRQ_H
@@ -0,0 +1,111 @@
+/**
+ * @file pio.h
+ * @brief Blocos PIO do simulador. Os programas não são interpretados: cada .pio.h do
+ * simulador liga a sua máquina de estados a um modelo em C (ex.: varredura do teclado).
+ * A FIFO RX tem 8 posições (unida) e a sua interrupção segue pio_set_irq0_source_enabled.
+ */
+
+#ifndef SIM_HARDWARE_PIO_H
+#define SIM_HARDWARE_PIO_H
+
+#include "pico.h"
+#include "hardware/gpio.h"
+#include "hardware/dma.h"
+
+typedef struct {
+    volatile uint32_t txf[4];
+    uint indice;
+} pio_hw_t;
+
+typedef pio_hw_t *PIO;
+
+extern pio_hw_t pio0_hw_s, pio1_hw_s;
+
+#define pio0 (&pio0_hw_s)
+#define pio1 (&pio1_hw_s)
+
+typedef struct pio_program {
+    const uint16_t *instructions;
+    uint8_t length;
+    int8_t origin;
+} pio_program_t;
+
+typedef struct {
+    float clkdiv;
+} pio_sm_config;
+
+enum pio_fifo_join {
+    PIO_FIFO_JOIN_NONE = 0,
+    PIO_FIFO_JOIN_TX = 1,
+    PIO_FIFO_JOIN_RX = 2,
+};
+
+enum pio_interrupt_source {
+    pis_sm0_rx_fifo_not_empty = 0,
+    pis_sm1_rx_fifo_not_empty,
+    pis_sm2_rx_fifo_not_empty,
+    pis_sm3_rx_fifo_not_empty,
+};
+
+static inline uint pio_get_index(PIO pio) {
+    return pio->indice;
+}
+
+static inline uint pio_get_irq_num(PIO pio, uint linha) {
+    return 7u + 2u * pio->indice + linha; // PIO0_IRQ_0 / PIO1_IRQ_0
+}
+
+static inline enum pio_interrupt_source pio_get_rx_fifo_not_empty_interrupt_source(uint sm) {
+    return (enum pio_interrupt_source)sm;
+}
+
+static inline uint pio_get_dreq(PIO pio, uint sm, bool tx) {
+    return pio->indice * 8u + (tx ? 0u : 4u) + sm;
+}
+
+uint pio_add_program(PIO pio, const pio_program_t *programa);
+int pio_claim_unused_sm(PIO pio, bool required);
+void pio_gpio_init(PIO pio, uint gpio);
+void pio_sm_init(PIO pio, uint sm, uint offset, const pio_sm_config *config);
+void pio_sm_set_enabled(PIO pio, uint sm, bool habilitada);
+void pio_sm_set_consecutive_pindirs(PIO pio, uint sm, uint base, uint quantidade, bool saida);
+void pio_sm_put(PIO pio, uint sm, uint32_t dado);
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t dado);
+uint32_t pio_sm_get(PIO pio, uint sm);
+bool pio_sm_is_rx_fifo_empty(PIO pio, uint sm);
+void pio_set_irq0_source_enabled(PIO pio, enum pio_interrupt_source fonte, bool habilitada);
+
+static inline pio_sm_config pio_get_default_sm_config(void) {
+    return (pio_sm_config){1.0f};
+}
+
+static inline void sm_config_set_clkdiv(pio_sm_config *c, float divisor) {
+    c->clkdiv = divisor;
+}
+
+// Mapeamento de pinos e deslocamentos não têm efeito sobre os modelos
+static inline void sm_config_set_sideset_pins(pio_sm_config *c, uint base) { (void)c; (void)base; }
+static inline void sm_config_set_set_pins(pio_sm_config *c, uint base, uint n) { (void)c; (void)base; (void)n; }
+static inline void sm_config_set_out_pins(pio_sm_config *c, uint base, uint n) { (void)c; (void)base; (void)n; }
+static inline void sm_config_set_in_pins(pio_sm_config *c, uint base) { (void)c; (void)base; }
+static inline void sm_config_set_in_shift(pio_sm_config *c, bool direita, bool autopush, uint limiar) {
+    (void)c; (void)direita; (void)autopush; (void)limiar;
+}
+static inline void sm_config_set_out_shift(pio_sm_config *c, bool direita, bool autopull, uint limiar) {
+    (void)c; (void)direita; (void)autopull; (void)limiar;
+}
+static inline void sm_config_set_fifo_join(pio_sm_config *c, enum pio_fifo_join uniao) { (void)c; (void)uniao; }
+static inline void pio_sm_set_pins_with_mask(PIO pio, uint sm, uint32_t valores, uint32_t mascara) {
+    (void)pio; (void)sm; (void)valores; (void)mascara;
+}
+static inline void pio_sm_set_pindirs_with_mask(PIO pio, uint sm, uint32_t direcoes, uint32_t mascara) {
+    (void)pio; (void)sm; (void)direcoes; (void)mascara;
+}
+
+/**
+ * @brief Entrega um dado à FIFO RX (como um 'push noblock': descartado se cheia) e
+ * sinaliza a interrupção, se habilitada. Usado pelos modelos das máquinas de estados.
+ */
+void sim_pio_empurrar(PIO pio, uint sm, uint32_t dado);
+
+#endif // SIM_HARDWARE_PIO_H
@@ -0,0 +1,36 @@
+/**
+ * @file pwm.h
+ * @brief Fatias de PWM do simulador (registradores em RAM, sem saída).
+ */
+
+#ifndef SIM_HARDWARE_PWM_H
+#define SIM_HARDWARE_PWM_H
+
+#include "pico.h"
+
+typedef struct {
+    volatile uint32_t csr, div, ctr, cc, top;
+} pwm_slice_hw_t;
+
+typedef struct {
+    pwm_slice_hw_t slice[8];
+} pwm_hw_t;
+
+extern pwm_hw_t *const pwm_hw;
+
+static inline uint pwm_gpio_to_slice_num(uint gpio) {
+    return (gpio >> 1) & 7u;
+}
+
+static inline uint pwm_gpio_to_channel(uint gpio) {
+    return gpio & 1u;
+}
+
+void pwm_set_clkdiv(uint fatia, float divisor);
+void pwm_set_clkdiv_int_frac(uint fatia, uint8_t inteiro, uint8_t fracao);
+void pwm_set_wrap(uint fatia, uint16_t wrap);
+void pwm_set_chan_level(uint fatia, uint canal, uint16_t nivel);
+void pwm_set_gpio_level(uint gpio, uint16_t nivel);
+void pwm_set_enabled(uint fatia, bool habilitada);
+
+#endif // SIM_HARDWARE_PWM_H
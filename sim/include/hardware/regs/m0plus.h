@@ -0,0 +1,13 @@
+/**
+ * @file m0plus.h
+ * @brief Bits do SYST_CSR usados pelo perfil (perfil.c).
+ */
+
+#ifndef SIM_HARDWARE_REGS_M0PLUS_H
+#define SIM_HARDWARE_REGS_M0PLUS_H
+
+#define M0PLUS_SYST_CSR_ENABLE_BITS 0x00000001u
+#define M0PLUS_SYST_CSR_TICKINT_BITS 0x00000002u
+#define M0PLUS_SYST_CSR_CLKSOURCE_BITS 0x00000004u
+
+#endif // SIM_HARDWARE_REGS_M0PLUS_H
@@ -0,0 +1,22 @@
+/**
+ * @file systick.h
+ * @brief SysTick do simulador: só guarda os registradores. Como o firmware executa em
+ * tempo virtual zero entre esperas, o contador não anda; o perfil (perfil.h) mede os
+ * trechos pelo timer de 1us.
+ */
+
+#ifndef SIM_HARDWARE_STRUCTS_SYSTICK_H
+#define SIM_HARDWARE_STRUCTS_SYSTICK_H
+
+#include "pico.h"
+
+typedef struct {
+    volatile uint32_t csr;
+    volatile uint32_t rvr;
+    volatile uint32_t cvr;
+    volatile uint32_t calib;
+} systick_hw_t;
+
+extern systick_hw_t *const systick_hw;
+
+#endif // SIM_HARDWARE_STRUCTS_SYSTICK_H
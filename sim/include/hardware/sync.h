@@ -0,0 +1,28 @@
+/**
+ * @file sync.h
+ * @brief Eventos (WFE/SEV), barreiras e máscara de interrupções do núcleo simulado.
+ */
+
+#ifndef SIM_HARDWARE_SYNC_H
+#define SIM_HARDWARE_SYNC_H
+
+#include "pico.h"
+
+void __wfe(void);
+void __sev(void);
+
+static inline void __dmb(void) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+static inline void __compiler_memory_barrier(void) {
+    __asm__ volatile("" ::: "memory");
+}
+
+/**
+ * @brief Enquanto desabilitadas no Núcleo 0, as interrupções ficam pendentes no escalonador.
+ */
+uint32_t save_and_disable_interrupts(void);
+void restore_interrupts(uint32_t estado);
+
+#endif // SIM_HARDWARE_SYNC_H
@@ -0,0 +1,11 @@
+/**
+ * @file timer.h
+ * @brief O temporizador de hardware é o relógio virtual (pico/time.h).
+ */
+
+#ifndef SIM_HARDWARE_TIMER_H
+#define SIM_HARDWARE_TIMER_H
+
+#include "pico/time.h"
+
+#endif // SIM_HARDWARE_TIMER_H
@@ -0,0 +1,32 @@
+/**
+ * @file keypad.pio.h
+ * @brief Substituto do header gerado de keypad.pio: a máquina de estados é o modelo
+ * de varredura com debounce de sim_perifericos.c (mesma lógica do programa PIO).
+ */
+
+#ifndef SIM_KEYPAD_PIO_H
+#define SIM_KEYPAD_PIO_H
+
+#include "hardware/pio.h"
+
+#define keypad_CICLOS_VARREDURA 46
+
+static const pio_program_t keypad_program = {NULL, 19, -1};
+
+/**
+ * @brief Inicia a varredura simulada: a cada periodo_us o estado físico das teclas
+ * (roteiro do cenário) é amostrado, e um estado confirmado por duas varreduras vai para a FIFO.
+ */
+void sim_teclado_iniciar(PIO pio, uint sm, uint32_t periodo_us);
+
+static inline void keypad_program_init(PIO pio, uint sm, uint offset, const uint row_pins[4], uint col_base,
+                                       uint32_t periodo_us) {
+    (void)row_pins;
+    (void)col_base;
+    pio_sm_config c = pio_get_default_sm_config();
+    pio_sm_init(pio, sm, offset, &c);
+    sim_teclado_iniciar(pio, sm, periodo_us);
+    pio_sm_set_enabled(pio, sm, true);
+}
+
+#endif // SIM_KEYPAD_PIO_H
@@ -0,0 +1,19 @@
+/**
+ * @file err.h
+ * @brief Códigos de erro da lwIP.
+ */
+
+#ifndef SIM_LWIP_ERR_H
+#define SIM_LWIP_ERR_H
+
+#include "lwip/arch.h"
+
+typedef s8_t err_t;
+
+#define ERR_OK 0
+#define ERR_MEM -1
+#define ERR_TIMEOUT -3
+#define ERR_CONN -11
+#define ERR_ARG -16
+
+#endif // SIM_LWIP_ERR_H
@@ -0,0 +1,21 @@
+/**
+ * @file ip_addr.h
+ * @brief Endereços IPv4 da lwIP (ordem de rede).
+ */
+
+#ifndef SIM_LWIP_IP_ADDR_H
+#define SIM_LWIP_IP_ADDR_H
+
+#include "lwip/arch.h"
+
+typedef struct {
+    u32_t addr;
+} ip4_addr_t;
+
+typedef ip4_addr_t ip_addr_t;
+
+#define ip4_addr_get_u32(endereco) ((endereco)->addr)
+
+int ip4addr_aton(const char *texto, ip4_addr_t *endereco);
+
+#endif // SIM_LWIP_IP_ADDR_H
@@ -0,0 +1,17 @@
+/**
+ * @file netif.h
+ * @brief Interface de rede: só o endereço obtido pelo DHCP simulado.
+ */
+
+#ifndef SIM_LWIP_NETIF_H
+#define SIM_LWIP_NETIF_H
+
+#include "lwip/ip_addr.h"
+
+struct netif {
+    ip4_addr_t ip_addr;
+};
+
+#define netif_ip4_addr(interface) (&(interface)->ip_addr)
+
+#endif // SIM_LWIP_NETIF_H
@@ -0,0 +1,43 @@
+/**
+ * @file pico.h
+ * @brief Tipos, macros e mapa de memória básicos do SDK, para o simulador no host.
+ */
+
+#ifndef SIM_PICO_H
+#define SIM_PICO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef unsigned int uint;
+typedef uint64_t absolute_time_t;   ///< Microssegundos de tempo virtual desde o boot.
+
+#define count_of(a) (sizeof(a) / sizeof((a)[0]))
+#define _u(x) x ## u
+#define __not_in_flash_func(f) f
+#define __no_inline_not_in_flash_func(f) __attribute__((noinline)) f
+
+#define PICO_OK 0
+#define PICO_ERROR_NONE 0
+#define PICO_ERROR_TIMEOUT -1
+#define PICO_ERROR_GENERIC -2
+
+// A flash simulada é mapeada no próprio endereço do XIP (sim_perifericos.c), então
+// ponteiros XIP_BASE + offset do firmware funcionam sem alteração
+#define XIP_BASE 0x10000000u
+#define PICO_FLASH_SIZE_BYTES (2u * 1024 * 1024)
+
+/**
+ * @brief Núcleo em execução (interrupções executam no Núcleo 0).
+ */
+uint get_core_num(void);
+
+/**
+ * @brief Espera ativa: cede o núcleo simulado por 1us de tempo virtual.
+ */
+void tight_loop_contents(void);
+
+void panic(const char *formato, ...);
+
+#endif // SIM_PICO_H
@@ -0,0 +1,11 @@
+/**
+ * @file binary_info.h
+ * @brief Sem metadados de binário no host.
+ */
+
+#ifndef SIM_PICO_BINARY_INFO_H
+#define SIM_PICO_BINARY_INFO_H
+
+#define bi_decl(...)
+
+#endif // SIM_PICO_BINARY_INFO_H
@@ -0,0 +1,48 @@
+/**
+ * @file cyw43_arch.h
+ * @brief Chip Wi-Fi simulado: associação e DHCP levam tempos fixos de tempo virtual
+ * (menos com BSSID e canal em cache), e o enlace pode cair pelo roteiro do cenário.
+ */
+
+#ifndef SIM_PICO_CYW43_ARCH_H
+#define SIM_PICO_CYW43_ARCH_H
+
+#include "pico.h"
+#include "lwip/netif.h"
+
+#define CYW43_ITF_STA 0
+#define CYW43_ITF_AP 1
+
+#define CYW43_LINK_DOWN 0
+#define CYW43_LINK_JOIN 1
+#define CYW43_LINK_NOIP 2
+#define CYW43_LINK_UP 3
+#define CYW43_LINK_FAIL -1
+#define CYW43_LINK_NONET -2
+#define CYW43_LINK_BADAUTH -3
+
+#define CYW43_AUTH_WPA2_AES_PSK 0x00400004
+#define CYW43_CHANNEL_NONE 0xffffffffu
+#define CYW43_IOCTL_GET_CHANNEL 0x3a
+
+typedef struct {
+    struct netif netif[2];
+} cyw43_t;
+
+extern cyw43_t cyw43_state;
+
+int cyw43_arch_init(void);
+void cyw43_arch_enable_sta_mode(void);
+void cyw43_arch_poll(void);
+
+static inline void cyw43_arch_lwip_begin(void) {}
+static inline void cyw43_arch_lwip_end(void) {}
+
+int cyw43_wifi_join(cyw43_t *self, size_t ssid_len, const uint8_t *ssid, size_t key_len, const uint8_t *key,
+                    uint32_t auth_type, const uint8_t *bssid, uint32_t channel);
+int cyw43_wifi_leave(cyw43_t *self, int itf);
+int cyw43_wifi_get_bssid(cyw43_t *self, uint8_t bssid[6]);
+int cyw43_ioctl(cyw43_t *self, uint32_t cmd, size_t len, uint8_t *buf, uint32_t iface);
+int cyw43_tcpip_link_status(cyw43_t *self, int itf);
+
+#endif // SIM_PICO_CYW43_ARCH_H
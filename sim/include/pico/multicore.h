@@ -0,0 +1,21 @@
+/**
+ * @file multicore.h
+ * @brief Lançamento do Núcleo 1 e FIFOs inter-core (8 posições em cada sentido).
+ */
+
+#ifndef SIM_PICO_MULTICORE_H
+#define SIM_PICO_MULTICORE_H
+
+#include "pico.h"
+#include "hardware/irq.h"
+
+void multicore_launch_core1(void (*entrada)(void));
+
+bool multicore_fifo_rvalid(void);
+bool multicore_fifo_wready(void);
+void multicore_fifo_push_blocking(uint32_t dado);
+uint32_t multicore_fifo_pop_blocking(void);
+void multicore_fifo_drain(void);
+void multicore_fifo_clear_irq(void);
+
+#endif // SIM_PICO_MULTICORE_H
@@ -0,0 +1,13 @@
+/**
+ * @file rand.h
+ * @brief Gerador do simulador: sequência fixa, para execuções reprodutíveis.
+ */
+
+#ifndef SIM_PICO_RAND_H
+#define SIM_PICO_RAND_H
+
+#include "pico.h"
+
+uint32_t get_rand_32(void);
+
+#endif // SIM_PICO_RAND_H
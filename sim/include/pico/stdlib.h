@@ -0,0 +1,17 @@
+/**
+ * @file stdlib.h
+ * @brief pico/stdlib.h do simulador.
+ */
+
+#ifndef SIM_PICO_STDLIB_H
+#define SIM_PICO_STDLIB_H
+
+#include <stdio.h>
+#include "pico.h"
+#include "pico/time.h"
+#include "hardware/gpio.h"
+#include "hardware/sync.h"   // No SDK chega por pico/time.h
+
+bool stdio_init_all(void);
+
+#endif // SIM_PICO_STDLIB_H
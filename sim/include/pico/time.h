@@ -0,0 +1,85 @@
+/**
+ * @file time.h
+ * @brief Tempo virtual, esperas e alarmes (sim_nucleos.c).
+ * O relógio só avança quando os dois núcleos simulados estão esperando: o código do
+ * firmware executa em tempo virtual zero entre uma espera e outra.
+ */
+
+#ifndef SIM_PICO_TIME_H
+#define SIM_PICO_TIME_H
+
+#include "pico.h"
+
+#define at_the_end_of_time ((absolute_time_t)INT64_MAX)
+#define nil_time ((absolute_time_t)0)
+
+uint64_t time_us_64(void);
+uint32_t time_us_32(void);
+
+static inline absolute_time_t get_absolute_time(void) {
+    return time_us_64();
+}
+
+static inline uint64_t to_us_since_boot(absolute_time_t t) {
+    return t;
+}
+
+static inline uint32_t to_ms_since_boot(absolute_time_t t) {
+    return (uint32_t)(t / 1000);
+}
+
+static inline absolute_time_t from_us_since_boot(uint64_t us) {
+    return us;
+}
+
+static inline bool is_at_the_end_of_time(absolute_time_t t) {
+    return t == at_the_end_of_time;
+}
+
+static inline int64_t absolute_time_diff_us(absolute_time_t de, absolute_time_t ate) {
+    return (int64_t)(ate - de);
+}
+
+static inline absolute_time_t absolute_time_min(absolute_time_t a, absolute_time_t b) {
+    return a < b ? a : b;
+}
+
+static inline absolute_time_t delayed_by_us(absolute_time_t t, uint64_t us) {
+    return (us >= at_the_end_of_time - t) ? at_the_end_of_time : t + us;
+}
+
+static inline absolute_time_t delayed_by_ms(absolute_time_t t, uint32_t ms) {
+    return delayed_by_us(t, (uint64_t)ms * 1000);
+}
+
+static inline absolute_time_t make_timeout_time_us(uint64_t us) {
+    return delayed_by_us(get_absolute_time(), us);
+}
+
+static inline absolute_time_t make_timeout_time_ms(uint32_t ms) {
+    return delayed_by_ms(get_absolute_time(), ms);
+}
+
+static inline bool time_reached(absolute_time_t t) {
+    return time_us_64() >= t;
+}
+
+void sleep_us(uint64_t us);
+void sleep_ms(uint32_t ms);
+void busy_wait_us(uint64_t us);
+void busy_wait_us_32(uint32_t us);
+
+/**
+ * @brief WFE com prazo: retorna no primeiro evento (SEV ou interrupção) ou no prazo.
+ * @return true se o prazo foi atingido.
+ */
+bool best_effort_wfe_or_timeout(absolute_time_t prazo);
+
+typedef int32_t alarm_id_t;
+typedef int64_t (*alarm_callback_t)(alarm_id_t id, void *user_data);
+
+alarm_id_t add_alarm_at(absolute_time_t instante, alarm_callback_t callback, void *user_data, bool fire_if_past);
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past);
+bool cancel_alarm(alarm_id_t alarm_id);
+
+#endif // SIM_PICO_TIME_H
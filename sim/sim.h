@@ -0,0 +1,163 @@
+/**
+ * @file sim.h
+ * @brief Interface interna do simulador da fechadura no host.
+ * Os dois núcleos do RP2040 são corrotinas (ucontext) trocadas por um escalonador
+ * determinístico; o relógio é virtual e só avança quando os dois núcleos esperam
+ * (WFE, sleep, espera ativa). Os periféricos são modelos dirigidos por eventos
+ * agendados nesse relógio, e o cenário (sim_cenario.c) roteiriza sensor, teclado e rede.
+ */
+
+#ifndef SIM_H
+#define SIM_H
+
+#include "pico.h"
+
+#define SIM_PARA_SEMPRE UINT64_MAX
+
+// --- Escalonador e tempo virtual (sim_nucleos.c) ---
+
+typedef void (*sim_acao_t)(void *arg);
+
+/**
+ * @brief Instante atual do relógio virtual (us desde o boot).
+ */
+uint64_t sim_agora_us(void);
+
+/**
+ * @brief Prepara o Núcleo 0 para começar em 'entrada' (o main() do firmware).
+ */
+void sim_nucleos_iniciar(void (*entrada)(void));
+
+/**
+ * @brief Executa os núcleos e os eventos até o instante 'fim_us' do relógio virtual.
+ */
+void sim_executar_ate(uint64_t fim_us);
+
+/**
+ * @brief Suspende o núcleo em execução até 'instante_us' ou, se 'acorda_com_evento',
+ * até um evento (SEV ou interrupção no Núcleo 0), o que vier primeiro.
+ * @return true se o instante foi atingido.
+ */
+bool sim_esperar_ate(uint64_t instante_us, bool acorda_com_evento);
+
+/**
+ * @brief Agenda uma ação no relógio virtual.
+ * @param interrupcao A ação é um tratador de interrupção: executa no contexto do Núcleo 0
+ * e fica pendente enquanto ele estiver com as interrupções desabilitadas.
+ * @return Identificador (> 0) para sim_cancelar.
+ */
+uint32_t sim_agendar(uint64_t instante_us, sim_acao_t acao, void *arg, bool interrupcao);
+
+/**
+ * @brief Remove uma ação ainda não executada.
+ */
+bool sim_cancelar(uint32_t id);
+
+/**
+ * @brief Sinaliza uma linha de interrupção: o tratador registrado executa no Núcleo 0
+ * se a linha estiver habilitada (sinalizações repetidas antes do atendimento se fundem).
+ */
+void sim_irq_sinalizar(uint irq);
+
+/**
+ * @brief Tempo de host (ns) gasto executando o Núcleo 0 e as interrupções desde o início.
+ */
+uint64_t sim_custo_nucleo0_ns(void);
+
+// --- Periféricos (sim_perifericos.c) ---
+
+/**
+ * @brief Mapeia a flash simulada em XIP_BASE, opcionalmente sobre um arquivo
+ * (o conteúdo persiste entre execuções, como num reinício da placa).
+ * @return false se o endereço não pôde ser mapeado.
+ */
+bool sim_flash_iniciar(const char *arquivo);
+
+/**
+ * @brief Pressiona ou solta uma tecla no teclado físico simulado.
+ * @return false se a tecla não existe no teclado.
+ */
+bool sim_teclado_mudar(char tecla, bool pressionada);
+
+// --- Barramentos I2C, sensor de cor e display (sim_i2c.c) ---
+
+/**
+ * @brief Carrega traços gravados do sensor (formato de scripts/tracos-classificador.csv):
+ * cada aproximação de um cartão reproduz uma aproximação gravada, em rodízio.
+ * Sem traços, o cartão é sintetizado a partir dos centróides de fábrica (configuracao.h).
+ */
+bool sim_sensor_carregar_tracos(const char *caminho);
+
+/**
+ * @brief Aproxima um objeto do sensor: um cartão (enum CorDetectada) ou, com COR_NENHUMA,
+ * um objeto que não é cartão.
+ */
+void sim_sensor_cartao(uint8_t cartao);
+
+/**
+ * @brief Retira o objeto: o sensor volta a ver só a luz ambiente.
+ */
+void sim_sensor_retirar(void);
+
+/**
+ * @brief Cartão pelo nome usado nos traços e nos cenários ("verde", "roxo", "nenhum"...).
+ * @return O cartão, ou -1 se o nome não existe.
+ */
+int sim_sensor_cartao_pelo_nome(const char *nome);
+
+/**
+ * @brief Indica se o barramento tem transações pendentes ou em andamento.
+ */
+bool sim_i2c_ocupado(uint barramento);
+
+// --- Wi-Fi e broker MQTT local (sim_rede.c) ---
+
+typedef void (*sim_broker_observador_t)(uint64_t chegada_us, const char *topico, const char *payload, uint16_t tamanho);
+
+/**
+ * @brief Latência de ida entre a placa e o broker.
+ */
+void sim_rede_latencia(uint32_t latencia_us);
+
+/**
+ * @brief Liga ou derruba o ponto de acesso (enlace Wi-Fi e broker).
+ */
+void sim_rede_ativa(bool ativa);
+
+/**
+ * @brief O broker publica 'payload' em DEVICE_ID/<topico_base> (entregue se a placa assina o tópico).
+ */
+void sim_broker_publicar(const char *topico_base, const char *payload);
+
+/**
+ * @brief Observa as publicações que chegam ao broker (com o instante de chegada).
+ */
+void sim_broker_observar(sim_broker_observador_t observador);
+
+// --- Cenário (sim_cenario.c) ---
+
+/**
+ * @brief Lê um roteiro e agenda as suas ações no relógio virtual.
+ * @param fim_us Saída: instante em que a simulação termina.
+ */
+bool sim_cenario_carregar(const char *caminho, uint64_t *fim_us);
+
+// --- Medidas (sim_medidas.c) ---
+
+/**
+ * @brief Marcos vindos do cenário: cartão aproximado e último dígito de uma senha pressionado.
+ */
+void sim_medidas_cartao_aproximado(void);
+void sim_medidas_ultimo_digito(void);
+
+/**
+ * @brief Passa a observar o broker e a contar as iterações do loop.
+ */
+void sim_medidas_iniciar(bool mostrar_broker);
+
+/**
+ * @brief Imprime as latências e o custo do loop.
+ */
+void sim_medidas_relatorio(uint64_t duracao_us);
+
+#endif // SIM_H
@@ -0,0 +1,320 @@
+/**
+ * @file sim_cenario.c
+ * @brief Roteiros de teste do simulador: o que acontece diante da fechadura e quando.
+ *
+ * Uma ação por linha, "<instante> <comando> [argumentos]", com '#' iniciando comentários.
+ * O instante é absoluto em ms desde o boot ou, com '+', relativo à linha anterior.
+ *   cartao <nome>               aproxima um cartão (verde, vermelho, azul, amarelo, roxo)
+ *                               ou, com "nenhum", um objeto que não é cartão
+ *   remover                     retira o cartão
+ *   teclas <sequência> [ms]     digita a sequência (uma tecla a cada 'ms', padrão 250)
+ *   tecla <c> pressionar|soltar muda uma tecla isolada
+ *   mqtt <tópico> <payload>     o broker publica em DEVICE_ID/<tópico>
+ *   rede cair|voltar            derruba ou religa o ponto de acesso
+ *   latencia <ms>               latência de ida até o broker
+ *   repetir <n> <período ms>    repete as linhas até "fim_repetir" n vezes; dentro do
+ *                               bloco os instantes contam a partir do início da repetição
+ *   fim <ms>                    instante em que a simulação termina
+ */
+
+#include "sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+// --- Definições ---
+#define LINHA_MAXIMO 256
+#define LINHAS_MAXIMO 512
+#define TECLA_PRESSIONADA_US 80000      // Duração de um toque
+#define INTERVALO_TECLAS_PADRAO_MS 250
+#define FOLGA_FIM_US 5000000            // Sem "fim": 5s após a última ação
+
+typedef enum {
+    ACAO_CARTAO,
+    ACAO_REMOVER,
+    ACAO_TECLA,
+    ACAO_MQTT,
+    ACAO_REDE,
+    ACAO_LATENCIA
+} tipo_acao_t;
+
+typedef struct {
+    tipo_acao_t tipo;
+    int valor;              // Cartão, estado da rede, latência (us) ou tecla
+    bool pressionada;
+    bool ultimo_digito;     // Última tecla de uma sequência (marco da medida de abertura)
+    char topico[64];
+    char payload[128];
+} acao_t;
+
+typedef struct {
+    char texto[LINHA_MAXIMO];
+    uint numero;
+} linha_t;
+
+
+// --- Estado ---
+static linha_t linhas[LINHAS_MAXIMO];
+static uint quantidade_linhas = 0;
+static uint64_t ultima_acao_us = 0;
+
+
+// --- Funções Auxiliares ---
+
+static void executar(void *arg) {
+    acao_t *acao = arg;
+    switch (acao->tipo) {
+        case ACAO_CARTAO:
+            sim_sensor_cartao((uint8_t)acao->valor);
+            if (acao->valor != 0) {
+                sim_medidas_cartao_aproximado();
+            }
+            break;
+        case ACAO_REMOVER:
+            sim_sensor_retirar();
+            break;
+        case ACAO_TECLA:
+            sim_teclado_mudar((char)acao->valor, acao->pressionada);
+            if (acao->ultimo_digito) {
+                sim_medidas_ultimo_digito();
+            }
+            break;
+        case ACAO_MQTT:
+            sim_broker_publicar(acao->topico, acao->payload);
+            break;
+        case ACAO_REDE:
+            sim_rede_ativa(acao->valor != 0);
+            break;
+        case ACAO_LATENCIA:
+            sim_rede_latencia((uint32_t)acao->valor);
+            break;
+    }
+    free(acao);
+}
+
+static acao_t *nova_acao(tipo_acao_t tipo) {
+    acao_t *acao = calloc(1, sizeof(acao_t));
+    if (!acao) {
+        panic("sem memoria para o cenario");
+    }
+    acao->tipo = tipo;
+    return acao;
+}
+
+static void agendar(uint64_t instante_us, acao_t *acao) {
+    sim_agendar(instante_us, executar, acao, false);
+    if (instante_us > ultima_acao_us) {
+        ultima_acao_us = instante_us;
+    }
+}
+
+static bool erro(const linha_t *linha, const char *motivo) {
+    fprintf(stderr, "cenario, linha %u: %s\n", linha->numero, motivo);
+    return false;
+}
+
+/**
+ * @brief Lê o instante de uma linha.
+ * @param anterior_us Instante da linha anterior (base dos relativos); atualizado.
+ * @param base_us Origem dos instantes absolutos (início da repetição, fora dela 0).
+ */
+static bool ler_instante(const char *campo, uint64_t base_us, uint64_t *anterior_us, uint64_t *instante_us) {
+    char *fim;
+    bool relativo = campo[0] == '+';
+    unsigned long long ms = strtoull(campo + (relativo ? 1 : 0), &fim, 10);
+    if (*fim != '\0') {
+        return false;
+    }
+    *instante_us = (relativo ? *anterior_us : base_us) + ms * 1000u;
+    *anterior_us = *instante_us;
+    return true;
+}
+
+/**
+ * @brief Agenda o comando de uma linha no instante dado.
+ */
+static bool agendar_comando(const linha_t *linha, uint64_t instante_us, char *comando, char *resto, uint64_t *fim_us) {
+    char argumento[LINHA_MAXIMO] = "";
+    sscanf(resto, "%255s", argumento);
+
+    if (strcmp(comando, "cartao") == 0) {
+        int cartao = sim_sensor_cartao_pelo_nome(argumento);
+        if (cartao < 0) {
+            return erro(linha, "cartao desconhecido");
+        }
+        acao_t *acao = nova_acao(ACAO_CARTAO);
+        acao->valor = cartao;
+        agendar(instante_us, acao);
+    } else if (strcmp(comando, "remover") == 0) {
+        agendar(instante_us, nova_acao(ACAO_REMOVER));
+    } else if (strcmp(comando, "teclas") == 0) {
+        unsigned intervalo_ms = INTERVALO_TECLAS_PADRAO_MS;
+        sscanf(resto, "%*s %u", &intervalo_ms);
+        size_t quantidade = strlen(argumento);
+        if (quantidade == 0) {
+            return erro(linha, "sequencia de teclas vazia");
+        }
+        for (size_t i = 0; i < quantidade; i++) {
+            uint64_t toque_us = instante_us + (uint64_t)i * intervalo_ms * 1000u;
+            acao_t *pressionar = nova_acao(ACAO_TECLA);
+            pressionar->valor = argumento[i];
+            pressionar->pressionada = true;
+            pressionar->ultimo_digito = (i + 1 == quantidade);
+            acao_t *soltar = nova_acao(ACAO_TECLA);
+            soltar->valor = argumento[i];
+            if (!sim_teclado_mudar(argumento[i], false)) {
+                free(pressionar);
+                free(soltar);
+                return erro(linha, "tecla inexistente");
+            }
+            agendar(toque_us, pressionar);
+            agendar(toque_us + TECLA_PRESSIONADA_US, soltar);
+        }
+    } else if (strcmp(comando, "tecla") == 0) {
+        char estado[16] = "";
+        sscanf(resto, "%*s %15s", estado);
+        if (strlen(argumento) != 1 || !sim_teclado_mudar(argumento[0], false) ||
+            (strcmp(estado, "pressionar") != 0 && strcmp(estado, "soltar") != 0)) {
+            return erro(linha, "uso: tecla <c> pressionar|soltar");
+        }
+        acao_t *acao = nova_acao(ACAO_TECLA);
+        acao->valor = argumento[0];
+        acao->pressionada = strcmp(estado, "pressionar") == 0;
+        agendar(instante_us, acao);
+    } else if (strcmp(comando, "mqtt") == 0) {
+        acao_t *acao = nova_acao(ACAO_MQTT);
+        if (sscanf(resto, "%63s %127[^\n]", acao->topico, acao->payload) != 2) {
+            free(acao);
+            return erro(linha, "uso: mqtt <topico> <payload>");
+        }
+        agendar(instante_us, acao);
+    } else if (strcmp(comando, "rede") == 0) {
+        if (strcmp(argumento, "cair") != 0 && strcmp(argumento, "voltar") != 0) {
+            return erro(linha, "uso: rede cair|voltar");
+        }
+        acao_t *acao = nova_acao(ACAO_REDE);
+        acao->valor = strcmp(argumento, "voltar") == 0;
+        agendar(instante_us, acao);
+    } else if (strcmp(comando, "latencia") == 0) {
+        unsigned ms;
+        if (sscanf(argumento, "%u", &ms) != 1) {
+            return erro(linha, "uso: latencia <ms>");
+        }
+        acao_t *acao = nova_acao(ACAO_LATENCIA);
+        acao->valor = (int)(ms * 1000u);
+        agendar(instante_us, acao);
+    } else if (strcmp(comando, "fim") == 0) {
+        *fim_us = instante_us;
+    } else {
+        return erro(linha, "comando desconhecido");
+    }
+    return true;
+}
+
+/**
+ * @brief Separa uma linha em instante, comando e argumentos.
+ * @return false se a linha não tem comando (vazia ou só comentário).
+ */
+static bool separar(char *texto, char **instante, char **comando, char **resto) {
+    char *comentario = strchr(texto, '#');
+    if (comentario) {
+        *comentario = '\0';
+    }
+    texto[strcspn(texto, "\r\n")] = '\0';
+    *instante = strtok(texto, " \t");
+    *comando = *instante ? strtok(NULL, " \t") : NULL;
+    if (!*comando) {
+        return false;
+    }
+    static char vazio[] = "";
+    *resto = strtok(NULL, "");
+    if (!*resto) {
+        *resto = vazio;
+    }
+    return true;
+}
+
+
+// --- Implementação das Funções Públicas ---
+
+bool sim_cenario_carregar(const char *caminho, uint64_t *fim_us) {
+    FILE *arquivo = fopen(caminho, "r");
+    if (!arquivo) {
+        perror(caminho);
+        return false;
+    }
+    uint numero = 0;
+    char texto[LINHA_MAXIMO];
+    while (fgets(texto, sizeof(texto), arquivo)) {
+        numero++;
+        if (quantidade_linhas == LINHAS_MAXIMO) {
+            fclose(arquivo);
+            fprintf(stderr, "cenario: mais de %u linhas\n", LINHAS_MAXIMO);
+            return false;
+        }
+        linhas[quantidade_linhas] = (linha_t){"", numero};
+        strcpy(linhas[quantidade_linhas].texto, texto);
+        quantidade_linhas++;
+    }
+    fclose(arquivo);
+
+    *fim_us = 0;
+    uint64_t anterior_us = 0;
+    for (uint i = 0; i < quantidade_linhas; i++) {
+        char copia[LINHA_MAXIMO];
+        char *instante, *comando, *resto;
+        strcpy(copia, linhas[i].texto);
+        if (!separar(copia, &instante, &comando, &resto)) {
+            continue;
+        }
+        uint64_t instante_us;
+        if (!ler_instante(instante, 0, &anterior_us, &instante_us)) {
+            return erro(&linhas[i], "instante invalido");
+        }
+        if (strcmp(comando, "repetir") != 0) {
+            if (!agendar_comando(&linhas[i], instante_us, comando, resto, fim_us)) {
+                return false;
+            }
+            continue;
+        }
+
+        unsigned repeticoes, periodo_ms;
+        if (sscanf(resto, "%u %u", &repeticoes, &periodo_ms) != 2) {
+            return erro(&linhas[i], "uso: repetir <n> <periodo ms>");
+        }
+        uint inicio_bloco = i + 1, fim_bloco = inicio_bloco;
+        for (; fim_bloco < quantidade_linhas; fim_bloco++) {
+            strcpy(copia, linhas[fim_bloco].texto);
+            if (separar(copia, &instante, &comando, &resto) && strcmp(comando, "fim_repetir") == 0) {
+                break;
+            }
+        }
+        if (fim_bloco == quantidade_linhas) {
+            return erro(&linhas[i], "repetir sem fim_repetir");
+        }
+        for (unsigned r = 0; r < repeticoes; r++) {
+            uint64_t base_us = instante_us + (uint64_t)r * periodo_ms * 1000u;
+            uint64_t anterior_bloco_us = base_us;
+            for (uint j = inicio_bloco; j < fim_bloco; j++) {
+                uint64_t instante_bloco_us;
+                strcpy(copia, linhas[j].texto);
+                if (!separar(copia, &instante, &comando, &resto)) {
+                    continue;
+                }
+                if (!ler_instante(instante, base_us, &anterior_bloco_us, &instante_bloco_us)) {
+                    return erro(&linhas[j], "instante invalido");
+                }
+                if (!agendar_comando(&linhas[j], instante_bloco_us, comando, resto, fim_us)) {
+                    return false;
+                }
+            }
+        }
+        anterior_us = instante_us + (uint64_t)repeticoes * periodo_ms * 1000u;
+        i = fim_bloco;
+    }
+    if (*fim_us == 0) {
+        *fim_us = ultima_acao_us + FOLGA_FIM_US;
+    }
+    return true;
+}
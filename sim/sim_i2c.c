@@ -0,0 +1,516 @@
+/**
+ * @file sim_i2c.c
+ * @brief Modelo do motor i2c_dma (substitui i2c_dma.c no simulador) e dos dispositivos
+ * nos barramentos: o sensor TCS34725 no i2c0 e o display SSD1306 no i2c1.
+ *
+ * A fila de cada barramento segue o motor real (identificadores, estados, estatísticas);
+ * cada transação ocupa o barramento pelo tempo dos seus bits no baudrate configurado e
+ * termina numa interrupção, onde o efeito no dispositivo é aplicado e o callback é chamado.
+ * O sensor é um banco de registradores que integra em ciclos de 2.4ms: ao fim de cada
+ * integração a cena (luz ambiente ou o objeto aproximado) é amostrada com o ganho e o
+ * tempo programados, e o canal Clear é comparado com a janela da interrupção.
+ */
+
+#include "sim.h"
+#include "i2c_dma.h"
+#include "configura_geral.h"
+#include "configuracao.h"
+#include "tcs34725.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include <stdio.h>
+#include <string.h>
+
+
+// --- Definições ---
+#define SSD1306_ENDERECO 0x3C
+#define SOBRECARGA_TRANSACAO_US 5       // START, STOP e latência do DMA/interrupção
+
+// Registradores do TCS34725 usados pelo modelo (ver tcs34725.c)
+#define TCS_COMANDO 0x80
+#define TCS_TIPO_MASCARA 0x60
+#define TCS_TIPO_AUTO_INCREMENTO 0x20
+#define TCS_TIPO_FUNCAO_ESPECIAL 0x60
+#define TCS_FUNCAO_LIMPAR 0x06
+#define TCS_ENABLE 0x00
+#define TCS_ATIME 0x01
+#define TCS_WTIME 0x03
+#define TCS_AILTL 0x04
+#define TCS_PERS 0x0C
+#define TCS_CONTROL 0x0F
+#define TCS_ID 0x12
+#define TCS_STATUS 0x13
+#define TCS_CDATAL 0x14
+#define TCS_PON 0x01
+#define TCS_AEN 0x02
+#define TCS_WEN 0x08
+#define TCS_AVALID 0x01
+#define TCS_AINT 0x10
+#define TCS_CICLO_US 2400
+#define TCS_CICLOS_REFERENCIA 21        // Exposição dos traços (ganho 1x, 50.4ms)
+
+// Traços: intervalo entre leituras gravadas (uma integração de referência completa)
+#define TRACO_PASSO_US ((TCS_CICLOS_REFERENCIA + 1) * TCS_CICLO_US)
+#define MAXIMO_APROXIMACOES 256
+#define MAXIMO_LEITURAS 16
+
+// Luz ambiente sem objeto, na exposição de referência
+#define AMBIENTE_CLEAR 20
+#define AMBIENTE_RED 9
+#define AMBIENTE_GREEN 7
+#define AMBIENTE_BLUE 5
+#define SINTETICO_CLEAR 900             // Cartão sintético: reflexo típico dos traços
+
+typedef struct {
+    i2c_dma_transacao_t transacao;
+    uint8_t dados_inline[I2C_DMA_DADOS_INLINE];
+    i2c_dma_resultado_t estado;
+} slot_transacao_t;
+
+typedef struct {
+    uint baudrate;
+    bool inicializado;
+    slot_transacao_t fila[I2C_DMA_FILA_TAMANHO];
+    i2c_dma_id_t proximo_id;
+    i2c_dma_id_t id_cabeca;
+    bool ativo;
+    i2c_dma_estatisticas_t estatisticas;
+} barramento_t;
+
+typedef struct {
+    uint16_t clear, red, green, blue;
+} leitura_t;
+
+typedef struct {
+    uint8_t cartao;
+    uint8_t quantidade;
+    leitura_t leituras[MAXIMO_LEITURAS];
+} aproximacao_t;
+
+
+// --- Estado ---
+i2c_inst_t i2c0_inst = {0};
+i2c_inst_t i2c1_inst = {1};
+static barramento_t barramentos[2];
+
+static const char *const NOMES[] = {"nenhum", "verde", "vermelho", "azul", "amarelo", "roxo"};
+#define QUANTIDADE_NOMES (sizeof(NOMES) / sizeof(NOMES[0]))
+
+static aproximacao_t aproximacoes[MAXIMO_APROXIMACOES];
+static size_t total_aproximacoes = 0;
+static size_t rodizio[QUANTIDADE_NOMES];    // Próxima aproximação gravada de cada cartão
+
+// Cena diante do sensor
+static struct {
+    bool presente;
+    uint8_t cartao;
+    const aproximacao_t *traco;             // NULL: cartão sintético
+    uint64_t inicio_us;
+    uint32_t semente;                       // Ruído do cartão sintético
+} cena;
+
+// Sensor
+static struct {
+    uint8_t registradores[32];
+    uint64_t fim_integracao_us;             // Fim da integração em curso (SIM_PARA_SEMPRE se parado)
+    uint8_t fora_seguidas;                  // Integrações seguidas fora da janela (persistência)
+} sensor;
+
+
+// --- Cena e sensor ---
+
+int sim_sensor_cartao_pelo_nome(const char *nome) {
+    for (size_t i = 0; i < QUANTIDADE_NOMES; i++) {
+        if (strcmp(nome, NOMES[i]) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+bool sim_sensor_carregar_tracos(const char *caminho) {
+    FILE *arquivo = fopen(caminho, "r");
+    if (!arquivo) {
+        return false;
+    }
+    char linha[128];
+    aproximacao_t *atual = NULL;
+    while (fgets(linha, sizeof(linha), arquivo)) {
+        if (linha[0] == '#') {
+            continue;
+        }
+        char nome[16];
+        unsigned clear, red, green, blue;
+        if (sscanf(linha, "%15[^,],%u,%u,%u,%u", nome, &clear, &red, &green, &blue) != 5) {
+            atual = NULL; // Linha vazia (ou só '\r'): fim da aproximação
+            continue;
+        }
+        int cartao = sim_sensor_cartao_pelo_nome(nome);
+        if (cartao < 0) {
+            fprintf(stderr, "cartao desconhecido nos tracos: %s\n", nome);
+            continue;
+        }
+        if (!atual || atual->cartao != cartao || atual->quantidade == MAXIMO_LEITURAS) {
+            if (total_aproximacoes == MAXIMO_APROXIMACOES) {
+                break;
+            }
+            atual = &aproximacoes[total_aproximacoes++];
+            atual->cartao = (uint8_t)cartao;
+            atual->quantidade = 0;
+        }
+        atual->leituras[atual->quantidade++] = (leitura_t){clear, red, green, blue};
+    }
+    fclose(arquivo);
+    return total_aproximacoes > 0;
+}
+
+/**
+ * @brief Próxima aproximação gravada do cartão, em rodízio (NULL se não há nenhuma).
+ */
+static const aproximacao_t *proxima_aproximacao(uint8_t cartao) {
+    for (size_t n = 0; n < total_aproximacoes; n++) {
+        size_t i = (rodizio[cartao] + n) % total_aproximacoes;
+        if (aproximacoes[i].cartao == cartao) {
+            rodizio[cartao] = i + 1;
+            return &aproximacoes[i];
+        }
+    }
+    return NULL;
+}
+
+void sim_sensor_cartao(uint8_t cartao) {
+    cena.presente = true;
+    cena.cartao = cartao;
+    cena.traco = proxima_aproximacao(cartao);
+    cena.inicio_us = sim_agora_us();
+    cena.semente = 0x9E3779B9u * (uint32_t)(cena.inicio_us / 1000 + cartao + 1);
+}
+
+void sim_sensor_retirar(void) {
+    cena.presente = false;
+}
+
+/**
+ * @brief Ruído determinístico de até ±2%.
+ */
+static uint16_t com_ruido(uint32_t valor, uint32_t *semente) {
+    *semente ^= *semente << 13;
+    *semente ^= *semente >> 17;
+    *semente ^= *semente << 5;
+    int32_t variacao = (int32_t)(*semente % 41) - 20; // -20..20 (por mil)
+    return (uint16_t)((int32_t)valor + (int32_t)valor * variacao / 1000);
+}
+
+/**
+ * @brief Leitura sintetizada a partir do centróide de fábrica do cartão.
+ * Um objeto que não é cartão reflete luz sem cor dominante.
+ */
+static leitura_t leitura_sintetica(uint8_t cartao) {
+#define CONFIGURACAO_PADRAO(chave, campo, nome, padrao, minimo, maximo) padrao,
+    static const uint16_t PADROES[] = {CONFIGURACAO_CAMPOS(CONFIGURACAO_PADRAO)};
+#undef CONFIGURACAO_PADRAO
+    uint32_t r = 341, g = 352; // Cinza levemente esverdeado, como os "nenhum" dos traços
+    if (cartao != COR_NENHUMA) {
+        r = PADROES[CONFIG_CENTROIDE_R(cartao)];
+        g = PADROES[CONFIG_CENTROIDE_G(cartao)];
+    }
+    uint32_t b = 1024 - r - g;
+    uint32_t soma = SINTETICO_CLEAR * 9 / 10; // R+G+B ficam ~10% abaixo do Clear
+    return (leitura_t){
+        com_ruido(SINTETICO_CLEAR, &cena.semente),
+        com_ruido(soma * r / 1024, &cena.semente),
+        com_ruido(soma * g / 1024, &cena.semente),
+        com_ruido(soma * b / 1024, &cena.semente),
+    };
+}
+
+/**
+ * @brief Luz que chega ao sensor no instante 't_us', na exposição de referência.
+ */
+static leitura_t cena_em(uint64_t t_us) {
+    if (!cena.presente) {
+        return (leitura_t){AMBIENTE_CLEAR, AMBIENTE_RED, AMBIENTE_GREEN, AMBIENTE_BLUE};
+    }
+    uint64_t passo = (t_us - cena.inicio_us) / TRACO_PASSO_US;
+    if (cena.traco) {
+        uint64_t ultima = cena.traco->quantidade - 1u;
+        return cena.traco->leituras[passo < ultima ? passo : ultima];
+    }
+    leitura_t leitura = leitura_sintetica(cena.cartao);
+    if (passo == 0) {
+        // Cartão ainda chegando: metade do reflexo
+        leitura.clear = (uint16_t)((leitura.clear + AMBIENTE_CLEAR) / 2);
+        leitura.red = (uint16_t)((leitura.red + AMBIENTE_RED) / 2);
+        leitura.green = (uint16_t)((leitura.green + AMBIENTE_GREEN) / 2);
+        leitura.blue = (uint16_t)((leitura.blue + AMBIENTE_BLUE) / 2);
+    }
+    return leitura;
+}
+
+static uint16_t registrador16(uint8_t endereco) {
+    return (uint16_t)(sensor.registradores[endereco] | (sensor.registradores[endereco + 1] << 8));
+}
+
+static void escrever16(uint8_t endereco, uint16_t valor) {
+    sensor.registradores[endereco] = (uint8_t)valor;
+    sensor.registradores[endereco + 1] = (uint8_t)(valor >> 8);
+}
+
+static uint32_t ciclos_integracao(void) {
+    return 256u - sensor.registradores[TCS_ATIME];
+}
+
+/**
+ * @brief Integrações fora da janela exigidas pelo registrador PERS.
+ */
+static uint8_t persistencia_exigida(void) {
+    uint8_t pers = sensor.registradores[TCS_PERS] & 0x0F;
+    return pers <= 3 ? pers : (uint8_t)(5 * (pers - 3));
+}
+
+/**
+ * @brief Fim de uma integração: amostra a cena com a exposição programada.
+ */
+static void concluir_integracao(uint64_t t_us) {
+    static const uint8_t GANHOS[] = {1, 4, 16, 60};
+    uint32_t ciclos = ciclos_integracao();
+    uint32_t ganho = GANHOS[sensor.registradores[TCS_CONTROL] & 0x03];
+    uint32_t fundo = 1024u * ciclos > 65535u ? 65535u : 1024u * ciclos;
+    leitura_t luz = cena_em(t_us);
+    const uint16_t canais[] = {luz.clear, luz.red, luz.green, luz.blue};
+    for (int i = 0; i < 4; i++) {
+        uint32_t bruto = (uint32_t)canais[i] * ganho * ciclos / TCS_CICLOS_REFERENCIA;
+        escrever16((uint8_t)(TCS_CDATAL + 2 * i), (uint16_t)(bruto < fundo ? bruto : fundo));
+    }
+    sensor.registradores[TCS_STATUS] |= TCS_AVALID;
+
+    uint16_t clear = registrador16(TCS_CDATAL);
+    uint8_t exigida = persistencia_exigida();
+    bool fora = clear < registrador16(TCS_AILTL) || clear > registrador16(TCS_AILTL + 2);
+    sensor.fora_seguidas = fora ? (uint8_t)(sensor.fora_seguidas + 1) : 0;
+    if (exigida == 0 || sensor.fora_seguidas >= exigida) {
+        sensor.registradores[TCS_STATUS] |= TCS_AINT;
+    }
+}
+
+/**
+ * @brief Atualiza o sensor até o instante atual (as integrações são avaliadas sob demanda).
+ */
+static void avancar_sensor(void) {
+    uint64_t agora = sim_agora_us();
+    while (sensor.fim_integracao_us <= agora) {
+        concluir_integracao(sensor.fim_integracao_us);
+        uint8_t enable = sensor.registradores[TCS_ENABLE];
+        uint32_t espera = (enable & TCS_WEN) ? 256u - sensor.registradores[TCS_WTIME] : 0;
+        sensor.fim_integracao_us += (uint64_t)(espera + 1 + ciclos_integracao()) * TCS_CICLO_US;
+    }
+}
+
+static void sensor_escrever_enable(uint8_t valor) {
+    bool ativo_antes = (sensor.registradores[TCS_ENABLE] & (TCS_PON | TCS_AEN)) == (TCS_PON | TCS_AEN);
+    bool ativo = (valor & (TCS_PON | TCS_AEN)) == (TCS_PON | TCS_AEN);
+    sensor.registradores[TCS_ENABLE] = valor;
+    if (ativo && !ativo_antes) {
+        // Conversores religados: inicialização do ADC e uma integração completa
+        sensor.registradores[TCS_STATUS] &= (uint8_t)~TCS_AVALID;
+        sensor.fim_integracao_us = sim_agora_us() + (uint64_t)(1 + ciclos_integracao()) * TCS_CICLO_US;
+    } else if (!ativo) {
+        sensor.fim_integracao_us = SIM_PARA_SEMPRE;
+    }
+}
+
+/**
+ * @brief Aplica uma transação ao sensor.
+ */
+static void sensor_transacao(const uint8_t *escrita, uint16_t escrita_len, uint8_t *leitura, uint16_t leitura_len) {
+    avancar_sensor();
+    static uint8_t endereco = 0;
+    static bool auto_incremento = false;
+    if (escrita_len > 0) {
+        uint8_t comando = escrita[0];
+        if (!(comando & TCS_COMANDO)) {
+            return; // Sem o bit de comando o sensor ignora o byte
+        }
+        if ((comando & TCS_TIPO_MASCARA) == TCS_TIPO_FUNCAO_ESPECIAL) {
+            if ((comando & 0x1F) == TCS_FUNCAO_LIMPAR) {
+                sensor.registradores[TCS_STATUS] &= (uint8_t)~TCS_AINT;
+                sensor.fora_seguidas = 0;
+            }
+            return;
+        }
+        endereco = comando & 0x1F;
+        auto_incremento = (comando & TCS_TIPO_MASCARA) == TCS_TIPO_AUTO_INCREMENTO;
+        for (uint16_t i = 1; i < escrita_len; i++) {
+            if (endereco == TCS_ENABLE) {
+                sensor_escrever_enable(escrita[i]);
+            } else if (endereco < TCS_ID) {
+                sensor.registradores[endereco] = escrita[i];
+            }
+            if (auto_incremento) {
+                endereco = (endereco + 1) & 0x1F;
+            }
+        }
+    }
+    for (uint16_t i = 0; i < leitura_len; i++) {
+        leitura[i] = sensor.registradores[endereco];
+        if (auto_incremento) {
+            endereco = (endereco + 1) & 0x1F;
+        }
+    }
+}
+
+
+// --- Barramentos ---
+
+static inline barramento_t *obter_barramento(i2c_inst_t *i2c) {
+    return &barramentos[i2c_hw_index(i2c)];
+}
+
+static inline slot_transacao_t *obter_slot(barramento_t *b, i2c_dma_id_t id) {
+    return &b->fila[id % I2C_DMA_FILA_TAMANHO];
+}
+
+/**
+ * @brief Tempo de barramento de uma transação: 9 bits por byte (dado + ACK).
+ */
+static uint64_t duracao_us(const barramento_t *b, const i2c_dma_transacao_t *t) {
+    uint32_t bytes = 1u + (t->com_prefixo ? 1u : 0u) + t->escrita_len;
+    if (t->leitura_len > 0) {
+        bytes += 1u + t->leitura_len; // Repeated start e novo endereço
+    }
+    return (uint64_t)bytes * 9u * 1000000u / b->baudrate + SOBRECARGA_TRANSACAO_US;
+}
+
+static void iniciar_proxima(barramento_t *b);
+
+/**
+ * @brief Interrupção de fim da transação da cabeça: efeito no dispositivo e callback.
+ */
+static void concluir(void *arg) {
+    barramento_t *b = arg;
+    i2c_dma_id_t id = b->id_cabeca;
+    slot_transacao_t *slot = obter_slot(b, id);
+    const i2c_dma_transacao_t *t = &slot->transacao;
+
+    i2c_dma_resultado_t resultado = I2C_DMA_CONCLUIDA;
+    if (b == &barramentos[0] && t->endereco == TCS34725_ADDR) {
+        sensor_transacao(t->escrita, t->escrita_len, t->leitura, t->leitura_len);
+    } else if (b != &barramentos[1] || t->endereco != SSD1306_ENDERECO) {
+        resultado = I2C_DMA_ERRO_NAK;
+    }
+
+    slot->estado = resultado;
+    b->ativo = false;
+    b->id_cabeca++;
+    if (resultado == I2C_DMA_CONCLUIDA) {
+        b->estatisticas.concluidas++;
+    } else {
+        b->estatisticas.erros_nak++;
+    }
+    if (t->callback) {
+        t->callback(id, resultado, t->arg);
+    }
+    iniciar_proxima(b);
+    __sev();
+}
+
+static void iniciar_proxima(barramento_t *b) {
+    if (b->ativo || b->id_cabeca == b->proximo_id) {
+        return;
+    }
+    slot_transacao_t *slot = obter_slot(b, b->id_cabeca);
+    slot->estado = I2C_DMA_EM_ANDAMENTO;
+    b->ativo = true;
+    sim_agendar(sim_agora_us() + duracao_us(b, &slot->transacao), concluir, b, true);
+}
+
+bool sim_i2c_ocupado(uint barramento) {
+    return barramentos[barramento].id_cabeca != barramentos[barramento].proximo_id;
+}
+
+
+// --- API do motor (i2c_dma.h) ---
+
+void i2c_dma_init(i2c_inst_t *i2c, uint sda, uint scl, uint baudrate) {
+    (void)sda;
+    (void)scl;
+    barramento_t *b = obter_barramento(i2c);
+    b->baudrate = baudrate;
+    b->proximo_id = 1;
+    b->id_cabeca = 1;
+    b->ativo = false;
+    b->inicializado = true;
+    if (i2c_hw_index(i2c) == 0) {
+        sensor.registradores[TCS_ID] = 0x44;
+        sensor.fim_integracao_us = SIM_PARA_SEMPRE;
+    }
+}
+
+i2c_dma_id_t i2c_dma_enviar(i2c_inst_t *i2c, const i2c_dma_transacao_t *transacao) {
+    barramento_t *b = obter_barramento(i2c);
+    uint total = (transacao->com_prefixo ? 1 : 0) + transacao->escrita_len + transacao->leitura_len;
+    if (!b->inicializado || total == 0 || total > I2C_DMA_MAX_BYTES) {
+        return 0;
+    }
+    uint32_t interrupcoes = save_and_disable_interrupts();
+    if (b->proximo_id - b->id_cabeca >= I2C_DMA_FILA_TAMANHO) {
+        b->estatisticas.fila_cheia++;
+        restore_interrupts(interrupcoes);
+        return 0;
+    }
+    i2c_dma_id_t id = b->proximo_id++;
+    slot_transacao_t *slot = obter_slot(b, id);
+    slot->transacao = *transacao;
+    if (transacao->escrita_len <= I2C_DMA_DADOS_INLINE) {
+        memcpy(slot->dados_inline, transacao->escrita, transacao->escrita_len);
+        slot->transacao.escrita = slot->dados_inline;
+    }
+    slot->estado = I2C_DMA_PENDENTE;
+    iniciar_proxima(b);
+    restore_interrupts(interrupcoes);
+    return id;
+}
+
+i2c_dma_resultado_t i2c_dma_estado(i2c_inst_t *i2c, i2c_dma_id_t id) {
+    barramento_t *b = obter_barramento(i2c);
+    if (id == 0 || id >= b->proximo_id) {
+        return I2C_DMA_INVALIDA;
+    }
+    if (b->proximo_id - id > I2C_DMA_FILA_TAMANHO) {
+        return I2C_DMA_CONCLUIDA;
+    }
+    return obter_slot(b, id)->estado;
+}
+
+bool i2c_dma_em_curso(i2c_inst_t *i2c, i2c_dma_id_t id) {
+    i2c_dma_resultado_t estado = i2c_dma_estado(i2c, id);
+    return estado == I2C_DMA_PENDENTE || estado == I2C_DMA_EM_ANDAMENTO;
+}
+
+uint i2c_dma_livres(i2c_inst_t *i2c) {
+    barramento_t *b = obter_barramento(i2c);
+    return I2C_DMA_FILA_TAMANHO - (b->proximo_id - b->id_cabeca);
+}
+
+bool i2c_dma_ocupado(i2c_inst_t *i2c) {
+    return sim_i2c_ocupado(i2c_hw_index(i2c));
+}
+
+void i2c_dma_processar(void) {
+    // Os dispositivos simulados nunca travam o barramento: não há prazos a vigiar
+}
+
+absolute_time_t i2c_dma_proximo_prazo(void) {
+    return at_the_end_of_time;
+}
+
+i2c_dma_resultado_t i2c_dma_aguardar(i2c_inst_t *i2c, i2c_dma_id_t id) {
+    while (i2c_dma_em_curso(i2c, id)) {
+        sim_esperar_ate(SIM_PARA_SEMPRE, true);
+    }
+    return i2c_dma_estado(i2c, id);
+}
+
+void i2c_dma_obter_estatisticas(i2c_inst_t *i2c, i2c_dma_estatisticas_t *estatisticas) {
+    *estatisticas = obter_barramento(i2c)->estatisticas;
+}
@@ -0,0 +1,290 @@
+/**
+ * @file sim_medidas.c
+ * @brief Latências ponta a ponta e custo do loop, medidos no relógio virtual.
+ *
+ * As chamadas do main.c aos outros módulos que marcam as etapas são interceptadas no
+ * link (--wrap) e repassadas ao original:
+ *   cartão aproximado (cenário)  -> eventos_enviar(MSG_STATUS_CARTAO_LIDO)   detecção
+ *   cartão lido                  -> pedido de senha no OLED ("Senha (...)")  quando o
+ *                                   barramento do display termina o quadro
+ *   último dígito (cenário)      -> servo_start_move (abertura)
+ *   eventos_enviar/diario_registrar -> chegada do payload correspondente ao broker
+ * O custo do loop é o tempo de host gasto pelo Núcleo 0 (e suas interrupções) entre
+ * duas chamadas a energia_registrar_iteracao: no relógio virtual o código não consome tempo.
+ */
+
+#include "sim.h"
+#include "configura_geral.h"
+#include "mqtt_lwip.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+// --- Definições ---
+#define AMOSTRAS_MAXIMO 16384
+#define PREVISTOS_MAXIMO 256
+#define PAYLOAD_MAXIMO 128
+#define PREFIXO_PEDIDO_SENHA "Senha ("
+#define VERIFICACAO_DISPLAY_US 100      // Passo da espera pelo fim do quadro no barramento
+
+typedef struct {
+    const char *nome;
+    uint32_t quantidade;
+    uint32_t valores[AMOSTRAS_MAXIMO];  // us (latências) ou ns (custo do loop)
+} serie_t;
+
+/**
+ * @brief Publicação esperada no broker por causa de um evento do Núcleo 0.
+ */
+typedef struct {
+    uint64_t instante_us;
+    bool historico;
+    char topico[64];
+    char payload[PAYLOAD_MAXIMO];
+} previsto_t;
+
+
+// --- Estado ---
+static serie_t deteccao = {.nome = "cartao aproximado -> cartao lido"};
+static serie_t pedido_senha = {.nome = "cartao lido -> pedido de senha no OLED"};
+static serie_t abertura = {.nome = "ultimo digito -> comando do servo"};
+static serie_t broker_estado = {.nome = "evento de estado -> broker"};
+static serie_t broker_historico = {.nome = "evento de historico -> broker"};
+static serie_t iteracoes = {.nome = "iteracao do loop (custo no host)"};
+
+static uint64_t aproximado_us = 0;      // 0: nenhuma medida em aberto
+static uint64_t lido_us = 0;
+static bool pedido_exibido = false;
+static uint64_t digito_us = 0;
+static uint64_t custo_anterior_ns = 0;
+static uint32_t total_iteracoes = 0;
+
+static previsto_t previstos[PREVISTOS_MAXIMO];
+static uint quantidade_previstos = 0;
+static uint32_t coalescidos = 0;
+static uint32_t previstos_descartados = 0;
+static bool mostrar_broker = false;
+
+
+// --- Funções originais (--wrap) ---
+bool __real_eventos_enviar(uint8_t tipo, uint8_t cor, uint32_t argumento);
+bool __real_diario_registrar(uint8_t tipo, uint8_t cor);
+void __real_display_show_message(const char *line1, const char *line2, const char *line3);
+void __real_servo_start_move(int angle);
+void __real_energia_registrar_iteracao(void);
+
+
+// --- Funções Auxiliares ---
+
+static void registrar(serie_t *serie, uint64_t valor) {
+    if (serie->quantidade < AMOSTRAS_MAXIMO) {
+        serie->valores[serie->quantidade++] = valor > UINT32_MAX ? UINT32_MAX : (uint32_t)valor;
+    }
+}
+
+static void prever(uint8_t tipo, uint8_t cor, uint32_t argumento, bool historico) {
+    int topico = mqtt_topico_do_evento(tipo);
+    if (topico < 0) {
+        return;
+    }
+    if (quantidade_previstos == PREVISTOS_MAXIMO) {
+        previstos_descartados++;
+        return;
+    }
+    static const char *const TOPICOS[TOPICO_ID_QUANTIDADE] = {
+        [TOPICO_ID_STATUS] = TOPICO_STATUS,
+        [TOPICO_ID_HISTORICO] = TOPICO_HISTORICO,
+        [TOPICO_ID_HEARTBEAT] = TOPICO_HEARTBEAT,
+        [TOPICO_ID_CONEXAO] = TOPICO_CONEXAO,
+        [TOPICO_ID_DIAGNOSTICO] = TOPICO_DIAGNOSTICO,
+    };
+    previsto_t *previsto = &previstos[quantidade_previstos];
+    // O histórico sai do diário sem argumento (publicacoes.c)
+    if (mqtt_formatar_evento(tipo, cor, historico ? 0 : argumento, previsto->payload, sizeof(previsto->payload)) < 0) {
+        return;
+    }
+    snprintf(previsto->topico, sizeof(previsto->topico), "%s/%s", DEVICE_ID, TOPICOS[topico]);
+    previsto->instante_us = sim_agora_us();
+    previsto->historico = historico;
+    quantidade_previstos++;
+}
+
+static void remover_previsto(uint indice) {
+    memmove(&previstos[indice], &previstos[indice + 1], (quantidade_previstos - indice - 1) * sizeof(previsto_t));
+    quantidade_previstos--;
+}
+
+/**
+ * @brief Casa uma mensagem que chegou ao broker com o evento mais antigo igual.
+ * Estados anteriores do mesmo tópico ainda pendentes foram substituídos antes do envio.
+ */
+static void casar(uint64_t chegada_us, const char *topico, const char *mensagem) {
+    for (uint i = 0; i < quantidade_previstos; i++) {
+        previsto_t *previsto = &previstos[i];
+        if (strcmp(previsto->topico, topico) != 0 || strcmp(previsto->payload, mensagem) != 0) {
+            continue;
+        }
+        bool historico = previsto->historico;
+        registrar(historico ? &broker_historico : &broker_estado, chegada_us - previsto->instante_us);
+        remover_previsto(i);
+        if (!historico) {
+            for (uint j = 0; j < i;) {
+                if (!previstos[j].historico && strcmp(previstos[j].topico, topico) == 0) {
+                    coalescidos++;
+                    remover_previsto(j);
+                    i--;
+                } else {
+                    j++;
+                }
+            }
+        }
+        return;
+    }
+}
+
+static void observar_broker(uint64_t chegada_us, const char *topico, const char *payload, uint16_t tamanho) {
+    if (mostrar_broker) {
+        fprintf(stdout, "[%10.3f ms] broker <- %s: %.*s\n", chegada_us / 1000.0, topico, (int)tamanho, payload);
+    }
+    // Lotes do histórico: um evento por linha
+    char mensagem[PAYLOAD_MAXIMO];
+    uint16_t inicio = 0;
+    for (uint16_t i = 0; i <= tamanho; i++) {
+        if (i == tamanho || payload[i] == '\n') {
+            uint16_t comprimento = (uint16_t)(i - inicio);
+            if (comprimento < sizeof(mensagem)) {
+                memcpy(mensagem, payload + inicio, comprimento);
+                mensagem[comprimento] = '\0';
+                casar(chegada_us, topico, mensagem);
+            }
+            inicio = (uint16_t)(i + 1);
+        }
+    }
+}
+
+/**
+ * @brief O pedido de senha está na tela quando o display termina de receber o quadro.
+ */
+static void verificar_display(void *arg) {
+    (void)arg;
+    if (!pedido_exibido) {
+        return;
+    }
+    if (sim_i2c_ocupado(1)) {
+        sim_agendar(sim_agora_us() + VERIFICACAO_DISPLAY_US, verificar_display, NULL, false);
+        return;
+    }
+    registrar(&pedido_senha, sim_agora_us() - lido_us);
+    pedido_exibido = false;
+    lido_us = 0;
+}
+
+static int comparar(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static uint32_t percentil(const serie_t *serie, uint32_t p) {
+    return serie->valores[(serie->quantidade - 1) * p / 100];
+}
+
+static void imprimir(serie_t *serie, double escala, const char *unidade) {
+    if (serie->quantidade == 0) {
+        fprintf(stdout, "  %-42s sem amostras\n", serie->nome);
+        return;
+    }
+    uint64_t soma = 0;
+    for (uint32_t i = 0; i < serie->quantidade; i++) {
+        soma += serie->valores[i];
+    }
+    qsort(serie->valores, serie->quantidade, sizeof(uint32_t), comparar);
+    fprintf(stdout, "  %-42s n=%-5lu media %8.3f  p50 %8.3f  p95 %8.3f  p99 %8.3f  max %8.3f %s\n", serie->nome,
+           (unsigned long)serie->quantidade, (double)soma / serie->quantidade / escala, percentil(serie, 50) / escala,
+           percentil(serie, 95) / escala, percentil(serie, 99) / escala,
+           serie->valores[serie->quantidade - 1] / escala, unidade);
+}
+
+
+// --- Interceptações (--wrap) ---
+
+bool __wrap_eventos_enviar(uint8_t tipo, uint8_t cor, uint32_t argumento) {
+    if (tipo == MSG_STATUS_CARTAO_LIDO && aproximado_us != 0) {
+        registrar(&deteccao, sim_agora_us() - aproximado_us);
+        aproximado_us = 0;
+    }
+    if (tipo == MSG_STATUS_CARTAO_LIDO) {
+        lido_us = sim_agora_us();
+        pedido_exibido = false;
+        digito_us = 0; // Nova tentativa: uma senha anterior errada não abre mais nada
+    }
+    prever(tipo, cor, argumento, false);
+    return __real_eventos_enviar(tipo, cor, argumento);
+}
+
+bool __wrap_diario_registrar(uint8_t tipo, uint8_t cor) {
+    prever(tipo, cor, 0, true);
+    return __real_diario_registrar(tipo, cor);
+}
+
+void __wrap_display_show_message(const char *line1, const char *line2, const char *line3) {
+    __real_display_show_message(line1, line2, line3);
+    if (lido_us != 0 && !pedido_exibido && line1 && strncmp(line1, PREFIXO_PEDIDO_SENHA, strlen(PREFIXO_PEDIDO_SENHA)) == 0) {
+        pedido_exibido = true;
+        verificar_display(NULL);
+    }
+}
+
+void __wrap_servo_start_move(int angle) {
+    __real_servo_start_move(angle);
+    if (angle != 0 && digito_us != 0) { // 0 é a posição de fechado
+        registrar(&abertura, sim_agora_us() - digito_us);
+        digito_us = 0;
+    }
+}
+
+void __wrap_energia_registrar_iteracao(void) {
+    __real_energia_registrar_iteracao();
+    uint64_t custo_ns = sim_custo_nucleo0_ns();
+    if (total_iteracoes > 0) {
+        registrar(&iteracoes, custo_ns - custo_anterior_ns);
+    }
+    custo_anterior_ns = custo_ns;
+    total_iteracoes++;
+}
+
+
+// --- Implementação das Funções Públicas ---
+
+void sim_medidas_cartao_aproximado(void) {
+    aproximado_us = sim_agora_us();
+}
+
+void sim_medidas_ultimo_digito(void) {
+    digito_us = sim_agora_us();
+}
+
+void sim_medidas_iniciar(bool mostrar) {
+    mostrar_broker = mostrar;
+    sim_broker_observar(observar_broker);
+}
+
+void sim_medidas_relatorio(uint64_t duracao_us) {
+    fprintf(stdout, "\n=== Simulacao: %.3f s de tempo virtual ===\n", duracao_us / 1e6);
+    fprintf(stdout, "Latencias (ms):\n");
+    imprimir(&deteccao, 1000.0, "ms");
+    imprimir(&pedido_senha, 1000.0, "ms");
+    imprimir(&abertura, 1000.0, "ms");
+    imprimir(&broker_estado, 1000.0, "ms");
+    imprimir(&broker_historico, 1000.0, "ms");
+    uint32_t perdidos = 0;
+    for (uint i = 0; i < quantidade_previstos; i++) {
+        perdidos += previstos[i].historico ? 1u : 0u;
+    }
+    fprintf(stdout, "  estados substituidos antes do envio: %lu; historico sem chegada ao broker: %lu; nao acompanhados: %lu\n",
+           (unsigned long)coalescidos, (unsigned long)perdidos, (unsigned long)previstos_descartados);
+    fprintf(stdout, "Loop principal (Nucleo 0):\n");
+    imprimir(&iteracoes, 1000.0, "us");
+    fprintf(stdout, "  %lu iteracoes, %.1f por segundo virtual\n", (unsigned long)total_iteracoes,
+           duracao_us ? total_iteracoes * 1e6 / duracao_us : 0.0);
+}
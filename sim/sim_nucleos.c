@@ -0,0 +1,520 @@
+/**
+ * @file sim_nucleos.c
+ * @brief Relógio virtual, escalonador dos dois núcleos, interrupções, alarmes e FIFOs inter-core.
+ * Cada núcleo é uma corrotina com pilha própria. Um núcleo executa até esperar (WFE,
+ * sleep, espera ativa, FIFO); então o escalonador dispara os eventos vencidos, atende as
+ * interrupções do Núcleo 0 e retoma o outro núcleo. Quando nenhum dos dois pode executar,
+ * o relógio salta para o próximo evento ou prazo de espera. Nada depende do relógio do
+ * host, então a mesma entrada produz sempre a mesma execução.
+ */
+
+#include "sim.h"
+#include "pico/multicore.h"
+#include "pico/time.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <ucontext.h>
+
+
+// --- Definições ---
+#define NUCLEOS 2
+#define PILHA_NUCLEO (1024 * 1024)
+#define INTERRUPCOES_PENDENTES 64
+#define ALARMES 16                  // Como o pool padrão do SDK
+#define FIFO_PROFUNDIDADE 8
+
+typedef struct {
+    ucontext_t contexto;
+    void (*entrada)(void);
+    bool lancado;
+    bool terminou;
+    bool pronto;                // Executável sem esperar nada
+    uint64_t acordar_us;        // Fim da espera em curso
+    bool acorda_com_evento;     // A espera em curso é um WFE
+    bool evento;                // Registro de evento (SEV / interrupção)
+    uint32_t interrupcoes_off;  // Diferente de 0: interrupções desabilitadas
+} nucleo_t;
+
+typedef struct {
+    uint64_t instante;
+    uint32_t id;                // Também desempata eventos no mesmo instante (ordem de agendamento)
+    sim_acao_t acao;
+    void *arg;
+    bool interrupcao;
+} evento_t;
+
+typedef struct {
+    uint32_t id;
+    sim_acao_t acao;
+    void *arg;
+} interrupcao_t;
+
+typedef struct {
+    alarm_id_t id;              // 0: posição livre
+    uint32_t evento;
+    alarm_callback_t callback;
+    void *user_data;
+    uint64_t alvo_us;
+} alarme_t;
+
+typedef struct {
+    uint32_t dados[FIFO_PROFUNDIDADE];
+    uint cabeca;
+    uint quantidade;
+} fifo_t;
+
+
+// --- Estado ---
+static uint64_t agora_us = 0;
+static nucleo_t nucleos[NUCLEOS];
+static ucontext_t escalonador;
+static int atual = -1;              // -1: escalonador (e tratadores de interrupção, no Núcleo 0)
+static int ultimo_executado = NUCLEOS - 1;
+
+static evento_t *eventos = NULL;
+static size_t eventos_quantidade = 0, eventos_capacidade = 0;
+static uint32_t ultimo_id = 0;
+
+static irq_handler_t tratadores[NUM_IRQS];
+static bool habilitadas[NUM_IRQS];
+static uint32_t linhas_pendentes = 0;
+static interrupcao_t pendentes[INTERRUPCOES_PENDENTES];
+static uint pendentes_cabeca = 0, pendentes_quantidade = 0;
+
+static alarme_t alarmes[ALARMES];
+static alarm_id_t ultimo_alarme = 0;
+
+static fifo_t fifos[NUCLEOS];       // fifos[n]: dados recebidos pelo núcleo n
+
+// Tempo de host gasto no Núcleo 0 (código e interrupções)
+static uint64_t custo_nucleo0_ns = 0;
+static uint64_t inicio_medicao_ns = 0;
+static bool medindo = false;
+
+
+// --- Funções Auxiliares Estáticas ---
+
+static uint64_t host_ns(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000u + (uint64_t)t.tv_nsec;
+}
+
+static void iniciar_medicao(void) {
+    inicio_medicao_ns = host_ns();
+    medindo = true;
+}
+
+static void encerrar_medicao(void) {
+    custo_nucleo0_ns += host_ns() - inicio_medicao_ns;
+    medindo = false;
+}
+
+static uint nucleo_atual(void) {
+    return atual < 0 ? 0 : (uint)atual;
+}
+
+static void executar_nucleo(void) {
+    nucleo_t *n = &nucleos[atual];
+    n->entrada();
+    n->terminou = true; // O firmware não retorna; se retornar, o núcleo para
+    swapcontext(&n->contexto, &escalonador);
+}
+
+static void criar_nucleo(uint indice, void (*entrada)(void)) {
+    nucleo_t *n = &nucleos[indice];
+    memset(n, 0, sizeof(*n));
+    getcontext(&n->contexto);
+    n->contexto.uc_stack.ss_sp = malloc(PILHA_NUCLEO);
+    n->contexto.uc_stack.ss_size = PILHA_NUCLEO;
+    n->contexto.uc_link = NULL;
+    if (!n->contexto.uc_stack.ss_sp) {
+        panic("sem memoria para a pilha do nucleo %u", indice);
+    }
+    makecontext(&n->contexto, executar_nucleo, 0);
+    n->entrada = entrada;
+    n->acordar_us = SIM_PARA_SEMPRE;
+    n->lancado = true;
+    n->pronto = true;
+}
+
+static bool executavel(const nucleo_t *n) {
+    return n->lancado && !n->terminou &&
+           (n->pronto || agora_us >= n->acordar_us || (n->acorda_com_evento && n->evento));
+}
+
+static void retomar(int indice) {
+    nucleo_t *n = &nucleos[indice];
+    n->pronto = false;
+    atual = indice;
+    if (indice == 0) {
+        iniciar_medicao();
+    }
+    swapcontext(&escalonador, &n->contexto);
+    if (indice == 0) {
+        encerrar_medicao();
+    }
+    atual = -1;
+    ultimo_executado = indice;
+}
+
+static void enfileirar_interrupcao(uint32_t id, sim_acao_t acao, void *arg) {
+    if (pendentes_quantidade == INTERRUPCOES_PENDENTES) {
+        panic("interrupcoes pendentes demais");
+    }
+    pendentes[(pendentes_cabeca + pendentes_quantidade++) % INTERRUPCOES_PENDENTES] = (interrupcao_t){id, acao, arg};
+}
+
+static void disparar_eventos_vencidos(void) {
+    while (eventos_quantidade > 0 && eventos[0].instante <= agora_us) {
+        evento_t evento = eventos[0];
+        memmove(&eventos[0], &eventos[1], --eventos_quantidade * sizeof(evento_t));
+        if (evento.interrupcao) {
+            enfileirar_interrupcao(evento.id, evento.acao, evento.arg);
+        } else {
+            evento.acao(evento.arg);
+        }
+    }
+}
+
+static void atender_interrupcoes(void) {
+    while (pendentes_quantidade > 0 && nucleos[0].interrupcoes_off == 0) {
+        interrupcao_t interrupcao = pendentes[pendentes_cabeca];
+        pendentes_cabeca = (pendentes_cabeca + 1) % INTERRUPCOES_PENDENTES;
+        pendentes_quantidade--;
+        if (!interrupcao.acao) {
+            continue; // Cancelada depois de vencer
+        }
+        iniciar_medicao();
+        interrupcao.acao(interrupcao.arg);
+        encerrar_medicao();
+        nucleos[0].evento = true; // Uma interrupção tira o Núcleo 0 do WFE
+    }
+}
+
+static int proximo_nucleo(void) {
+    for (int i = 1; i <= NUCLEOS; i++) {
+        int indice = (ultimo_executado + i) % NUCLEOS;
+        if (executavel(&nucleos[indice])) {
+            return indice;
+        }
+    }
+    return -1;
+}
+
+static uint64_t proximo_instante(void) {
+    uint64_t proximo = eventos_quantidade > 0 ? eventos[0].instante : SIM_PARA_SEMPRE;
+    for (int i = 0; i < NUCLEOS; i++) {
+        const nucleo_t *n = &nucleos[i];
+        if (n->lancado && !n->terminou && n->acordar_us < proximo) {
+            proximo = n->acordar_us;
+        }
+    }
+    return proximo;
+}
+
+static void atender_linha(void *arg) {
+    uint irq = (uint)(uintptr_t)arg;
+    linhas_pendentes &= ~(1u << irq);
+    if (habilitadas[irq] && tratadores[irq]) {
+        tratadores[irq]();
+    }
+}
+
+
+// --- Escalonador ---
+
+uint64_t sim_agora_us(void) {
+    return agora_us;
+}
+
+void sim_nucleos_iniciar(void (*entrada)(void)) {
+    criar_nucleo(0, entrada);
+}
+
+void sim_executar_ate(uint64_t fim_us) {
+    while (agora_us < fim_us) {
+        disparar_eventos_vencidos();
+        atender_interrupcoes();
+        int indice = proximo_nucleo();
+        if (indice >= 0) {
+            retomar(indice);
+            continue;
+        }
+        uint64_t proximo = proximo_instante();
+        agora_us = proximo < fim_us ? proximo : fim_us;
+    }
+}
+
+bool sim_esperar_ate(uint64_t instante_us, bool acorda_com_evento) {
+    if (atual < 0) {
+        panic("espera bloqueante em contexto de interrupcao");
+    }
+    nucleo_t *n = &nucleos[atual];
+    if (acorda_com_evento && n->evento) {
+        n->evento = false; // WFE com o evento já registrado retorna na hora
+        return agora_us >= instante_us;
+    }
+    if (agora_us >= instante_us) {
+        return true;
+    }
+    n->acordar_us = instante_us;
+    n->acorda_com_evento = acorda_com_evento;
+    swapcontext(&n->contexto, &escalonador);
+    n->acordar_us = SIM_PARA_SEMPRE;
+    if (n->acorda_com_evento) {
+        n->evento = false;
+        n->acorda_com_evento = false;
+    }
+    return agora_us >= instante_us;
+}
+
+uint32_t sim_agendar(uint64_t instante_us, sim_acao_t acao, void *arg, bool interrupcao) {
+    if (eventos_quantidade == eventos_capacidade) {
+        eventos_capacidade = eventos_capacidade ? eventos_capacidade * 2 : 64;
+        eventos = realloc(eventos, eventos_capacidade * sizeof(evento_t));
+        if (!eventos) {
+            panic("sem memoria para os eventos");
+        }
+    }
+    if (instante_us < agora_us) {
+        instante_us = agora_us;
+    }
+    size_t posicao = eventos_quantidade;
+    while (posicao > 0 && eventos[posicao - 1].instante > instante_us) {
+        posicao--;
+    }
+    memmove(&eventos[posicao + 1], &eventos[posicao], (eventos_quantidade - posicao) * sizeof(evento_t));
+    if (++ultimo_id == 0) {
+        ultimo_id = 1;
+    }
+    eventos[posicao] = (evento_t){instante_us, ultimo_id, acao, arg, interrupcao};
+    eventos_quantidade++;
+    return ultimo_id;
+}
+
+bool sim_cancelar(uint32_t id) {
+    for (size_t i = 0; i < eventos_quantidade; i++) {
+        if (eventos[i].id == id) {
+            memmove(&eventos[i], &eventos[i + 1], (--eventos_quantidade - i) * sizeof(evento_t));
+            return true;
+        }
+    }
+    // Já vencido, aguardando o atendimento da interrupção
+    for (uint i = 0; i < pendentes_quantidade; i++) {
+        interrupcao_t *pendente = &pendentes[(pendentes_cabeca + i) % INTERRUPCOES_PENDENTES];
+        if (pendente->id == id) {
+            pendente->acao = NULL;
+            pendente->id = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+void sim_irq_sinalizar(uint irq) {
+    if (irq >= NUM_IRQS || (linhas_pendentes & (1u << irq))) {
+        return;
+    }
+    linhas_pendentes |= 1u << irq;
+    enfileirar_interrupcao(0, atender_linha, (void *)(uintptr_t)irq);
+}
+
+uint64_t sim_custo_nucleo0_ns(void) {
+    return custo_nucleo0_ns + (medindo ? host_ns() - inicio_medicao_ns : 0);
+}
+
+
+// --- pico.h / hardware/sync.h / hardware/irq.h ---
+
+uint get_core_num(void) {
+    return nucleo_atual();
+}
+
+void tight_loop_contents(void) {
+    if (atual >= 0) {
+        sim_esperar_ate(agora_us + 1, false);
+    }
+}
+
+void panic(const char *formato, ...) {
+    va_list argumentos;
+    va_start(argumentos, formato);
+    fprintf(stderr, "[%10.6f] PANIC: ", agora_us / 1e6);
+    vfprintf(stderr, formato, argumentos);
+    fputc('\n', stderr);
+    va_end(argumentos);
+    exit(2);
+}
+
+void __wfe(void) {
+    sim_esperar_ate(SIM_PARA_SEMPRE, true);
+}
+
+void __sev(void) {
+    for (int i = 0; i < NUCLEOS; i++) {
+        nucleos[i].evento = true;
+    }
+}
+
+uint32_t save_and_disable_interrupts(void) {
+    nucleo_t *n = &nucleos[nucleo_atual()];
+    uint32_t estado = n->interrupcoes_off;
+    n->interrupcoes_off = 1;
+    return estado;
+}
+
+void restore_interrupts(uint32_t estado) {
+    nucleos[nucleo_atual()].interrupcoes_off = estado;
+}
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler) {
+    if (num >= NUM_IRQS || (tratadores[num] && tratadores[num] != handler)) {
+        panic("irq %u: tratador ja registrado", num);
+    }
+    tratadores[num] = handler;
+}
+
+void irq_set_enabled(uint num, bool enabled) {
+    if (num < NUM_IRQS) {
+        habilitadas[num] = enabled;
+    }
+}
+
+
+// --- pico/time.h ---
+
+uint64_t time_us_64(void) {
+    return agora_us;
+}
+
+uint32_t time_us_32(void) {
+    return (uint32_t)agora_us;
+}
+
+void sleep_us(uint64_t us) {
+    sim_esperar_ate(delayed_by_us(agora_us, us), false);
+}
+
+void sleep_ms(uint32_t ms) {
+    sleep_us((uint64_t)ms * 1000);
+}
+
+void busy_wait_us(uint64_t us) {
+    sleep_us(us);
+}
+
+void busy_wait_us_32(uint32_t us) {
+    sleep_us(us);
+}
+
+bool best_effort_wfe_or_timeout(absolute_time_t prazo) {
+    if (time_reached(prazo)) {
+        return true;
+    }
+    return sim_esperar_ate(prazo, true);
+}
+
+static void disparar_alarme(void *arg) {
+    alarme_t *alarme = (alarme_t *)arg;
+    alarm_id_t id = alarme->id;
+    alarme->evento = 0;
+    int64_t reagendar = alarme->callback(id, alarme->user_data);
+    if (alarme->id != id) {
+        return; // Cancelado pelo próprio callback
+    }
+    if (reagendar < 0) {
+        alarme->alvo_us += (uint64_t)-reagendar;
+    } else if (reagendar > 0) {
+        alarme->alvo_us = agora_us + (uint64_t)reagendar;
+    } else {
+        alarme->id = 0;
+        return;
+    }
+    alarme->evento = sim_agendar(alarme->alvo_us, disparar_alarme, alarme, true);
+}
+
+alarm_id_t add_alarm_at(absolute_time_t instante, alarm_callback_t callback, void *user_data, bool fire_if_past) {
+    if (instante <= agora_us && !fire_if_past) {
+        return 0;
+    }
+    for (int i = 0; i < ALARMES; i++) {
+        alarme_t *alarme = &alarmes[i];
+        if (alarme->id == 0) {
+            ultimo_alarme = (ultimo_alarme == INT32_MAX) ? 1 : ultimo_alarme + 1;
+            *alarme = (alarme_t){ultimo_alarme, 0, callback, user_data, instante};
+            alarme->evento = sim_agendar(instante, disparar_alarme, alarme, true);
+            return alarme->id;
+        }
+    }
+    return -1; // Sem alarmes livres
+}
+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past) {
+    return add_alarm_at(delayed_by_us(agora_us, us), callback, user_data, fire_if_past);
+}
+
+bool cancel_alarm(alarm_id_t alarm_id) {
+    for (int i = 0; i < ALARMES; i++) {
+        alarme_t *alarme = &alarmes[i];
+        if (alarm_id > 0 && alarme->id == alarm_id) {
+            if (alarme->evento) {
+                sim_cancelar(alarme->evento);
+            }
+            alarme->id = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+// --- pico/multicore.h ---
+
+void multicore_launch_core1(void (*entrada)(void)) {
+    criar_nucleo(1, entrada);
+}
+
+bool multicore_fifo_rvalid(void) {
+    return fifos[nucleo_atual()].quantidade > 0;
+}
+
+bool multicore_fifo_wready(void) {
+    return fifos[1 - nucleo_atual()].quantidade < FIFO_PROFUNDIDADE;
+}
+
+void multicore_fifo_push_blocking(uint32_t dado) {
+    uint destino = 1 - nucleo_atual();
+    fifo_t *fifo = &fifos[destino];
+    while (fifo->quantidade == FIFO_PROFUNDIDADE) {
+        tight_loop_contents();
+    }
+    fifo->dados[(fifo->cabeca + fifo->quantidade++) % FIFO_PROFUNDIDADE] = dado;
+    __sev();
+    if (destino == 0) {
+        sim_irq_sinalizar(SIO_IRQ_PROC0);
+    }
+}
+
+uint32_t multicore_fifo_pop_blocking(void) {
+    fifo_t *fifo = &fifos[nucleo_atual()];
+    while (fifo->quantidade == 0) {
+        __wfe();
+    }
+    uint32_t dado = fifo->dados[fifo->cabeca];
+    fifo->cabeca = (fifo->cabeca + 1) % FIFO_PROFUNDIDADE;
+    fifo->quantidade--;
+    return dado;
+}
+
+void multicore_fifo_drain(void) {
+    fifos[nucleo_atual()].quantidade = 0;
+}
+
+void multicore_fifo_clear_irq(void) {
+}
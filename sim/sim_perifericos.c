@@ -0,0 +1,456 @@
+/**
+ * @file sim_perifericos.c
+ * @brief Modelos dos periféricos simples: GPIO, PWM, DMA, PIO (com a varredura do teclado),
+ * flash, relógios, SysTick e gerador aleatório.
+ * Saídas sem observador (LEDs, buzzer, servo) só guardam os registradores; a medida do
+ * servo é feita na chamada do driver (sim_medidas.c).
+ */
+
+#include "sim.h"
+#include "pico/stdlib.h"
+#include "pico/rand.h"
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/flash.h"
+#include "hardware/irq.h"
+#include "hardware/pio.h"
+#include "hardware/pwm.h"
+#include "hardware/structs/systick.h"
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+
+// --- Definições ---
+#define GPIOS 30
+#define RELOGIO_SISTEMA_HZ 125000000u
+#define PIO_FIFO_RX 8                   // FIFO RX unida (TX + RX)
+#define WS2812_US_POR_PALAVRA 30        // 24 bits a 800kHz por LED
+#define FLASH_APAGAR_SETOR_US 45000     // Tempos típicos do W25Q16JV
+#define FLASH_GRAVAR_PAGINA_US 400
+
+typedef struct {
+    bool reivindicado;
+    uint dreq;
+    uint64_t fim_us;                    // Ocupado até este instante
+} canal_dma_t;
+
+typedef struct {
+    uint32_t fifo_rx[PIO_FIFO_RX];
+    uint cabeca;
+    uint quantidade;
+    bool habilitada;
+} maquina_pio_t;
+
+typedef struct {
+    uint8_t programas;                  // Instruções já ocupadas
+    uint8_t reivindicadas;              // Máscara de máquinas em uso
+    uint8_t fontes_irq0;                // Máscara de FIFOs RX que sinalizam PIOx_IRQ_0
+    maquina_pio_t maquinas[4];
+} bloco_pio_t;
+
+
+// --- Estado ---
+static bool gpio_nivel[GPIOS];
+static pwm_hw_t pwm_registradores;
+pwm_hw_t *const pwm_hw = &pwm_registradores;
+static systick_hw_t systick_registradores;
+systick_hw_t *const systick_hw = &systick_registradores;
+
+static canal_dma_t canais[NUM_DMA_CHANNELS];
+static uint32_t temporizador_taxa_hz[NUM_DMA_TIMERS];
+static uint8_t temporizadores_reivindicados = 0;
+
+pio_hw_t pio0_hw_s = {.indice = 0};
+pio_hw_t pio1_hw_s = {.indice = 1};
+static bloco_pio_t blocos[2];
+
+static uint32_t semente = 0x2545F491u;
+
+// Teclado físico: bit (3 - linha) * 4 + coluna, como em keypad.c
+static const char TECLAS[4][4] = {
+    {'D', 'C', 'B', 'A'},
+    {'#', '9', '6', '3'},
+    {'0', '8', '5', '2'},
+    {'*', '7', '4', '1'}
+};
+static uint16_t teclas_pressionadas = 0;
+
+// Máquina de estados do teclado: mesma lógica de keypad.pio (X = candidato, Y = estável)
+static struct {
+    PIO pio;
+    uint sm;
+    uint32_t periodo_us;
+    uint32_t candidato;
+    uint32_t estavel;
+} varredura;
+
+
+// --- GPIO ---
+
+void gpio_init(uint gpio) {
+    gpio_nivel[gpio] = false;
+}
+
+void gpio_set_dir(uint gpio, bool saida) {
+    (void)gpio;
+    (void)saida;
+}
+
+void gpio_put(uint gpio, bool valor) {
+    gpio_nivel[gpio] = valor;
+}
+
+bool gpio_get(uint gpio) {
+    return gpio_nivel[gpio];
+}
+
+void gpio_pull_up(uint gpio) {
+    gpio_nivel[gpio] = true;
+}
+
+void gpio_set_function(uint gpio, enum gpio_function funcao) {
+    (void)gpio;
+    (void)funcao;
+}
+
+
+// --- PWM ---
+
+void pwm_set_clkdiv(uint fatia, float divisor) {
+    pwm_hw->slice[fatia].div = (uint32_t)(divisor * 16.0f);
+}
+
+void pwm_set_clkdiv_int_frac(uint fatia, uint8_t inteiro, uint8_t fracao) {
+    pwm_hw->slice[fatia].div = ((uint32_t)inteiro << 4) | (fracao & 0xFu);
+}
+
+void pwm_set_wrap(uint fatia, uint16_t wrap) {
+    pwm_hw->slice[fatia].top = wrap;
+}
+
+void pwm_set_chan_level(uint fatia, uint canal, uint16_t nivel) {
+    uint32_t cc = pwm_hw->slice[fatia].cc;
+    uint deslocamento = canal ? 16u : 0u;
+    pwm_hw->slice[fatia].cc = (cc & ~(0xFFFFu << deslocamento)) | ((uint32_t)nivel << deslocamento);
+}
+
+void pwm_set_gpio_level(uint gpio, uint16_t nivel) {
+    pwm_set_chan_level(pwm_gpio_to_slice_num(gpio), pwm_gpio_to_channel(gpio), nivel);
+}
+
+void pwm_set_enabled(uint fatia, bool habilitada) {
+    pwm_hw->slice[fatia].csr = habilitada ? 1u : 0u;
+}
+
+
+// --- DMA ---
+
+int dma_claim_unused_channel(bool required) {
+    for (int canal = 0; canal < NUM_DMA_CHANNELS; canal++) {
+        if (!canais[canal].reivindicado) {
+            canais[canal].reivindicado = true;
+            return canal;
+        }
+    }
+    if (required) {
+        panic("sem canais de DMA livres");
+    }
+    return -1;
+}
+
+dma_channel_config dma_channel_get_default_config(uint canal) {
+    (void)canal;
+    return (dma_channel_config){0, DREQ_FORCE};
+}
+
+void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size tamanho) {
+    (void)c;
+    (void)tamanho;
+}
+
+void channel_config_set_read_increment(dma_channel_config *c, bool incrementa) {
+    (void)c;
+    (void)incrementa;
+}
+
+void channel_config_set_write_increment(dma_channel_config *c, bool incrementa) {
+    (void)c;
+    (void)incrementa;
+}
+
+void channel_config_set_dreq(dma_channel_config *c, uint dreq) {
+    c->dreq = dreq;
+}
+
+/**
+ * @brief Duração de uma transferência pelo ritmo do seu DREQ.
+ */
+static uint64_t duracao_transferencia_us(uint dreq, uint32_t quantidade) {
+    if (dreq >= DREQ_DMA_TIMER0 && dreq < DREQ_DMA_TIMER0 + NUM_DMA_TIMERS) {
+        uint32_t taxa = temporizador_taxa_hz[dreq - DREQ_DMA_TIMER0];
+        return taxa ? ((uint64_t)quantidade * 1000000u) / taxa : 0;
+    }
+    if (dreq < DREQ_PIO1_TX0 + 8) {
+        return (uint64_t)quantidade * WS2812_US_POR_PALAVRA; // Só a matriz de LEDs alimenta um PIO por DMA
+    }
+    return 0;
+}
+
+void dma_channel_configure(uint canal, const dma_channel_config *c, volatile void *destino,
+                           const volatile void *origem, uint quantidade, bool iniciar) {
+    (void)destino;
+    canais[canal].dreq = c->dreq;
+    if (iniciar) {
+        dma_channel_transfer_from_buffer_now(canal, origem, quantidade);
+    }
+}
+
+void dma_channel_transfer_from_buffer_now(uint canal, const volatile void *origem, uint32_t quantidade) {
+    (void)origem;
+    canais[canal].fim_us = sim_agora_us() + duracao_transferencia_us(canais[canal].dreq, quantidade);
+}
+
+bool dma_channel_is_busy(uint canal) {
+    return sim_agora_us() < canais[canal].fim_us;
+}
+
+void dma_channel_abort(uint canal) {
+    canais[canal].fim_us = 0;
+}
+
+void dma_channel_wait_for_finish_blocking(uint canal) {
+    sim_esperar_ate(canais[canal].fim_us, false);
+}
+
+int dma_claim_unused_timer(bool required) {
+    for (int temporizador = 0; temporizador < NUM_DMA_TIMERS; temporizador++) {
+        if (!(temporizadores_reivindicados & (1u << temporizador))) {
+            temporizadores_reivindicados |= 1u << temporizador;
+            return temporizador;
+        }
+    }
+    if (required) {
+        panic("sem temporizadores de DMA livres");
+    }
+    return -1;
+}
+
+void dma_timer_set_fraction(uint temporizador, uint16_t numerador, uint16_t denominador) {
+    temporizador_taxa_hz[temporizador] = denominador ? (uint32_t)(((uint64_t)RELOGIO_SISTEMA_HZ * numerador) / denominador) : 0;
+}
+
+
+// --- PIO ---
+
+uint pio_add_program(PIO pio, const pio_program_t *programa) {
+    bloco_pio_t *bloco = &blocos[pio->indice];
+    if (bloco->programas + programa->length > 32) {
+        panic("PIO%u: sem espaco para o programa", pio->indice);
+    }
+    uint offset = bloco->programas;
+    bloco->programas += programa->length;
+    return offset;
+}
+
+int pio_claim_unused_sm(PIO pio, bool required) {
+    bloco_pio_t *bloco = &blocos[pio->indice];
+    for (int sm = 0; sm < 4; sm++) {
+        if (!(bloco->reivindicadas & (1u << sm))) {
+            bloco->reivindicadas |= 1u << sm;
+            return sm;
+        }
+    }
+    if (required) {
+        panic("PIO%u: sem maquinas de estados livres", pio->indice);
+    }
+    return -1;
+}
+
+void pio_gpio_init(PIO pio, uint gpio) {
+    gpio_set_function(gpio, pio->indice ? GPIO_FUNC_PIO1 : GPIO_FUNC_PIO0);
+}
+
+void pio_sm_init(PIO pio, uint sm, uint offset, const pio_sm_config *config) {
+    (void)offset;
+    (void)config;
+    maquina_pio_t *maquina = &blocos[pio->indice].maquinas[sm];
+    maquina->quantidade = 0;
+    maquina->habilitada = false;
+}
+
+void pio_sm_set_enabled(PIO pio, uint sm, bool habilitada) {
+    blocos[pio->indice].maquinas[sm].habilitada = habilitada;
+}
+
+void pio_sm_set_consecutive_pindirs(PIO pio, uint sm, uint base, uint quantidade, bool saida) {
+    (void)pio;
+    (void)sm;
+    (void)base;
+    (void)quantidade;
+    (void)saida;
+}
+
+void pio_sm_put(PIO pio, uint sm, uint32_t dado) {
+    pio->txf[sm] = dado;
+}
+
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t dado) {
+    pio_sm_put(pio, sm, dado);
+}
+
+uint32_t pio_sm_get(PIO pio, uint sm) {
+    maquina_pio_t *maquina = &blocos[pio->indice].maquinas[sm];
+    if (maquina->quantidade == 0) {
+        return 0; // FIFO vazia: o hardware também devolve lixo
+    }
+    uint32_t dado = maquina->fifo_rx[maquina->cabeca];
+    maquina->cabeca = (maquina->cabeca + 1) % PIO_FIFO_RX;
+    maquina->quantidade--;
+    return dado;
+}
+
+bool pio_sm_is_rx_fifo_empty(PIO pio, uint sm) {
+    return blocos[pio->indice].maquinas[sm].quantidade == 0;
+}
+
+void pio_set_irq0_source_enabled(PIO pio, enum pio_interrupt_source fonte, bool habilitada) {
+    bloco_pio_t *bloco = &blocos[pio->indice];
+    if (habilitada) {
+        bloco->fontes_irq0 |= (uint8_t)(1u << fonte);
+    } else {
+        bloco->fontes_irq0 &= (uint8_t)~(1u << fonte);
+    }
+}
+
+void sim_pio_empurrar(PIO pio, uint sm, uint32_t dado) {
+    bloco_pio_t *bloco = &blocos[pio->indice];
+    maquina_pio_t *maquina = &bloco->maquinas[sm];
+    if (maquina->quantidade == PIO_FIFO_RX) {
+        return; // push noblock
+    }
+    maquina->fifo_rx[(maquina->cabeca + maquina->quantidade++) % PIO_FIFO_RX] = dado;
+    if (bloco->fontes_irq0 & (1u << sm)) {
+        sim_irq_sinalizar(pio_get_irq_num(pio, 0));
+    }
+}
+
+
+// --- Teclado (máquina de estados de keypad.pio) ---
+
+/**
+ * @brief Uma varredura: o estado só vai para a FIFO quando duas varreduras seguidas
+ * concordam e ele difere do último enviado.
+ */
+static void varrer_teclado(void *arg) {
+    (void)arg;
+    if (blocos[varredura.pio->indice].maquinas[varredura.sm].habilitada) {
+        uint32_t leitura = (uint16_t)~teclas_pressionadas; // Tecla pressionada lê 0
+        if (leitura != varredura.candidato) {
+            varredura.candidato = leitura;
+        } else if (leitura != varredura.estavel) {
+            varredura.estavel = leitura;
+            sim_pio_empurrar(varredura.pio, varredura.sm, leitura);
+        }
+    }
+    sim_agendar(sim_agora_us() + varredura.periodo_us, varrer_teclado, NULL, false);
+}
+
+void sim_teclado_iniciar(PIO pio, uint sm, uint32_t periodo_us) {
+    varredura.pio = pio;
+    varredura.sm = sm;
+    varredura.periodo_us = periodo_us;
+    varredura.candidato = 0;
+    varredura.estavel = 0;      // Como o Y zerado do PIO: o primeiro estado (nenhuma tecla) é enviado
+    sim_agendar(sim_agora_us() + periodo_us, varrer_teclado, NULL, false);
+}
+
+bool sim_teclado_mudar(char tecla, bool pressionada) {
+    for (uint linha = 0; linha < 4; linha++) {
+        for (uint coluna = 0; coluna < 4; coluna++) {
+            if (TECLAS[linha][coluna] == tecla) {
+                uint16_t bit = (uint16_t)(1u << ((3 - linha) * 4 + coluna));
+                teclas_pressionadas = pressionada ? (teclas_pressionadas | bit) : (teclas_pressionadas & ~bit);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+
+// --- Flash ---
+
+bool sim_flash_iniciar(const char *arquivo) {
+    void *desejado = (void *)(uintptr_t)XIP_BASE;
+    void *mapa;
+    if (arquivo) {
+        int fd = open(arquivo, O_RDWR | O_CREAT, 0644);
+        if (fd < 0) {
+            return false;
+        }
+        off_t tamanho = lseek(fd, 0, SEEK_END);
+        if (tamanho < (off_t)PICO_FLASH_SIZE_BYTES) {
+            // Arquivo novo: flash apagada
+            static uint8_t apagado[FLASH_SECTOR_SIZE];
+            memset(apagado, 0xFF, sizeof(apagado));
+            for (off_t posicao = tamanho & ~(off_t)(FLASH_SECTOR_SIZE - 1); posicao < (off_t)PICO_FLASH_SIZE_BYTES;
+                 posicao += FLASH_SECTOR_SIZE) {
+                if (pwrite(fd, apagado, FLASH_SECTOR_SIZE, posicao) != FLASH_SECTOR_SIZE) {
+                    close(fd);
+                    return false;
+                }
+            }
+        }
+        mapa = mmap(desejado, PICO_FLASH_SIZE_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED_NOREPLACE, fd, 0);
+        close(fd);
+    } else {
+        mapa = mmap(desejado, PICO_FLASH_SIZE_BYTES, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+        if (mapa == desejado) {
+            memset(mapa, 0xFF, PICO_FLASH_SIZE_BYTES);
+        }
+    }
+    return mapa == desejado;
+}
+
+void flash_range_erase(uint32_t offset, size_t tamanho) {
+    if (offset % FLASH_SECTOR_SIZE || tamanho % FLASH_SECTOR_SIZE || offset + tamanho > PICO_FLASH_SIZE_BYTES) {
+        panic("flash_range_erase fora do alinhamento: %lu +%lu", (unsigned long)offset, (unsigned long)tamanho);
+    }
+    memset((uint8_t *)(uintptr_t)(XIP_BASE + offset), 0xFF, tamanho);
+    busy_wait_us((uint64_t)(tamanho / FLASH_SECTOR_SIZE) * FLASH_APAGAR_SETOR_US);
+}
+
+void flash_range_program(uint32_t offset, const uint8_t *dados, size_t tamanho) {
+    if (offset % FLASH_PAGE_SIZE || tamanho % FLASH_PAGE_SIZE || offset + tamanho > PICO_FLASH_SIZE_BYTES) {
+        panic("flash_range_program fora do alinhamento: %lu +%lu", (unsigned long)offset, (unsigned long)tamanho);
+    }
+    // A gravação só leva bits de 1 para 0
+    uint8_t *destino = (uint8_t *)(uintptr_t)(XIP_BASE + offset);
+    for (size_t i = 0; i < tamanho; i++) {
+        destino[i] &= dados[i];
+    }
+    busy_wait_us((uint64_t)(tamanho / FLASH_PAGE_SIZE) * FLASH_GRAVAR_PAGINA_US);
+}
+
+
+// --- Relógios, gerador aleatório e stdio ---
+
+uint32_t clock_get_hz(enum clock_index relogio) {
+    (void)relogio;
+    return RELOGIO_SISTEMA_HZ;
+}
+
+uint32_t get_rand_32(void) {
+    // xorshift32: sequência fixa, execuções reprodutíveis
+    semente ^= semente << 13;
+    semente ^= semente >> 17;
+    semente ^= semente << 5;
+    return semente;
+}
+
+bool stdio_init_all(void) {
+    return true;
+}
@@ -0,0 +1,132 @@
+/**
+ * @file sim_principal.c
+ * @brief Ponto de entrada do simulador da fechadura no host.
+ *
+ * Uso: simulador_fechadura [-s|--silencioso] [--broker] [--flash arquivo] [--tracos csv] <cenario>
+ *   -s, --silencioso  não mostra a saída serial do firmware
+ *   --broker          mostra as mensagens que chegam ao broker
+ *   --flash arquivo   flash persistente entre execuções (padrão: apagada a cada execução)
+ *   --tracos csv      traços do sensor (padrão: scripts/tracos-classificador.csv)
+ *
+ * A saída serial do firmware (printf/puts/putchar, interceptados no link) recebe o
+ * instante virtual no começo de cada linha.
+ */
+
+#include "sim.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+
+// --- Estado ---
+static bool silencioso = false;
+static bool inicio_de_linha = true;
+
+int firmware_main(void); // main() do firmware, renomeado na compilação de main.c
+
+
+// --- Saída serial (--wrap) ---
+
+static void prefixar(void) {
+    if (inicio_de_linha) {
+        fprintf(stdout, "[%10.3f ms] ", sim_agora_us() / 1000.0);
+        inicio_de_linha = false;
+    }
+}
+
+static void escrever(const char *texto, size_t tamanho) {
+    for (size_t i = 0; i < tamanho; i++) {
+        prefixar();
+        fputc(texto[i], stdout);
+        if (texto[i] == '\n') {
+            inicio_de_linha = true;
+        }
+    }
+}
+
+int __wrap_printf(const char *formato, ...) {
+    char texto[512];
+    va_list argumentos;
+    va_start(argumentos, formato);
+    int tamanho = vsnprintf(texto, sizeof(texto), formato, argumentos);
+    va_end(argumentos);
+    if (!silencioso && tamanho > 0) {
+        escrever(texto, (size_t)tamanho < sizeof(texto) ? (size_t)tamanho : sizeof(texto) - 1);
+    }
+    return tamanho;
+}
+
+int __wrap_puts(const char *texto) {
+    if (!silencioso) {
+        escrever(texto, strlen(texto));
+        escrever("\n", 1);
+    }
+    return 1;
+}
+
+int __wrap_putchar(int caractere) {
+    if (!silencioso) {
+        char c = (char)caractere;
+        escrever(&c, 1);
+    }
+    return caractere;
+}
+
+
+/**
+ * @brief Núcleo 0: o main() do firmware nunca retorna; se retornar, a simulação para.
+ */
+static void nucleo0(void) {
+    firmware_main();
+    panic("main() do firmware retornou");
+}
+
+
+int main(int argc, char **argv) {
+    const char *cenario = NULL;
+    const char *flash = NULL;
+    const char *tracos = SIM_TRACOS_PADRAO;
+    bool mostrar_broker = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0 || strcmp(argv[i], "--silencioso") == 0) {
+            silencioso = true;
+        } else if (strcmp(argv[i], "--broker") == 0) {
+            mostrar_broker = true;
+        } else if (strcmp(argv[i], "--flash") == 0 && i + 1 < argc) {
+            flash = argv[++i];
+        } else if (strcmp(argv[i], "--tracos") == 0 && i + 1 < argc) {
+            tracos = argv[++i];
+        } else if (argv[i][0] != '-' && !cenario) {
+            cenario = argv[i];
+        } else {
+            cenario = NULL;
+            break;
+        }
+    }
+    if (!cenario) {
+        fprintf(stderr, "uso: %s [-s|--silencioso] [--broker] [--flash arquivo] [--tracos csv] <cenario>\n", argv[0]);
+        return 1;
+    }
+
+    if (!sim_flash_iniciar(flash)) {
+        fprintf(stderr, "nao foi possivel mapear a flash em 0x%08x\n", (unsigned)XIP_BASE);
+        return 1;
+    }
+    if (!sim_sensor_carregar_tracos(tracos)) {
+        fprintf(stderr, "sem tracos em %s: cartoes sintetizados pelos centroides de fabrica\n", tracos);
+    }
+    sim_medidas_iniciar(mostrar_broker);
+
+    uint64_t fim_us;
+    if (!sim_cenario_carregar(cenario, &fim_us)) {
+        return 1;
+    }
+    sim_nucleos_iniciar(nucleo0);
+    sim_executar_ate(fim_us);
+    if (!inicio_de_linha) {
+        fputc('\n', stdout);
+    }
+    sim_medidas_relatorio(fim_us);
+    return 0;
+}
@@ -0,0 +1,406 @@
+/**
+ * @file sim_rede.c
+ * @brief Modelo do enlace Wi-Fi (CYW43) e de um broker MQTT local.
+ *
+ * A associação leva o tempo de uma varredura completa, ou menos com BSSID e canal em
+ * cache, seguida do DHCP. O cliente MQTT segue a semântica da lwIP usada pelo firmware:
+ * as respostas (CONNACK, SUBACK, PUBACK e publicações recebidas) só são entregues dentro
+ * de cyw43_arch_poll, no núcleo que faz o polling; mqtt_disconnect descarta as
+ * requisições pendentes sem chamar callbacks; e uma publicação ocupa uma das
+ * MQTT_REQ_MAX_IN_FLIGHT requisições até o PUBACK. Cada conexão é uma sessão: o que
+ * estava a caminho numa sessão anterior (ou durante uma queda da rede) se perde.
+ */
+
+#include "sim.h"
+#include "configura_geral.h"
+#include "pico/cyw43_arch.h"
+#include "pico/time.h"
+#include "lwip/apps/mqtt.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+// --- Definições ---
+#define ASSOCIACAO_VARREDURA_US 1500000 // Varredura de todos os canais + autenticação WPA2
+#define ASSOCIACAO_CACHE_US 300000      // BSSID e canal conhecidos: sem varredura
+#define DHCP_US 400000
+#define INICIO_CHIP_MS 250              // Carga do firmware do CYW43
+#define LATENCIA_PADRAO_US 5000
+#define CANAL_PONTO_DE_ACESSO 6
+#define ENTREGAS_MAXIMO 64
+#define ASSINATURAS_MAXIMO 4
+#define TOPICO_MAXIMO 100
+#define PAYLOAD_MAXIMO 256
+
+typedef enum {
+    WIFI_DESASSOCIADO,
+    WIFI_ASSOCIANDO,
+    WIFI_SEM_IP,
+    WIFI_CONECTADO
+} estado_wifi_t;
+
+typedef enum {
+    ENTREGA_CONNACK,
+    ENTREGA_SUBACK,
+    ENTREGA_PUBACK,
+    ENTREGA_PUBLICACAO
+} tipo_entrega_t;
+
+/**
+ * @brief Resposta do broker à espera de cyw43_arch_poll.
+ */
+typedef struct {
+    uint64_t instante_us;
+    uint32_t sessao;
+    tipo_entrega_t tipo;
+    mqtt_request_cb_t cb;
+    void *arg;
+    char topico[TOPICO_MAXIMO];
+    uint8_t payload[PAYLOAD_MAXIMO];
+    uint16_t tamanho;
+} entrega_t;
+
+/**
+ * @brief Publicação a caminho do broker.
+ */
+typedef struct {
+    uint32_t sessao;
+    char topico[TOPICO_MAXIMO];
+    uint16_t tamanho;
+    char payload[];
+} chegada_t;
+
+struct mqtt_client_s {
+    bool conectado;
+    uint32_t sessao;
+    mqtt_connection_cb_t conexao_cb;
+    void *conexao_arg;
+    mqtt_incoming_publish_cb_t publicacao_cb;
+    mqtt_incoming_data_cb_t dados_cb;
+    void *entrada_arg;
+    uint em_voo;
+    char assinaturas[ASSINATURAS_MAXIMO][TOPICO_MAXIMO];
+    uint quantidade_assinaturas;
+};
+
+
+// --- Estado ---
+cyw43_t cyw43_state;
+
+static bool rede_ativa = true;
+static uint32_t latencia_us = LATENCIA_PADRAO_US;
+
+static estado_wifi_t wifi = WIFI_DESASSOCIADO;
+static uint64_t associado_us;       // Fim da associação em curso
+static uint64_t endereco_us;        // Fim do DHCP
+
+static struct mqtt_client_s cliente;
+static bool cliente_criado = false;
+
+// Fila ordenada por instante (estável: mesma ordem de envio para o mesmo instante)
+static entrega_t entregas[ENTREGAS_MAXIMO];
+static uint quantidade_entregas = 0;
+
+static sim_broker_observador_t observador = NULL;
+
+
+// --- Funções Auxiliares ---
+
+static entrega_t *agendar_entrega(uint64_t instante_us, tipo_entrega_t tipo) {
+    if (quantidade_entregas == ENTREGAS_MAXIMO) {
+        panic("fila de entregas MQTT cheia");
+    }
+    uint posicao = quantidade_entregas;
+    while (posicao > 0 && entregas[posicao - 1].instante_us > instante_us) {
+        entregas[posicao] = entregas[posicao - 1];
+        posicao--;
+    }
+    quantidade_entregas++;
+    entrega_t *entrega = &entregas[posicao];
+    memset(entrega, 0, sizeof(*entrega));
+    entrega->instante_us = instante_us;
+    entrega->sessao = cliente.sessao;
+    entrega->tipo = tipo;
+    return entrega;
+}
+
+/**
+ * @brief Encerra a sessão MQTT: o que estava a caminho se perde.
+ */
+static void encerrar_sessao(void) {
+    cliente.sessao++;
+    cliente.conectado = false;
+    cliente.em_voo = 0;
+    cliente.quantidade_assinaturas = 0;
+}
+
+static bool assinado(const char *topico) {
+    for (uint i = 0; i < cliente.quantidade_assinaturas; i++) {
+        if (strcmp(cliente.assinaturas[i], topico) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Chegada de uma publicação ao broker (ação agendada).
+ */
+static void chegar_ao_broker(void *arg) {
+    chegada_t *chegada = arg;
+    if (chegada->sessao == cliente.sessao && rede_ativa && observador) {
+        observador(sim_agora_us(), chegada->topico, chegada->payload, chegada->tamanho);
+    }
+    free(chegada);
+}
+
+/**
+ * @brief Avança a associação e o DHCP até o instante atual.
+ */
+static void avancar_wifi(void) {
+    uint64_t agora = sim_agora_us();
+    if (wifi == WIFI_ASSOCIANDO && agora >= associado_us && rede_ativa) {
+        wifi = WIFI_SEM_IP;
+    }
+    if (wifi == WIFI_SEM_IP && agora >= endereco_us) {
+        wifi = WIFI_CONECTADO;
+        ip4addr_aton("192.168.0.42", &cyw43_state.netif[CYW43_ITF_STA].ip_addr);
+    }
+}
+
+
+// --- Controle pelo cenário ---
+
+void sim_rede_latencia(uint32_t latencia) {
+    latencia_us = latencia;
+}
+
+void sim_rede_ativa(bool ativa) {
+    rede_ativa = ativa;
+    if (!ativa) {
+        if (wifi == WIFI_SEM_IP || wifi == WIFI_CONECTADO) {
+            wifi = WIFI_DESASSOCIADO;
+            cyw43_state.netif[CYW43_ITF_STA].ip_addr.addr = 0;
+        }
+        encerrar_sessao();
+    }
+}
+
+void sim_broker_publicar(const char *topico_base, const char *payload) {
+    if (!rede_ativa || !cliente.conectado) {
+        return; // Ninguém conectado para receber
+    }
+    entrega_t *entrega = agendar_entrega(sim_agora_us() + latencia_us, ENTREGA_PUBLICACAO);
+    snprintf(entrega->topico, sizeof(entrega->topico), "%s/%s", DEVICE_ID, topico_base);
+    size_t tamanho = strlen(payload);
+    entrega->tamanho = (uint16_t)(tamanho < PAYLOAD_MAXIMO ? tamanho : PAYLOAD_MAXIMO);
+    memcpy(entrega->payload, payload, entrega->tamanho);
+}
+
+void sim_broker_observar(sim_broker_observador_t novo) {
+    observador = novo;
+}
+
+
+// --- CYW43 ---
+
+int cyw43_arch_init(void) {
+    sleep_ms(INICIO_CHIP_MS);
+    return 0;
+}
+
+void cyw43_arch_enable_sta_mode(void) {
+}
+
+/**
+ * @brief Entrega as respostas do broker que já chegaram, na ordem de chegada.
+ */
+void cyw43_arch_poll(void) {
+    uint64_t agora = sim_agora_us();
+    while (quantidade_entregas > 0 && entregas[0].instante_us <= agora) {
+        entrega_t entrega = entregas[0];
+        memmove(&entregas[0], &entregas[1], (--quantidade_entregas) * sizeof(entrega_t));
+        if (entrega.sessao != cliente.sessao || !rede_ativa) {
+            continue;
+        }
+        switch (entrega.tipo) {
+            case ENTREGA_CONNACK:
+                cliente.conectado = true;
+                if (cliente.conexao_cb) {
+                    cliente.conexao_cb(&cliente, cliente.conexao_arg, MQTT_CONNECT_ACCEPTED);
+                }
+                break;
+            case ENTREGA_SUBACK:
+                if (entrega.cb) {
+                    entrega.cb(entrega.arg, ERR_OK);
+                }
+                break;
+            case ENTREGA_PUBACK:
+                cliente.em_voo--;
+                if (entrega.cb) {
+                    entrega.cb(entrega.arg, ERR_OK);
+                }
+                break;
+            case ENTREGA_PUBLICACAO:
+                if (assinado(entrega.topico) && cliente.publicacao_cb && cliente.dados_cb) {
+                    cliente.publicacao_cb(cliente.entrada_arg, entrega.topico, entrega.tamanho);
+                    cliente.dados_cb(cliente.entrada_arg, entrega.payload, entrega.tamanho, MQTT_DATA_FLAG_LAST);
+                }
+                break;
+        }
+    }
+}
+
+int cyw43_wifi_join(cyw43_t *self, size_t ssid_len, const uint8_t *ssid, size_t key_len, const uint8_t *key,
+                    uint32_t auth_type, const uint8_t *bssid, uint32_t channel) {
+    (void)self;
+    (void)ssid_len;
+    (void)ssid;
+    (void)key_len;
+    (void)key;
+    (void)auth_type;
+    bool em_cache = bssid != NULL && channel == CANAL_PONTO_DE_ACESSO;
+    associado_us = sim_agora_us() + (em_cache ? ASSOCIACAO_CACHE_US : ASSOCIACAO_VARREDURA_US);
+    endereco_us = associado_us + DHCP_US;
+    wifi = WIFI_ASSOCIANDO;
+    return 0;
+}
+
+int cyw43_wifi_leave(cyw43_t *self, int itf) {
+    (void)self;
+    (void)itf;
+    wifi = WIFI_DESASSOCIADO;
+    cyw43_state.netif[CYW43_ITF_STA].ip_addr.addr = 0;
+    return 0;
+}
+
+int cyw43_wifi_get_bssid(cyw43_t *self, uint8_t bssid[6]) {
+    (void)self;
+    static const uint8_t PONTO_DE_ACESSO[6] = {0x02, 0x1A, 0x11, 0xF0, 0x42, 0x06};
+    memcpy(bssid, PONTO_DE_ACESSO, sizeof(PONTO_DE_ACESSO));
+    return 0;
+}
+
+int cyw43_ioctl(cyw43_t *self, uint32_t cmd, size_t len, uint8_t *buf, uint32_t iface) {
+    (void)self;
+    (void)iface;
+    if (cmd != CYW43_IOCTL_GET_CHANNEL || len < 4) {
+        return -1;
+    }
+    buf[0] = CANAL_PONTO_DE_ACESSO;
+    buf[1] = buf[2] = buf[3] = 0;
+    return 0;
+}
+
+int cyw43_tcpip_link_status(cyw43_t *self, int itf) {
+    (void)self;
+    (void)itf;
+    avancar_wifi();
+    switch (wifi) {
+        case WIFI_ASSOCIANDO:
+            // Ponto de acesso fora do ar: a varredura termina sem encontrá-lo
+            return (!rede_ativa && sim_agora_us() >= associado_us) ? CYW43_LINK_NONET : CYW43_LINK_JOIN;
+        case WIFI_SEM_IP:
+            return CYW43_LINK_NOIP;
+        case WIFI_CONECTADO:
+            return CYW43_LINK_UP;
+        default:
+            return CYW43_LINK_DOWN;
+    }
+}
+
+int ip4addr_aton(const char *texto, ip4_addr_t *endereco) {
+    unsigned a, b, c, d;
+    if (sscanf(texto, "%u.%u.%u.%u", &a, &b, &c, &d) != 4 || a > 255 || b > 255 || c > 255 || d > 255) {
+        return 0;
+    }
+    endereco->addr = a | (b << 8) | (c << 16) | ((u32_t)d << 24); // Ordem de rede, como na lwIP
+    return 1;
+}
+
+
+// --- Cliente MQTT ---
+
+mqtt_client_t *mqtt_client_new(void) {
+    if (cliente_criado) {
+        return NULL; // O firmware cria um único cliente
+    }
+    cliente_criado = true;
+    return &cliente;
+}
+
+err_t mqtt_client_connect(mqtt_client_t *client, const ip_addr_t *ip_addr, u16_t port, mqtt_connection_cb_t cb,
+                          void *arg, const struct mqtt_connect_client_info_t *client_info) {
+    (void)ip_addr;
+    (void)port;
+    (void)client_info;
+    encerrar_sessao();
+    client->conexao_cb = cb;
+    client->conexao_arg = arg;
+    if (rede_ativa && wifi == WIFI_CONECTADO) {
+        // SYN/SYN-ACK, ACK + CONNECT e CONNACK
+        agendar_entrega(sim_agora_us() + 4u * latencia_us, ENTREGA_CONNACK);
+    }
+    return ERR_OK;
+}
+
+void mqtt_disconnect(mqtt_client_t *client) {
+    (void)client;
+    encerrar_sessao();
+}
+
+u8_t mqtt_client_is_connected(mqtt_client_t *client) {
+    return client->conectado;
+}
+
+void mqtt_set_inpub_callback(mqtt_client_t *client, mqtt_incoming_publish_cb_t pub_cb,
+                             mqtt_incoming_data_cb_t data_cb, void *arg) {
+    client->publicacao_cb = pub_cb;
+    client->dados_cb = data_cb;
+    client->entrada_arg = arg;
+}
+
+err_t mqtt_subscribe(mqtt_client_t *client, const char *topic, u8_t qos, mqtt_request_cb_t cb, void *arg) {
+    (void)qos;
+    if (!client->conectado) {
+        return ERR_CONN;
+    }
+    if (client->quantidade_assinaturas == ASSINATURAS_MAXIMO) {
+        return ERR_MEM;
+    }
+    snprintf(client->assinaturas[client->quantidade_assinaturas++], TOPICO_MAXIMO, "%s", topic);
+    entrega_t *entrega = agendar_entrega(sim_agora_us() + 2u * latencia_us, ENTREGA_SUBACK);
+    entrega->cb = cb;
+    entrega->arg = arg;
+    return ERR_OK;
+}
+
+err_t mqtt_publish(mqtt_client_t *client, const char *topic, const void *payload, u16_t payload_length,
+                   u8_t qos, u8_t retain, mqtt_request_cb_t cb, void *arg) {
+    (void)qos;
+    (void)retain;
+    if (!client->conectado) {
+        return ERR_CONN;
+    }
+    if (client->em_voo >= MQTT_REQ_MAX_IN_FLIGHT) {
+        return ERR_MEM;
+    }
+    client->em_voo++;
+
+    chegada_t *chegada = malloc(sizeof(chegada_t) + payload_length + 1u);
+    if (!chegada) {
+        panic("sem memoria para a publicacao");
+    }
+    chegada->sessao = client->sessao;
+    snprintf(chegada->topico, sizeof(chegada->topico), "%s", topic);
+    chegada->tamanho = payload_length;
+    memcpy(chegada->payload, payload, payload_length);
+    chegada->payload[payload_length] = '\0';
+    sim_agendar(sim_agora_us() + latencia_us, chegar_ao_broker, chegada, false);
+
+    entrega_t *entrega = agendar_entrega(sim_agora_us() + 2u * latencia_us, ENTREGA_PUBACK);
+    entrega->cb = cb;
+    entrega->arg = arg;
+    return ERR_OK;
+}
@@ -25,7 +25,7 @@
 #ifndef SSD1306_FONT_H
 #define SSD1306_FONT_H
 
-static uint8_t font[] = {
+static const uint8_t font[] = {
     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, //0: Nothing
     0x78, 0x14, 0x12, 0x11, 0x12, 0x14, 0x78, 0x00, //1: A
     0x7f, 0x49, 0x49, 0x49, 0x49, 0x49, 0x7f, 0x00, //2: B
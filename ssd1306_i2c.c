@@ -9,14 +9,20 @@
 #include "pico/binary_info.h"
 #include "hardware/i2c.h"
 #include "ssd1306_font.h"
+#include "ssd1306_assets.h" // Gerado no build: tabela de glifos e textos fixos pré-renderizados
 #include "ssd1306_i2c.h"
+#include "i2c_dma.h"
+#include "perfil.h"
 
 // Protótipos de funções estáticas
 static void ssd1306_draw_char(uint8_t *ssd, int16_t x, int16_t y, uint8_t character);
-static inline int ssd1306_get_font(uint8_t character);
-static void ssd1306_send_command(uint8_t command);
-static void ssd1306_send_command_list(uint8_t *ssd, int number);
-static void ssd1306_send_buffer(uint8_t ssd[], int buffer_length);
+static bool ssd1306_draw_texto_pronto(uint8_t *ssd, int16_t y, const char *utf8_string);
+static i2c_dma_id_t ssd1306_send_command_list(uint8_t *ssd, int number);
+static i2c_dma_id_t ssd1306_send_buffer(uint8_t ssd[], int buffer_length);
+
+// Contadores de tráfego: transações enfileiradas e bytes colocados no barramento
+// (inclui o byte de endereço e o byte de controle de cada transação)
+static ssd1306_estatisticas_t estatisticas = {0};
 
 
 // Implementações
@@ -25,22 +31,44 @@ void calculate_render_area_buffer_length(struct render_area *area) {
     area->buffer_length = (area->end_column - area->start_column + 1) * (area->end_page - area->start_page + 1);
 }
 
-static void ssd1306_send_command(uint8_t command) {
-    uint8_t buffer[2] = {0x80, command};
-    i2c_write_blocking(i2c1, ssd1306_i2c_address, buffer, 2, false);
-}
+// Os envios são enfileirados no motor I2C/DMA e retornam imediatamente.
+// O buffer passado precisa continuar válido até a conclusão da transação
+// (listas de até I2C_DMA_DADOS_INLINE comandos são copiadas pelo motor).
 
-static void ssd1306_send_command_list(uint8_t *ssd, int number) {
-    for (int i = 0; i < number; i++) {
-        ssd1306_send_command(ssd[i]);
+// Envia uma sequência de comandos em uma única transação: o byte de controle 0x00
+// (Co=0, D/C#=0) indica que todos os bytes seguintes, até o STOP, são comandos.
+static i2c_dma_id_t ssd1306_send_command_list(uint8_t *ssd, int number) {
+    i2c_dma_transacao_t transacao = {
+        .endereco = ssd1306_i2c_address,
+        .com_prefixo = true,
+        .prefixo = 0x00,
+        .escrita = ssd,
+        .escrita_len = number,
+    };
+    i2c_dma_id_t id = i2c_dma_enviar(i2c1, &transacao);
+    if (id) {
+        estatisticas.transacoes++;
+        estatisticas.bytes += 1 + 1 + number;
     }
+    return id;
 }
 
-static void ssd1306_send_buffer(uint8_t ssd[], int buffer_length) {
-    uint8_t temp_buffer[buffer_length + 1];
-    temp_buffer[0] = 0x40;
-    memcpy(temp_buffer + 1, ssd, buffer_length);
-    i2c_write_blocking(i2c1, ssd1306_i2c_address, temp_buffer, buffer_length + 1, false);
+// Envia dados de imagem: o byte de controle 0x40 (D/C#=1) é inserido pelo motor como
+// prefixo, e o DMA lê o quadro direto do buffer de origem, sem cópia intermediária.
+static i2c_dma_id_t ssd1306_send_buffer(uint8_t ssd[], int buffer_length) {
+    i2c_dma_transacao_t transacao = {
+        .endereco = ssd1306_i2c_address,
+        .com_prefixo = true,
+        .prefixo = 0x40,
+        .escrita = ssd,
+        .escrita_len = buffer_length,
+    };
+    i2c_dma_id_t id = i2c_dma_enviar(i2c1, &transacao);
+    if (id) {
+        estatisticas.transacoes++;
+        estatisticas.bytes += 1 + 1 + buffer_length;
+    }
+    return id;
 }
 
 void ssd1306_init() {
@@ -61,55 +89,31 @@ void ssd1306_init() {
         ssd1306_set_charge_pump, 0x14,
         ssd1306_set_display | 0x01,
     };
-    ssd1306_send_command_list(commands, count_of(commands));
+    // A lista vive na pilha e excede a cópia inline do motor: aguarda a conclusão
+    // (o display também precisa estar pronto antes do primeiro quadro)
+    i2c_dma_aguardar(i2c1, ssd1306_send_command_list(commands, count_of(commands)));
+}
+
+bool ssd1306_pronto_para_renderizar() {
+    return i2c_dma_livres(i2c1) >= SSD1306_TRANSACOES_POR_RENDER;
 }
 
-void render_on_display(uint8_t *ssd, struct render_area *area) {
+i2c_dma_id_t render_on_display(uint8_t *ssd, struct render_area *area) {
+    if (!ssd1306_pronto_para_renderizar()) {
+        return 0;
+    }
+    PERFIL_ESCOPO(PERFIL_RENDER_DISPLAY);
     uint8_t commands[] = {
         ssd1306_set_column_address, area->start_column, area->end_column,
         ssd1306_set_page_address, area->start_page, area->end_page
     };
     ssd1306_send_command_list(commands, count_of(commands));
-    ssd1306_send_buffer(ssd, area->buffer_length);
+    estatisticas.renders++;
+    return ssd1306_send_buffer(ssd, area->buffer_length);
 }
 
-static inline int ssd1306_get_font(uint8_t character) {
-    switch(character) {
-        case 'A' ... 'Z': return character - 'A' + 1;
-        case '0' ... '9': return character - '0' + 27;
-        case 'a' ... 'z': return character - 'a' + 37;
-        case '.': return 63;
-        case ':': return 64;
-        case '#': return 65;
-        case '!': return 66;
-        case '?': return 67;
-        case 0xC3: return 68; // Ã
-        case 0xC2: return 69; // Â
-        case 0xC1: return 70; // Á
-        case 0xC0: return 71; // À
-        case 0xC9: return 72; // É
-        case 0xCA: return 73; // Ê
-        case 0xCD: return 74; // Í
-        case 0xD3: return 75; // Ó
-        case 0xD4: return 76; // Ô
-        case 0xD5: return 77; // Õ
-        case 0xDA: return 78; // Ú
-        case 0xC7: return 79; // Ç
-        case 0xE7: return 80; // ç
-        case 0xE3: return 81; // ã
-        case 0xE1: return 82; // á
-        case 0xE0: return 83; // à
-        case 0xE2: return 84; // â
-        case 0xE9: return 85; // é
-        case 0xEA: return 86; // ê
-        case 0xED: return 87; // í
-        case 0xF3: return 88; // ó
-        case 0xF4: return 89; // ô
-        case 0xFA: return 90; // ú
-        case ',':  return 91;
-        case '-':  return 92;
-        default:   return 0; // caractere vazio/inválido
-    }
+void ssd1306_obter_estatisticas(ssd1306_estatisticas_t *saida) {
+    *saida = estatisticas;
 }
 
 static void ssd1306_draw_char(uint8_t *ssd, int16_t x, int16_t y, uint8_t character) {
@@ -117,14 +121,48 @@ static void ssd1306_draw_char(uint8_t *ssd, int16_t x, int16_t y, uint8_t charac
         return;
     }
     y = y / 8;
-    int idx = ssd1306_get_font(character);
+    int idx = ssd1306_glifo_indice[character]; // Tabela gerada a partir de ssd1306_font.h
     int fb_idx = y * 128 + x;
     for (int i = 0; i < 8; i++) {
         ssd[fb_idx++] = font[idx * 8 + i];
     }
 }
 
+// Procura o texto entre os pré-renderizados no build (ssd1306_telas.txt) e, se existir,
+// copia as páginas prontas da flash em vez de decodificar e desenhar caractere a caractere.
+static bool ssd1306_draw_texto_pronto(uint8_t *ssd, int16_t y, const char *utf8_string) {
+    uint32_t hash = 2166136261u; // FNV-1a, o mesmo usado pelo gerador
+    for (const uint8_t *p = (const uint8_t *)utf8_string; *p; p++) {
+        hash = (hash ^ *p) * 16777619u;
+    }
+
+    for (int i = 0; i < SSD1306_N_TELAS; i++) {
+        const ssd1306_tela_t *tela = &ssd1306_telas[i];
+        if (tela->hash != hash || strcmp(tela->texto, utf8_string) != 0) {
+            continue;
+        }
+        // Mesmo layout do desenho em tempo de execução: 16 caracteres por linha de 8 px
+        const int por_linha = ssd1306_width / 8;
+        const uint8_t *origem = tela->bitmap;
+        int restantes = tela->n_caracteres;
+        while (restantes > 0 && y <= ssd1306_height - 8) {
+            int n = restantes < por_linha ? restantes : por_linha;
+            memcpy(&ssd[(y / 8) * ssd1306_width], origem, n * 8);
+            origem += n * 8;
+            restantes -= n;
+            y += 8;
+        }
+        return true;
+    }
+    return false;
+}
+
 void ssd1306_draw_utf8_multiline(uint8_t *ssd, int16_t x, int16_t y, const char *utf8_string) {
+    // Textos fixos já vêm rasterizados da flash; só os campos dinâmicos são desenhados aqui
+    if (x == 0 && ssd1306_draw_texto_pronto(ssd, y, utf8_string)) {
+        return;
+    }
+
     const int max_width = ssd1306_width;
     const int max_height = ssd1306_height;
     const int char_width = 8;
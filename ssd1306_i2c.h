@@ -8,6 +8,7 @@
 
 #include "pico/stdlib.h"
 #include "hardware/i2c.h"
+#include "i2c_dma.h"
 
 // --- Configurações do Display ---
 #define ssd1306_height 64 // Altura do display em pixels
@@ -18,6 +19,7 @@
 #define ssd1306_page_height 8
 #define ssd1306_n_pages (ssd1306_height / ssd1306_page_height)
 #define ssd1306_buffer_length (ssd1306_n_pages * ssd1306_width)
+#define SSD1306_TRANSACOES_POR_RENDER 2 // 1 sequência de comandos de endereçamento + 1 bloco de dados
 
 // --- Comandos do Controlador SSD1306 ---
 #define ssd1306_set_memory_mode _u(0x20)
@@ -47,10 +49,21 @@ struct render_area {
     int buffer_length;
 };
 
+// Contadores de tráfego do display, para medir o custo de barramento por atualização
+typedef struct {
+    uint32_t transacoes; // Transações I2C enfileiradas (comandos e dados)
+    uint32_t bytes;      // Bytes no barramento: endereço + byte de controle + carga
+    uint32_t renders;    // Chamadas bem-sucedidas a render_on_display
+} ssd1306_estatisticas_t;
+
 // --- Funções Públicas do Driver ---
 void ssd1306_init();
-void render_on_display(uint8_t *ssd, struct render_area *area);
+// Enfileira o envio da área no motor I2C/DMA e retorna o id da transação de dados
+// (0 se a fila estiver cheia). 'ssd' deve permanecer inalterado até a conclusão.
+i2c_dma_id_t render_on_display(uint8_t *ssd, struct render_area *area);
+bool ssd1306_pronto_para_renderizar();
 void calculate_render_area_buffer_length(struct render_area *area);
 void ssd1306_draw_utf8_multiline(uint8_t *ssd, int16_t x, int16_t y, const char *utf8_string);
+void ssd1306_obter_estatisticas(ssd1306_estatisticas_t *saida);
 
 #endif // SSD1306_I2C_H
\ No newline at end of file
@@ -4,87 +4,427 @@
  */
 
 #include "tcs34725.h"
+#include "i2c_dma.h"
+#include "perfil.h"
 
 // --- Definições Internas de Registradores do Sensor ---
 
 // O bit de comando deve ser setado para '1' para indicar ao sensor
 // que estamos acessando um de seus registradores ou iniciando uma transação de dados.
 #define TCS34725_COMMAND_BIT 0x80
+// Tipo de transação "auto-incremento": cada byte lido/escrito avança para o próximo registrador
+#define TCS34725_AUTO_INCREMENTO 0x20
 
 // Endereços dos Registradores
 #define TCS34725_ENABLE_REG   0x00 // Registro de habilitação (liga/desliga o sensor e ADCs)
 #define TCS34725_ATIME_REG    0x01 // Registro de tempo de integração do ADC
+#define TCS34725_WTIME_REG    0x03 // Tempo de espera entre integrações (com WEN)
+#define TCS34725_AILTL_REG    0x04 // Limiar inferior da interrupção do canal Clear (Low Byte)
+#define TCS34725_AILTH_REG    0x05 // Limiar inferior da interrupção do canal Clear (High Byte)
+#define TCS34725_AIHTL_REG    0x06 // Limiar superior da interrupção do canal Clear (Low Byte)
+#define TCS34725_AIHTH_REG    0x07 // Limiar superior da interrupção do canal Clear (High Byte)
+#define TCS34725_PERS_REG     0x0C // Filtro de persistência da interrupção
 #define TCS34725_CONTROL_REG  0x0F // Registro de controle (ganho do sensor)
 #define TCS34725_ID_REG       0x12 // Registro de ID do dispositivo
-#define TCS34725_CDATAL_REG   0x14 // Endereço inicial dos dados de cor (Clear, Low Byte)
+#define TCS34725_STATUS_REG   0x13 // Registro de status (AVALID, AINT), seguido dos dados de cor
+
+// Bits dos registradores
+#define TCS34725_ENABLE_PON   0x01 // Oscilador interno ligado
+#define TCS34725_ENABLE_AEN   0x02 // Conversores RGBC habilitados
+#define TCS34725_ENABLE_WEN   0x08 // Estado de espera (WTIME) entre integrações
+#define TCS34725_ENABLE_AIEN  0x10 // Interrupção por limiar do canal Clear habilitada
+#define TCS34725_STATUS_AVALID 0x01 // Um ciclo de integração foi concluído
+#define TCS34725_STATUS_AINT   0x10 // Canal Clear fora da janela [AILT, AIHT] (persistente)
+
+// Comando de função especial que limpa o bit AINT
+#define TCS34725_LIMPAR_INTERRUPCAO (TCS34725_COMMAND_BIT | 0x66)
+
+// Persistência: uma integração acima do limiar já tira o sensor do repouso; reflexos
+// momentâneos são filtrados pelas leituras completas, que devolvem o sensor ao repouso.
+#define TCS34725_PERSISTENCIA 0x01
+
+// --- Temporização ---
+#define CICLO_US 2400               // Passo do ATIME e do WTIME (e duração da inicialização do ADC)
+#define CICLOS_REFERENCIA 21        // Exposição em que TCS34725_LIMIAR_PRESENCA vale (1x, 50.4ms)
+#define CICLOS_REPOUSO 10           // Integração curta em repouso (24ms)
+#define CICLOS_ESPERA 10            // Espera entre as integrações de repouso (24ms, WEN)
+#define CICLOS_MAXIMO 42            // Integração mais longa do ajuste automático (100.8ms)
+#define AUSENCIAS_PARA_REPOUSO 2    // Leituras seguidas sem cartão que devolvem o sensor ao repouso
+#define TRANSACOES_CONFIGURACAO 6   // Escritas enfileiradas por configurar()
+
+
+// --- Variáveis Estáticas ---
+
+/**
+ * @brief Um degrau do ajuste automático: ganho do amplificador e tempo de integração.
+ */
+typedef struct {
+    uint8_t control;    // Valor do registrador CONTROL
+    uint8_t ganho;
+    uint8_t ciclos;     // Ciclos de 2.4ms (ATIME = 256 - ciclos)
+} exposicao_t;
+
+// Do menos ao mais sensível; entre degraus vizinhos o sinal muda no máximo 4x
+static const exposicao_t EXPOSICOES[] = {
+    {0x00, 1, 10},      // 24ms: luz intensa
+    {0x00, 1, CICLOS_REFERENCIA},
+    {0x01, 4, CICLOS_REFERENCIA},
+    {0x02, 16, CICLOS_REFERENCIA},
+    {0x03, 60, CICLOS_REFERENCIA},
+    {0x03, 60, CICLOS_MAXIMO},  // Pouca luz
+};
+#define QUANTIDADE_EXPOSICOES (sizeof(EXPOSICOES) / sizeof(EXPOSICOES[0]))
+#define EXPOSICAO_REFERENCIA 1
+
+_Static_assert((CICLOS_MAXIMO + 1) * CICLO_US == TCS34725_PERIODO_MAXIMO_US,
+               "TCS34725_PERIODO_MAXIMO_US deve cobrir a exposição mais longa");
+
+// Etapas da aquisição: em repouso só o status é consultado a cada amostra; as cores são
+// lidas (junto com o status, numa única transação) enquanto há um cartão provável.
+typedef enum {
+    AQUISICAO_AGUARDANDO,   // Esperando o fim da próxima integração
+    AQUISICAO_LENDO_STATUS, // Leitura do registrador STATUS no barramento
+    AQUISICAO_LENDO_CORES,  // Leitura de STATUS + 8 bytes RGBC no barramento
+    AQUISICAO_CONFIGURANDO  // Escrita de um novo modo/exposição no barramento
+} etapa_aquisicao_t;
+
+static etapa_aquisicao_t etapa = AQUISICAO_AGUARDANDO;
+// Buffer para o status e os 8 bytes de dados (STATUS, CL, CH, RL, RH, GL, GH, BL, BH).
+// Estático porque o DMA escreve nele depois que tcs34725_read_colors retorna.
+static uint8_t buffer_leitura[9];
+static i2c_dma_id_t leitura = 0;        // Transação em curso no motor I2C (0 se nenhuma)
+static absolute_time_t proxima_amostra; // Quando o sensor terá concluído a próxima integração
+
+static bool repouso = true;             // Modo programado no sensor
+static uint8_t exposicao = EXPOSICAO_REFERENCIA;
+static bool reconfigurar = false;       // A última configuração falhou no barramento
+static uint8_t ausencias = 0;           // Leituras completas seguidas sem cartão
+static bool cartao_visto = false;       // Alguma leitura acima do limiar desde a saída do repouso
+static absolute_time_t ultima_ausencia; // Última amostra de repouso sem cartão
+static tcs34725_estatisticas_t estatisticas;
+static uint64_t deteccao_soma_us = 0;
+
+
+// --- Funções Auxiliares Estáticas ---
+
+/**
+ * @brief Enfileira a escrita de 'tamanho' bytes (comando incluso) sem bloquear.
+ */
+static i2c_dma_id_t enviar_escrita(i2c_inst_t* i2c, const uint8_t *bytes, uint16_t tamanho) {
+    i2c_dma_transacao_t transacao = {.endereco = TCS34725_ADDR, .escrita = bytes, .escrita_len = tamanho};
+    return i2c_dma_enviar(i2c, &transacao);
+}
+
+/**
+ * @brief Enfileira a escrita de um registrador (não bloqueia).
+ */
+static i2c_dma_id_t enviar_registrador(i2c_inst_t* i2c, uint8_t reg, uint8_t valor) {
+    uint8_t cmd[] = {TCS34725_COMMAND_BIT | reg, valor};
+    return enviar_escrita(i2c, cmd, sizeof(cmd));
+}
+
+/**
+ * @brief Escreve um registrador do sensor e aguarda a conclusão (usada só na inicialização).
+ */
+static bool escrever_registrador(i2c_inst_t* i2c, uint8_t reg, uint8_t valor) {
+    return i2c_dma_aguardar(i2c, enviar_registrador(i2c, reg, valor)) == I2C_DMA_CONCLUIDA;
+}
+
+/**
+ * @brief Enfileira a leitura de 'tamanho' registradores a partir de 'reg' (não bloqueia).
+ * Escreve o endereço inicial (com o bit de comando) e lê com repeated start, em uma única transação.
+ */
+static i2c_dma_id_t enviar_leitura(i2c_inst_t* i2c, uint8_t reg, uint8_t *destino, uint16_t tamanho) {
+    uint8_t cmd = TCS34725_COMMAND_BIT | TCS34725_AUTO_INCREMENTO | reg;
+    i2c_dma_transacao_t transacao = {
+        .endereco = TCS34725_ADDR,
+        .escrita = &cmd, .escrita_len = 1,
+        .leitura = destino, .leitura_len = tamanho,
+    };
+    return i2c_dma_enviar(i2c, &transacao);
+}
+
+/**
+ * @brief Maior contagem de um canal com 'ciclos' de integração.
+ */
+static uint32_t fundo_de_escala(uint8_t ciclos) {
+    uint32_t fundo = 1024u * ciclos;
+    return fundo > 65535u ? 65535u : fundo;
+}
+
+/**
+ * @brief Converte o limiar de presença para a contagem bruta de uma exposição.
+ */
+static uint32_t limiar_bruto(uint8_t ganho, uint8_t ciclos) {
+    uint32_t referencia = CICLOS_REFERENCIA;
+    return ((uint32_t)TCS34725_LIMIAR_PRESENCA * ganho * ciclos + referencia - 1) / referencia;
+}
+
+/**
+ * @brief Intervalo entre amostras no modo programado.
+ */
+static uint32_t periodo_amostra_us(void) {
+    if (repouso) {
+        return (1 + CICLOS_REPOUSO + CICLOS_ESPERA) * CICLO_US;
+    }
+    return (1 + EXPOSICOES[exposicao].ciclos) * CICLO_US;
+}
+
+/**
+ * @brief Programa o modo (repouso ou leitura completa) e a exposição, sem bloquear.
+ * A integração em curso é interrompida (AEN desligado) e recomeça com a nova configuração
+ * quando a última escrita é concluída: nenhuma amostra mistura dois ajustes.
+ * @return false se não há espaço na fila do barramento (nada foi enviado).
+ */
+static bool configurar(i2c_inst_t* i2c, bool repousar, uint8_t indice) {
+    if (i2c_dma_livres(i2c) < TRANSACOES_CONFIGURACAO) {
+        return false;
+    }
+    const exposicao_t *e = &EXPOSICOES[indice];
+    uint8_t ciclos = repousar ? CICLOS_REPOUSO : e->ciclos;
+    uint8_t enable = TCS34725_ENABLE_PON | TCS34725_ENABLE_AEN;
+
+    enviar_registrador(i2c, TCS34725_ENABLE_REG, TCS34725_ENABLE_PON);
+    enviar_registrador(i2c, TCS34725_ATIME_REG, (uint8_t)(256 - ciclos));
+    enviar_registrador(i2c, TCS34725_CONTROL_REG, e->control);
+    if (repousar) {
+        // Espera entre amostras e janela [0, limiar - 1] do canal Clear, de modo que AINT
+        // indique "luz refletida suficiente para haver um cartão" na exposição de repouso
+        uint16_t limiar_superior = (uint16_t)(limiar_bruto(e->ganho, ciclos) - 1);
+        uint8_t bloco[] = {
+            TCS34725_COMMAND_BIT | TCS34725_AUTO_INCREMENTO | TCS34725_WTIME_REG,
+            (uint8_t)(256 - CICLOS_ESPERA),
+            0x00, 0x00,
+            limiar_superior & 0xFF, limiar_superior >> 8,
+        };
+        enviar_escrita(i2c, bloco, sizeof(bloco));
+        uint8_t limpar = TCS34725_LIMPAR_INTERRUPCAO;
+        enviar_escrita(i2c, &limpar, 1);
+        enable |= TCS34725_ENABLE_WEN | TCS34725_ENABLE_AIEN;
+    }
+    leitura = enviar_registrador(i2c, TCS34725_ENABLE_REG, enable);
+
+    if (indice != exposicao) {
+        estatisticas.ajustes++;
+    }
+    repouso = repousar;
+    exposicao = indice;
+    reconfigurar = false;
+    etapa = AQUISICAO_CONFIGURANDO;
+    return true;
+}
+
+/**
+ * @brief Interpreta uma leitura completa: ajuste automático, presença e métricas.
+ * @return true se 'colors' recebeu uma leitura utilizável.
+ */
+static bool tratar_cores(i2c_inst_t* i2c, tcs34725_color_data_t* colors) {
+    // Os dados chegam como pares de bytes (Low, High). Recombina-os em valores de 16 bits.
+    // (High Byte << 8) | Low Byte
+    colors->clear = (buffer_leitura[2] << 8) | buffer_leitura[1];
+    colors->red   = (buffer_leitura[4] << 8) | buffer_leitura[3];
+    colors->green = (buffer_leitura[6] << 8) | buffer_leitura[5];
+    colors->blue  = (buffer_leitura[8] << 8) | buffer_leitura[7];
+
+    const exposicao_t *e = &EXPOSICOES[exposicao];
+    uint32_t fundo = fundo_de_escala(e->ciclos);
+
+    // Saturação a 3/4 do fundo de escala: abaixo de 150ms de integração a ondulação do
+    // conversor satura o canal antes da contagem máxima (datasheet). A leitura é descartada,
+    // a menos que já não haja exposição menor.
+    if (colors->clear >= fundo * 3 / 4) {
+        estatisticas.saturacoes++;
+        if (exposicao > 0) {
+            configurar(i2c, false, exposicao - 1);
+            return false;
+        }
+    }
+
+    uint32_t normalizado = ((uint32_t)colors->clear * CICLOS_REFERENCIA) / ((uint32_t)e->ganho * e->ciclos);
+    colors->clear_normalizado = normalizado > 65535u ? 65535u : (uint16_t)normalizado;
+
+    uint8_t nova_exposicao = exposicao;
+    bool repousar = false;
+    if (colors->clear_normalizado < TCS34725_LIMIAR_PRESENCA) {
+        if (++ausencias >= AUSENCIAS_PARA_REPOUSO) {
+            if (!cartao_visto) {
+                estatisticas.alarmes_falsos++;
+            }
+            repousar = true;
+            nova_exposicao = EXPOSICAO_REFERENCIA; // O limiar do repouso vale na exposição de referência
+        }
+    } else {
+        // Só um cartão justifica mais sensibilidade: sem ele o sinal é sempre fraco, e o
+        // próximo cartão encontraria o sensor no ganho máximo, saturado
+        if (colors->clear < fundo / 16 && exposicao + 1u < QUANTIDADE_EXPOSICOES) {
+            // Sinal fraco: a próxima exposição (no máximo 4x mais sensível) ainda fica abaixo da saturação
+            nova_exposicao = exposicao + 1;
+        }
+        ausencias = 0;
+        if (!cartao_visto) {
+            cartao_visto = true;
+            uint32_t deteccao_us = (uint32_t)absolute_time_diff_us(ultima_ausencia, get_absolute_time());
+            estatisticas.deteccoes++;
+            deteccao_soma_us += deteccao_us;
+            if (deteccao_us > estatisticas.deteccao_maxima_us) {
+                estatisticas.deteccao_maxima_us = deteccao_us;
+            }
+        }
+    }
+    if (repousar || nova_exposicao != exposicao) {
+        configurar(i2c, repousar, nova_exposicao);
+    }
+    return true;
+}
 
 
 // --- Implementação das Funções Públicas ---
 
 /**
- * @brief Configura o sensor TCS34725 com parâmetros padrão e o liga.
+ * @brief Configura o sensor TCS34725 e o liga no modo de repouso.
  * Checa o ID do dispositivo para garantir a comunicação.
- * @param i2c_port A instância do I2C já inicializada onde o sensor está conectado.
+ * @param i2c_port A instância do I2C já inicializada (via i2c_dma_init) onde o sensor está conectado.
  * @return true se o sensor foi inicializado com sucesso, false caso contrário.
  */
 bool tcs34725_init(i2c_inst_t* i2c) {
     // 1. Verifica o ID do chip para garantir a comunicação com o sensor correto.
+    // Escreve o endereço do registro ID e lê o valor com repeated start, na mesma transação.
     uint8_t id_reg = TCS34725_COMMAND_BIT | TCS34725_ID_REG;
     uint8_t chip_id;
-    int ret = i2c_write_blocking(i2c, TCS34725_ADDR, &id_reg, 1, true); // Envia endereço do registro ID
-    if (ret < 0) return false; // Erro de escrita I2C
-    ret = i2c_read_blocking(i2c, TCS34725_ADDR, &chip_id, 1, false);     // Lê o ID
-    if (ret < 0) return false; // Erro de leitura I2C
+    i2c_dma_transacao_t leitura_id = {
+        .endereco = TCS34725_ADDR,
+        .escrita = &id_reg, .escrita_len = 1,
+        .leitura = &chip_id, .leitura_len = 1,
+    };
+    if (i2c_dma_aguardar(i2c, i2c_dma_enviar(i2c, &leitura_id)) != I2C_DMA_CONCLUIDA) {
+        return false; // Erro de comunicação I2C
+    }
 
     // O ID de um TCS34725 é 0x44 e de um TCS34727 é 0x4D. Ambos são compatíveis.
     if (chip_id != 0x44 && chip_id != 0x4D) {
         return false; // ID não corresponde ao esperado
     }
 
-    // 2. Configura o tempo de integração do ADC (ATIME).
-    // O valor 0xEB resulta em (256 - 235) * 2.4ms = 50.4ms de tempo de integração.
-    uint8_t atime_cmd[] = {TCS34725_COMMAND_BIT | TCS34725_ATIME_REG, 0xEB};
-    ret = i2c_write_blocking(i2c, TCS34725_ADDR, atime_cmd, 2, false);
-    if (ret < 0) return false;
-
-    // 3. Configura o ganho (gain) do amplificador para 1x (0x00).
-    uint8_t control_cmd[] = {TCS34725_COMMAND_BIT | TCS34725_CONTROL_REG, 0x00};
-    ret = i2c_write_blocking(i2c, TCS34725_ADDR, control_cmd, 2, false);
-    if (ret < 0) return false;
-    
-    // 4. Habilita o oscilador interno (PON - Power ON) e os conversores ADC (AEN - RGBC Enable).
-    uint8_t enable_cmd[] = {TCS34725_COMMAND_BIT | TCS34725_ENABLE_REG, 0x03}; // PON=1, AEN=1
-    ret = i2c_write_blocking(i2c, TCS34725_ADDR, enable_cmd, 2, false);
-    if (ret < 0) return false;
-
-    // Pequena pausa para a primeira conversão ser estabilizada após habilitar o sensor.
-    sleep_ms(3); 
+    // 2. Filtro de persistência da interrupção de presença (não muda depois).
+    if (!escrever_registrador(i2c, TCS34725_PERS_REG, TCS34725_PERSISTENCIA)) return false;
+
+    // 3. Liga o oscilador interno (PON) e aguarda os 2.4ms de aquecimento antes dos conversores.
+    if (!escrever_registrador(i2c, TCS34725_ENABLE_REG, TCS34725_ENABLE_PON)) return false;
+    sleep_ms(3);
+
+    // 4. Repouso na exposição de referência: integração curta, espera (WEN) e interrupção (AIEN).
+    leitura = 0;
+    if (!configurar(i2c, true, EXPOSICAO_REFERENCIA) || i2c_dma_aguardar(i2c, leitura) != I2C_DMA_CONCLUIDA) {
+        leitura = 0;
+        return false;
+    }
+
+    // A primeira amostra completa só existe após um ciclo
+    leitura = 0;
+    etapa = AQUISICAO_AGUARDANDO;
+    ultima_ausencia = get_absolute_time();
+    proxima_amostra = make_timeout_time_us(periodo_amostra_us());
 
     return true; // Inicialização bem-sucedida
 }
 
 /**
- * @brief Lê os valores brutos dos quatro canais de cor do sensor.
+ * @brief Obtém os valores brutos dos quatro canais de cor do sensor sem bloquear.
+ * Em repouso consulta apenas o registrador STATUS (1 byte) a cada amostra; quando AINT indica
+ * um cartão provável, reprograma o sensor para leituras completas (STATUS + RGBC numa única
+ * transação) até AUSENCIAS_PARA_REPOUSO leituras seguidas abaixo do limiar.
+ * Todas as transferências passam pelo motor I2C/DMA, de modo que o chamador nunca espera o barramento.
  * @param i2c_port A instância do I2C onde o sensor está conectado.
  * @param colors Ponteiro para uma estrutura tcs34725_color_data_t onde os dados lidos serão armazenados.
+ * @return true se 'colors' recebeu uma leitura nova; false caso contrário.
  */
-void tcs34725_read_colors(i2c_inst_t* i2c, tcs34725_color_data_t* colors) {
-    uint8_t buffer[8]; // Buffer para armazenar os 8 bytes de dados (2 bytes por canal: CL, CH, RL, RH, GL, GH, BL, BH)
-    
-    // Define o registrador inicial a partir do qual queremos ler (Clear Data Low Byte)
-    // O bit de comando é setado para indicar que é uma operação de leitura de registro.
-    uint8_t start_reg = TCS34725_COMMAND_BIT | TCS34725_CDATAL_REG;
-
-    // Pede ao sensor para ler 8 bytes em sequência a partir do registrador inicial.
-    // 'true' no primeiro write_blocking mantém o controle do barramento I2C, permitindo um "repeated start"
-    // antes da leitura, o que é comum para ler múltiplos bytes de registradores.
-    i2c_write_blocking(i2c, TCS34725_ADDR, &start_reg, 1, true); 
-    i2c_read_blocking(i2c, TCS34725_ADDR, buffer, 8, false); // Lê os 8 bytes
+bool tcs34725_read_colors(i2c_inst_t* i2c, tcs34725_color_data_t* colors) {
+    PERFIL_ESCOPO(PERFIL_LEITURA_SENSOR);
+    bool nova_leitura = false;
 
-    // Os dados chegam como pares de bytes (Low, High). Recombina-os em valores de 16 bits.
-    // (High Byte << 8) | Low Byte
-    colors->clear = (buffer[1] << 8) | buffer[0];
-    colors->red   = (buffer[3] << 8) | buffer[2];
-    colors->green = (buffer[5] << 8) | buffer[4];
-    colors->blue  = (buffer[7] << 8) | buffer[6];
+    if (leitura != 0) {
+        if (i2c_dma_em_curso(i2c, leitura)) {
+            return false; // Transação anterior ainda no barramento
+        }
+        bool concluida = (i2c_dma_estado(i2c, leitura) == I2C_DMA_CONCLUIDA);
+        etapa_aquisicao_t concluiu = etapa;
+        leitura = 0;
+        etapa = AQUISICAO_AGUARDANDO;
+
+        if (concluiu == AQUISICAO_CONFIGURANDO) {
+            // A escrita do ENABLE reiniciou a integração; se falhou, tenta de novo na próxima amostra
+            reconfigurar = !concluida;
+            if (concluida && repouso) {
+                ultima_ausencia = get_absolute_time();
+            }
+            proxima_amostra = make_timeout_time_us(periodo_amostra_us());
+            return false;
+        }
+
+        uint8_t status = buffer_leitura[0];
+        if (concluida && (status & TCS34725_STATUS_AVALID)) {
+            if (concluiu == AQUISICAO_LENDO_STATUS) {
+                if (status & TCS34725_STATUS_AINT) {
+                    // Cartão provável: sai do repouso para as leituras completas
+                    ausencias = 0;
+                    cartao_visto = false;
+                    configurar(i2c, false, exposicao);
+                } else {
+                    ultima_ausencia = get_absolute_time();
+                }
+            } else if (concluiu == AQUISICAO_LENDO_CORES) {
+                nova_leitura = tratar_cores(i2c, colors);
+            }
+        }
+        if (leitura != 0) {
+            return nova_leitura; // Reconfiguração a caminho
+        }
+    }
+
+    // Os registradores só mudam ao fim de cada integração: antes disso, reler seria desperdício
+    if (!time_reached(proxima_amostra)) {
+        return nova_leitura;
+    }
+
+    if (reconfigurar) {
+        if (!configurar(i2c, repouso, exposicao)) {
+            proxima_amostra = make_timeout_time_us(periodo_amostra_us());
+        }
+        return nova_leitura;
+    }
+
+    if (repouso) {
+        leitura = enviar_leitura(i2c, TCS34725_STATUS_REG, buffer_leitura, 1);
+        etapa = AQUISICAO_LENDO_STATUS;
+    } else {
+        leitura = enviar_leitura(i2c, TCS34725_STATUS_REG, buffer_leitura, sizeof(buffer_leitura));
+        etapa = AQUISICAO_LENDO_CORES;
+    }
+    if (leitura != 0) {
+        proxima_amostra = make_timeout_time_us(periodo_amostra_us());
+    } else {
+        etapa = AQUISICAO_AGUARDANDO;
+    }
+
+    return nova_leitura;
+}
+
+/**
+ * @brief Informa quando tcs34725_read_colors terá algo a fazer.
+ * @return Instante da próxima amostra; at_the_end_of_time enquanto uma transação estiver
+ * no barramento (a interrupção de conclusão do I2C acorda o núcleo).
+ */
+absolute_time_t tcs34725_proxima_amostra(void) {
+    return (leitura != 0) ? at_the_end_of_time : proxima_amostra;
+}
+
+/**
+ * @brief Copia as métricas do sensor.
+ */
+void tcs34725_obter_estatisticas(tcs34725_estatisticas_t *saida) {
+    *saida = estatisticas;
+    saida->deteccao_media_us = estatisticas.deteccoes ? (uint32_t)(deteccao_soma_us / estatisticas.deteccoes) : 0;
+    saida->ganho = EXPOSICOES[exposicao].ganho;
+    saida->integracao_us = EXPOSICOES[exposicao].ciclos * CICLO_US;
+    saida->repouso = repouso;
 }
\ No newline at end of file
@@ -13,6 +13,15 @@
 // Endereço I2C padrão para o sensor TCS34725/TCS34727
 #define TCS34725_ADDR 0x29
 
+// Maior intervalo entre duas leituras com o cartão presente (100.8ms de integração,
+// a exposição mais longa do ajuste automático, mais o ciclo de inicialização do ADC)
+#define TCS34725_PERIODO_MAXIMO_US 103200
+
+// Valor mínimo do canal Clear para considerar que há um cartão diante do sensor, na
+// exposição de referência (ganho 1x, 50.4ms). Convertido para a exposição em vigor no
+// limiar da interrupção do chip; comparado com clear_normalizado pela classificação.
+#define TCS34725_LIMIAR_PRESENCA 70
+
 /**
  * @struct tcs34725_color_data_t
  * @brief Estrutura para armazenar os dados brutos dos 4 canais de cor lidos do sensor.
@@ -22,22 +31,54 @@ typedef struct {
     uint16_t red;    ///< Leitura do canal de luz vermelha.
     uint16_t green;  ///< Leitura do canal de luz verde.
     uint16_t blue;   ///< Leitura do canal de luz azul.
+    uint16_t clear_normalizado; ///< Canal Clear convertido para a exposição de referência.
 } tcs34725_color_data_t;
 
 /**
- * @brief Configura o sensor TCS34725 com parâmetros padrão e o liga.
+ * @struct tcs34725_estatisticas_t
+ * @brief Métricas do ajuste automático e da detecção.
+ */
+typedef struct {
+    uint32_t deteccoes;             ///< Aproximações detectadas a partir do repouso.
+    uint32_t deteccao_media_us;     ///< Da última amostra de repouso sem cartão à primeira leitura com ele.
+    uint32_t deteccao_maxima_us;
+    uint32_t alarmes_falsos;        ///< Saídas do repouso sem nenhuma leitura acima do limiar.
+    uint32_t saturacoes;            ///< Leituras com o canal Clear saturado.
+    uint32_t ajustes;               ///< Mudanças de ganho ou tempo de integração.
+    uint8_t ganho;                  ///< Ganho em vigor (1, 4, 16 ou 60).
+    uint32_t integracao_us;         ///< Tempo de integração das leituras com o cartão.
+    bool repouso;                   ///< Sensor no modo de espera entre amostras curtas.
+} tcs34725_estatisticas_t;
+
+/**
+ * @brief Configura o sensor TCS34725 e o liga no modo de repouso.
  * Checa o ID do dispositivo para garantir a comunicação.
- * @param i2c_port A instância do I2C já inicializada onde o sensor está conectado.
+ * @param i2c_port A instância do I2C já inicializada (via i2c_dma_init) onde o sensor está conectado.
  * @return true se o sensor foi inicializado com sucesso, false caso contrário.
  */
 bool tcs34725_init(i2c_inst_t* i2c_port);
 
 /**
- * @brief Lê os valores brutos dos quatro canais de cor do sensor.
- * Os dados são armazenados na estrutura colors.
+ * @brief Obtém os valores brutos dos quatro canais de cor do sensor sem bloquear.
+ * Em repouso o sensor faz integrações curtas intercaladas com o estado de espera (WEN) e
+ * só o status é consultado; quando o canal Clear ultrapassa TCS34725_LIMIAR_PRESENCA
+ * (interrupção AINT do chip), passa às leituras completas, com ganho e tempo de integração
+ * ajustados pelo próprio canal Clear, até o cartão sair.
  * @param i2c_port A instância do I2C onde o sensor está conectado.
  * @param colors Ponteiro para uma estrutura tcs34725_color_data_t.
+ * @return true se 'colors' foi preenchida com uma leitura nova.
+ */
+bool tcs34725_read_colors(i2c_inst_t* i2c_port, tcs34725_color_data_t* colors);
+
+/**
+ * @brief Prazo da próxima amostra do sensor, para que o chamador possa dormir até lá.
+ * @return Instante em que tcs34725_read_colors deve ser chamada novamente.
+ */
+absolute_time_t tcs34725_proxima_amostra(void);
+
+/**
+ * @brief Copia as métricas do sensor.
  */
-void tcs34725_read_colors(i2c_inst_t* i2c_port, tcs34725_color_data_t* colors);
+void tcs34725_obter_estatisticas(tcs34725_estatisticas_t *estatisticas);
 
 #endif // TCS34725_H
\ No newline at end of file